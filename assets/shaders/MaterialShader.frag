@@ -7,8 +7,6 @@ struct directional_light {
     vec4 colour;
 };
 
-const int MAX_POINT_LIGHTS = 10;
-
 struct point_light {
     vec4 position;
     vec4 colour;
@@ -22,11 +20,34 @@ struct point_light {
     float pad;
 };
 
+layout(set = 0, binding = 0) uniform global_uniform_object {
+    mat4 projection;
+    mat4 view;
+    vec4 ambient_colour;
+    vec3 view_position;
+    int mode;
+} global_ubo;
+
+// Filled each frame by the light system's cluster assignment
+layout(std430, set = 0, binding = 1) readonly buffer light_buffer {
+    point_light lights[];
+} light_data;
+
+layout(std430, set = 0, binding = 2) readonly buffer light_grid_buffer {
+    uvec4 dimensions;
+    // near, far, slice scale, slice bias
+    vec4 depth;
+    // offset into light_indices, light count
+    uvec2 cells[];
+} light_grid;
+
+layout(std430, set = 0, binding = 3) readonly buffer light_index_buffer {
+    uint indices[];
+} light_indices;
+
 layout(set = 1, binding = 0) uniform local_uniform_object {
     vec4 diffuse_colour;
     directional_light dir_light;
-    point_light point_lights[MAX_POINT_LIGHTS];
-    int num_point_lights;
     float shininess;
 } object_ubo;
 
@@ -53,6 +74,19 @@ mat3 TBN;
 vec4 calculate_directional_light(directional_light light, vec3 normal, vec3 view_direction);
 vec4 calculate_point_light(point_light light, vec3 normal, vec3 frag_position, vec3 view_direction);
 
+uvec2 find_cluster(vec3 frag_position)
+{
+    vec4 view_space = global_ubo.view * vec4(frag_position, 1);
+    vec4 clip = global_ubo.projection * view_space;
+    vec2 tiles = vec2(light_grid.dimensions.xy);
+    uvec2 tile = uvec2(clamp(((clip.xy / clip.w) * 0.5 + 0.5) * tiles, vec2(0), tiles - 1));
+
+    float depth = max(-view_space.z, light_grid.depth.x);
+    uint slice = uint(clamp(floor(log(depth) * light_grid.depth.z - light_grid.depth.w), 0.0, float(light_grid.dimensions.z - 1)));
+
+    return light_grid.cells[tile.x + light_grid.dimensions.x * (tile.y + light_grid.dimensions.y * slice)];
+}
+
 void main() {
     vec3 normal = in_dto.normal;
     vec3 tangent = in_dto.tangent.xyz;
@@ -69,9 +103,10 @@ void main() {
 
         out_colour = calculate_directional_light(object_ubo.dir_light, normal, view_direction);
 
-        for(int i = 0; i < object_ubo.num_point_lights; i++)
+        uvec2 cluster = find_cluster(in_dto.frag_position);
+        for(uint i = 0; i < cluster.y; i++)
         {
-        out_colour += calculate_point_light(object_ubo.point_lights[i], normal, in_dto.frag_position, view_direction);
+        out_colour += calculate_point_light(light_data.lights[light_indices.indices[cluster.x + i]], normal, in_dto.frag_position, view_direction);
         }
     } else if(in_mode == 2) {
         out_colour = vec4(abs(normal), 1.0);
@@ -7,8 +7,6 @@ struct directional_light {
     vec4 colour;
 };
 
-const int MAX_POINT_LIGHTS = 10;
-
 struct point_light {
     vec4 position;
     vec4 colour;
@@ -28,10 +26,33 @@ struct pbr_properties {
     float shininess;
 };
 
+layout(set = 0, binding = 0) uniform global_uniform_object {
+    mat4 projection;
+    mat4 view;
+    vec4 ambient_colour;
+    vec3 view_position;
+    int mode;
+} global_ubo;
+
+// Filled each frame by the light system's cluster assignment
+layout(std430, set = 0, binding = 1) readonly buffer light_buffer {
+    point_light lights[];
+} light_data;
+
+layout(std430, set = 0, binding = 2) readonly buffer light_grid_buffer {
+    uvec4 dimensions;
+    // near, far, slice scale, slice bias
+    vec4 depth;
+    // offset into light_indices, light count
+    uvec2 cells[];
+} light_grid;
+
+layout(std430, set = 0, binding = 3) readonly buffer light_index_buffer {
+    uint indices[];
+} light_indices;
+
 layout(set = 1, binding = 0) uniform local_uniform_object {
     directional_light dir_light;
-    point_light point_lights[MAX_POINT_LIGHTS];
-    int num_point_lights;
     pbr_properties props;
 } object_ubo;
 
@@ -68,6 +89,19 @@ float geometry_ggx(float normal_dot_direction, float roughness)
     return normal_dot_direction / (normal_dot_direction * (1 - k) + k);
 }
 
+uvec2 find_cluster(vec3 frag_position)
+{
+    vec4 view_space = global_ubo.view * vec4(frag_position, 1);
+    vec4 clip = global_ubo.projection * view_space;
+    vec2 tiles = vec2(light_grid.dimensions.xy);
+    uvec2 tile = uvec2(clamp(((clip.xy / clip.w) * 0.5 + 0.5) * tiles, vec2(0), tiles - 1));
+
+    float depth = max(-view_space.z, light_grid.depth.x);
+    uint slice = uint(clamp(floor(log(depth) * light_grid.depth.z - light_grid.depth.w), 0.0, float(light_grid.dimensions.z - 1)));
+
+    return light_grid.cells[tile.x + light_grid.dimensions.x * (tile.y + light_grid.dimensions.y * slice)];
+}
+
 vec3 calculate_point_light_radiance(point_light light, vec3 view_direction, vec3 frag_position)
 {
     float distance = length(light.position.xyz - frag_position);
@@ -156,9 +190,10 @@ void main() {
             total_reflectance += calculate_reflectance(albedo, normal, view_direction, light_dir, metallic, roughness, base_reflectivity, radiance);
         }
 
-        for (int i = 0; i < object_ubo.num_point_lights; i++)
+        uvec2 cluster = find_cluster(in_dto.frag_position);
+        for (uint i = 0; i < cluster.y; i++)
         {
-            point_light light = object_ubo.point_lights[i];
+            point_light light = light_data.lights[light_indices.indices[cluster.x + i]];
 
             vec3 light_dir = normalize(light.position.xyz - in_dto.frag_position.xyz);
 
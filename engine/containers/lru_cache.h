@@ -0,0 +1,73 @@
+#pragma once
+#include <pch.h>
+
+#include <list>
+
+namespace egkr::container
+{
+	// Keeps values up to a total cost, evicting the least recently used first. A value costing more than
+	// the whole capacity is not kept. Not thread safe, callers sharing a cache lock around it
+	template<class key, class value>
+	class lru_cache
+	{
+	public:
+		explicit lru_cache(uint64_t capacity) : capacity_{ capacity } {}
+
+		// Marks a hit as the most recently used
+		std::optional<value> get(const key& entry_key);
+		void put(const key& entry_key, value entry_value, uint64_t cost);
+
+		[[nodiscard]] uint64_t get_size() const { return size_; }
+		[[nodiscard]] uint64_t get_capacity() const { return capacity_; }
+
+	private:
+		struct entry
+		{
+			key entry_key;
+			value entry_value;
+			uint64_t cost{};
+		};
+
+		// Most recently used at the front
+		std::list<entry> entries_;
+		std::unordered_map<key, typename std::list<entry>::iterator> lookup_;
+		uint64_t capacity_{};
+		uint64_t size_{};
+	};
+
+	template<class key, class value>
+	inline std::optional<value> lru_cache<key, value>::get(const key& entry_key)
+	{
+		auto found = lookup_.find(entry_key);
+		if (found == lookup_.end())
+		{
+			return {};
+		}
+
+		entries_.splice(entries_.begin(), entries_, found->second);
+		return found->second->entry_value;
+	}
+
+	template<class key, class value>
+	inline void lru_cache<key, value>::put(const key& entry_key, value entry_value, uint64_t cost)
+	{
+		if (auto found = lookup_.find(entry_key); found != lookup_.end())
+		{
+			size_ -= found->second->cost;
+			entries_.erase(found->second);
+			lookup_.erase(found);
+		}
+
+		entries_.push_front({ .entry_key = entry_key, .entry_value = std::move(entry_value), .cost = cost });
+		lookup_[entry_key] = entries_.begin();
+		size_ += cost;
+
+		while (size_ > capacity_ && !entries_.empty())
+		{
+			const auto& oldest = entries_.back();
+			size_ -= oldest.cost;
+			lookup_.erase(oldest.entry_key);
+			entries_.pop_back();
+		}
+	}
+}
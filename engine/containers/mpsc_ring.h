@@ -0,0 +1,95 @@
+#pragma once
+#include <pch.h>
+
+#include <atomic>
+#include <bit>
+
+namespace egkr::container
+{
+	// Bounded queue any number of threads can push to without locking, drained by a single consumer.
+	// A full ring rejects the push and counts the drop instead of blocking the producer
+	template<class T>
+	class mpsc_ring
+	{
+	public:
+		explicit mpsc_ring(uint32_t capacity);
+
+		bool try_push(T value);
+		bool try_pop(T& value);
+
+		[[nodiscard]] uint64_t get_dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+	private:
+		struct cell
+		{
+			std::atomic<uint64_t> sequence{};
+			T value{};
+		};
+
+		egkr::vector<cell> cells_;
+		uint64_t mask_{};
+
+		alignas(64) std::atomic<uint64_t> enqueue_position_{};
+		alignas(64) uint64_t dequeue_position_{};
+		std::atomic<uint64_t> dropped_{};
+	};
+
+	template<class T>
+	inline mpsc_ring<T>::mpsc_ring(uint32_t capacity)
+		: cells_(std::bit_ceil(std::max(capacity, 2u))), mask_{ cells_.size() - 1 }
+	{
+		for (uint64_t i{}; i < cells_.size(); ++i)
+		{
+			cells_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	template<class T>
+	inline bool mpsc_ring<T>::try_push(T value)
+	{
+		uint64_t position = enqueue_position_.load(std::memory_order_relaxed);
+		cell* target{};
+		for (;;)
+		{
+			target = &cells_[position & mask_];
+			const uint64_t sequence = target->sequence.load(std::memory_order_acquire);
+			const auto difference = (int64_t)sequence - (int64_t)position;
+			if (difference == 0)
+			{
+				if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				dropped_.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				position = enqueue_position_.load(std::memory_order_relaxed);
+			}
+		}
+
+		target->value = std::move(value);
+		target->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	template<class T>
+	inline bool mpsc_ring<T>::try_pop(T& value)
+	{
+		auto& source = cells_[dequeue_position_ & mask_];
+		const uint64_t sequence = source.sequence.load(std::memory_order_acquire);
+		if ((int64_t)sequence - (int64_t)(dequeue_position_ + 1) < 0)
+		{
+			return false;
+		}
+
+		value = std::move(source.value);
+		source.sequence.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+		++dequeue_position_;
+		return true;
+	}
+}
@@ -0,0 +1,147 @@
+#include "skyline_packer.h"
+
+namespace egkr::container
+{
+	skyline_packer::skyline_packer(uint32_t width, uint32_t height)
+	{
+		reset(width, height);
+	}
+
+	void skyline_packer::reset(uint32_t width, uint32_t height)
+	{
+		width_ = width;
+		height_ = height;
+		skyline_.clear();
+		skyline_.push_back({.x = 0, .y = 0, .width = width});
+	}
+
+	void skyline_packer::grow(uint32_t width, uint32_t height)
+	{
+		if (width > width_)
+		{
+			skyline_.push_back({.x = width_, .y = 0, .width = width - width_});
+			width_ = width;
+		}
+		height_ = std::max(height, height_);
+	}
+
+	bool skyline_packer::restore(uint32_t width, uint32_t height, egkr::vector<node> skyline)
+	{
+		// Nodes have to tile the full width left to right, anything else would hand out overlapping rects
+		uint32_t x{};
+		for (const auto& n : skyline)
+		{
+			if (n.x != x || n.width == 0 || n.y > height)
+			{
+				return false;
+			}
+			x += n.width;
+		}
+
+		if (x != width)
+		{
+			return false;
+		}
+
+		width_ = width;
+		height_ = height;
+		skyline_ = std::move(skyline);
+		return true;
+	}
+
+	std::optional<uint32_t> skyline_packer::fit(size_t index, uint32_t width, uint32_t height) const
+	{
+		const auto x = skyline_[index].x;
+		if (x + width > width_)
+		{
+			return std::nullopt;
+		}
+
+		// The rect rests on the tallest node it spans
+		uint32_t y{};
+		uint32_t remaining = width;
+		for (size_t i{index}; remaining > 0; ++i)
+		{
+			y = std::max(y, skyline_[i].y);
+			if (y + height > height_)
+			{
+				return std::nullopt;
+			}
+			remaining -= std::min(remaining, skyline_[i].width);
+		}
+		return y;
+	}
+
+	std::optional<skyline_packer::rect> skyline_packer::insert(uint32_t width, uint32_t height)
+	{
+		size_t best_index{skyline_.size()};
+		uint32_t best_bottom{std::numeric_limits<uint32_t>::max()};
+		uint32_t best_width{std::numeric_limits<uint32_t>::max()};
+		uint32_t best_y{};
+
+		for (size_t i{}; i < skyline_.size(); ++i)
+		{
+			const auto y = fit(i, width, height);
+			if (!y)
+			{
+				continue;
+			}
+
+			const uint32_t bottom = *y + height;
+			if (bottom < best_bottom || (bottom == best_bottom && skyline_[i].width < best_width))
+			{
+				best_index = i;
+				best_bottom = bottom;
+				best_width = skyline_[i].width;
+				best_y = *y;
+			}
+		}
+
+		if (best_index == skyline_.size())
+		{
+			return std::nullopt;
+		}
+
+		const rect placed{.x = skyline_[best_index].x, .y = best_y, .width = width, .height = height};
+		skyline_.insert(skyline_.begin() + (ptrdiff_t)best_index, {.x = placed.x, .y = placed.y + height, .width = width});
+
+		// Trim or drop the nodes now covered by the new one
+		const uint32_t right = placed.x + width;
+		for (size_t i{best_index + 1}; i < skyline_.size();)
+		{
+			auto& covered = skyline_[i];
+			if (covered.x >= right)
+			{
+				break;
+			}
+
+			const uint32_t overlap = right - covered.x;
+			if (overlap < covered.width)
+			{
+				covered.x += overlap;
+				covered.width -= overlap;
+				break;
+			}
+			skyline_.erase(skyline_.begin() + (ptrdiff_t)i);
+		}
+
+		merge();
+		return placed;
+	}
+
+	void skyline_packer::merge()
+	{
+		for (size_t i{}; i + 1 < skyline_.size();)
+		{
+			if (skyline_[i].y == skyline_[i + 1].y)
+			{
+				skyline_[i].width += skyline_[i + 1].width;
+				skyline_.erase(skyline_.begin() + (ptrdiff_t)(i + 1));
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <pch.h>
+
+#include <optional>
+
+namespace egkr::container
+{
+	// Packs rectangles bottom-left first along a skyline of the tallest filled point in each column span.
+	// Inserts are incremental, space is only reclaimed by reset()
+	class skyline_packer
+	{
+	public:
+		struct rect
+		{
+			uint32_t x{};
+			uint32_t y{};
+			uint32_t width{};
+			uint32_t height{};
+		};
+
+		struct node
+		{
+			uint32_t x{};
+			uint32_t y{};
+			uint32_t width{};
+		};
+
+		skyline_packer() = default;
+		skyline_packer(uint32_t width, uint32_t height);
+
+		void reset(uint32_t width, uint32_t height);
+		// Keeps everything packed so far and extends the free space to the right and below
+		void grow(uint32_t width, uint32_t height);
+
+		[[nodiscard]] std::optional<rect> insert(uint32_t width, uint32_t height);
+
+		// Lets a packing be saved and picked up again later without repacking what it already holds
+		[[nodiscard]] const auto& get_skyline() const { return skyline_; }
+		bool restore(uint32_t width, uint32_t height, egkr::vector<node> skyline);
+
+		[[nodiscard]] const auto& get_width() const { return width_; }
+		[[nodiscard]] const auto& get_height() const { return height_; }
+
+	private:
+		[[nodiscard]] std::optional<uint32_t> fit(size_t index, uint32_t width, uint32_t height) const;
+		void merge();
+
+	private:
+		uint32_t width_{};
+		uint32_t height_{};
+		egkr::vector<node> skyline_;
+	};
+}
@@ -2,10 +2,39 @@
 #include "systems/console_system.h"
 #include "systems/input.h"
 
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/pattern_formatter.h>
+#include <spdlog/sinks/base_sink.h>
+
 namespace egkr
 {
 	static debug_console::unique_ptr state;
 
+	// Runs on the logging thread, the dist sink it is attached to already serialises calls
+	class console_log_sink : public spdlog::sinks::base_sink<spdlog::details::null_mutex>
+	{
+	public:
+		console_log_sink()
+		{
+			set_formatter_(std::make_unique<spdlog::pattern_formatter>("[%T] %v"));
+		}
+
+	protected:
+		void sink_it_(const spdlog::details::log_msg& msg) override
+		{
+			spdlog::memory_buf_t formatted{};
+			formatter_->format(msg, formatted);
+			std::string line{ formatted.data(), formatted.size() };
+			while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+			{
+				line.pop_back();
+			}
+			debug_console::consumer_write(nullptr, log_level::info, line);
+		}
+
+		void flush_() override {}
+	};
+
 	debug_console* debug_console::create()
 	{
 		if (state)
@@ -16,6 +45,9 @@ namespace egkr
 
 		state = std::make_unique<debug_console>();
 		console::register_consumer(nullptr, &debug_console::consumer_write);
+
+		state->log_sink_ = std::make_shared<console_log_sink>();
+		log::add_sink(state->log_sink_);
 		return state.get();
 	}
 
@@ -27,21 +59,8 @@ namespace egkr
 			return false;
 		}
 
-		if (message.contains('\n'))
-		{
-			std::istringstream ss{ message };
-			std::string line{};
-			while (std::getline(ss, line, '\n'))
-			{
-				state->lines_.push_back(line);
-			}
-		}
-		else
-		{
-			state->lines_.push_back(message);
-		}
-
-		state->is_dirty_ = true;
+		// A full ring drops the line, update() reports how many went missing
+		state->pending_.try_push(message);
 		return true;
 	}
 
@@ -73,6 +92,39 @@ namespace egkr
 			return;
 		}
 
+		std::string message{};
+		while (state->pending_.try_pop(message))
+		{
+			std::string_view remaining{ message };
+			while (!remaining.empty())
+			{
+				const auto end = remaining.find('\n');
+				state->lines_.emplace_back(remaining.substr(0, end));
+				if (state->lines_.size() > state->max_line_count_)
+				{
+					state->lines_.pop_front();
+				}
+
+				if (end == std::string_view::npos)
+				{
+					break;
+				}
+				remaining.remove_prefix(end + 1);
+			}
+			state->is_dirty_ = true;
+		}
+
+		if (const auto dropped = state->pending_.get_dropped(); dropped != state->reported_drops_)
+		{
+			state->lines_.emplace_back(std::format("[console] {} lines dropped", dropped - state->reported_drops_));
+			state->reported_drops_ = dropped;
+			if (state->lines_.size() > state->max_line_count_)
+			{
+				state->lines_.pop_front();
+			}
+			state->is_dirty_ = true;
+		}
+
 		if (state->is_dirty_)
 		{
 			const int32_t line_count = (int32_t)state->lines_.size();
@@ -105,6 +157,8 @@ namespace egkr
 	{
 		if (state)
 		{
+			// Once removed the logging thread can no longer reach the console
+			log::remove_sink(state->log_sink_);
 			state->text_control_.reset();
 			state->entry_control_.reset();
 			state.reset();
@@ -3,6 +3,9 @@
 #include "event.h"
 
 #include <resources/ui_text.h>
+#include <containers/mpsc_ring.h>
+
+#include <deque>
 
 namespace egkr
 {
@@ -13,6 +16,7 @@ namespace egkr
 		using unique_ptr = std::unique_ptr<debug_console>;
 		static debug_console* create();
 
+		// Safe from any thread, lines are queued and only reach the console on the next update()
 		static bool consumer_write(void* instance, log_level level, const std::string& message);
 
 		static bool load();
@@ -36,7 +40,12 @@ namespace egkr
 	private:
 		int32_t line_display_count_{ 10 };
 		int32_t line_offset_{};
-		egkr::vector<std::string> lines_{};
+		// Oldest lines are discarded once the history is full
+		uint32_t max_line_count_{ 1024 };
+		std::deque<std::string> lines_{};
+		container::mpsc_ring<std::string> pending_{ 1024 };
+		uint64_t reported_drops_{};
+		spdlog::sink_ptr log_sink_{};
 
 		text::ui_text::shared_ptr text_control_{};
 		text::ui_text::shared_ptr entry_control_{};
@@ -1,4 +1,5 @@
 #include "engine.h"
+#include "systems/input_recorder.h"
 
 using namespace std::chrono_literals;
 
@@ -27,6 +28,7 @@ namespace egkr
 	void engine::init()
 	{
 		egkr::log::init();
+		event::create();
 		const uint32_t start_x = 100;
 		const uint32_t start_y = 100;
 
@@ -47,12 +49,18 @@ namespace egkr
 
 		application_->set_engine(this);
 		system_manager::create(application_.get());
-
+		// Booting builds the render graph passes, whose shaders are created as parallel jobs
+		if (!system_manager::init_jobs())
+		{
+			LOG_FATAL("Failed to start the job system");
+		}
 
 		application_->boot();
 
 		system_manager::init();
 
+		limit_framerate_ = evar_system::create_bool("frame_limit", false);
+		frame_rate_limit_ = evar_system::create_int("frame_rate_limit", 60, 1, 1000);
 
 
 		if (!application_->init())
@@ -66,6 +74,9 @@ namespace egkr
 
 		is_running_ = true;
 		is_initialised_ = true;
+
+		const std::chrono::duration<double, std::milli> startup_time = platform_->get_time();
+		LOG_INFO("Engine startup took {:.2f}ms", startup_time.count());
 	}
 
 	void engine::run()
@@ -77,6 +88,8 @@ namespace egkr
 			engine_->frame_data_.delta_time = (float)delta.count();
 			engine_->frame_data_.total_time = (double)time.count();
 			engine_->platform_->pump();
+			input_recorder::begin_frame(engine_->frame_data_);
+			event::dispatch_posted();
 
 			if (!engine_->is_suspended_)
 			{
@@ -88,9 +101,10 @@ namespace egkr
 			}
 
 			auto frame_duration = engine_->platform_->get_time() - time;
-			if (engine_->limit_framerate_ && frame_duration < engine_->frame_time_)
+			const std::chrono::nanoseconds frame_time{ std::chrono::nanoseconds{ 1s } / engine_->frame_rate_limit_.get() };
+			if (engine_->limit_framerate_.get() && frame_duration < frame_time)
 			{
-				auto time_remaining = engine_->frame_time_ - frame_duration;
+				auto time_remaining = frame_time - frame_duration;
 				engine_->platform_->sleep(time_remaining);
 			}
 
@@ -110,6 +124,7 @@ namespace egkr
 		system_manager::shutdown();
 		engine_->get_renderer()->shutdown();
 		engine_->platform_->shutdown();
+		egkr::log::shutdown();
 	}
 
 	const frame_data& engine::get_frame_data()
@@ -6,6 +6,7 @@
 #include "event.h"
 #include "frame_data.h"
 #include "renderer/renderer_frontend.h"
+#include "systems/evar_system.h"
 
 
 namespace egkr
@@ -33,8 +34,8 @@ namespace egkr
 		bool is_initialised_{false};
 		std::chrono::nanoseconds last_time_{};
 
-	    bool limit_framerate_{false};
-		std::chrono::milliseconds frame_time_{16ms};
+		evar_handle<bool> limit_framerate_;
+		evar_handle<int32_t> frame_rate_limit_;
 
 		bool is_running_{};
 		bool is_suspended_{};
@@ -1,77 +1,224 @@
 #include "event.h"
 
+#include <containers/mpsc_ring.h>
+
+#include <unordered_map>
+
 namespace egkr
 {
 	struct registered_event
 	{
 		void* listener{};
-		event::callback callback;
+		// Cleared on unregister, the entry is erased once no dispatch is walking the list
+		event::callback callback{};
 
 		bool operator==(const registered_event& other) const
 		{
-			return listener == other.listener;
+			return listener == other.listener && callback == other.callback;
+		}
+	};
+
+	struct registered_event_hash
+	{
+		size_t operator()(const registered_event& event) const
+		{
+			return std::hash<void*>{}(event.listener) ^ (std::hash<event::callback>{}(event.callback) * 0x9E3779B97F4A7C15ULL);
 		}
 	};
 
 	struct event_code_entry
 	{
 		std::vector<registered_event> event;
+		// Where each live listener sits in event, so unregistering never searches the list
+		std::unordered_map<registered_event, size_t, registered_event_hash> slots;
+		uint32_t removed_count{};
+	};
+
+	struct posted_event
+	{
+		event::code code{};
+		void* sender{};
+		event::context context{};
 	};
 
+	constexpr static uint32_t posted_event_capacity{ 4096 };
+
 	struct event_system_state
 	{
 		std::array<event_code_entry, (size_t)event::code::event_code_size> events{};
+		uint32_t dispatch_depth{};
+
+		container::mpsc_ring<posted_event> posted{ posted_event_capacity };
+		uint64_t reported_drops{};
+		// Reused every frame, so draining the queue doesn't allocate once it has warmed up
+		egkr::vector<posted_event> pending{};
+		std::array<size_t, (size_t)event::code::event_code_size> last_pending{};
 	};
 
 	static bool is_initialsed{ false };
 	static event_system_state state{};
 
+	static bool is_coalescable(event::code code)
+	{
+		return code == event::code::mouse_move || code == event::code::mouse_drag_begin || code == event::code::mouse_drag;
+	}
+
+	static bool can_coalesce(const posted_event& pending, const posted_event& incoming)
+	{
+		if (pending.sender != incoming.sender)
+		{
+			return false;
+		}
+
+		if (incoming.code == event::code::mouse_move)
+		{
+			return true;
+		}
+
+		// Drags carry the button in slot 2, each button keeps its own latest position
+		int32_t pending_button{};
+		int32_t incoming_button{};
+		pending.context.get(2, pending_button);
+		incoming.context.get(2, incoming_button);
+		return pending_button == incoming_button;
+	}
+
+	// Erases the cleared entries once they are at least half the list, so each unregister costs O(1) amortised
+	static void compact(event_code_entry& entry)
+	{
+		if (entry.removed_count == 0 || (size_t)entry.removed_count * 2 < entry.event.size())
+		{
+			return;
+		}
+
+		std::erase_if(entry.event, [](const registered_event& event) { return event.callback == nullptr; });
+		entry.removed_count = 0;
+		for (size_t i{}; i < entry.event.size(); ++i)
+		{
+			entry.slots[entry.event[i]] = i;
+		}
+	}
+
 	void event::create()
 	{
 		if (!is_initialsed)
 		{
-			state = event_system_state{};
+			state.pending.reserve(posted_event_capacity);
+			is_initialsed = true;
 			return;
 		}
 
 		LOG_WARN("Already created the event system");
 	}
 
-	bool event::register_event(code code, void* listener, const callback& callback)
+	bool event::register_event(code code, void* listener, callback callback)
 	{
-		state.events[(size_t)code].event.emplace_back(listener, callback);
+		auto& entry = state.events.at((size_t)code);
+
+		const registered_event event{ listener, callback };
+		if (!entry.slots.try_emplace(event, entry.event.size()).second)
+		{
+			LOG_WARN("Listener already registered for this event");
+			return false;
+		}
+		entry.event.push_back(event);
 
 		return true;
 	}
-	bool event::unregister_event(code code, void* listener, const callback& callback)
+	bool event::unregister_event(code code, void* listener, callback callback)
 	{
-		auto& events = state.events.at((size_t)code).event;
-
-		auto event = registered_event{ listener, callback };
-		
-		auto removed_event = std::remove(events.begin(), events.end(), event);
+		auto& entry = state.events.at((size_t)code);
 
-		if (removed_event != events.end())
+		const auto slot = entry.slots.find(registered_event{ listener, callback });
+		if (slot == entry.slots.end())
 		{
-			LOG_INFO("Event unregistered");
-			return true;
+			LOG_ERROR("Attempted to remove event that wasn't registered");
+			return false;
 		}
 
-		LOG_ERROR("Attempted to remove event that wasn't registered");
-		return false;
+		entry.event[slot->second].callback = nullptr;
+		entry.slots.erase(slot);
+		++entry.removed_count;
+		if (state.dispatch_depth == 0)
+		{
+			compact(entry);
+		}
+		return true;
 	}
 	void event::fire_event(code code, void* sender, const context& context)
 	{
-		const auto& events = state.events.at((size_t)code).event;
+		auto& entry = state.events.at((size_t)code);
 
-		for (const auto& event : events)
+		++state.dispatch_depth;
+		// Indexed, a listener may register another while this is walking the list
+		for (size_t i{}; i < entry.event.size(); ++i)
 		{
-			auto result = event.callback(code, sender, event.listener, context);
+			const auto event = entry.event[i];
+			if (event.callback == nullptr)
+			{
+				continue;
+			}
 
-			if (result)
+			if (event.callback(code, sender, event.listener, context))
 			{
 				break;
 			}
 		}
+		--state.dispatch_depth;
+
+		if (state.dispatch_depth == 0)
+		{
+			compact(entry);
+		}
+	}
+
+	bool event::post(code code, void* sender, const context& context)
+	{
+		return state.posted.try_push({ .code = code, .sender = sender, .context = context });
+	}
+
+	void event::dispatch_posted()
+	{
+		ZoneScoped;
+
+		auto& pending = state.pending;
+		auto& last_pending = state.last_pending;
+		pending.clear();
+		last_pending.fill(std::numeric_limits<size_t>::max());
+
+		posted_event incoming{};
+		while (state.posted.try_pop(incoming))
+		{
+			if (is_coalescable(incoming.code))
+			{
+				// Only collapse into an entry nothing order-sensitive has been queued behind
+				const auto previous = last_pending[(size_t)incoming.code];
+				if (previous != std::numeric_limits<size_t>::max() && can_coalesce(pending[previous], incoming))
+				{
+					pending[previous] = incoming;
+					continue;
+				}
+
+				last_pending[(size_t)incoming.code] = pending.size();
+			}
+			else
+			{
+				last_pending.fill(std::numeric_limits<size_t>::max());
+			}
+
+			pending.push_back(incoming);
+		}
+
+		if (const auto dropped = state.posted.get_dropped(); dropped != state.reported_drops)
+		{
+			LOG_WARN("Event queue full, dropped {} events", dropped - state.reported_drops);
+			state.reported_drops = dropped;
+		}
+
+		// Events posted by listeners land in the queue and are delivered next frame
+		for (const auto& event : pending)
+		{
+			fire_event(event.code, event.sender, event.context);
+		}
 	}
 }
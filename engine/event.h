@@ -80,11 +80,18 @@ namespace egkr
 			ctx context_{};
 		};
 
-		using callback = std::function<bool(code, void*, void*, const context&)>;
+		// A plain function pointer so listeners can be compared and dispatch never touches the heap
+		using callback = bool(*)(code, void*, void*, const context&);
 
 		static void create();
-		static bool register_event(code code, void* listener, const callback& callback);
-		static bool unregister_event(code code, void* listener, const callback& callback);
+		static bool register_event(code code, void* listener, callback callback);
+		static bool unregister_event(code code, void* listener, callback callback);
 		static void fire_event(code code, void* sender, const context& context);
+
+		// Queues the event for the next dispatch_posted(), safe to call from any thread.
+		// Consecutive mouse_move, mouse_drag_begin and mouse_drag events are collapsed to the latest one
+		static bool post(code code, void* sender, const context& context);
+		// Delivers everything posted so far, called once a frame from the main thread
+		static void dispatch_posted();
 	};
 }
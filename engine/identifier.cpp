@@ -1,28 +1,118 @@
 #include "identifier.h"
 
+#include <atomic>
+
 namespace egkr
 {
-	static egkr::vector<void*> owners;
+	constexpr static uint32_t slots_per_chunk{ 4096 };
+	constexpr static uint32_t max_chunks{ (identifier::max_ids + slots_per_chunk - 1) / slots_per_chunk };
+	constexpr static uint32_t generation_mask{ 0xFF };
+	constexpr static uint32_t empty_free_list{ identifier::index_mask };
 
-	uint32_t identifier::acquire_unique_id(void* owner)
+	struct id_slot
+	{
+		std::atomic<void*> owner{};
+		std::atomic<uint32_t> generation{};
+		std::atomic<uint32_t> next_free{ empty_free_list };
+	};
+
+	struct id_chunk
+	{
+		std::array<id_slot, slots_per_chunk> slots{};
+	};
+
+	// Chunks are never moved or freed, so a slot can be read while another thread grows the table and
+	// objects released during static destruction still find their slot
+	struct id_table
+	{
+		std::array<std::atomic<id_chunk*>, max_chunks> chunks{};
+		std::atomic<uint32_t> next_unused_index{};
+		// Index of the first free slot in the low half, bumped tag in the high half so a pop can't be fooled by ABA
+		std::atomic<uint64_t> free_list_head{ empty_free_list };
+	};
+
+	static id_table table{};
+
+	static id_slot* find_slot(uint32_t index)
+	{
+		if (index >= identifier::max_ids)
+		{
+			return nullptr;
+		}
+
+		auto* chunk = table.chunks[index / slots_per_chunk].load(std::memory_order_acquire);
+		return chunk ? &chunk->slots[index % slots_per_chunk] : nullptr;
+	}
+
+	static id_slot& create_slot(uint32_t index)
+	{
+		auto& chunk = table.chunks[index / slots_per_chunk];
+		auto* existing = chunk.load(std::memory_order_acquire);
+		if (!existing)
+		{
+			// Several threads can race to create the same chunk, the loser frees its copy
+			auto* created = new id_chunk{};
+			if (chunk.compare_exchange_strong(existing, created, std::memory_order_acq_rel))
+			{
+				existing = created;
+			}
+			else
+			{
+				delete created;
+			}
+		}
+		return existing->slots[index % slots_per_chunk];
+	}
+
+	static uint64_t make_head(uint64_t previous, uint32_t index)
+	{
+		return (((previous >> 32) + 1) << 32) | index;
+	}
+
+	static uint32_t pop_free()
 	{
-		if (owners.empty())
+		uint64_t head = table.free_list_head.load(std::memory_order_acquire);
+		for (;;)
 		{
-			owners.reserve(100);
-			owners.push_back(nullptr);
+			const auto index = (uint32_t)head;
+			if (index == empty_free_list)
+			{
+				return empty_free_list;
+			}
+
+			const uint32_t next = find_slot(index)->next_free.load(std::memory_order_relaxed);
+			if (table.free_list_head.compare_exchange_weak(head, make_head(head, next), std::memory_order_acquire, std::memory_order_acquire))
+			{
+				return index;
+			}
 		}
+	}
+
+	static void push_free(id_slot& slot, uint32_t index)
+	{
+		uint64_t head = table.free_list_head.load(std::memory_order_relaxed);
+		do
+		{
+			slot.next_free.store((uint32_t)head, std::memory_order_relaxed);
+		} while (!table.free_list_head.compare_exchange_weak(head, make_head(head, index), std::memory_order_release, std::memory_order_relaxed));
+	}
 
-		for (auto i{ 0U }; i < owners.size(); ++i)
+	uint32_t identifier::acquire_unique_id(void* owner)
+	{
+		uint32_t index = pop_free();
+		if (index == empty_free_list)
 		{
-			if (owners[i] == nullptr)
+			index = table.next_unused_index.fetch_add(1, std::memory_order_relaxed);
+			if (index >= max_ids)
 			{
-				owners[i] = owner;
-				return i;
+				LOG_ERROR("Ran out of unique identifiers");
+				return invalid_32_id;
 			}
 		}
 
-		owners.push_back(owner);
-		return (uint32_t)owners.size() - 1;
+		auto& slot = create_slot(index);
+		slot.owner.store(owner, std::memory_order_release);
+		return ((slot.generation.load(std::memory_order_acquire) & generation_mask) << index_bits) | index;
 	}
 
 	void identifier::release_id(uint32_t id)
@@ -32,17 +122,114 @@ namespace egkr
 			return;
 		}
 
-		if (owners.empty())
+		auto* slot = find_slot(get_index(id));
+		if (!slot)
+		{
+			LOG_ERROR("Identifier exceeds registered amount");
+			return;
+		}
+
+		// Only one release of an id can win the bump, a second or stale release is reported and ignored
+		uint32_t generation = slot->generation.load(std::memory_order_acquire);
+		if ((generation & generation_mask) != get_generation(id) || !slot->generation.compare_exchange_strong(generation, generation + 1, std::memory_order_acq_rel))
 		{
-			LOG_ERROR("Cannot release identifier Identifier system has not been used");
+			LOG_ERROR("Attempted to release identifier {} that was already released", id);
 			return;
 		}
 
-		if (id > owners.size())
+		slot->owner.store(nullptr, std::memory_order_release);
+		push_free(*slot, get_index(id));
+	}
+
+	void* identifier::get_owner(uint32_t id)
+	{
+		if (id == invalid_32_id)
 		{
-			LOG_ERROR("Identifier exceeds registered amount");
-				return;
+			return nullptr;
+		}
+
+		auto* slot = find_slot(get_index(id));
+		if (!slot)
+		{
+			return nullptr;
+		}
+
+		// Generation checked either side of the read, so the owner returned belongs to this id
+		const uint32_t before = slot->generation.load(std::memory_order_acquire);
+		void* owner = slot->owner.load(std::memory_order_acquire);
+		const uint32_t after = slot->generation.load(std::memory_order_acquire);
+		if (before != after || (before & generation_mask) != get_generation(id))
+		{
+			return nullptr;
+		}
+		return owner;
+	}
+
+	// The allocator identifier replaced: owners in one array, acquire takes the first free slot it finds scanning from
+	// the front. Kept only as the benchmark's baseline
+	struct linear_scan_ids
+	{
+		egkr::vector<void*> owners{ nullptr };
+
+		uint32_t acquire(void* owner)
+		{
+			for (auto i{ 0U }; i < owners.size(); ++i)
+			{
+				if (owners[i] == nullptr)
+				{
+					owners[i] = owner;
+					return i;
+				}
+			}
+
+			owners.push_back(owner);
+			return (uint32_t)owners.size() - 1;
 		}
-		owners[id] = nullptr;
+
+		void release(uint32_t id) { owners[id] = nullptr; }
+	};
+
+	void identifier::benchmark_command(const console::context& /*context*/)
+	{
+		constexpr uint32_t live_count{100000};
+		constexpr uint32_t churn_count{10000};
+		using clock = std::chrono::high_resolution_clock;
+
+		egkr::vector<uint32_t> ids(live_count);
+		void* owner = &ids;
+
+		// Fills live_count ids, then releases and reacquires churn_count of them spread over the whole range. Returns the
+		// cost per acquire and per release and reacquire
+		const auto measure = [&ids](auto&& acquire, auto&& release)
+		{
+			auto start = clock::now();
+			for (auto& id : ids)
+			{
+				id = acquire();
+			}
+			const auto acquire_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / live_count;
+
+			start = clock::now();
+			for (uint32_t i{}; i < churn_count; ++i)
+			{
+				auto& id = ids[(i * 7919) % live_count];
+				release(id);
+				id = acquire();
+			}
+			const auto churn_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / churn_count;
+
+			for (const auto id : ids)
+			{
+				release(id);
+			}
+			return std::pair{ acquire_ns, churn_ns };
+		};
+
+		linear_scan_ids baseline{};
+		const auto [scan_acquire_ns, scan_churn_ns] = measure([&baseline, owner]() { return baseline.acquire(owner); }, [&baseline](uint32_t id) { baseline.release(id); });
+		const auto [acquire_ns, churn_ns] = measure([owner]() { return acquire_unique_id(owner); }, [](uint32_t id) { release_id(id); });
+
+		LOG_INFO("Identifier cost with {} live, linear scan vs generational: acquire {:.1f}ns vs {:.1f}ns, release and reacquire {:.1f}ns vs {:.1f}ns",
+			live_count, scan_acquire_ns, acquire_ns, scan_churn_ns, churn_ns);
 	}
 }
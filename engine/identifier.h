@@ -1,13 +1,32 @@
 #pragma once
 
 #include <pch.h>
+#include "systems/console_system.h"
 
 namespace egkr
 {
+	// Ids pack a slot index in the low 24 bits and the slot's generation in the high 8 bits.
+	// Releasing a slot bumps its generation, so an id held past its owner's lifetime stops resolving.
+	// Acquire, release and lookup are lock-free and safe from any thread
 	class identifier
 	{
 	public:
+		constexpr static uint32_t index_bits{ 24 };
+		constexpr static uint32_t index_mask{ (1u << index_bits) - 1 };
+		// The last index is never handed out so no id can equal invalid_32_id
+		constexpr static uint32_t max_ids{ index_mask };
+
 		static uint32_t acquire_unique_id(void* owner);
 		static void release_id(uint32_t id);
+
+		// Returns nullptr when the id was released, even if its slot has been reused since
+		[[nodiscard]] static void* get_owner(uint32_t id);
+		[[nodiscard]] static bool is_valid(uint32_t id) { return get_owner(id) != nullptr; }
+
+		[[nodiscard]] constexpr static uint32_t get_index(uint32_t id) { return id & index_mask; }
+		[[nodiscard]] constexpr static uint32_t get_generation(uint32_t id) { return id >> index_bits; }
+
+		// Times acquiring ids for many live objects, then releasing and reacquiring among them
+		static void benchmark_command(const console::context& context);
 	};
 }
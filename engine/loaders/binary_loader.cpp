@@ -1,6 +1,6 @@
 #include "binary_loader.h"
 
-#include "platform/filesystem.h"
+#include "platform/mapped_file.h"
 
 namespace egkr
 {
@@ -20,34 +20,56 @@ namespace egkr
 		const auto base_path = get_base_path();
 		const std::string filename = std::format("{}/{}", base_path, name);
 
-		auto handle = filesystem::open(filename, file_mode::read, true);
-		if (!handle.is_valid)
+		auto file = mapped_file::open(filename, mapped_file::access_hint::sequential);
+		if (!file.is_valid())
 		{
 			LOG_ERROR("Failed to open binary file: {}", filename);
 			return {};
 		}
 
-		auto line = filesystem::read_all(handle);
+		auto* binary_properties = new binary_resource_properties{};
+		binary_properties->data = file.bytes();
+		binary_properties->file = std::move(file);
+		return create_resource(name, filename, binary_properties);
+	}
+
+	egkr::vector<std::string> binary_loader::candidate_paths(const std::string& name, void* /*params*/) const
+	{
+		return {std::format("{}/{}", get_base_path(), name)};
+	}
+
+	resource::shared_ptr binary_loader::load_from_memory(const std::string& name, const std::string& full_path, std::span<const uint8_t> data, void* /*params*/)
+	{
+		auto* binary_properties = new binary_resource_properties{};
+		binary_properties->owned.assign(data.begin(), data.end());
+		binary_properties->data = binary_properties->owned;
+		return create_resource(name, full_path, binary_properties);
+	}
+
+	resource::shared_ptr binary_loader::load_from_buffer(const std::string& name, const std::string& full_path, egkr::vector<uint8_t> data, void* /*params*/)
+	{
+		auto* binary_properties = new binary_resource_properties{};
+		binary_properties->owned = std::move(data);
+		binary_properties->data = binary_properties->owned;
+		return create_resource(name, full_path, binary_properties);
+	}
 
+	resource::shared_ptr binary_loader::create_resource(const std::string& name, const std::string& full_path, binary_resource_properties* binary_properties)
+	{
 		resource::properties properties
 		{
-			.type = get_loader_type(),
+			.type = resource::type::binary,
 			.name = name.data(),
-			.full_path = name.data(),
-			.data = new(binary_resource_properties)
+			.full_path = full_path,
+			.data = binary_properties
 		};
 
-		binary_resource_properties binary_properties{ line };
-		*(binary_resource_properties*)properties.data = binary_properties;
-
 		return resource::create(properties);
 	}
 
 	bool binary_loader::unload(const resource::shared_ptr& resource)
 	{
-		auto* data = (binary_resource_properties*)resource->data;
-		data->data.clear();
-		delete data;
+		delete (binary_resource_properties*)resource->data;
 		return true;
 	}
 }
@@ -14,5 +14,12 @@ namespace egkr
 
 		resource::shared_ptr load(const std::string& name, void* params) override;
 		bool unload(const resource::shared_ptr& resource) override;
+
+		[[nodiscard]] egkr::vector<std::string> candidate_paths(const std::string& name, void* params) const override;
+		resource::shared_ptr load_from_memory(const std::string& name, const std::string& full_path, std::span<const uint8_t> data, void* params) override;
+		resource::shared_ptr load_from_buffer(const std::string& name, const std::string& full_path, egkr::vector<uint8_t> data, void* params) override;
+
+	private:
+		static resource::shared_ptr create_resource(const std::string& name, const std::string& full_path, binary_resource_properties* binary_properties);
 	};
 }
@@ -0,0 +1,57 @@
+#pragma once
+#include "pch.h"
+#include <span>
+
+namespace egkr
+{
+    // Walks a baked binary layout in memory, failing rather than reading past the end of a truncated file. Once a
+    // read fails every later read fails too, so a loader can check failed once at the end
+    class binary_reader
+    {
+    public:
+	explicit binary_reader(std::span<const uint8_t> data): data_{data} { }
+
+	template<class T>
+	void read(T* value, size_t count = 1)
+	{
+	    read_bytes(value, sizeof(T) * count);
+	}
+
+	void read_bytes(void* destination, size_t size)
+	{
+	    if (failed_ || size > data_.size() - position_)
+	    {
+		failed_ = true;
+		return;
+	    }
+	    memcpy(destination, data_.data() + position_, size);
+	    position_ += size;
+	}
+
+	std::string read_string()
+	{
+	    size_t length{};
+	    read(&length);
+	    if (length > remaining())
+	    {
+		failed_ = true;
+		return {};
+	    }
+
+	    std::string value(length, '\0');
+	    read_bytes(value.data(), length);
+	    return value;
+	}
+
+	// For checks the reader cannot make itself, such as a count too large for the data left
+	void fail() { failed_ = true; }
+
+	[[nodiscard]] size_t remaining() const { return failed_ ? 0 : data_.size() - position_; }
+	[[nodiscard]] bool failed() const { return failed_; }
+
+    private:
+	std::span<const uint8_t> data_;
+	size_t position_{};
+	bool failed_{};
+    };
+}
@@ -1,7 +1,7 @@
 #include "image_loader.h"
 
 #include "resources/texture.h"
-#include "platform/filesystem.h"
+#include "platform/mapped_file.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_NO_STDIO
@@ -15,41 +15,59 @@ namespace egkr
 
     resource::shared_ptr image_loader::load(const std::string& name, void* params)
     {
-	auto* parameters = std::bit_cast<image_resource_parameters*>(params);
-
-	auto base_path = get_base_path();
+	const auto filename = resolve_path(name, params);
+	if (!filename)
+	{
+	    LOG_ERROR("File not found: {}/{}", get_base_path(), name);
+	    return {};
+	}
 
-	stbi_set_flip_vertically_on_load(parameters->flip_y);
+	// Decoded straight out of the mapping
+	const auto file = mapped_file::open(*filename, mapped_file::access_hint::sequential);
+	if (!file.is_valid())
+	{
+	    return {};
+	}
+	return load_from_memory(name, *filename, file.bytes(), params);
+    }
 
-	std::string filename;
-	egkr::vector<std::string_view> extensions{".tga", ".png", ".jpg", ".bmp"};
+    egkr::vector<std::string> image_loader::candidate_paths(const std::string& name, void* /*params*/) const
+    {
+	constexpr std::array<std::string_view, 4> extensions{".tga", ".png", ".jpg", ".bmp"};
 
-	auto found{false};
+	egkr::vector<std::string> paths;
+	paths.reserve(extensions.size());
 	for (const auto& extension : extensions)
 	{
-	    filename = std::format("{}/{}{}", base_path, name, extension);
-
-	    if (filesystem::does_path_exist(filename))
-	    {
-		found = true;
-		break;
-	    }
+	    paths.push_back(std::format("{}/{}{}", get_base_path(), name, extension));
 	}
+	return paths;
+    }
 
-	if (!found)
-	{
-	    LOG_ERROR("File not found: {}", filename);
-	    return {};
-	}
+    resource::shared_ptr image_loader::load_from_memory(const std::string& name, const std::string& filename, std::span<const uint8_t> raw, void* params)
+    {
+	auto* parameters = std::bit_cast<image_resource_parameters*>(params);
 
-	auto file = filesystem::open(filename, file_mode::read, true);
-	auto raw = filesystem::read_all(file);
+	stbi_set_flip_vertically_on_load(parameters->flip_y);
 
 	int32_t width{};
 	int32_t height{};
 	int32_t channels{};
 	int32_t required_channels{4};
 
+	if (parameters->single_channel_16_bit)
+	{
+	    auto* samples = stbi_load_16_from_memory(raw.data(), (int32_t)raw.size(), &width, &height, &channels, 1);
+	    if (samples == nullptr)
+	    {
+		LOG_ERROR("Failed to load image {}, reason: {}", filename, stbi_failure_reason());
+		return nullptr;
+	    }
+
+	    auto* properties = new texture::properties{.name = name, .width = (uint32_t)width, .height = (uint32_t)height, .channel_count = 1, .data = samples};
+	    return resource::create({.type = resource::type::image, .name = name, .full_path = filename, .data = properties});
+	}
+
 	auto* image_data = stbi_load_from_memory(raw.data(), (int32_t)raw.size(), &width, &height, &channels, required_channels);
 
 	if (image_data != nullptr)
@@ -15,5 +15,9 @@ namespace egkr
 		//Params is a image_resource_parameters
 		resource::shared_ptr load(const std::string& name, void* params) override;
 		bool unload(const resource::shared_ptr& resource) override;
+
+		// Tries each supported extension in turn
+		[[nodiscard]] egkr::vector<std::string> candidate_paths(const std::string& name, void* params) const override;
+		resource::shared_ptr load_from_memory(const std::string& name, const std::string& full_path, std::span<const uint8_t> data, void* params) override;
 	};
 }
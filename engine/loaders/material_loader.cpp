@@ -1,8 +1,10 @@
 #include "material_loader.h"
 #include "systems/texture_system.h"
-#include "platform/filesystem.h"
+#include "platform/mapped_file.h"
 #include "parser.h"
 
+#include <mutex>
+
 namespace egkr
 {
     material_loader::unique_ptr material_loader::create(const loader_properties& properties) { return std::make_unique<material_loader>(properties); }
@@ -34,26 +36,29 @@ namespace egkr
 	return false;
     }
 
-    static enum class parse_mode : uint8_t { root, map, property } parse_mode;
+    // Per thread, materials are loaded in parallel when a scene preloads its dependencies
+    static thread_local enum class parse_mode : uint8_t { root, map, property } parse_mode;
 
-    static struct map
+    static thread_local struct map
     {
 	texture_map::properties map_properties;
 	std::string map_name;
 	std::string texture_name;
     } current_map;
 
-    static struct property
+    static thread_local struct property
     {
 	std::string name;
 	std::string value;
 	std::string type;
     } current_property;
 
-    const std::map<std::string, std::function<void(material::properties&, const std::string&)>> material_configuration_members = {
-        {"version", [](material::properties& /* config */, const std::string& /* value */) noexcept {}},
+    using material_member = void (*)(material::properties&, std::string_view);
+
+    constexpr auto material_configuration_members = parser::make_key_dispatch<material_member>({
+        {"version", [](material::properties& /* config */, std::string_view /* value */) noexcept {}},
         {"name",
-            [](material::properties& config, const std::string& value) noexcept
+            [](material::properties& config, std::string_view value) noexcept
             {
 	        if (parse_mode == parse_mode::root)
 	        {
@@ -64,23 +69,19 @@ namespace egkr
 	            current_map.map_name = value;
 	        }
             }},
-        {"type", [](material::properties& config, const std::string& value) noexcept { config.material_type = (value == "phong") ? material::type::phong : material::type::pbr; }},
-        {"diffuse_map_name", [](material::properties& config, const std::string& value) noexcept { config.texture_maps.emplace("diffuse", std::make_pair(value, texture_map::properties{})); }},
-        {"specular_map_name", [](material::properties& config, const std::string& value) noexcept { config.texture_maps.emplace("specular", std::make_pair(value, texture_map::properties{})); }},
-        {"normal_map_name", [](material::properties& config, const std::string& value) noexcept { config.texture_maps.emplace("normal", std::make_pair(value, texture_map::properties{})); }},
+        {"type", [](material::properties& config, std::string_view value) noexcept { config.material_type = (value == "phong") ? material::type::phong : material::type::pbr; }},
+        {"diffuse_map_name", [](material::properties& config, std::string_view value) noexcept { config.texture_maps.emplace("diffuse", std::make_pair(std::string{value}, texture_map::properties{})); }},
+        {"specular_map_name", [](material::properties& config, std::string_view value) noexcept { config.texture_maps.emplace("specular", std::make_pair(std::string{value}, texture_map::properties{})); }},
+        {"normal_map_name", [](material::properties& config, std::string_view value) noexcept { config.texture_maps.emplace("normal", std::make_pair(std::string{value}, texture_map::properties{})); }},
         {"diffuse_colour",
-            [](material::properties& config, const std::string& value) noexcept
+            [](material::properties& config, std::string_view value) noexcept
             {
-	        std::stringstream ss{value};
-	        float x, y, z, w;
-	        ss >> x >> y >> z >> w;
-
-	        config.diffuse_colour = {x, y, z, w};
+	        parser::parse_floats(value, &config.diffuse_colour.x, 4);
             }},
-        {"shader", [](material::properties& config, const std::string& value) noexcept { config.shader_name = value; }},
-        {"shininess", [](material::properties& config, const std::string& value) noexcept { config.shininess = std::stof(value); }},
+        {"shader", [](material::properties& config, std::string_view value) noexcept { config.shader_name = value; }},
+        {"shininess", [](material::properties& config, std::string_view value) noexcept { config.shininess = parser::parse_number<float>(value); }},
         {"[map]",
-            [](material::properties& /* config */, const std::string& /* value */) noexcept
+            [](material::properties& /* config */, std::string_view /* value */) noexcept
             {
 	        current_map = {};
 	        if (parse_mode == parse_mode::map)
@@ -90,7 +91,7 @@ namespace egkr
 	        parse_mode = parse_mode::map;
             }},
         {"[/map]",
-            [](material::properties& config, const std::string& /* value */) noexcept
+            [](material::properties& config, std::string_view /* value */) noexcept
             {
 	        parse_mode = parse_mode::root;
 
@@ -102,13 +103,13 @@ namespace egkr
 
 	        config.texture_maps.emplace(current_map.map_name, std::make_pair(current_map.texture_name, current_map.map_properties));
             }},
-        {"texture_name", [](material::properties& /* config */, const std::string& value) noexcept { current_map.texture_name = value; }},
+        {"texture_name", [](material::properties& /* config */, std::string_view value) noexcept { current_map.texture_name = value; }},
         {"filter_min",
-            [](material::properties& /* config */, const std::string& value) noexcept { current_map.map_properties.minify = (value == "linear") ? texture_map::filter::linear : texture_map::filter::nearest; }},
+            [](material::properties& /* config */, std::string_view value) noexcept { current_map.map_properties.minify = (value == "linear") ? texture_map::filter::linear : texture_map::filter::nearest; }},
         {"filter_mag",
-            [](material::properties& /* config */, const std::string& value) noexcept { current_map.map_properties.magnify = (value == "linear") ? texture_map::filter::linear : texture_map::filter::nearest; }},
+            [](material::properties& /* config */, std::string_view value) noexcept { current_map.map_properties.magnify = (value == "linear") ? texture_map::filter::linear : texture_map::filter::nearest; }},
         {"repeat_u",
-            [](material::properties& /* config */, const std::string& value) noexcept
+            [](material::properties& /* config */, std::string_view value) noexcept
             {
 	        if (value == "repeat")
 	        {
@@ -128,7 +129,7 @@ namespace egkr
 	        }
             }},
         {"repeat_v",
-            [](material::properties& /* config */, const std::string& value) noexcept
+            [](material::properties& /* config */, std::string_view value) noexcept
             {
 	        if (value == "repeat")
 	        {
@@ -148,7 +149,7 @@ namespace egkr
 	        }
             }},
         {"repeat_w",
-            [](material::properties& /* config */, const std::string& value) noexcept
+            [](material::properties& /* config */, std::string_view value) noexcept
             {
 	        if (value == "repeat")
 	        {
@@ -167,49 +168,52 @@ namespace egkr
 	            current_map.map_properties.repeat_w = texture_map::repeat::clamp_to_border;
 	        }
             }},
-    };
+    });
 
     static std::map<std::string, material::properties> loaded_materials;
+    static std::mutex loaded_materials_mutex;
 
     material::properties material_loader::load_configuration_file(std::string_view path)
     {
-	if (loaded_materials.contains(path.data()))
 	{
-	    return loaded_materials[path.data()];
+	    std::lock_guard lock{loaded_materials_mutex};
+	    if (auto found = loaded_materials.find(std::string{path}); found != loaded_materials.end())
+	    {
+		return found->second;
+	    }
 	}
 
-	material::properties properties{};
-
-	auto handle = filesystem::open(path, file_mode::read, false);
-	if (!handle.is_valid)
+	const auto file = mapped_file::open(path, mapped_file::access_hint::sequential);
+	if (!file.is_valid())
 	{
+	    material::properties properties{};
 	    properties.diffuse_colour = float4{1.F};
 	    return properties;
 	}
 
-	auto line = filesystem::read_line(handle, 511);
-	uint32_t line_number{};
-	for (; !line.empty(); line = filesystem::read_line(handle, 511), ++line_number)
-	{
-	    std::string line_string{line.begin(), line.end()};
-	    trim(line_string);
+	auto properties = parse_configuration(file.text());
 
-	    if (const auto& parse_result = parser::parse_line(line_string))
-	    {
-		const auto& [variable_name, value] = parse_result.value();
-		if (!material_configuration_members.contains(variable_name))
-		{
-		    LOG_WARN("Unrecognised material configuration argument: {}, with value {} on line", variable_name, value, line_number);
-		    continue;
-		}
-		material_configuration_members.at(variable_name)(properties, value);
-	    }
-	    else
+	std::lock_guard lock{loaded_materials_mutex};
+	loaded_materials.emplace(path, properties);
+	return properties;
+    }
+
+    material::properties material_loader::parse_configuration(std::string_view text)
+    {
+	material::properties properties{};
+	parse_mode = parse_mode::root;
+
+	parser::tokenizer tokenizer{text};
+	while (const auto token = tokenizer.next())
+	{
+	    const auto member = material_configuration_members.find(token->key);
+	    if (!member)
 	    {
+		LOG_WARN("Unrecognised material configuration argument: {}, with value {} on line {}", token->key, token->value, token->line_number);
 		continue;
 	    }
+	    member(properties, token->value);
 	}
-	loaded_materials.emplace(path, properties);
 	return properties;
     }
 }
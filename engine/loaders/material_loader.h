@@ -15,6 +15,9 @@ namespace egkr
 
 	resource::shared_ptr load(const std::string& name, void* params) override;
 	bool unload(const resource::shared_ptr& resource) override;
+
+	// Parses the contents of an .emt file, without the loaded material cache
+	static material::properties parse_configuration(std::string_view text);
     private:
 	static material::properties load_configuration_file(std::string_view path);
     };
@@ -1,6 +1,10 @@
 #include "mesh_loader.h"
 #include <filesystem>
 #include "systems/geometry_utils.h"
+#include "parser.h"
+#include "binary_reader.h"
+#include "systems/resource_system.h"
+#include "platform/mapped_file.h"
 
 namespace egkr
 {
@@ -15,24 +19,22 @@ namespace egkr
 	bool found{};
 	supported_file_type found_type{};
 	std::string filename;
+	mapped_file file{};
 	for (const auto& file_type : file_types)
 	{
 	    const auto base_path = get_base_path();
 	    filename = std::format("{}/{}{}", base_path, name, file_type.extension);
 
-	    auto handle = filesystem::open(filename, file_mode::read, file_type.is_binary);
-	    if (handle.is_valid)
+	    file = mapped_file::open(filename, mapped_file::access_hint::sequential);
+	    if (file.is_valid())
 	    {
 		found = true;
 		found_type = file_type;
 
 		break;
 	    }
-	    filesystem::close(handle);
 	}
 
-	auto handle = filesystem::open(filename, file_mode::read, found_type.is_binary);
-
 	if (!found)
 	{
 	    LOG_ERROR("Could not find mesh file: {}", name.data());
@@ -44,10 +46,10 @@ namespace egkr
 	switch (found_type.file_type)
 	{
 	case mesh_file_type::obj:
-	    resource_data = import_obj(handle, filename);
+	    resource_data = import_obj(file.text(), filename);
 	    break;
 	case mesh_file_type::esm:
-	    resource_data = load_esm(handle);
+	    resource_data = load_esm(file.bytes());
 	    break;
 	case mesh_file_type::not_found:
 	default:
@@ -65,6 +67,26 @@ namespace egkr
 	return resource::create(properties);
     }
 
+    egkr::vector<std::string> mesh_loader::candidate_paths(const std::string& name, void* /*params*/) const
+    {
+	// Only converted meshes, an obj is imported and written out as esm by load
+	return {std::format("{}/{}.esm", get_base_path(), name)};
+    }
+
+    resource::shared_ptr mesh_loader::load_from_memory(const std::string& name, const std::string& full_path, std::span<const uint8_t> data, void* /*params*/)
+    {
+	auto resource_data = load_esm(data);
+	if (resource_data.empty())
+	{
+	    LOG_ERROR("Failed to load mesh {}", full_path);
+	    return nullptr;
+	}
+
+	resource::properties properties{.type = resource::type::mesh, .name = name, .full_path = full_path};
+	properties.data = new egkr::vector<geometry::properties>(std::move(resource_data));
+	return resource::create(properties);
+    }
+
     bool mesh_loader::unload(const resource::shared_ptr& resource)
     {
 	auto* data = (egkr::vector<geometry::properties>*)resource->data;
@@ -77,7 +99,30 @@ namespace egkr
 	return false;
     }
 
-    egkr::vector<geometry::properties> mesh_loader::import_obj(file_handle& file_handle, std::string_view esm_filename)
+    // The argument of a "keyword argument" line
+    static std::string_view line_argument(std::string_view line)
+    {
+	parser::next_word(line);
+	return parser::next_word(line);
+    }
+
+    // Reads "v", "v/t", "v//n" or "v/t/n"
+    static void parse_face_vertex(std::string_view word, mesh_vertex_index_data& vertex)
+    {
+	std::array<uint32_t*, 3> indices{&vertex.position_index, &vertex.tex_index, &vertex.normal_index};
+	for (auto* index : indices)
+	{
+	    const auto slash = word.find('/');
+	    parser::try_parse_number(word.substr(0, slash), *index);
+	    if (slash == std::string_view::npos)
+	    {
+		break;
+	    }
+	    word.remove_prefix(slash + 1);
+	}
+    }
+
+    egkr::vector<geometry::properties> mesh_loader::import_obj(std::string_view text, std::string_view esm_filename)
     {
 	egkr::vector<geometry::properties> geometries{};
 
@@ -100,50 +145,37 @@ namespace egkr
 
 	std::array<char, 2> previous_first_chars{};
 
-	while (true)
+	parser::tokenizer tokenizer{text};
+	std::string_view line{};
+	while (tokenizer.next_line(line))
 	{
-	    auto line = filesystem::read_line(file_handle, 512);
-	    if (line.empty())
-	    {
-		break;
-	    }
-
-	    std::string line_string{line.begin(), line.end()};
-	    trim(line_string);
-
-
 	    uint8_t first_char = line[0];
 
 	    switch (first_char)
 	    {
-	    case '#':
-		continue;
 	    case 'v':
 	    {
-		auto second_char = line[1];
+		auto second_char = line.size() > 1 ? line[1] : '\0';
 		switch (second_char)
 		{
 		case ' ':
 		{
-		    char waste[2]{};
 		    float3 pos{};
-		    sscanf(line_string.data(), "%s %f %f %f", waste, &pos.x, &pos.y, &pos.z);
+		    parser::parse_floats(line.substr(2), &pos.x, 3);
 		    positions.push_back(pos);
 		}
 		break;
 		case 'n':
 		{
-		    char waste[3]{};
 		    float3 norm{};
-		    sscanf(line_string.data(), "%s %f %f %f", waste, &norm.x, &norm.y, &norm.z);
+		    parser::parse_floats(line.substr(2), &norm.x, 3);
 		    normals.push_back(norm);
 		}
 		break;
 		case 't':
 		{
-		    char waste[3]{};
 		    float2 tex{};
-		    sscanf(line_string.data(), "%s %f %f", waste, &tex.x, &tex.y);
+		    parser::parse_floats(line.substr(2), &tex.x, 2);
 		    tex_coords.push_back(tex);
 		}
 		break;
@@ -156,17 +188,11 @@ namespace egkr
 		break;
 	    case 'f':
 	    {
-		char waste[2]{};
 		mesh_face_data face{};
-		if (normals.empty() || tex_coords.empty())
+		auto remaining = line.substr(1);
+		for (auto& vertex : face.vertices)
 		{
-		    sscanf(line_string.data(), "%s %u %u %u", waste, &face.vertices[0].position_index, &face.vertices[1].position_index, &face.vertices[2].position_index);
-		}
-		else
-		{
-		    sscanf(line_string.data(), "%s %u/%u/%u %u/%u/%u %u/%u/%u", waste, &face.vertices[0].position_index, &face.vertices[0].tex_index, &face.vertices[0].normal_index,
-		        &face.vertices[1].position_index, &face.vertices[1].tex_index, &face.vertices[1].normal_index, &face.vertices[2].position_index, &face.vertices[2].tex_index,
-		        &face.vertices[2].normal_index);
+		    parse_face_vertex(parser::next_word(remaining), vertex);
 		}
 
 		auto group_index = groups.size() - 1;
@@ -175,10 +201,7 @@ namespace egkr
 	    break;
 	    case 'm':
 	    {
-		char waste[7]{};
-		char matname[128]{};
-		sscanf(line_string.data(), "%s %s", waste, matname);
-		material_filename = matname;
+		material_filename = line_argument(line);
 	    }
 	    break;
 	    case 'u':
@@ -187,10 +210,7 @@ namespace egkr
 		new_group.faces.reserve(16384);
 		groups.push_back(new_group);
 
-		char waste[8]{};
-		char material[128]{};
-		sscanf(line_string.data(), "%s %s", waste, material);
-		material_names[current_material_name_count] = material;
+		material_names[current_material_name_count] = line_argument(line);
 		current_material_name_count++;
 	    }
 	    break;
@@ -217,10 +237,7 @@ namespace egkr
 		}
 		current_material_name_count = 0;
 		groups.clear();
-		char waste[2]{};
-		char names[128]{};
-		sscanf(line_string.data(), "%s %s", waste, names);
-		name = names;
+		name = line_argument(line);
 	    }
 	    break;
 	    default:
@@ -373,36 +390,26 @@ namespace egkr
 
     bool mesh_loader::import_obj_material_library(std::string_view filepath)
     {
-	auto file = filesystem::open(filepath, file_mode::read, false);
+	const auto file = mapped_file::open(filepath, mapped_file::access_hint::sequential);
 	material::properties current_properties{};
 
 	bool hit_name{};
-	while (true)
+	parser::tokenizer tokenizer{file.text()};
+	std::string_view line{};
+	while (tokenizer.next_line(line))
 	{
-	    auto line = filesystem::read_line(file, 511);
-	    if (line.empty())
-	    {
-		break;
-	    }
-
-	    std::string line_string{line.begin(), line.end()};
-	    trim(line_string);
-
-	    auto first_char = line_string[0];
+	    auto first_char = line[0];
 	    switch (first_char)
 	    {
-	    case '#':
-		continue;
 	    case 'K':
 	    {
-		auto second_char{line_string[1]};
+		auto second_char{line.size() > 1 ? line[1] : '\0'};
 		switch (second_char)
 		{
 		case 'a':
 		case 'd':
 		{
-		    char waste[3]{};
-		    sscanf(line_string.data(), "%s %f %f %f", waste, &current_properties.diffuse_colour.r, &current_properties.diffuse_colour.g, &current_properties.diffuse_colour.b);
+		    parser::parse_floats(line.substr(2), &current_properties.diffuse_colour.r, 3);
 		    current_properties.diffuse_colour.a = 1.F;
 		}
 		break;
@@ -415,28 +422,25 @@ namespace egkr
 	    break;
 	    case 'N':
 	    {
-		char waste[3]{};
-		sscanf(line_string.data(), "%s %f", waste, &current_properties.shininess);
+		parser::try_parse_number(line_argument(line), current_properties.shininess);
 	    }
 	    break;
 	    case 'm':
 	    {
-		char map_type[10]{};
-		char texture_filename[128]{};
-		sscanf(line_string.data(), "%s %s", map_type, texture_filename);
-
-		std::filesystem::path path{texture_filename};
+		auto remaining = line;
+		const auto map_type = parser::next_word(remaining);
+		std::filesystem::path path{parser::next_word(remaining)};
 		path = path.stem();
 		path.replace_extension();
-		if (strncmp(map_type, "map_Kd", 7) == 0)
+		if (map_type == "map_Kd")
 		{
 		    current_properties.texture_maps.emplace("diffuse", std::make_pair(path.string(), texture_map::properties{}));
 		}
-		else if (strncmp(map_type, "map_Ks", 7) == 0)
+		else if (map_type == "map_Ks")
 		{
 		    current_properties.texture_maps.emplace("specular", std::make_pair(path.string(), texture_map::properties{}));
 		}
-		else if (strncmp(map_type, "map_bump", 9) == 0)
+		else if (map_type == "map_bump")
 		{
 		    current_properties.texture_maps.emplace("normal", std::make_pair(path.string(), texture_map::properties{}));
 		}
@@ -444,11 +448,7 @@ namespace egkr
 	    break;
 	    case 'b':
 	    {
-		char map_type[10]{};
-		char texture_filename[128]{};
-		sscanf(line_string.data(), "%s %s", map_type, texture_filename);
-
-		std::filesystem::path path{texture_filename};
+		std::filesystem::path path{line_argument(line)};
 		path = path.stem();
 		path.replace_extension();
 		// current_properties.normal_map_name = path.string();
@@ -457,9 +457,7 @@ namespace egkr
 	    break;
 	    case 'n':
 	    {
-		char waste[7]{};
-		char material_name[128]{};
-		sscanf(line_string.data(), "%s %s", waste, material_name);
+		const auto material_name = line_argument(line);
 
 		current_properties.shader_name = "Shader.Material";
 		if (std::abs(current_properties.shininess) <= 0.001f)
@@ -499,57 +497,58 @@ namespace egkr
 	return true;
     }
 
-    egkr::vector<geometry::properties> mesh_loader::load_esm(file_handle& file_handle)
+    egkr::vector<geometry::properties> mesh_loader::load_esm(std::span<const uint8_t> data)
     {
-	if (!file_handle.is_valid)
-	{
-	    LOG_ERROR("Invalid file handle used");
-	    return {};
-	}
+	binary_reader reader{data};
 
 	size_t property_count{};
-	filesystem::read(file_handle, &property_count, 1);
+	reader.read(&property_count);
 
 	egkr::vector<geometry::properties> geoms;
-	for (auto i{0U}; i < property_count; ++i)
+	for (auto i{0U}; i < property_count && !reader.failed(); ++i)
 	{
 	    geometry::properties property{};
 
-	    size_t name_length{};
-	    filesystem::read(file_handle, &name_length, 1);
+	    property.name = reader.read_string();
+	    property.material_name = reader.read_string();
 
-	    property.name.resize(name_length);
-	    filesystem::read(file_handle, property.name.data(), name_length);
+	    reader.read(&property.vertex_count);
+	    reader.read(&property.vertex_size);
 
-	    //property.name = std::string(name);
-
-	    size_t material_name_length{};
-	    filesystem::read(file_handle, &material_name_length, 1);
-
-	    property.material_name.resize(material_name_length);
-	    filesystem::read(file_handle, property.material_name.data(), material_name_length);
-
-	    filesystem::read(file_handle, &property.vertex_count, 1);
-	    filesystem::read(file_handle, &property.vertex_size, 1);
-
-	    auto size = property.vertex_count * property.vertex_size;
+	    const size_t size = (size_t)property.vertex_count * property.vertex_size;
+	    if (size > reader.remaining())
+	    {
+		break;
+	    }
 	    property.vertices = malloc(size);
-
-	    filesystem::read(file_handle, property.vertices, property.vertex_size, property.vertex_count);
-	    //std::copy((uint8_t*)property.vertices, (uint8_t*)property.vertices + size, verts.data());
+	    reader.read_bytes(property.vertices, size);
 
 	    size_t index_count{};
-	    filesystem::read(file_handle, &index_count, 1);
+	    reader.read(&index_count);
+	    if (index_count > reader.remaining() / sizeof(uint32_t))
+	    {
+		free(property.vertices);
+		break;
+	    }
 
 	    property.indices.resize(index_count);
-	    filesystem::read(file_handle, property.indices.data(), index_count);
+	    reader.read(property.indices.data(), index_count);
 
-	    filesystem::read(file_handle, &property.center, 1);
-	    filesystem::read(file_handle, &property.extents.min, 1);
-	    filesystem::read(file_handle, &property.extents.max, 1);
+	    reader.read(&property.center);
+	    reader.read(&property.extents.min);
+	    reader.read(&property.extents.max);
 	    geoms.push_back(property);
 	}
 
+	if (reader.failed() || geoms.size() != property_count)
+	{
+	    LOG_ERROR("Truncated or corrupt esm file");
+	    for (auto& geometry : geoms)
+	    {
+		free(geometry.vertices);
+	    }
+	    return {};
+	}
 	return geoms;
     }
 
@@ -725,4 +724,74 @@ namespace egkr
 
 	return true;
     }
+
+    // Reads a mesh's esm, sponza by default in the sandbox, into a buffer and through a mapping, then times whole loads
+    void mesh_loader::file_read_benchmark_command(const console::context& context)
+    {
+	if (context.arguments.size() != 1)
+	{
+	    LOG_ERROR("Invalid number of arguments for file_read_benchmark. Got {}, expected 1", context.arguments.size());
+	    return;
+	}
+
+	constexpr uint32_t iterations{10};
+	using clock = std::chrono::high_resolution_clock;
+	const auto& mesh_name = context.arguments[0].value;
+	const auto resolved = resource_system::resolve_path(mesh_name, resource::type::mesh, nullptr);
+	if (!resolved)
+	{
+	    LOG_ERROR("No converted mesh {} to read, load it once to write its esm", mesh_name);
+	    return;
+	}
+	const auto& filename = *resolved;
+
+	// Touching every byte makes the mapping pay for its page faults, as a loader would
+	const auto checksum = [](std::span<const uint8_t> bytes)
+	{
+	    uint64_t sum{};
+	    for (const auto byte : bytes)
+	    {
+		sum += byte;
+	    }
+	    return sum;
+	};
+
+	size_t size{};
+	uint64_t read_sum{};
+	auto start = clock::now();
+	for (uint32_t i{}; i < iterations; ++i)
+	{
+	    auto handle = filesystem::open(filename, file_mode::read, true);
+	    const auto data = filesystem::read_all(handle);
+	    size = data.size();
+	    read_sum += checksum(data);
+	}
+	const auto read_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / iterations;
+
+	uint64_t mapped_sum{};
+	start = clock::now();
+	for (uint32_t i{}; i < iterations; ++i)
+	{
+	    const auto file = mapped_file::open(filename, mapped_file::access_hint::sequential);
+	    mapped_sum += checksum(file.bytes());
+	}
+	const auto mapped_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / iterations;
+
+	start = clock::now();
+	for (uint32_t i{}; i < iterations; ++i)
+	{
+	    if (auto mesh = resource_system::load(mesh_name, resource::type::mesh, nullptr))
+	    {
+		resource_system::unload(mesh);
+	    }
+	}
+	const auto load_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / iterations;
+
+	LOG_INFO("Reading {} ({:.1f}MB, warm cache): read_all {:.2f}ms, mapped {:.2f}ms, full mesh load {:.2f}ms", filename, (double)size / (1024.0 * 1024.0), read_ms, mapped_ms,
+	    load_ms);
+	if (read_sum != mapped_sum)
+	{
+	    LOG_WARN("Mapped and read bytes differ");
+	}
+    }
 }
@@ -5,6 +5,7 @@
 #include "resources/geometry.h"
 
 #include "platform/filesystem.h"
+#include "systems/console_system.h"
 
 namespace egkr
 {
@@ -50,12 +51,18 @@ namespace egkr
 
 	resource::shared_ptr load(const std::string& name, void* params) override;
 	bool unload(const resource::shared_ptr& resource) override;
+
+	[[nodiscard]] egkr::vector<std::string> candidate_paths(const std::string& name, void* params) const override;
+	resource::shared_ptr load_from_memory(const std::string& name, const std::string& full_path, std::span<const uint8_t> data, void* params) override;
+
+	// Compares read_all, a mapping and a full load of a converted mesh, file_read_benchmark <name>
+	static void file_read_benchmark_command(const console::context& context);
     private:
-	egkr::vector<geometry::properties> import_obj(file_handle& file_handle, std::string_view esm_filename);
+	egkr::vector<geometry::properties> import_obj(std::string_view text, std::string_view esm_filename);
 	geometry::properties process_subobject(egkr::vector<float3>& positions, const egkr::vector<float3>& normals, const egkr::vector<float2>& tex, egkr::vector<mesh_face_data> faces);
 	bool import_obj_material_library(std::string_view filepath);
 
-	egkr::vector<geometry::properties> load_esm(file_handle& file_handle);
+	egkr::vector<geometry::properties> load_esm(std::span<const uint8_t> data);
 	bool write_esm(std::string_view path, const egkr::vector<geometry::properties>& properties);
 	bool write_emt(std::string_view directory, const material::properties& properties);
     };
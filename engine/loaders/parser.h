@@ -1,37 +1,228 @@
+#pragma once
 #include "pch.h"
 #include <optional>
-#include <algorithm>
+#include <charconv>
+#include <bit>
 
 namespace egkr::parser
 {
-    static std::optional<std::pair<std::string, std::string>> parse_line(const std::string& line, char separator = '=', const std::string& continue_chars = "#\n")
+    constexpr bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f' || c == '\0'; }
+
+    constexpr std::string_view trim_view(std::string_view text)
     {
-	std::string l = line;
-	trim(l);
+	while (!text.empty() && is_space(text.front()))
+	{
+	    text.remove_prefix(1);
+	}
+	while (!text.empty() && is_space(text.back()))
+	{
+	    text.remove_suffix(1);
+	}
+	return text;
+    }
 
-	if (l.empty() || l == "" || l[0] == '\0')
+    // Splits the first whitespace separated word off text
+    constexpr std::string_view next_word(std::string_view& text)
+    {
+	text = trim_view(text);
+	size_t end{};
+	while (end < text.size() && !is_space(text[end]))
 	{
-	    return {};
+	    ++end;
 	}
+	const auto word = text.substr(0, end);
+	text.remove_prefix(end);
+	return word;
+    }
 
-	if (std::ranges::any_of(continue_chars, [&](char continue_char) { return l[0] == continue_char; }))
+    // Parses a leading number from text, leaving value untouched and returning false when there isn't one
+    template<class T>
+    bool try_parse_number(std::string_view text, T& value)
+    {
+	text = trim_view(text);
+	if (!text.empty() && text.front() == '+')
 	{
-	    return {};
+	    text.remove_prefix(1);
 	}
+	const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == std::errc{};
+    }
+
+    template<class T>
+    T parse_number(std::string_view text, T fallback = {})
+    {
+	T value{fallback};
+	try_parse_number(text, value);
+	return value;
+    }
 
-	const auto split_index = l.find_first_of(separator);
-	if (split_index == std::string::npos)
+    // Reads up to count whitespace or comma separated floats into values, returning how many were read
+    inline size_t parse_floats(std::string_view text, float* values, size_t count)
+    {
+	size_t read{};
+	const char* first = text.data();
+	const char* last = text.data() + text.size();
+	while (read < count)
 	{
-	    LOG_ERROR("Potential formatting issue, {}", line);
-	    return {{line, ""}};
+	    while (first != last && (is_space(*first) || *first == ',' || *first == '+'))
+	    {
+		++first;
+	    }
+	    const auto result = std::from_chars(first, last, values[read]);
+	    if (result.ec != std::errc{})
+	    {
+		break;
+	    }
+	    first = result.ptr;
+	    ++read;
 	}
+	return read;
+    }
+
+    struct token
+    {
+	std::string_view key;
+	std::string_view value;
+	uint32_t line_number{};
+    };
+
+    // Walks a whole file held in memory, yielding trimmed views into it so nothing is copied per line. Blank and
+    // comment lines are skipped. A line without the separator, such as a [section] tag, is returned as a key with no value
+    class tokenizer
+    {
+    public:
+	explicit tokenizer(std::string_view text, char separator = '=', char comment = '#')
+	    : text_{text}, separator_{separator}, comment_{comment}
+	{ }
 
-	auto variable_name = l.substr(0, split_index);
-	trim(variable_name);
+	explicit tokenizer(const egkr::vector<uint8_t>& buffer, char separator = '=', char comment = '#')
+	    : tokenizer{std::string_view{(const char*)buffer.data(), buffer.size()}, separator, comment}
+	{ }
 
-	auto value = l.substr(split_index + 1);
-	trim(value);
+	bool next_line(std::string_view& line)
+	{
+	    while (position_ < text_.size())
+	    {
+		auto end = text_.find('\n', position_);
+		if (end == std::string_view::npos)
+		{
+		    end = text_.size();
+		}
+		line = trim_view(text_.substr(position_, end - position_));
+		position_ = end + 1;
+		++line_number_;
+
+		if (!line.empty() && line.front() != comment_)
+		{
+		    return true;
+		}
+	    }
+	    return false;
+	}
 
-	return {{variable_name, value}};
+	std::optional<token> next()
+	{
+	    std::string_view line{};
+	    if (!next_line(line))
+	    {
+		return {};
+	    }
+
+	    const auto split_index = line.find(separator_);
+	    if (split_index == std::string_view::npos)
+	    {
+		if (line.front() != '[')
+		{
+		    LOG_WARN("Potential formatting issue on line {}: '{}' token not found in {}", line_number_, separator_, line);
+		}
+		return token{.key = line, .value = {}, .line_number = line_number_};
+	    }
+	    return token{.key = trim_view(line.substr(0, split_index)), .value = trim_view(line.substr(split_index + 1)), .line_number = line_number_};
+	}
+
+	[[nodiscard]] uint32_t line_number() const { return line_number_; }
+
+    private:
+	std::string_view text_{};
+	size_t position_{};
+	uint32_t line_number_{};
+	char separator_{'='};
+	char comment_{'#'};
+    };
+
+    constexpr uint64_t hash_key(std::string_view key, uint64_t seed = 14695981039346656037ULL)
+    {
+	uint64_t hash{seed};
+	for (const char c : key)
+	{
+	    hash ^= (uint8_t)c;
+	    hash *= 1099511628211ULL;
+	}
+	return hash;
+    }
+
+    // Maps a fixed set of keys to handlers with a perfect hash found at compile time. Every key owns its slot, so a
+    // lookup is one hash and one string compare, which also rejects unknown keys
+    template<class Handler, size_t N>
+    class key_dispatch
+    {
+    public:
+	consteval explicit key_dispatch(const std::pair<std::string_view, Handler> (&entries)[N])
+	{
+	    std::array<uint64_t, N> hashes{};
+	    for (size_t i{}; i < N; ++i)
+	    {
+		hashes[i] = hash_key(entries[i].first);
+	    }
+
+	    for (uint64_t attempt{1}; attempt < 65536; ++attempt)
+	    {
+		seed_ = attempt;
+		slots_ = {};
+
+		bool collided{};
+		for (size_t i{}; i < N && !collided; ++i)
+		{
+		    auto& slot = slots_[slot_index(hashes[i])];
+		    collided = slot.handler != nullptr;
+		    slot = {entries[i].first, entries[i].second};
+		}
+
+		if (!collided)
+		{
+		    return;
+		}
+	    }
+	    throw "No perfect hash seed found, duplicate key?";
+	}
+
+	[[nodiscard]] constexpr Handler find(std::string_view key) const
+	{
+	    const auto& slot = slots_[slot_index(hash_key(key))];
+	    return slot.key == key ? slot.handler : nullptr;
+	}
+
+    private:
+	// Half full at most so a seed turns up in a few attempts
+	static constexpr size_t table_size{std::bit_ceil(N * 2)};
+	static constexpr int table_shift{64 - std::countr_zero(table_size)};
+
+	// Multiplicative hashing takes the well mixed high bits, FNV-1a's low bits only see the low bits of each character
+	[[nodiscard]] constexpr size_t slot_index(uint64_t hash) const { return (size_t)(((hash ^ seed_) * 0x9E3779B97F4A7C15ULL) >> table_shift); }
+
+	struct slot
+	{
+	    std::string_view key{};
+	    Handler handler{};
+	};
+
+	std::array<slot, table_size> slots_{};
+	uint64_t seed_{};
+    };
+
+    template<class Handler, size_t N>
+    consteval key_dispatch<Handler, N> make_key_dispatch(const std::pair<std::string_view, Handler> (&entries)[N])
+    {
+	return key_dispatch<Handler, N>{entries};
     }
 }
@@ -1,5 +1,7 @@
 #include "resource_loader.h"
 
+#include "platform/filesystem.h"
+
 namespace egkr
 {
 	resource_loader::resource_loader(resource::type type, const loader_properties& properties)
@@ -10,4 +12,16 @@ namespace egkr
 			custom_type_name_ = *properties.custom_type;
 		}
 	}
+
+	std::optional<std::string> resource_loader::resolve_path(const std::string& name, void* params) const
+	{
+		for (auto& path : candidate_paths(name, params))
+		{
+			if (filesystem::does_path_exist(path))
+			{
+				return std::move(path);
+			}
+		}
+		return {};
+	}
 }
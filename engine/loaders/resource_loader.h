@@ -1,6 +1,7 @@
 #pragma once
 
 #include "resources/resource.h"
+#include <span>
 
 namespace egkr
 {
@@ -22,6 +23,20 @@ namespace egkr
 		virtual resource::shared_ptr load(const std::string& name, void* params) = 0;
 		virtual bool unload(const resource::shared_ptr& resource) = 0;
 
+		// Where load would look for name, in the order it tries them, for loaders that can build a resource from bytes
+		// read elsewhere. Only formats the paths, so it is cheap to call on the main thread. Empty when the loader
+		// does its own reading
+		[[nodiscard]] virtual egkr::vector<std::string> candidate_paths(const std::string& /*name*/, void* /*params*/) const { return {}; }
+		// The first candidate path that exists. Checks the disk for each one, so keep it off the main thread
+		[[nodiscard]] std::optional<std::string> resolve_path(const std::string& name, void* params) const;
+		// Builds the resource from the whole of one of the files named by candidate_paths
+		virtual resource::shared_ptr load_from_memory(const std::string& name, const std::string& /*full_path*/, std::span<const uint8_t> /*data*/, void* params) { return load(name, params); }
+		// As load_from_memory, for a buffer the caller is done with. A loader that keeps the bytes takes it instead of copying
+		virtual resource::shared_ptr load_from_buffer(const std::string& name, const std::string& full_path, egkr::vector<uint8_t> data, void* params)
+		{
+			return load_from_memory(name, full_path, data, params);
+		}
+
 		[[nodiscard]] const auto& get_loader_type() const { return loader_type_; }
 
 	protected:
@@ -2,12 +2,27 @@
 #include "scene_loader.h"
 
 #include "platform/filesystem.h"
+#include "platform/mapped_file.h"
+#include "resources/material.h"
+#include "material_loader.h"
 #include "scenes/simple_scene.h"
-#include <map>
+#include "systems/resource_system.h"
+#include "parser.h"
+#include "binary_reader.h"
+
+#include <filesystem>
 
 namespace egkr
 {
-    [[nodiscard]] scene::configuration load_configuration_file(file_handle& handle);
+    [[nodiscard]] static bool is_bake_current(const std::string& baked_filename, std::span<const std::string> source_files);
+    [[nodiscard]] static bool read_baked(const std::string& baked_filename, scene::configuration& configuration);
+    static bool write_baked(const std::string& baked_filename, const scene::configuration& configuration, std::span<const std::string> source_files);
+    // Also appends the path of every mesh and material file it reads to source_files
+    [[nodiscard]] static scene::dependency_graph resolve_dependencies(const scene::configuration& configuration, egkr::vector<std::string>& source_files);
+
+    // "ESB1" followed by a format version, bumped whenever the layout below changes
+    constexpr uint32_t baked_scene_magic{0x31425345};
+    constexpr uint32_t baked_scene_version{2};
 
     enum class parse_mode : uint8_t
     {
@@ -24,19 +39,28 @@ namespace egkr
 
     scene_loader::scene_loader(const loader_properties& properties): resource_loader(resource::type::scene, properties) { }
 
-    resource::shared_ptr scene_loader::load(const std::string& name, void* /*params*/)
+    resource::shared_ptr scene_loader::load(const std::string& name, void* params)
     {
 	const auto base_path = get_base_path();
 	const std::string filename = std::format("{}/{}", base_path, name);
+	const auto baked_filename = std::filesystem::path{filename}.replace_extension(".esb").string();
+	const bool rebake = params && ((parameters*)params)->rebake;
 
-	auto handle = filesystem::open(filename, file_mode::read, false);
-	if (!handle.is_valid)
+	scene::configuration scene_configuration{};
+	if (rebake || !read_baked(baked_filename, scene_configuration))
 	{
-	    LOG_ERROR("Failed to load scene {}", name.data());
-	    return nullptr;
-	}
+	    const auto file = mapped_file::open(filename, mapped_file::access_hint::sequential);
+	    if (!file.is_valid())
+	    {
+		LOG_ERROR("Failed to load scene {}", name.data());
+		return nullptr;
+	    }
 
-	const auto scene_configuration = load_configuration_file(handle);
+	    scene_configuration = parse_configuration(file.text());
+	    egkr::vector<std::string> source_files{filename};
+	    scene_configuration.dependencies = resolve_dependencies(scene_configuration, source_files);
+	    write_baked(baked_filename, scene_configuration, source_files);
+	}
 
 	resource::properties properties{
 	    .type = resource::type::scene,
@@ -62,23 +86,26 @@ namespace egkr
     static scene::terrain_scene_configuration current_terrain{};
     static scene::point_light_scene_configuration current_point_light{};
 
-    const std::map<std::string, std::function<void(scene::configuration&, const std::string&)>> scene_configuration_members = {{"!version",
-                                                                                                                                   [](scene::configuration& config, const std::string& value)
-                                                                                                                                   {
-	                                                                                                                               if (mode != parse_mode::root)
-	                                                                                                                               {
-	                                                                                                                                   LOG_ERROR("Attempting to parse version in non-root parsing mode");
-	                                                                                                                                   return;
-	                                                                                                                               }
-	                                                                                                                               config.version = std::stoi(value);
-
-	                                                                                                                               if (config.version != 1)
-	                                                                                                                               {
-	                                                                                                                                   LOG_WARN("Scene version exceeds known version number");
-	                                                                                                                               }
-                                                                                                                                   }},
+    using scene_member = void (*)(scene::configuration&, std::string_view);
+
+    constexpr auto scene_configuration_members = parser::make_key_dispatch<scene_member>({
+        {"!version",
+            [](scene::configuration& config, std::string_view value)
+            {
+	        if (mode != parse_mode::root)
+	        {
+	            LOG_ERROR("Attempting to parse version in non-root parsing mode");
+	            return;
+	        }
+	        config.version = parser::parse_number<int32_t>(value);
+
+	        if (config.version != 1)
+	        {
+	            LOG_WARN("Scene version exceeds known version number");
+	        }
+            }},
         {"[Scene]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::root)
 	        {
@@ -88,7 +115,7 @@ namespace egkr
 	        mode = parse_mode::scene;
             }},
         {"[/Scene]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::scene)
 	        {
@@ -98,7 +125,7 @@ namespace egkr
 	        mode = parse_mode::root;
             }},
         {"[DirectionalLight]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::root)
 	        {
@@ -108,7 +135,7 @@ namespace egkr
 	        mode = parse_mode::directional_light;
             }},
         {"[/DirectionalLight]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::directional_light)
 	        {
@@ -118,7 +145,7 @@ namespace egkr
 	        mode = parse_mode::root;
             }},
         {"[Skybox]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::root)
 	        {
@@ -128,7 +155,7 @@ namespace egkr
 	        mode = parse_mode::skybox;
             }},
         {"[/Skybox]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::skybox)
 	        {
@@ -138,7 +165,7 @@ namespace egkr
 	        mode = parse_mode::root;
             }},
         {"[PointLight]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::root)
 	        {
@@ -149,7 +176,7 @@ namespace egkr
 	        current_point_light = {};
             }},
         {"[/PointLight]",
-            [](scene::configuration& config, const std::string& /* value */)
+            [](scene::configuration& config, std::string_view /* value */)
             {
 	        if (mode != parse_mode::point_light)
 	        {
@@ -160,7 +187,7 @@ namespace egkr
 	        config.point_lights.push_back(current_point_light);
             }},
         {"[Mesh]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::root)
 	        {
@@ -171,7 +198,7 @@ namespace egkr
 	        current_mesh = {};
             }},
         {"[/Mesh]",
-            [](scene::configuration& config, const std::string& /* value */)
+            [](scene::configuration& config, std::string_view /* value */)
             {
 	        if (mode != parse_mode::mesh)
 	        {
@@ -182,7 +209,7 @@ namespace egkr
 	        config.meshes.push_back(current_mesh);
             }},
         {"[Terrain]",
-            [](scene::configuration& /* config */, const std::string& /* value */)
+            [](scene::configuration& /* config */, std::string_view /* value */)
             {
 	        if (mode != parse_mode::root)
 	        {
@@ -193,7 +220,7 @@ namespace egkr
 	        current_terrain = {};
             }},
         {"[/Terrain]",
-            [](scene::configuration& config, const std::string& /* value */)
+            [](scene::configuration& config, std::string_view /* value */)
             {
 	        if (mode != parse_mode::terrain)
 	        {
@@ -204,7 +231,7 @@ namespace egkr
 	        config.terrains.push_back(current_terrain);
             }},
         {"name",
-            [](scene::configuration& configuration, const std::string& value)
+            [](scene::configuration& configuration, std::string_view value)
             {
 	        switch (mode)
 	        {
@@ -232,7 +259,7 @@ namespace egkr
 	        }
             }},
         {"description",
-            [](scene::configuration& configuration, const std::string& value)
+            [](scene::configuration& configuration, std::string_view value)
             {
 	        switch (mode)
 	        {
@@ -244,7 +271,7 @@ namespace egkr
 	        }
             }},
         {"resource_name",
-            [](scene::configuration& configuration, const std::string& value)
+            [](scene::configuration& configuration, std::string_view value)
             {
 	        switch (mode)
 	        {
@@ -262,11 +289,10 @@ namespace egkr
 	        }
             }},
         {"colour",
-            [](scene::configuration& configuration, const std::string& value)
+            [](scene::configuration& configuration, std::string_view value)
             {
-	        std::istringstream ss{value};
-	        egkr::float4 colour;
-	        ss >> colour.r >> colour.g >> colour.b >> colour.a;
+	        egkr::float4 colour{};
+	        parser::parse_floats(value, &colour.r, 4);
 	        switch (mode)
 	        {
 	        case parse_mode::directional_light:
@@ -279,84 +305,469 @@ namespace egkr
 	            break;
 	        }
             }},
-        {"parent", [](scene::configuration& /* configuration */, const std::string& value) { current_mesh.parent_name = value; }},
-        {"constant", [](scene::configuration& /* configuration */, const std::string& value) { current_point_light.constant = std::stof(value); }},
-        {"linear", [](scene::configuration& /* configuration */, const std::string& value) { current_point_light.linear = std::stof(value); }},
-        {"quadratic", [](scene::configuration& /* configuration */, const std::string& value) { current_point_light.quadratic = std::stof(value); }},
+        {"parent", [](scene::configuration& /* configuration */, std::string_view value) { current_mesh.parent_name = value; }},
+        {"constant", [](scene::configuration& /* configuration */, std::string_view value) { current_point_light.constant = parser::parse_number<float>(value); }},
+        {"linear", [](scene::configuration& /* configuration */, std::string_view value) { current_point_light.linear = parser::parse_number<float>(value); }},
+        {"quadratic", [](scene::configuration& /* configuration */, std::string_view value) { current_point_light.quadratic = parser::parse_number<float>(value); }},
         {"transform",
-            [](scene::configuration& /* configuration */, const std::string& value)
+            [](scene::configuration& /* configuration */, std::string_view value)
             {
-	        std::istringstream ss{value};
-	        ss >> current_mesh.pos.x >> current_mesh.pos.y >> current_mesh.pos.z;
+	        // Position, euler angles in degrees, then scale
+	        std::array<float, 9> transform{};
+	        parser::parse_floats(value, transform.data(), transform.size());
 
-	        ss >> current_mesh.euler_angles.x >> current_mesh.euler_angles.y >> current_mesh.euler_angles.z;
-
-	        current_mesh.euler_angles = glm::radians(current_mesh.euler_angles);
-	        ss >> current_mesh.scale.x >> current_mesh.scale.y >> current_mesh.scale.z;
+	        current_mesh.pos = {transform[0], transform[1], transform[2]};
+	        current_mesh.euler_angles = glm::radians(float3{transform[3], transform[4], transform[5]});
+	        current_mesh.scale = {transform[6], transform[7], transform[8]};
             }},
         {"direction",
-            [](scene::configuration& configuration, const std::string& value)
+            [](scene::configuration& configuration, std::string_view value)
             {
-	        std::istringstream ss{value};
 	        egkr::float4 direction{};
-	        ss >> direction.x >> direction.y >> direction.z >> direction.w;
+	        parser::parse_floats(value, &direction.x, 4);
 	        configuration.directional_light.direction = direction;
             }},
-        {"position", [](scene::configuration& /* configuration */, const std::string& value)
+        {"position", [](scene::configuration& /* configuration */, std::string_view value)
             {
-	        std::istringstream ss{value};
 	        egkr::float4 position{};
-	        ss >> position.x >> position.y >> position.z >> position.w;
+	        parser::parse_floats(value, &position.x, 4);
 
 	        current_point_light.position = position;
-            }}};
+            }},
+    });
 
-    scene::configuration load_configuration_file(file_handle& handle)
+    scene::configuration scene_loader::parse_configuration(std::string_view text)
     {
 	scene::configuration configuration{};
+	mode = parse_mode::root;
 
+	parser::tokenizer tokenizer{text};
+	while (const auto token = tokenizer.next())
+	{
+	    const auto member = scene_configuration_members.find(token->key);
+	    if (!member)
+	    {
+		LOG_ERROR("Unrecognised scene configuration member: {} on line {}", token->key, token->line_number);
+		continue;
+	    }
+	    member(configuration, token->value);
+	}
+	return configuration;
+    }
 
-	uint32_t line_number{};
-	egkr::vector<uint8_t> line{'#'};
-	for (; !line.empty(); line = filesystem::read_line(handle, 511), ++line_number)
+    void scene_loader::bake_command(const console::context& context)
+    {
+	if (context.arguments.size() != 1)
 	{
-	    std::string line_string{line.begin(), line.end()};
-	    trim(line_string);
+	    LOG_ERROR("Invalid number of arguments for scene_bake. Got {}, expected 1", context.arguments.size());
+	    return;
+	}
 
-	    if (line[0] == '#' || line[0] == '\0')
+	parameters bake_parameters{.rebake = true};
+	if (auto scene = resource_system::load(context.arguments[0].value, resource::type::scene, &bake_parameters))
+	{
+	    const auto* configuration = (scene::configuration*)scene->data;
+	    LOG_INFO("Baked scene {}: {} meshes, {} materials, {} textures", context.arguments[0].value, configuration->dependencies.meshes.size(),
+	        configuration->dependencies.materials.size(), configuration->dependencies.textures.size());
+	    resource_system::unload(scene);
+	}
+    }
+
+    // Parses large generated material and scene files, comparing the tokenizer with the per line copies it replaced
+    void scene_loader::parse_benchmark_command(const console::context& /*context*/)
+    {
+	constexpr uint32_t block_count{20000};
+	using clock = std::chrono::high_resolution_clock;
+
+	std::string material_text{"version=1\nname=benchmark\ntype=pbr\nshader=Shader.PBR\ndiffuse_colour=0.8 0.7 0.6 1.0\nshininess=32.0\n"};
+	std::string scene_text{"!version=1\n[Scene]\nname=benchmark\ndescription=generated\n[/Scene]\n"};
+	for (uint32_t i{}; i < block_count; ++i)
+	{
+	    material_text += std::format("[map]\nname=map_{0}\ntexture_name=texture_{0}\nfilter_min=linear\nfilter_mag=nearest\nrepeat_u=repeat\nrepeat_v=clamp_to_edge\nrepeat_w=repeat_mirrored\n[/map]\n", i);
+	    scene_text += std::format("# block {0}\n[Mesh]\nname=mesh_{0}\nresource_name=sponza\ntransform=1.5 2.0 -3.25 0 90 0 1 1 1\n[/Mesh]\n"
+		"[PointLight]\nname=light_{0}\ncolour=1 0.5 0.25 1\nposition=4 5 6 1\nconstant=1.0\nlinear=0.35\nquadratic=0.44\n[/PointLight]\n", i);
+	}
+	const std::string text = material_text + scene_text;
+	const auto megabytes = [](const std::string& bytes, double seconds) { return (double)bytes.size() / (1024.0 * 1024.0) / seconds; };
+
+	auto start = clock::now();
+	size_t copied_tokens{};
+	for (size_t position{}; position < text.size();)
+	{
+	    auto end = text.find('\n', position);
+	    end = end == std::string::npos ? text.size() : end;
+	    std::string line = text.substr(position, end - position);
+	    position = end + 1;
+
+	    trim(line);
+	    if (line.empty() || line[0] == '#')
 	    {
 		continue;
 	    }
+	    const auto split_index = line.find('=');
+	    std::string key = line.substr(0, split_index);
+	    std::string value = split_index == std::string::npos ? std::string{} : line.substr(split_index + 1);
+	    trim(key);
+	    trim(value);
+	    copied_tokens += !key.empty();
+	}
+	const auto copied_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+	start = clock::now();
+	size_t viewed_tokens{};
+	parser::tokenizer tokenizer{text};
+	while (tokenizer.next())
+	{
+	    ++viewed_tokens;
+	}
+	const auto viewed_seconds = std::chrono::duration<double>(clock::now() - start).count();
 
-	    std::string variable_name{};
-	    std::string value{};
-	    if (line[0] == '[')
+	start = clock::now();
+	const auto material = material_loader::parse_configuration(material_text);
+	const auto material_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+	start = clock::now();
+	const auto scene = scene_loader::parse_configuration(scene_text);
+	const auto scene_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+	LOG_INFO("Tokenizing {} lines: copying {:.1f}MB/s, views {:.1f}MB/s", viewed_tokens, megabytes(text, copied_seconds), megabytes(text, viewed_seconds));
+	LOG_INFO("Parsing {} maps {:.1f}MB/s, {} meshes and {} lights {:.1f}MB/s", material.texture_maps.size(), megabytes(material_text, material_seconds), scene.meshes.size(),
+	    scene.point_lights.size(), megabytes(scene_text, scene_seconds));
+	if (copied_tokens != viewed_tokens)
+	{
+	    LOG_WARN("Tokenizers disagree, {} lines copied and {} viewed", copied_tokens, viewed_tokens);
+	}
+    }
+
+    bool is_bake_current(const std::string& baked_filename, std::span<const std::string> source_files)
+    {
+	std::error_code error{};
+	const auto baked_time = std::filesystem::last_write_time(baked_filename, error);
+	if (error)
+	{
+	    return false;
+	}
+
+	// Sources that no longer exist are skipped, a scene may ship baked only
+	return std::ranges::none_of(source_files,
+	    [baked_time](const std::string& source)
+	    {
+		std::error_code source_error{};
+		const auto source_time = std::filesystem::last_write_time(source, source_error);
+		return !source_error && source_time > baked_time;
+	    });
+    }
+
+    scene::dependency_graph resolve_dependencies(const scene::configuration& configuration, egkr::vector<std::string>& source_files)
+    {
+	ZoneScoped;
+
+	scene::dependency_graph graph{};
+	std::unordered_map<std::string, uint32_t> texture_indices{};
+	std::unordered_map<std::string, uint32_t> material_indices{};
+
+	const auto add_material = [&](const std::string& material_name) -> uint32_t
+	{
+	    if (auto found = material_indices.find(material_name); found != material_indices.end())
 	    {
-		variable_name = line_string;
+		return found->second;
 	    }
-	    else
+
+	    scene::material_dependency material{.name = material_name};
+	    if (auto material_resource = resource_system::load(material_name, resource::type::material, nullptr))
 	    {
-		auto split_index = line_string.find_first_of('=');
-		if (split_index == std::string::npos)
+		source_files.push_back(material_resource->get_full_path());
+		for (const auto& texture_name : ((material::properties*)material_resource->data)->texture_maps | std::views::values | std::views::keys)
 		{
-		    LOG_WARN("Potential formatting issue found in file {}: '=' token not found on line number {}.", handle.filepath.data(), line_number);
-		    continue;
+		    // The texture system builds the default textures itself
+		    if (texture_name.empty() || texture_name.starts_with("default"))
+		    {
+			continue;
+		    }
+
+		    auto [found, inserted] = texture_indices.try_emplace(texture_name, (uint32_t)graph.textures.size());
+		    if (inserted)
+		    {
+			graph.textures.push_back(texture_name);
+		    }
+		    material.textures.push_back(found->second);
 		}
+		resource_system::unload(material_resource);
+	    }
 
-		variable_name = line_string.substr(0, split_index);
-		trim(variable_name);
+	    const auto index = (uint32_t)graph.materials.size();
+	    material_indices.emplace(material_name, index);
+	    graph.materials.push_back(std::move(material));
+	    return index;
+	};
 
-		value = line_string.substr(split_index + 1);
-		trim(value);
+	for (const auto& mesh : configuration.meshes)
+	{
+	    if (mesh.resource_name.empty() || std::ranges::any_of(graph.meshes, [&mesh](const auto& baked) { return baked.resource_name == mesh.resource_name; }))
+	    {
+		continue;
 	    }
-	    if (!scene_configuration_members.contains(variable_name))
+
+	    auto mesh_resource = resource_system::load(mesh.resource_name, resource::type::mesh, nullptr);
+	    if (!mesh_resource)
 	    {
-		LOG_ERROR("Unrecognised scene configuration member: {}", variable_name);
+		LOG_WARN("Could not resolve dependencies of mesh {}", mesh.resource_name);
 		continue;
 	    }
 
-	    scene_configuration_members.at(variable_name)(configuration, value);
+	    source_files.push_back(mesh_resource->get_full_path());
+	    scene::mesh_dependency dependency{.resource_name = mesh.resource_name};
+	    for (const auto& geometry : *(egkr::vector<geometry::properties>*)mesh_resource->data)
+	    {
+		if (geometry.material_name.empty() || geometry.material_name == default_material_name_)
+		{
+		    continue;
+		}
+
+		const auto material_index = add_material(geometry.material_name);
+		if (std::ranges::find(dependency.materials, material_index) == dependency.materials.end())
+		{
+		    dependency.materials.push_back(material_index);
+		}
+	    }
+	    resource_system::unload(mesh_resource);
+	    graph.meshes.push_back(std::move(dependency));
 	}
-	return configuration;
+	return graph;
+    }
+
+    static void write_string(file_handle& handle, const std::string& value)
+    {
+	filesystem::write(handle, value.size(), 1);
+	filesystem::write(handle, value.data(), 1, value.size());
+    }
+
+    static void write_indices(file_handle& handle, const egkr::vector<uint32_t>& indices)
+    {
+	filesystem::write(handle, indices.size(), 1);
+	filesystem::write(handle, indices.data(), sizeof(uint32_t), indices.size());
+    }
+
+    // Reads a container size, failing if that many elements could not possibly fit in what is left of the file
+    static size_t read_count(binary_reader& reader, size_t element_size = 1)
+    {
+	size_t count{};
+	reader.read(&count);
+	if (count > reader.remaining() / element_size)
+	{
+	    reader.fail();
+	    return 0;
+	}
+	return count;
+    }
+
+    static egkr::vector<uint32_t> read_indices(binary_reader& reader)
+    {
+	egkr::vector<uint32_t> indices(read_count(reader, sizeof(uint32_t)));
+	reader.read(indices.data(), indices.size());
+	return indices;
+    }
+
+    bool write_baked(const std::string& baked_filename, const scene::configuration& configuration, std::span<const std::string> source_files)
+    {
+	// Written aside and renamed over the bake once complete, so a crash or full disk never leaves a torn bake behind
+	const auto temporary_filename = baked_filename + ".tmp";
+	auto handle = filesystem::open(temporary_filename, file_mode::write, true);
+	if (!handle.is_valid)
+	{
+	    LOG_WARN("Could not write baked scene {}", baked_filename);
+	    return false;
+	}
+
+	filesystem::write(handle, baked_scene_magic);
+	filesystem::write(handle, baked_scene_version);
+
+	filesystem::write(handle, source_files.size(), 1);
+	for (const auto& source : source_files)
+	{
+	    write_string(handle, source);
+	}
+
+	filesystem::write(handle, configuration.version);
+	write_string(handle, configuration.name);
+	write_string(handle, configuration.description);
+
+	write_string(handle, configuration.skybox.name);
+	write_string(handle, configuration.skybox.resource_name);
+
+	write_string(handle, configuration.directional_light.name);
+	filesystem::write(handle, configuration.directional_light.colour);
+	filesystem::write(handle, configuration.directional_light.direction);
+
+	filesystem::write(handle, configuration.point_lights.size(), 1);
+	for (const auto& light : configuration.point_lights)
+	{
+	    write_string(handle, light.name);
+	    filesystem::write(handle, light.colour);
+	    filesystem::write(handle, light.position);
+	    filesystem::write(handle, light.constant);
+	    filesystem::write(handle, light.linear);
+	    filesystem::write(handle, light.quadratic);
+	}
+
+	filesystem::write(handle, configuration.meshes.size(), 1);
+	for (const auto& mesh : configuration.meshes)
+	{
+	    write_string(handle, mesh.name);
+	    write_string(handle, mesh.resource_name);
+	    filesystem::write(handle, mesh.pos);
+	    filesystem::write(handle, mesh.euler_angles);
+	    filesystem::write(handle, mesh.scale);
+	    write_string(handle, mesh.parent_name.value_or(""));
+	}
+
+	filesystem::write(handle, configuration.terrains.size(), 1);
+	for (const auto& terrain : configuration.terrains)
+	{
+	    write_string(handle, terrain.name);
+	    write_string(handle, terrain.resource_name);
+	}
+
+	const auto& dependencies = configuration.dependencies;
+	filesystem::write(handle, dependencies.textures.size(), 1);
+	for (const auto& texture : dependencies.textures)
+	{
+	    write_string(handle, texture);
+	}
+
+	filesystem::write(handle, dependencies.materials.size(), 1);
+	for (const auto& material : dependencies.materials)
+	{
+	    write_string(handle, material.name);
+	    write_indices(handle, material.textures);
+	}
+
+	filesystem::write(handle, dependencies.meshes.size(), 1);
+	for (const auto& mesh : dependencies.meshes)
+	{
+	    write_string(handle, mesh.resource_name);
+	    write_indices(handle, mesh.materials);
+	}
+
+	const bool written = fflush(handle.handle) == 0 && ferror(handle.handle) == 0;
+	filesystem::close(handle);
+
+	std::error_code error{};
+	if (written)
+	{
+	    std::filesystem::rename(temporary_filename, baked_filename, error);
+	}
+	if (!written || error)
+	{
+	    LOG_WARN("Could not write baked scene {}", baked_filename);
+	    std::filesystem::remove(temporary_filename, error);
+	    return false;
+	}
+	return true;
+    }
+
+    bool read_baked(const std::string& baked_filename, scene::configuration& configuration)
+    {
+	ZoneScoped;
+
+	const auto file = mapped_file::open(baked_filename, mapped_file::access_hint::sequential);
+	if (!file.is_valid())
+	{
+	    return false;
+	}
+	binary_reader reader{file.bytes()};
+
+	uint32_t magic{};
+	uint32_t version{};
+	reader.read(&magic);
+	reader.read(&version);
+	if (reader.failed() || magic != baked_scene_magic || version != baked_scene_version)
+	{
+	    LOG_INFO("Baked scene {} is out of date, rebaking", baked_filename);
+	    return false;
+	}
+
+	egkr::vector<std::string> source_files(read_count(reader));
+	for (auto& source : source_files)
+	{
+	    source = reader.read_string();
+	}
+	if (reader.failed() || !is_bake_current(baked_filename, source_files))
+	{
+	    LOG_INFO("Baked scene {} is older than its sources, rebaking", baked_filename);
+	    return false;
+	}
+
+	reader.read(&configuration.version);
+	configuration.name = reader.read_string();
+	configuration.description = reader.read_string();
+
+	configuration.skybox.name = reader.read_string();
+	configuration.skybox.resource_name = reader.read_string();
+
+	configuration.directional_light.name = reader.read_string();
+	reader.read(&configuration.directional_light.colour);
+	reader.read(&configuration.directional_light.direction);
+
+	configuration.point_lights.resize(read_count(reader));
+	for (auto& light : configuration.point_lights)
+	{
+	    light.name = reader.read_string();
+	    reader.read(&light.colour);
+	    reader.read(&light.position);
+	    reader.read(&light.constant);
+	    reader.read(&light.linear);
+	    reader.read(&light.quadratic);
+	}
+
+	configuration.meshes.resize(read_count(reader));
+	for (auto& mesh : configuration.meshes)
+	{
+	    mesh.name = reader.read_string();
+	    mesh.resource_name = reader.read_string();
+	    reader.read(&mesh.pos);
+	    reader.read(&mesh.euler_angles);
+	    reader.read(&mesh.scale);
+	    if (auto parent = reader.read_string(); !parent.empty())
+	    {
+		mesh.parent_name = std::move(parent);
+	    }
+	}
+
+	configuration.terrains.resize(read_count(reader));
+	for (auto& terrain : configuration.terrains)
+	{
+	    terrain.name = reader.read_string();
+	    terrain.resource_name = reader.read_string();
+	}
+
+	auto& dependencies = configuration.dependencies;
+	dependencies.textures.resize(read_count(reader));
+	for (auto& texture : dependencies.textures)
+	{
+	    texture = reader.read_string();
+	}
+
+	dependencies.materials.resize(read_count(reader));
+	for (auto& material : dependencies.materials)
+	{
+	    material.name = reader.read_string();
+	    material.textures = read_indices(reader);
+	}
+
+	dependencies.meshes.resize(read_count(reader));
+	for (auto& mesh : dependencies.meshes)
+	{
+	    mesh.resource_name = reader.read_string();
+	    mesh.materials = read_indices(reader);
+	}
+
+	if (reader.failed())
+	{
+	    LOG_WARN("Baked scene {} is truncated, rebaking", baked_filename);
+	    configuration = {};
+	    return false;
+	}
+	return true;
     }
 }
@@ -1,13 +1,27 @@
 #pragma once
 
 #include "resource_loader.h"
+#include "systems/console_system.h"
 
 namespace egkr
 {
+	namespace scene
+	{
+		struct configuration;
+	}
+
 	class scene_loader : public resource_loader
 	{
 	public:
 		using unique_ptr = std::unique_ptr<scene_loader>;
+
+		// Optional load parameters
+		struct parameters
+		{
+			// Re-resolves dependencies and rewrites the baked scene even if it is newer than the text
+			bool rebake{};
+		};
+
 		static unique_ptr create(const loader_properties& properties);
 
 		explicit scene_loader(const loader_properties& properties);
@@ -15,5 +29,14 @@ namespace egkr
 
 		resource::shared_ptr load(const std::string& name, void* params) override;
 		bool unload(const resource::shared_ptr& resource) override;
+
+		// Parses the contents of a scene file
+		static scene::configuration parse_configuration(std::string_view text);
+
+		// Bakes a text scene offline, scene_bake <name>.ess
+		static void bake_command(const console::context& context);
+
+		// Parses large generated material and scene files, parse_benchmark
+		static void parse_benchmark_command(const console::context& context);
 	};
 }
@@ -1,7 +1,6 @@
 #include "shader_loader.h"
 
-#include "platform/filesystem.h"
-#include <map>
+#include "platform/mapped_file.h"
 #include <resources/shader.h>
 #include "parser.h"
 
@@ -35,32 +34,34 @@ namespace egkr
 	return true;
     }
 
-    const std::map<std::string, std::function<void(shader::properties&, const std::string&)>> shader_configuration_members = {
-        {"version", [](shader::properties& /* properties */, const std::string& /* value */) noexcept {}},
-        {"name", [](shader::properties& properties, const std::string& value) noexcept { properties.name = value; }},
+    using shader_member = void (*)(shader::properties&, std::string_view);
+
+    constexpr auto shader_configuration_members = parser::make_key_dispatch<shader_member>({
+        {"version", [](shader::properties& /* properties */, std::string_view /* value */) noexcept {}},
+        {"name", [](shader::properties& properties, std::string_view value) noexcept { properties.name = value; }},
         {"depth_write",
-            [](shader::properties& properties, const std::string& value) noexcept
+            [](shader::properties& properties, std::string_view value) noexcept
             {
-	        if (std::stoi(value))
+	        if (parser::parse_number<int32_t>(value))
 	        {
 	            properties.shader_flags |= shader::flags::depth_write;
 	        }
             }},
         {"depth_test",
-            [](shader::properties& properties, const std::string& value) noexcept
+            [](shader::properties& properties, std::string_view value) noexcept
             {
-	        if (std::stoi(value))
+	        if (parser::parse_number<int32_t>(value))
 	        {
 	            properties.shader_flags |= shader::flags::depth_test;
 	        }
             }},
         {"stages",
-            [](shader::properties& properties, const std::string& val) noexcept
+            [](shader::properties& properties, std::string_view val) noexcept
             {
-	        std::string stage{};
-	        std::string value = val;
+	        std::string_view stage{};
+	        std::string_view value = val;
 	        auto offset = value.find_first_of(',');
-	        while (offset != std::string::npos)
+	        while (offset != std::string_view::npos)
 	        {
 	            stage = value.substr(0, offset);
 	            shader::stages shader_stage;
@@ -92,7 +93,7 @@ namespace egkr
 
 	        stage = value.substr(0, offset);
 	        shader::stages shader_stage;
-	        if (stage == "frag" || strcmp(stage.data(), "fragment") == 0)
+	        if (stage == "frag" || stage == "fragment")
 	        {
 	            shader_stage = shader::stages::fragment;
 	        }
@@ -116,24 +117,24 @@ namespace egkr
 	        properties.shader_stages.push_back(shader_stage);
             }},
         {"stagefiles",
-            [](shader::properties& properties, const std::string& val) noexcept
+            [](shader::properties& properties, std::string_view val) noexcept
             {
-	        std::string value = val;
+	        std::string_view value = val;
 	        auto offset = value.find_first_of(',');
-	        while (offset != std::string::npos)
+	        while (offset != std::string_view::npos)
 	        {
-	            std::string filename = value.substr(0, offset);
-	            properties.stage_filenames.push_back(filename);
+	            const auto filename = value.substr(0, offset);
+	            properties.stage_filenames.emplace_back(filename);
 	            value = value.substr(offset + 1);
 	            offset = value.find_first_of(',');
 	        }
 
-	        std::string filename = value.substr(0, offset);
-	        properties.stage_filenames.push_back(filename);
+	        const auto filename = value.substr(0, offset);
+	        properties.stage_filenames.emplace_back(filename);
 	        value = value.substr(offset + 1);
             }},
         {"cull_mode",
-            [](shader::properties& properties, const std::string& value) noexcept
+            [](shader::properties& properties, std::string_view value) noexcept
             {
 	        if (value == "front")
 	        {
@@ -149,30 +150,30 @@ namespace egkr
 	        }
             }},
         {"topology",
-            [](shader::properties& properties, const std::string& val) noexcept
+            [](shader::properties& properties, std::string_view val) noexcept
             {
-	        std::string value = val;
+	        std::string_view value = val;
 	        shader::primitive_topology_type types{};
 	        auto offset = value.find_first_of(',');
-	        while (offset != std::string::npos)
+	        while (offset != std::string_view::npos)
 	        {
-	            std::string filename = value.substr(0, offset);
+	            const auto filename = value.substr(0, offset);
 	            types |= shader::to_primitive_topology(filename);
 	            value = value.substr(offset + 1);
 	            offset = value.find_first_of(',');
 	        }
 
-	        std::string filename = value.substr(0, offset);
+	        const auto filename = value.substr(0, offset);
 	        types |= shader::to_primitive_topology(filename);
 	        value = value.substr(offset + 1);
 
 	        properties.topology_types = types;
             }},
         {"attribute",
-            [](shader::properties& properties, const std::string& value) noexcept
+            [](shader::properties& properties, std::string_view value) noexcept
             {
 	        auto offset = value.find_first_of(',');
-	        if (offset == std::string::npos)
+	        if (offset == std::string_view::npos)
 	        {
 	            LOG_ERROR("Invalid attribute: {}", value);
 	        }
@@ -244,11 +245,11 @@ namespace egkr
 	        }
             }},
         {"uniform",
-            [](shader::properties& properties, const std::string& val) noexcept
+            [](shader::properties& properties, std::string_view val) noexcept
             {
-	        std::string value = val;
+	        std::string_view value = val;
 	        auto offset = value.find_first_of(',');
-	        if (offset == std::string::npos)
+	        if (offset == std::string_view::npos)
 	        {
 	            LOG_ERROR("Invalid uniform: {}", value);
 	        }
@@ -359,40 +360,30 @@ namespace egkr
 	            properties.uniforms.push_back(uniform);
 	        }
             }},
-    };
+        {"storage", [](shader::properties& properties, std::string_view value) noexcept { properties.storage_buffers.emplace_back(value); }},
+    });
 
     shader::properties shader_loader::load_configuration_file(std::string_view path)
     {
 	shader::properties properties{};
 	properties.shader_cull_mode = shader::cull_mode::back;
-	auto handle = filesystem::open(path, file_mode::read, false);
-	if (!handle.is_valid)
+	const auto file = mapped_file::open(path, mapped_file::access_hint::sequential);
+	if (!file.is_valid())
 	{
 	    LOG_ERROR("Failed to open binary file: {}", path.data());
 	    return {};
 	}
 
-	auto line = filesystem::read_line(handle, 511);
-	uint32_t line_number{};
-	for (; !line.empty(); line = filesystem::read_line(handle, 511), ++line_number)
+	parser::tokenizer tokenizer{file.text()};
+	while (const auto token = tokenizer.next())
 	{
-	    std::string line_string{line.begin(), line.end()};
-	    trim(line_string);
-
-	    if (const auto& parse_result = parser::parse_line(line_string))
-	    {
-		const auto& [variable_name, value] = parse_result.value();
-		if (!shader_configuration_members.contains(variable_name))
-		{
-		    LOG_WARN("Unrecognised terrain configuration argument: {}", variable_name);
-		    continue;
-		}
-		shader_configuration_members.at(variable_name)(properties, value);
-	    }
-	    else
+	    const auto member = shader_configuration_members.find(token->key);
+	    if (!member)
 	    {
+		LOG_WARN("Unrecognised shader configuration argument: {}", token->key);
 		continue;
 	    }
+	    member(properties, token->value);
 	}
 	return properties;
     }
@@ -1,5 +1,7 @@
 #include "system_font_loader.h"
 #include "systems/resource_system.h"
+#include "platform/mapped_file.h"
+#include "parser.h"
 
 namespace egkr
 {
@@ -37,21 +39,24 @@ namespace egkr
 
 
 	font::system_font_resource_data resource_data{};
-	auto file = filesystem::open(filename, file_mode::read, filetype.is_binary);
+	const auto file = mapped_file::open(filename, mapped_file::access_hint::sequential);
+	if (!file.is_valid())
+	{
+	    return nullptr;
+	}
 
 	switch (filetype.type)
 	{
 	case system_font_file_type::font_config:
 	{
-	    filename = std::format("{}/{}{}", base_path, name, ".ebf");
-
-	    std::string ebf_file_name = filename;
-	    resource_data = import_fontcfg_file(file, ebf_file_name);
+	    auto ebf_file_name = std::format("{}/{}{}", base_path, name, ".ebf");
+	    resource_data = import_fontcfg_file(file.text(), filename, ebf_file_name);
+	    filename = std::move(ebf_file_name);
 	}
 	break;
 	case system_font_file_type::esf:
 	{
-	    resource_data = read_esf_file(file);
+	    resource_data = read_esf_file(file.bytes());
 	}
 	break;
 	case system_font_file_type::not_found:
@@ -76,76 +81,57 @@ namespace egkr
 	if (resource->data)
 	{
 	    auto* data = ((font::system_font_resource_data*)(resource->data));
-	    free(data->font_binary);
+	    if (data->binary_resource)
+	    {
+		resource_system::unload(data->binary_resource);
+	    }
 	    delete data;
-	    data = nullptr;
-
-	    free(resource->data);
 	    resource->data = nullptr;
 	}
 	return true;
     }
 
-    font::system_font_resource_data system_font_loader::import_fontcfg_file(file_handle& handle, std::string_view esf_filename)
+    font::system_font_resource_data system_font_loader::import_fontcfg_file(std::string_view text, std::string_view filename, std::string_view esf_filename)
     {
 	font::system_font_resource_data data{};
-	uint32_t line_number{};
-	egkr::vector<uint8_t> line{'#'};
 
-	for (; !line.empty(); line = filesystem::read_line(handle, 511), ++line_number)
+	parser::tokenizer tokenizer{text};
+	while (const auto token = tokenizer.next())
 	{
-	    std::string line_string{line.begin(), line.end()};
-	    trim(line_string);
-
-	    if (line[0] == '#' || line[0] == '\0')
-	    {
-		continue;
-	    }
-
-	    auto split_index = line_string.find_first_of('=');
-	    if (split_index == std::string::npos)
-	    {
-		LOG_WARN("Potential formatting issue found in file {}: '=' token not found on line number {}.", handle.filepath.data(), line_number);
-		continue;
-	    }
-
-	    auto variable_name = line_string.substr(0, split_index);
-	    trim(variable_name);
-
-	    auto value = line_string.substr(split_index + 1);
-	    trim(value);
-
-	    if (variable_name == "version")
+	    if (token->key == "file")
 	    {
+		// The binary loader maps the font, which the resource then keeps rather than copying it out
+		auto font_resource = resource_system::load(std::string{token->value}, resource::type::binary, nullptr);
+		if (!font_resource)
+		{
+		    LOG_ERROR("Failed to load font binary {} for {}", token->value, filename);
+		    continue;
+		}
+		const auto& font_data = ((binary_resource_properties*)font_resource->data)->data;
+		data.binary_size = font_data.size();
+		data.font_binary = font_data.data();
+		data.binary_resource = std::move(font_resource);
 	    }
-	    else if (variable_name == "file")
+	    else if (token->key == "face")
 	    {
-		const auto& font_file = value;
-		auto font_resource = resource_system::load(font_file, resource::type::binary, nullptr);
-		auto* font_data = (binary_resource_properties*)font_resource->data;
-		data.binary_size = font_data->data.size();
-		data.font_binary = malloc(data.binary_size);
-		std::memcpy(data.font_binary, font_data->data.data(), data.binary_size);
-		resource_system::unload(font_resource);
+		data.fonts.push_back({.name = std::string{token->value}});
 	    }
-	    else if (variable_name == "face")
+	    else if (token->key != "version")
 	    {
-		font::system_font_face new_face{};
-		new_face.name = value;
-		data.fonts.push_back(new_face);
+		LOG_WARN("Unrecognised system font configuration argument: {} on line {} of {}", token->key, token->line_number, filename);
 	    }
 	}
 
 	if ((data.font_binary == nullptr) || data.fonts.empty())
 	{
-	    LOG_ERROR("Bad fontcfg file, {}. Required information missing", handle.filepath.data());
+	    LOG_ERROR("Bad fontcfg file, {}. Required information missing", filename);
 	    return data;
 	}
 
 	return write_esf_file(esf_filename, data);
     }
 
-    font::system_font_resource_data system_font_loader::read_esf_file(file_handle& /*handle*/) { return {}; }
+    font::system_font_resource_data system_font_loader::read_esf_file(std::span<const uint8_t> /*data*/) { return {}; }
 
     font::system_font_resource_data system_font_loader::write_esf_file(std::string_view /*path*/, const font::system_font_resource_data& data)
     {
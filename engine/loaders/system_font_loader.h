@@ -32,8 +32,8 @@ namespace egkr
 		bool unload(const resource::shared_ptr& resource) override;
 
 	private:
-		font::system_font_resource_data import_fontcfg_file(file_handle& handle, std::string_view esf_filename);
-		static font::system_font_resource_data read_esf_file(file_handle& handle);
+		font::system_font_resource_data import_fontcfg_file(std::string_view text, std::string_view filename, std::string_view esf_filename);
+		static font::system_font_resource_data read_esf_file(std::span<const uint8_t> data);
 		static font::system_font_resource_data write_esf_file(std::string_view path, const font::system_font_resource_data& data);
 	};
 }
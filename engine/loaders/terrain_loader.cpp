@@ -1,7 +1,7 @@
 #include "terrain_loader.h"
 
 #include "log/log.h"
-#include "platform/filesystem.h"
+#include "platform/mapped_file.h"
 #include "resources/resource.h"
 #include "resources/terrain.h"
 #include "systems/resource_system.h"
@@ -37,52 +37,51 @@ namespace egkr::loader
 	return true;
     }
 
-    const std::map<std::string, std::function<void(egkr::terrain::configuration&, const std::string&)>> terrain_configuration_members = {
-        {"version", [](egkr::terrain::configuration& /* config */, const std::string& /* value */) noexcept {}},
-        {"heightmap", [](egkr::terrain::configuration& config, const std::string& value) noexcept { config.heightmap = value; }},
-        {"tiles_x", [](egkr::terrain::configuration& config, const std::string& value) noexcept { config.tiles_x = (uint32_t)std::stoi(value); }},
-        {"tiles_y", [](egkr::terrain::configuration& config, const std::string& value) noexcept { config.tiles_y = (uint32_t)std::stoi(value); }},
-        {"scale_x", [](egkr::terrain::configuration& config, const std::string& value) noexcept { config.scale_x = std::stof(value); }},
-        {"scale_y", [](egkr::terrain::configuration& config, const std::string& value) noexcept { config.scale_y = std::stof(value); }},
-        {"scale_z", [](egkr::terrain::configuration& config, const std::string& value) noexcept { config.scale_z = std::stof(value); }},
-    };
+    using terrain_member = void (*)(egkr::terrain::configuration&, std::string_view);
+
+    constexpr auto terrain_configuration_members = parser::make_key_dispatch<terrain_member>({
+        {"version", [](egkr::terrain::configuration& /* config */, std::string_view /* value */) noexcept {}},
+        {"heightmap", [](egkr::terrain::configuration& config, std::string_view value) noexcept { config.heightmap = value; }},
+        {"heightmap_raw", [](egkr::terrain::configuration& config, std::string_view value) noexcept { config.heightmap_raw = value; }},
+        {"tiles_x", [](egkr::terrain::configuration& config, std::string_view value) noexcept { config.tiles_x = parser::parse_number<uint32_t>(value); }},
+        {"tiles_y", [](egkr::terrain::configuration& config, std::string_view value) noexcept { config.tiles_y = parser::parse_number<uint32_t>(value); }},
+        {"scale_x", [](egkr::terrain::configuration& config, std::string_view value) noexcept { config.scale_x = parser::parse_number<float>(value); }},
+        {"scale_y", [](egkr::terrain::configuration& config, std::string_view value) noexcept { config.scale_y = parser::parse_number<float>(value); }},
+        {"scale_z", [](egkr::terrain::configuration& config, std::string_view value) noexcept { config.scale_z = parser::parse_number<float>(value); }},
+    });
 
     egkr::terrain::configuration terrain::load_configuration_file(const std::string& path)
     {
 	egkr::terrain::configuration properties{};
 
-	auto handle = filesystem::open(path, file_mode::read, false);
-	if (!handle.is_valid)
+	const auto file = mapped_file::open(path, mapped_file::access_hint::sequential);
+	if (!file.is_valid())
 	{
 	    LOG_ERROR("Failed to open terrain file {}", path);
 	    return {};
 	}
 
-	auto line = filesystem::read_line(handle, 511);
-	uint32_t line_number{};
-	for (; !line.empty(); line = filesystem::read_line(handle, 511), ++line_number)
+	parser::tokenizer tokenizer{file.text()};
+	while (const auto token = tokenizer.next())
 	{
-	    std::string line_string{line.begin(), line.end()};
-
-	    if (const auto& parse_result = parser::parse_line(line_string))
-	    {
-		const auto& [variable_name, value] = parse_result.value();
-		if (!terrain_configuration_members.contains(variable_name))
-		{
-		    LOG_WARN("Unrecognised terrain configuration argument: {}, with value {} on line", variable_name, value, line_number);
-		    continue;
-		}
-		terrain_configuration_members.at(variable_name)(properties, value);
-	    }
-	    else
+	    const auto member = terrain_configuration_members.find(token->key);
+	    if (!member)
 	    {
+		LOG_WARN("Unrecognised terrain configuration argument: {}, with value {} on line {}", token->key, token->value, token->line_number);
 		continue;
 	    }
+	    member(properties, token->value);
 	}
 
-	if (!properties.heightmap.empty())
+	if (!properties.heightmap_raw.empty())
 	{
-	    image_resource_parameters params{.flip_y = false};
+	    // Left on disk, the terrain streams it a band of rows at a time
+	    const auto raw_path = std::format("{}/{}.r16", get_base_path(), properties.heightmap_raw);
+	    properties.heights = heightmap::open_raw(raw_path, properties.tiles_x, properties.tiles_y);
+	}
+	else if (!properties.heightmap.empty())
+	{
+	    image_resource_parameters params{.flip_y = false, .single_channel_16_bit = true};
 	    auto heightmap_image = resource_system::load(properties.heightmap, resource::type::image, &params);
 	    if (!heightmap_image || !heightmap_image->data)
 	    {
@@ -90,27 +89,22 @@ namespace egkr::loader
 	    }
 	    else
 	    {
+		// Images can't be decoded a row at a time, so the decoded samples are kept at 16 bits rather than as floats
 		auto* image_properties = (texture::properties*)heightmap_image->data;
-		const auto* pixels = (uint8_t*)image_properties->data;
-		properties.tiles_x = image_properties->width;
-		properties.tiles_y = image_properties->height;
-
-		const uint32_t count = properties.tiles_x * properties.tiles_y;
-		properties.height_data.reserve(count);
-		for (uint32_t i{}; i < 4 * count; i += 4)
-		{
-		    const auto r = pixels[i + 0];
-		    const auto g = pixels[i + 1];
-		    const auto b = pixels[i + 2];
-
-		    const float sum = (r + g + b) / (3.f * 255);
-		    properties.height_data.push_back(sum);
-		}
+		const auto* samples = (uint16_t*)image_properties->data;
+		const size_t count = (size_t)image_properties->width * image_properties->height;
+		properties.heights = heightmap::create(image_properties->width, image_properties->height, egkr::vector<uint16_t>(samples, samples + count));
 
 		egkr::resource_system::unload(heightmap_image);
 	    }
 	}
 
+	if (properties.heights)
+	{
+	    properties.tiles_x = properties.heights->get_width();
+	    properties.tiles_y = properties.heights->get_height();
+	}
+
 	return properties;
     }
 }
@@ -1,6 +1,6 @@
 #include "text_loader.h"
 
-#include "platform/filesystem.h"
+#include "platform/mapped_file.h"
 
 #include <format>
 
@@ -18,32 +18,29 @@ namespace egkr
 		const auto base_path = get_base_path();
 		std::string filename = std::format("{}/{}", base_path, name);
 
-		auto handle = filesystem::open(filename, file_mode::read, false);
-		if (!handle.is_valid)
+		auto file = mapped_file::open(filename, mapped_file::access_hint::sequential);
+		if (!file.is_valid())
 		{
 			LOG_ERROR("Failed to open binary file: {}", filename);
 			return {};
 		}
 
-		auto line = filesystem::read_all(handle);
-
 		resource::properties properties{};
 		properties.type = get_loader_type();
 		properties.name = name;
 		properties.full_path = name;
-		properties.data = new(binary_resource_properties);
 
-		binary_resource_properties binary_properties{ line };
-		*(binary_resource_properties*)properties.data = binary_properties;
+		auto* text_properties = new binary_resource_properties{};
+		text_properties->data = file.bytes();
+		text_properties->file = std::move(file);
+		properties.data = text_properties;
 
 		return resource::create(properties);
 	}
 
 	bool text_loader::unload(const resource::shared_ptr& resource)
 	{
-		auto* data = (binary_resource_properties*)resource->data;
-		data->data.clear();
-		delete data;
+		delete (binary_resource_properties*)resource->data;
 		return false;
 	}
 }
@@ -4,6 +4,21 @@
 #include <spdlog/spdlog.h>
 #include <string_view>
 
+// Matches spdlog's level numbering. Anything below EGKR_LOG_LEVEL compiles to nothing, arguments included
+#define EGKR_LOG_LEVEL_TRACE 0
+#define EGKR_LOG_LEVEL_INFO 2
+#define EGKR_LOG_LEVEL_WARN 3
+#define EGKR_LOG_LEVEL_ERROR 4
+#define EGKR_LOG_LEVEL_FATAL 5
+
+#ifndef EGKR_LOG_LEVEL
+#ifdef NDEBUG
+#define EGKR_LOG_LEVEL EGKR_LOG_LEVEL_INFO
+#else
+#define EGKR_LOG_LEVEL EGKR_LOG_LEVEL_TRACE
+#endif
+#endif
+
 namespace egkr
 {
 	using namespace std::literals;
@@ -11,17 +26,41 @@ namespace egkr
 	class log
 	{
 	public:
+		// Logging is asynchronous: callers only format and enqueue, a single worker thread runs the sinks
 		API static void init();
+		API static void shutdown();
         constexpr static std::string_view get_log_name() { return log_name_; }
 		static spdlog::logger* get_logger() { return core_logger_.get(); }
+
+		// Extra sinks run on the logging thread, one at a time
+		API static void add_sink(const spdlog::sink_ptr& sink);
+		API static void remove_sink(const spdlog::sink_ptr& sink);
+
+		// Times the caller's side of logging: formatting and enqueueing, or nothing at all for stripped levels
+		API static void benchmark();
 	private:
         constexpr static std::string_view log_name_{ "engine"sv };
 		inline static std::shared_ptr<spdlog::logger> core_logger_{};
 	};
 }
 
+#if EGKR_LOG_LEVEL <= EGKR_LOG_LEVEL_TRACE
 #define LOG_TRACE(...) egkr::log::get_logger()->trace(__VA_ARGS__)
+#else
+#define LOG_TRACE(...) (void)0
+#endif
+
+#if EGKR_LOG_LEVEL <= EGKR_LOG_LEVEL_INFO
 #define LOG_INFO(...)  egkr::log::get_logger()->info(__VA_ARGS__)
+#else
+#define LOG_INFO(...) (void)0
+#endif
+
+#if EGKR_LOG_LEVEL <= EGKR_LOG_LEVEL_WARN
 #define LOG_WARN(...)  egkr::log::get_logger()->warn(__VA_ARGS__)
+#else
+#define LOG_WARN(...) (void)0
+#endif
+
 #define LOG_ERROR(...) egkr::log::get_logger()->error(__VA_ARGS__)
 #define LOG_FATAL(...) egkr::log::get_logger()->critical(__VA_ARGS__)
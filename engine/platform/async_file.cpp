@@ -0,0 +1,570 @@
+#include "async_file.h"
+#include "filesystem.h"
+
+#include "systems/job_system.h"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef LINUX
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace egkr
+{
+    static async_file::unique_ptr state{};
+
+    struct async_file::batch
+    {
+	egkr::vector<read_result> results;
+	// Where each result may be read from, tried in order
+	egkr::vector<egkr::vector<std::string>> candidates;
+	std::atomic<size_t> remaining{};
+	batch_callback on_read;
+	completion_callback on_success;
+	completion_callback on_fail;
+	job::type type{};
+    };
+
+    // One file of a batch
+    struct read_request
+    {
+	std::shared_ptr<async_file::batch> owner;
+	size_t index{};
+    };
+
+    struct async_file::backend
+    {
+	virtual ~backend() = default;
+	virtual void submit(egkr::vector<read_request> requests) = 0;
+	virtual void stop() = 0;
+	[[nodiscard]] virtual bool is_io_uring() const { return false; }
+    };
+
+    // The job system runs on_read on a worker, then the completion on the main thread with the other job results
+    static void deliver(const std::shared_ptr<async_file::batch>& finished)
+    {
+	job::complete_job on_success{};
+	if (finished->on_success)
+	{
+	    on_success = [finished](void*) { finished->on_success(); };
+	}
+	job::complete_job on_fail{};
+	if (finished->on_fail)
+	{
+	    on_fail = [finished](void*) { finished->on_fail(); };
+	}
+
+	auto info = job_system::create_job([finished](void*, void*) { return finished->on_read(finished->results); }, on_success, on_fail, finished->type, nullptr, 0, 0);
+	job_system::submit(info);
+    }
+
+    static void finish_request(const read_request& request)
+    {
+	if (request.owner->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+	    deliver(request.owner);
+	}
+    }
+
+    class thread_pool_backend final : public async_file::backend
+    {
+    public:
+	explicit thread_pool_backend(uint32_t thread_count)
+	{
+	    for (uint32_t i{}; i < std::max(thread_count, 1U); ++i)
+	    {
+		threads_.emplace_back([this](const std::stop_token& stop) { run(stop); });
+	    }
+	}
+
+	~thread_pool_backend() override { stop(); }
+
+	void submit(egkr::vector<read_request> requests) override
+	{
+	    {
+		std::lock_guard lock{mutex_};
+		std::ranges::move(requests, std::back_inserter(queue_));
+	    }
+	    wake_.notify_all();
+	}
+
+	void stop() override
+	{
+	    for (auto& thread : threads_)
+	    {
+		thread.request_stop();
+	    }
+	    wake_.notify_all();
+	    // Joins, after the queue has drained
+	    threads_.clear();
+	}
+
+    private:
+	void run(const std::stop_token& stop)
+	{
+	    for (;;)
+	    {
+		read_request request{};
+		{
+		    std::unique_lock lock{mutex_};
+		    wake_.wait(lock, [this, &stop]() { return stop.stop_requested() || !queue_.empty(); });
+		    if (queue_.empty())
+		    {
+			return;
+		    }
+		    request = std::move(queue_.front());
+		    queue_.pop_front();
+		}
+
+		auto& result = request.owner->results[request.index];
+		for (const auto& candidate : request.owner->candidates[request.index])
+		{
+		    // Opened directly, a missing candidate is expected and filesystem::open would warn about it
+		    if (FILE* file = fopen(candidate.c_str(), "rb"))
+		    {
+			file_handle handle{file, candidate, true};
+			result.path = candidate;
+			result.data = filesystem::read_all(handle);
+			result.success = true;
+			break;
+		    }
+		}
+		if (!result.success && errno != ENOENT)
+		{
+		    LOG_WARN("Failed to open file: {}", result.path);
+		}
+		finish_request(request);
+	    }
+	}
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<read_request> queue_;
+	egkr::vector<std::jthread> threads_;
+    };
+
+#ifdef LINUX
+    // Talks to the kernel through the raw syscalls and ring layout in linux/io_uring.h, so there is no liburing
+    // dependency. One thread owns the ring: it opens files, queues their reads and reaps completions
+    class io_uring_backend final : public async_file::backend
+    {
+    public:
+	static std::unique_ptr<io_uring_backend> create(uint32_t queue_depth)
+	{
+	    auto backend = std::make_unique<io_uring_backend>();
+	    if (!backend->setup(queue_depth))
+	    {
+		return nullptr;
+	    }
+	    backend->thread_ = std::jthread([ring = backend.get()](const std::stop_token& stop) { ring->run(stop); });
+	    return backend;
+	}
+
+	~io_uring_backend() override
+	{
+	    stop();
+	    teardown();
+	}
+
+	void submit(egkr::vector<read_request> requests) override
+	{
+	    {
+		std::lock_guard lock{mutex_};
+		std::ranges::move(requests, std::back_inserter(pending_));
+	    }
+	    wake_.notify_one();
+	}
+
+	void stop() override
+	{
+	    thread_.request_stop();
+	    wake_.notify_one();
+	    if (thread_.joinable())
+	    {
+		thread_.join();
+	    }
+	}
+
+	[[nodiscard]] bool is_io_uring() const override { return true; }
+
+    private:
+	struct slot
+	{
+	    read_request request;
+	    int fd{-1};
+	    uint64_t offset{};
+	    iovec buffer{};
+	};
+
+	// Keeps each read under the kernel's per-call limit, larger files take several
+	static constexpr uint64_t max_read_size{1ULL << 30};
+
+	bool setup(uint32_t queue_depth)
+	{
+	    io_uring_params params{};
+	    ring_fd_ = (int)syscall(__NR_io_uring_setup, queue_depth, &params);
+	    if (ring_fd_ < 0)
+	    {
+		LOG_WARN("io_uring unavailable ({}), reading files on a thread pool", strerror(errno));
+		return false;
+	    }
+
+	    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	    if (single_mmap)
+	    {
+		sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+	    }
+
+	    sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+	    cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+	    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+	    sqes_ = (io_uring_sqe*)map(sqes_size_, IORING_OFF_SQES);
+	    if (!sq_ring_ || !cq_ring_ || !sqes_)
+	    {
+		LOG_WARN("Failed to map the io_uring rings ({}), reading files on a thread pool", strerror(errno));
+		teardown();
+		return false;
+	    }
+
+	    auto* sq = (uint8_t*)sq_ring_;
+	    sq_tail_ = (uint32_t*)(sq + params.sq_off.tail);
+	    sq_mask_ = *(uint32_t*)(sq + params.sq_off.ring_mask);
+	    sq_array_ = (uint32_t*)(sq + params.sq_off.array);
+
+	    auto* cq = (uint8_t*)cq_ring_;
+	    cq_head_ = (uint32_t*)(cq + params.cq_off.head);
+	    cq_tail_ = (uint32_t*)(cq + params.cq_off.tail);
+	    cq_mask_ = *(uint32_t*)(cq + params.cq_off.ring_mask);
+	    cqes_ = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	    // No more reads in flight than submission entries, so the completion queue, twice the size, never overflows
+	    slots_.resize(params.sq_entries);
+	    free_slots_.reserve(params.sq_entries);
+	    for (uint32_t i{params.sq_entries}; i > 0; --i)
+	    {
+		free_slots_.push_back(i - 1);
+	    }
+	    return true;
+	}
+
+	void* map(size_t size, uint64_t offset) const
+	{
+	    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, (off_t)offset);
+	    return memory == MAP_FAILED ? nullptr : memory;
+	}
+
+	void teardown()
+	{
+	    if (sqes_)
+	    {
+		munmap(sqes_, sqes_size_);
+		sqes_ = nullptr;
+	    }
+	    if (cq_ring_ && cq_ring_ != sq_ring_)
+	    {
+		munmap(cq_ring_, cq_ring_size_);
+	    }
+	    cq_ring_ = nullptr;
+	    if (sq_ring_)
+	    {
+		munmap(sq_ring_, sq_ring_size_);
+		sq_ring_ = nullptr;
+	    }
+	    if (ring_fd_ >= 0)
+	    {
+		close(ring_fd_);
+		ring_fd_ = -1;
+	    }
+	}
+
+	void run(const std::stop_token& stop)
+	{
+	    uint32_t in_flight{};
+	    for (;;)
+	    {
+		egkr::vector<read_request> incoming;
+		{
+		    std::unique_lock lock{mutex_};
+		    if (in_flight == 0)
+		    {
+			wake_.wait(lock, [this, &stop]() { return stop.stop_requested() || !pending_.empty(); });
+			if (pending_.empty())
+			{
+			    return;
+			}
+		    }
+
+		    while (!pending_.empty() && incoming.size() < free_slots_.size())
+		    {
+			incoming.push_back(std::move(pending_.front()));
+			pending_.pop_front();
+		    }
+		}
+
+		for (auto& request : incoming)
+		{
+		    in_flight += start_read(std::move(request)) ? 1 : 0;
+		}
+
+		if (in_flight == 0)
+		{
+		    continue;
+		}
+
+		// Submits everything queued and sleeps until at least one read lands
+		const auto submitted = syscall(__NR_io_uring_enter, ring_fd_, unsubmitted_, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+		if (submitted >= 0)
+		{
+		    unsubmitted_ -= (uint32_t)submitted;
+		}
+		else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+		{
+		    LOG_ERROR("io_uring_enter failed: {}", strerror(errno));
+		}
+
+		in_flight -= reap();
+	    }
+	}
+
+	// Opens the file and queues its first read, or finishes the request straight away when there is nothing to read
+	bool start_read(read_request request)
+	{
+	    auto& result = request.owner->results[request.index];
+
+	    int fd{-1};
+	    for (const auto& candidate : request.owner->candidates[request.index])
+	    {
+		fd = open(candidate.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd >= 0)
+		{
+		    result.path = candidate;
+		    break;
+		}
+	    }
+
+	    struct stat status{};
+	    if (fd < 0 || fstat(fd, &status) != 0)
+	    {
+		// None of the candidates existing is an answer, not an error
+		if (errno != ENOENT)
+		{
+		    LOG_WARN("Failed to open file: {}", result.path);
+		}
+		if (fd >= 0)
+		{
+		    close(fd);
+		}
+		finish_request(request);
+		return false;
+	    }
+
+	    result.data.resize((size_t)status.st_size);
+	    if (result.data.empty())
+	    {
+		close(fd);
+		result.success = true;
+		finish_request(request);
+		return false;
+	    }
+
+	    const auto index = free_slots_.back();
+	    free_slots_.pop_back();
+	    slots_[index] = {.request = std::move(request), .fd = fd};
+	    queue_read(index);
+	    return true;
+	}
+
+	void queue_read(uint32_t slot_index)
+	{
+	    auto& read = slots_[slot_index];
+	    auto& data = read.request.owner->results[read.request.index].data;
+	    read.buffer = {.iov_base = data.data() + read.offset, .iov_len = (size_t)std::min<uint64_t>(data.size() - read.offset, max_read_size)};
+
+	    // Only this thread writes the tail, the kernel reads it
+	    const uint32_t tail = *sq_tail_;
+	    const uint32_t index = tail & sq_mask_;
+	    auto& sqe = sqes_[index];
+	    sqe = {};
+	    sqe.opcode = IORING_OP_READV;
+	    sqe.fd = read.fd;
+	    sqe.off = read.offset;
+	    sqe.addr = (uint64_t)&read.buffer;
+	    sqe.len = 1;
+	    sqe.user_data = slot_index;
+	    sq_array_[index] = index;
+	    std::atomic_ref{*sq_tail_}.store(tail + 1, std::memory_order_release);
+	    ++unsubmitted_;
+	}
+
+	// Returns how many files finished, short reads are queued again for their remainder
+	uint32_t reap()
+	{
+	    uint32_t finished{};
+	    uint32_t head = *cq_head_;
+	    const uint32_t tail = std::atomic_ref{*cq_tail_}.load(std::memory_order_acquire);
+	    for (; head != tail; ++head)
+	    {
+		const auto& cqe = cqes_[head & cq_mask_];
+		const auto slot_index = (uint32_t)cqe.user_data;
+		auto& read = slots_[slot_index];
+		auto& result = read.request.owner->results[read.request.index];
+
+		if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+		{
+		    queue_read(slot_index);
+		    continue;
+		}
+
+		if (cqe.res > 0)
+		{
+		    read.offset += (uint64_t)cqe.res;
+		    if (read.offset < result.data.size())
+		    {
+			queue_read(slot_index);
+			continue;
+		    }
+		    result.success = true;
+		}
+		else if (cqe.res == 0)
+		{
+		    // The file shrank since it was opened
+		    result.data.resize(read.offset);
+		    result.success = true;
+		}
+		else
+		{
+		    LOG_WARN("Failed to read file {}: {}", result.path, strerror(-cqe.res));
+		    result.data.clear();
+		}
+
+		close(read.fd);
+		finish_request(read.request);
+		read = {};
+		free_slots_.push_back(slot_index);
+		++finished;
+	    }
+	    std::atomic_ref{*cq_head_}.store(head, std::memory_order_release);
+	    return finished;
+	}
+
+	int ring_fd_{-1};
+	void* sq_ring_{};
+	void* cq_ring_{};
+	size_t sq_ring_size_{};
+	size_t cq_ring_size_{};
+	size_t sqes_size_{};
+
+	uint32_t* sq_tail_{};
+	uint32_t sq_mask_{};
+	uint32_t* sq_array_{};
+	io_uring_sqe* sqes_{};
+	uint32_t unsubmitted_{};
+
+	uint32_t* cq_head_{};
+	uint32_t* cq_tail_{};
+	uint32_t cq_mask_{};
+	io_uring_cqe* cqes_{};
+
+	egkr::vector<slot> slots_;
+	egkr::vector<uint32_t> free_slots_;
+
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<read_request> pending_;
+	std::jthread thread_;
+    };
+#endif
+
+    async_file* async_file::create(const configuration& configuration)
+    {
+	state = std::make_unique<async_file>(configuration);
+	return state.get();
+    }
+
+    async_file::async_file(const configuration& configuration): configuration_{configuration} { }
+
+    async_file::~async_file() = default;
+
+    bool async_file::init()
+    {
+#ifdef LINUX
+	backend_ = io_uring_backend::create(configuration_.queue_depth);
+#endif
+	if (!backend_)
+	{
+	    backend_ = std::make_unique<thread_pool_backend>(configuration_.fallback_thread_count);
+	}
+
+	LOG_INFO("Initialised async file reads on {}", backend_->is_io_uring() ? "io_uring" : "a thread pool");
+	return true;
+    }
+
+    bool async_file::shutdown()
+    {
+	if (state)
+	{
+	    // Reads already queued finish before the backend goes
+	    state->backend_.reset();
+	    state.reset();
+	}
+	return true;
+    }
+
+    void async_file::submit(std::span<const std::string> paths, batch_callback on_read, completion_callback on_success, completion_callback on_fail, job::type type)
+    {
+	egkr::vector<egkr::vector<std::string>> candidates;
+	candidates.reserve(paths.size());
+	for (const auto& path : paths)
+	{
+	    candidates.push_back({path});
+	}
+	submit(candidates, std::move(on_read), std::move(on_success), std::move(on_fail), type);
+    }
+
+    void async_file::submit(std::span<const egkr::vector<std::string>> candidates, batch_callback on_read, completion_callback on_success,
+        completion_callback on_fail, job::type type)
+    {
+	auto pending = std::make_shared<batch>();
+	pending->on_read = std::move(on_read);
+	pending->on_success = std::move(on_success);
+	pending->on_fail = std::move(on_fail);
+	pending->type = type;
+	pending->remaining = candidates.size();
+	pending->candidates.assign(candidates.begin(), candidates.end());
+	pending->results.resize(candidates.size());
+	for (size_t i{}; i < candidates.size(); ++i)
+	{
+	    // Named after the first candidate until one is read
+	    pending->results[i].path = candidates[i].empty() ? std::string{} : candidates[i].front();
+	}
+
+	if (candidates.empty())
+	{
+	    deliver(pending);
+	    return;
+	}
+
+	egkr::vector<read_request> requests;
+	requests.reserve(candidates.size());
+	for (size_t i{}; i < candidates.size(); ++i)
+	{
+	    requests.push_back({.owner = pending, .index = i});
+	}
+	state->backend_->submit(std::move(requests));
+    }
+
+    bool async_file::is_io_uring() { return state && state->backend_ && state->backend_->is_io_uring(); }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "pch.h"
+#include <span>
+
+#include "resources/job.h"
+#include "systems/system.h"
+
+namespace egkr
+{
+    struct read_result
+    {
+	std::string path;
+	egkr::vector<uint8_t> data;
+	bool success{};
+    };
+
+    // Reads whole files without tying up a job worker. On Linux a single io_uring carries every read in flight, elsewhere,
+    // or when the kernel refuses to create a ring, a few blocking reader threads stand in
+    class async_file : public system
+    {
+    public:
+	struct configuration
+	{
+	    // Reads in flight at once, the ring's submission queue size
+	    uint32_t queue_depth{256};
+	    uint32_t fallback_thread_count{2};
+	};
+
+	// Runs on a job worker once every read of its batch has finished. The return value picks on_success or on_fail
+	using batch_callback = std::function<bool(std::span<read_result> results)>;
+	// Runs on the main thread after the batch callback
+	using completion_callback = std::function<void()>;
+
+	using unique_ptr = std::unique_ptr<async_file>;
+	static async_file* create(const configuration& configuration);
+
+	explicit async_file(const configuration& configuration);
+	~async_file() override;
+
+	bool init() override;
+	bool shutdown() override;
+
+	// Queues every path at once and returns straight away. Results keep the order of paths, a file that could not
+	// be read has success false and no data
+	static void submit(std::span<const std::string> paths, batch_callback on_read, completion_callback on_success = {}, completion_callback on_fail = {},
+	    job::type type = job::type::general);
+	// As above, but each file lists the paths it may be at. They are opened in order on the reading thread, so the
+	// caller never touches the disk, and read_result::path names the one that was read
+	static void submit(std::span<const egkr::vector<std::string>> candidates, batch_callback on_read, completion_callback on_success = {},
+	    completion_callback on_fail = {}, job::type type = job::type::general);
+
+	[[nodiscard]] static bool is_io_uring();
+
+	struct batch;
+	struct backend;
+
+    private:
+	configuration configuration_{};
+	std::unique_ptr<backend> backend_;
+    };
+}
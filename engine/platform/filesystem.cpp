@@ -6,20 +6,12 @@ namespace egkr
 {
 	bool filesystem::does_path_exist(std::string_view path)
 	{
-		const std::filesystem::path filepath{ path };
-		const auto absolute = std::filesystem::absolute(path);
-		return std::filesystem::exists(absolute);
+		std::error_code error{};
+		return std::filesystem::exists(path, error);
 	}
+
 	file_handle filesystem::open(std::string_view path, file_mode mode, bool is_binary)
 	{
-		auto absolute_filepath = std::filesystem::absolute(path);
-		if (!does_path_exist(path) && (mode & file_mode::read))
-		{
-			LOG_WARN("Invalid file path, does not exist: {}", path.data());
-			return { {}, "", false };
-		}
-
-
 		std::string openmode{};
 
 		if ((mode & file_mode::read) != 0 && (mode & file_mode::write) != 0)
@@ -36,18 +28,21 @@ namespace egkr
 		}
 		else
 		{
-			LOG_ERROR("Invalid mode passed while trying to open file: '%s'", path);
+			LOG_ERROR("Invalid mode passed while trying to open file: '{}'", path);
 			return { {}, "", false };
 		}
-		FILE* handle = fopen(absolute_filepath.string().c_str(), openmode.c_str());
+
+		// fopen resolves relative paths itself and reports a missing file, so there is no stat up front
+		const std::string filepath{ path };
+		FILE* handle = fopen(filepath.c_str(), openmode.c_str());
 
 		if (!handle)
 		{
-			LOG_WARN("Failed to open file: {}", path.data());
+			LOG_WARN("Failed to open file: {}", filepath);
 			return { {}, "", false };
 		}
 
-		return { handle, absolute_filepath.string(), true };
+		return { handle, filepath, true };
 	}
 
 	void filesystem::close(file_handle& handle)
@@ -55,6 +50,9 @@ namespace egkr
 		if (handle.handle)
 		{
 			fclose(handle.handle);
+			// The destructor closes too, so the handle must not be left dangling
+			handle.handle = nullptr;
+			handle.is_valid = false;
 		}
 	}
 
@@ -128,15 +126,26 @@ namespace egkr
 			return {};
 		}
 
-		auto size = std::filesystem::file_size(handle.filepath);
+		// Sized from the open handle rather than another lookup by path, with 64-bit offsets since long is 32 bits on Windows
+#ifdef WIN32
+		_fseeki64(handle.handle, 0, SEEK_END);
+		const int64_t end = _ftelli64(handle.handle);
+		_fseeki64(handle.handle, 0, SEEK_SET);
+#else
+		fseeko(handle.handle, 0, SEEK_END);
+		const int64_t end = ftello(handle.handle);
+		fseeko(handle.handle, 0, SEEK_SET);
+#endif
+		const auto size = (size_t)std::max<int64_t>(end, 0);
 
 		egkr::vector<uint8_t> data(size);
 		size_t count = 0;
 		size_t read = 0;
-		while ((read = fread(data.data() + count, 1, size, handle.handle)) > 0)
+		while (count < size && (read = fread(data.data() + count, 1, size - count, handle.handle)) > 0)
 		{
 			count += read;
 		}
+		data.resize(count);
 		return data;
 	}
 }
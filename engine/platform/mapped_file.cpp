@@ -0,0 +1,184 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace egkr
+{
+    mapped_file mapped_file::open(std::string_view path, access_hint hint)
+    {
+	ZoneScoped;
+
+	const std::string filepath{path};
+	mapped_file file{};
+
+#ifdef WIN32
+	auto* handle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	    hint == access_hint::random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+	    LOG_WARN("Failed to open file: {}", filepath);
+	    return {};
+	}
+	file.file_handle_ = handle;
+
+	LARGE_INTEGER size{};
+	GetFileSizeEx(handle, &size);
+	file.size_ = (size_t)size.QuadPart;
+	file.is_valid_ = true;
+
+	// A zero length file cannot be mapped, it is simply empty
+	if (file.size_ == 0)
+	{
+	    return file;
+	}
+
+	file.mapping_handle_ = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	file.data_ = file.mapping_handle_ ? (const std::byte*)MapViewOfFile(file.mapping_handle_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!file.data_)
+	{
+	    LOG_WARN("Failed to map file: {}", filepath);
+	    return {};
+	}
+#else
+	const int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+	    LOG_WARN("Failed to open file: {}", filepath);
+	    return {};
+	}
+
+	struct stat status{};
+	if (fstat(fd, &status) != 0)
+	{
+	    LOG_WARN("Failed to read the size of file: {}", filepath);
+	    ::close(fd);
+	    return {};
+	}
+
+	file.size_ = (size_t)status.st_size;
+	file.is_valid_ = true;
+	if (file.size_ == 0)
+	{
+	    ::close(fd);
+	    return file;
+	}
+
+	void* memory = mmap(nullptr, file.size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file
+	::close(fd);
+	if (memory == MAP_FAILED)
+	{
+	    LOG_WARN("Failed to map file: {}", filepath);
+	    return {};
+	}
+	file.data_ = (const std::byte*)memory;
+#endif
+
+	file.advise(hint);
+	return file;
+    }
+
+    mapped_file::~mapped_file() { close(); }
+
+    mapped_file::mapped_file(mapped_file&& other) noexcept
+        : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)}, is_valid_{std::exchange(other.is_valid_, false)}
+#ifdef WIN32
+        , file_handle_{std::exchange(other.file_handle_, nullptr)}, mapping_handle_{std::exchange(other.mapping_handle_, nullptr)}
+#endif
+    { }
+
+    mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+    {
+	if (this != &other)
+	{
+	    close();
+	    data_ = std::exchange(other.data_, nullptr);
+	    size_ = std::exchange(other.size_, 0);
+	    is_valid_ = std::exchange(other.is_valid_, false);
+#ifdef WIN32
+	    file_handle_ = std::exchange(other.file_handle_, nullptr);
+	    mapping_handle_ = std::exchange(other.mapping_handle_, nullptr);
+#endif
+	}
+	return *this;
+    }
+
+    void mapped_file::close()
+    {
+#ifdef WIN32
+	if (data_)
+	{
+	    UnmapViewOfFile(data_);
+	}
+	if (mapping_handle_)
+	{
+	    CloseHandle(mapping_handle_);
+	    mapping_handle_ = nullptr;
+	}
+	if (file_handle_)
+	{
+	    CloseHandle(file_handle_);
+	    file_handle_ = nullptr;
+	}
+#else
+	if (data_)
+	{
+	    munmap((void*)data_, size_);
+	}
+#endif
+	data_ = nullptr;
+	size_ = 0;
+	is_valid_ = false;
+    }
+
+    void mapped_file::advise(access_hint hint, size_t offset, size_t size) const
+    {
+	if (!data_ || offset >= size_)
+	{
+	    return;
+	}
+	size = std::min(size, size_ - offset);
+
+#ifdef WIN32
+	// Windows only takes a prefetch, the other hints were given when the file was opened
+	if (hint == access_hint::will_need)
+	{
+	    WIN32_MEMORY_RANGE_ENTRY range{.VirtualAddress = (void*)(data_ + offset), .NumberOfBytes = size};
+	    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+#else
+	int advice{MADV_NORMAL};
+	switch (hint)
+	{
+	case access_hint::sequential:
+	    advice = MADV_SEQUENTIAL;
+	    break;
+	case access_hint::random:
+	    advice = MADV_RANDOM;
+	    break;
+	case access_hint::will_need:
+	    advice = MADV_WILLNEED;
+	    break;
+	case access_hint::normal:
+	default:
+	    break;
+	}
+
+	// madvise wants a page aligned start
+	const auto page_size = (size_t)sysconf(_SC_PAGESIZE);
+	const auto start = (uintptr_t)(data_ + offset) & ~(uintptr_t)(page_size - 1);
+	const auto end = (uintptr_t)(data_ + offset + size);
+	madvise((void*)start, end - start, advice);
+#endif
+    }
+}
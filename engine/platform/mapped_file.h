@@ -0,0 +1,51 @@
+#pragma once
+#include "pch.h"
+#include <span>
+
+namespace egkr
+{
+    // A read only view of a whole file mapped into memory. Loaders parse the pages in place instead of copying the
+    // file into a buffer first. The view lives exactly as long as the mapped_file, or until close
+    class mapped_file
+    {
+    public:
+	enum class access_hint
+	{
+	    normal,
+	    // Read front to back once, the kernel reads ahead aggressively and drops pages behind
+	    sequential,
+	    random,
+	    // Start reading the whole file in now
+	    will_need
+	};
+
+	[[nodiscard]] static mapped_file open(std::string_view path, access_hint hint = access_hint::sequential);
+
+	mapped_file() = default;
+	~mapped_file();
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+	mapped_file(mapped_file&& other) noexcept;
+	mapped_file& operator=(mapped_file&& other) noexcept;
+
+	void close();
+	// Hints how a range will be read, the whole file by default
+	void advise(access_hint hint, size_t offset = 0, size_t size = std::numeric_limits<size_t>::max()) const;
+
+	[[nodiscard]] std::span<const std::byte> data() const { return {data_, size_}; }
+	[[nodiscard]] std::span<const uint8_t> bytes() const { return {(const uint8_t*)data_, size_}; }
+	[[nodiscard]] std::string_view text() const { return {(const char*)data_, size_}; }
+	[[nodiscard]] size_t size() const { return size_; }
+	[[nodiscard]] bool is_valid() const { return is_valid_; }
+
+    private:
+	const std::byte* data_{};
+	size_t size_{};
+	bool is_valid_{};
+#ifdef WIN32
+	void* file_handle_{};
+	void* mapping_handle_{};
+#endif
+    };
+}
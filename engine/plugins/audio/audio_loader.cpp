@@ -1,8 +1,12 @@
 #include "audio_loader.h"
 #include <resources/audio.h>
+#include <containers/lru_cache.h>
+#include <systems/job_system.h>
 
 #include <stb_vorbis.c>
 
+#include <condition_variable>
+
 //#define MINIMP3_IMPLEMENTATION
 //#include <minimp3/minimp3_ex.h>
 
@@ -10,20 +14,153 @@
 
 namespace egkr
 {
+    // Decoded sound effects, shared by every file loaded from the same name
+    struct decoded_pcm
+    {
+	egkr::vector<int16_t> samples;
+	int32_t channels{};
+	uint32_t sample_rate{};
+    };
+
+    constexpr static uint64_t pcm_cache_capacity{64ULL * 1024 * 1024};
+    // Stream chunks decoded ahead of the one being played
+    constexpr static uint32_t prefetch_chunk_count{4};
+
+    struct pcm_cache
+    {
+	std::mutex mutex;
+	container::lru_cache<std::string, std::shared_ptr<const decoded_pcm>> entries{pcm_cache_capacity};
+    };
+
+    static pcm_cache cache{};
+
+    struct prepared_chunk
+    {
+	egkr::vector<int16_t> samples;
+	uint64_t sample_count{};
+    };
+
     struct audio_file_internal
     {
 	stb_vorbis* vorbis{};
 	//mp3dec_file_info_t mp3_info{};
 	int16_t* pcm{};
 	uint64_t pcm_size{};
+	std::shared_ptr<const decoded_pcm> decoded;
+
+	// Streams only. The prefetch job is the single producer and load_samples the single consumer,
+	// the vorbis decoder and at_end are only touched under decode_mutex
+	std::array<prepared_chunk, prefetch_chunk_count> prepared{};
+	std::atomic<uint32_t> prepared_write{};
+	std::atomic<uint32_t> prepared_read{};
+	std::atomic<bool> prefetch_pending{};
+	std::mutex decode_mutex;
+	// Signalled when a prefetch job lets go of the stream, so unload can wait for it
+	std::mutex prefetch_mutex;
+	std::condition_variable prefetch_done;
+	bool at_end{};
+	uint32_t chunk_size{};
+	int32_t channels{};
     };
 
+    static uint64_t decode_chunk(audio_file_internal* internal, int16_t* destination)
+    {
+	if (internal->at_end)
+	{
+	    return 0;
+	}
+
+	const int32_t frames = stb_vorbis_get_samples_short_interleaved(internal->vorbis, internal->channels, destination, (int32_t)internal->chunk_size);
+	internal->at_end = frames == 0;
+	return (uint64_t)frames * (uint64_t)internal->channels;
+    }
+
+    // Takes decode_mutex once per chunk, so a source that ran dry only ever waits behind a single decode
+    static void prefetch(audio_file_internal* internal)
+    {
+	while (true)
+	{
+	    std::lock_guard lock{internal->decode_mutex};
+	    if (internal->prepared_write.load(std::memory_order_relaxed) - internal->prepared_read.load(std::memory_order_acquire) >= prefetch_chunk_count || internal->at_end)
+	    {
+		return;
+	    }
+
+	    const uint32_t write = internal->prepared_write.load(std::memory_order_relaxed);
+	    auto& chunk = internal->prepared[write % prefetch_chunk_count];
+	    chunk.samples.resize(internal->chunk_size);
+	    chunk.sample_count = decode_chunk(internal, chunk.samples.data());
+	    if (chunk.sample_count == 0)
+	    {
+		return;
+	    }
+	    internal->prepared_write.store(write + 1, std::memory_order_release);
+	}
+    }
+
+    // Decodes ahead on a resource_load worker, at most one job per stream in flight
+    static void request_prefetch(audio_file_internal* internal)
+    {
+	if (internal->prefetch_pending.exchange(true, std::memory_order_acq_rel))
+	{
+	    return;
+	}
+
+	auto job = job_system::create_job(
+	    [internal](void*, void*)
+	    {
+		prefetch(internal);
+		// Notified under the lock, unload cannot free internal until this job has let go of it
+		std::lock_guard lock{internal->prefetch_mutex};
+		internal->prefetch_pending.store(false, std::memory_order_release);
+		internal->prefetch_done.notify_all();
+		return true;
+	    },
+	    nullptr, nullptr, job::type::resource_load, nullptr, 0, 0);
+	job_system::submit(job);
+    }
+
     uint64_t audio::file::load_samples(uint32_t chunk_size, uint32_t /*count*/)
     {
+	if (internal_data->decoded)
+	{
+	    return std::min<uint64_t>(total_samples_left, chunk_size);
+	}
+
 	if (internal_data->vorbis)
 	{
-	    int64_t samples = stb_vorbis_get_samples_short_interleaved(internal_data->vorbis, channels, internal_data->pcm, (int32_t)chunk_size);
-	    return (uint64_t)(samples * channels);
+	    const auto take_prepared = [this, chunk_size](uint32_t read)
+	    {
+		const auto& chunk = internal_data->prepared[read % prefetch_chunk_count];
+		const uint64_t samples = std::min<uint64_t>(chunk.sample_count, chunk_size);
+		memcpy(internal_data->pcm, chunk.samples.data(), samples * sizeof(int16_t));
+		internal_data->prepared_read.store(read + 1, std::memory_order_release);
+		return samples;
+	    };
+
+	    uint64_t samples{};
+	    const uint32_t read = internal_data->prepared_read.load(std::memory_order_relaxed);
+	    if (read != internal_data->prepared_write.load(std::memory_order_acquire))
+	    {
+		samples = take_prepared(read);
+	    }
+	    else
+	    {
+		// The workers fell behind, decode here rather than let the source run dry
+		std::lock_guard lock{internal_data->decode_mutex};
+		// A prefetch may have published the next chunk while we waited for the lock, it comes before anything decoded now
+		if (read != internal_data->prepared_write.load(std::memory_order_acquire))
+		{
+		    samples = take_prepared(read);
+		}
+		else
+		{
+		    samples = decode_chunk(internal_data, internal_data->pcm);
+		}
+	    }
+
+	    request_prefetch(internal_data);
+	    return samples;
 	}
 	//else if (internal_data->mp3_info.buffer)
 	//{
@@ -35,6 +172,10 @@ namespace egkr
 
     void* audio::file::stream_buffer_data()
     {
+	if (internal_data->decoded)
+	{
+	    return (void*)internal_data->decoded->samples.data();
+	}
 	if (internal_data->vorbis)
 	{
 	    return internal_data->pcm;
@@ -53,10 +194,20 @@ namespace egkr
 
     void audio::file::rewind()
     {
-	if (internal_data->vorbis)
+	if (internal_data->decoded)
+	{
+	    total_samples_left = internal_data->decoded->samples.size();
+	}
+	else if (internal_data->vorbis)
 	{
-	    stb_vorbis_seek_start(internal_data->vorbis);
+	    {
+		std::lock_guard lock{internal_data->decode_mutex};
+		stb_vorbis_seek_start(internal_data->vorbis);
+		internal_data->at_end = false;
+		internal_data->prepared_read.store(internal_data->prepared_write.load(std::memory_order_relaxed), std::memory_order_release);
+	    }
 	    total_samples_left = stb_vorbis_stream_length_in_samples(internal_data->vorbis) * (uint32_t)channels;
+	    request_prefetch(internal_data);
 	}
 	//else if (internal_data->mp3_info.buffer)
 	//{
@@ -68,6 +219,46 @@ namespace egkr
 	}
     }
 
+    static std::shared_ptr<const decoded_pcm> decode_sound_effect(const std::string& name, const std::string& filename)
+    {
+	{
+	    std::lock_guard lock{cache.mutex};
+	    if (auto cached = cache.entries.get(name))
+	    {
+		return *cached;
+	    }
+	}
+
+	int32_t ogg_error{};
+	stb_vorbis* vorbis = stb_vorbis_open_filename(filename.c_str(), &ogg_error, nullptr);
+	if (!vorbis)
+	{
+	    LOG_ERROR("Failed to load vorbis file: {}", ogg_error);
+	    return nullptr;
+	}
+
+	const stb_vorbis_info info = stb_vorbis_get_info(vorbis);
+	auto decoded = std::make_shared<decoded_pcm>();
+	decoded->channels = info.channels;
+	decoded->sample_rate = info.sample_rate;
+
+	const uint64_t length_samples = stb_vorbis_stream_length_in_samples(vorbis) * (uint32_t)info.channels;
+	decoded->samples.resize(length_samples);
+	const int32_t read_frames = stb_vorbis_get_samples_short_interleaved(vorbis, info.channels, decoded->samples.data(), (int32_t)length_samples);
+	if ((uint64_t)read_frames * (uint64_t)info.channels != length_samples)
+	{
+	    LOG_WARN("Read/length mismatch while reading ogg file.");
+	}
+	stb_vorbis_close(vorbis);
+	// Padded with silence rather than reporting more samples than were decoded
+	decoded->samples.resize(length_samples + (length_samples % 4));
+
+	// Two loads racing on the same name both decode, the later insert wins and both results stay valid
+	std::lock_guard lock{cache.mutex};
+	cache.entries.put(name, decoded, decoded->samples.size() * sizeof(int16_t));
+	return decoded;
+    }
+
     audio_loader::unique_ptr audio_loader::create(const loader_properties& properties) { return std::make_unique<audio_loader>(properties); }
 
     audio_loader::audio_loader(const loader_properties& properties): resource_loader{resource::type::audio, properties}
@@ -92,43 +283,51 @@ namespace egkr
 
 	resource_data->internal_data = new audio_file_internal();
 	resource_data->audio_type = parameters->type;
+	// Nothing but the two allocations above is held yet when a file fails to open or decode
+	const auto discard = [resource_data]() -> resource::shared_ptr
+	{
+	    delete resource_data->internal_data;
+	    delete resource_data;
+	    return nullptr;
+	};
 	if (name.contains(".ogg"))
 	{
 	    LOG_TRACE("Processing OGG file");
 	    int32_t ogg_error{};
 
-	    resource_data->internal_data->vorbis = stb_vorbis_open_filename(filename.c_str(), &ogg_error, nullptr);
-	    if (!resource_data->internal_data->vorbis)
-	    {
-		LOG_ERROR("Failed to load vorbis file: {}", ogg_error);
-		return nullptr;
-	    }
-	    stb_vorbis_info info = stb_vorbis_get_info(resource_data->internal_data->vorbis);
-	    resource_data->channels = info.channels;
-	    resource_data->sample_rate = info.sample_rate;
-	    resource_data->total_samples_left = stb_vorbis_stream_length_in_samples(resource_data->internal_data->vorbis);
-
 	    if (resource_data->audio_type == audio::type::music_stream)
 	    {
+		auto* internal = resource_data->internal_data;
+		internal->vorbis = stb_vorbis_open_filename(filename.c_str(), &ogg_error, nullptr);
+		if (!internal->vorbis)
+		{
+		    LOG_ERROR("Failed to load vorbis file: {}", ogg_error);
+		    return discard();
+		}
+		stb_vorbis_info info = stb_vorbis_get_info(internal->vorbis);
+		resource_data->channels = info.channels;
+		resource_data->sample_rate = info.sample_rate;
+		resource_data->total_samples_left = stb_vorbis_stream_length_in_samples(internal->vorbis);
+
 		const uint64_t buffer_lenght = parameters->chunk_size * sizeof(int16_t);
-		resource_data->internal_data->pcm = (int16_t*)malloc(buffer_lenght);
-		resource_data->internal_data->pcm_size = buffer_lenght;
+		internal->pcm = (int16_t*)malloc(buffer_lenght);
+		internal->pcm_size = buffer_lenght;
+		internal->chunk_size = (uint32_t)parameters->chunk_size;
+		internal->channels = info.channels;
+		request_prefetch(internal);
 	    }
 	    else
 	    {
-		uint64_t length_samples = stb_vorbis_stream_length_in_samples(resource_data->internal_data->vorbis) * (uint32_t)info.channels;
-		const uint64_t buffer_lenght = length_samples * sizeof(int16_t);
-
-		resource_data->internal_data->pcm = (int16_t*)malloc(buffer_lenght);
-		resource_data->internal_data->pcm_size = buffer_lenght;
-		const int32_t read_samples = stb_vorbis_get_samples_short_interleaved(resource_data->internal_data->vorbis, info.channels, resource_data->internal_data->pcm, (int32_t)length_samples);
-		if ((uint64_t)read_samples != length_samples)
+		resource_data->internal_data->decoded = decode_sound_effect(name, filename);
+		const auto& decoded = resource_data->internal_data->decoded;
+		if (!decoded)
 		{
-		    LOG_WARN("Read/length mismatch while reading ogg file.");
+		    return discard();
 		}
 
-		length_samples += (length_samples % 4);
-		resource_data->total_samples_left = length_samples;
+		resource_data->channels = decoded->channels;
+		resource_data->sample_rate = decoded->sample_rate;
+		resource_data->total_samples_left = decoded->samples.size();
 	    }
 	}
 	else if (name.contains(".mp3"))
@@ -143,7 +342,7 @@ namespace egkr
 	else
 	{
 	    LOG_ERROR("Unsupported audio file type");
-	    return nullptr;
+	    return discard();
 	}
 
 	return resource::create(audio_properties);
@@ -157,6 +356,13 @@ namespace egkr
 
 	    if (file->internal_data != nullptr)
 	    {
+		// A prefetch job still decoding holds on to the stream
+		{
+		    auto* internal = file->internal_data;
+		    std::unique_lock lock{internal->prefetch_mutex};
+		    internal->prefetch_done.wait(lock, [internal] { return !internal->prefetch_pending.load(std::memory_order_acquire); });
+		}
+
 		if (file->internal_data->vorbis != nullptr)
 		{
 		    stb_vorbis_close(file->internal_data->vorbis);
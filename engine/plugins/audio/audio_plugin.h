@@ -1,6 +1,7 @@
 #pragma once
 
 #include <pch.h>
+#include <resources/resource.h>
 
 namespace egkr
 {
@@ -19,11 +20,19 @@ namespace egkr
 				uint32_t audio_channel_count{};
 			};
 
+			struct statistics
+			{
+				uint32_t thread_count{};
+				// Since the previous call
+				float wakeups_per_second{};
+			};
+
 			virtual ~plugin() = default;
 			virtual bool init(const configuration& configuration) = 0;
 			virtual bool shutdown() = 0;
 
 			virtual bool update() = 0;
+			virtual statistics get_statistics() = 0;
 
 			[[nodiscard]] virtual float3 get_listener_position() const = 0;
 			virtual bool set_listener_position(const float3& position) = 0;
@@ -43,7 +52,8 @@ namespace egkr
 			[[nodiscard]] virtual const float3& get_source_position(uint32_t source_id) const = 0;
 			virtual bool set_source_position(uint32_t source_id, const float3& position) = 0;
 
-			virtual audio::file* load_chunk(const std::string& name) = 0;
+			// Makes a sound effect the audio loader has already decoded playable, the returned file keeps the resource
+			virtual audio::file* load_chunk(const resource::shared_ptr& resource) = 0;
 			virtual audio::file* load_stream(const std::string& name) = 0;
 
 			virtual void unload_audio(audio::file* file) = 0;
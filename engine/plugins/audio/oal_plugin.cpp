@@ -4,6 +4,10 @@
 #include <AL/alc.h>
 
 #include <systems/resource_system.h>
+#include <containers/mpsc_ring.h>
+
+#include <deque>
+#include <latch>
 
 constexpr static const uint32_t OAL_PLUGIN_MUSIC_BUFFER_COUNT = 2u;
 
@@ -12,17 +16,59 @@ namespace egkr::audio
     struct source;
     static bool stream_music_data(ALuint buffer, audio::file* file);
     static bool update_stream(audio::file* audio, source* source);
+
+    // Everything that starts, stops or streams a source runs on the mixer thread, the caller only queues it
+    struct source_command
+    {
+	enum class type : uint8_t
+	{
+	    play,
+	    play_file,
+	    stop,
+	    pause,
+	    resume,
+	    // Stops every source playing file, so the caller can free it once detached counts down
+	    detach
+	};
+
+	type command_type{};
+	uint8_t source_index{};
+	audio::file* file{};
+	std::latch* detached{};
+    };
+
+    constexpr static uint32_t source_command_capacity{256};
+    // Bounds on how long the mixer sleeps while streaming, a quarter of a streaming buffer's length between them
+    constexpr static std::chrono::milliseconds min_refill_interval{5};
+    constexpr static std::chrono::milliseconds max_refill_interval{100};
+
     struct plugin_internal_data
     {
 	egkr::audio::plugin::configuration configuration{};
 	ALCdevice* device{};
 	ALCcontext* context{};
 	egkr::vector<ALuint> buffers;
+	// Every buffer belongs to one loaded file until it is unloaded, loads and unloads may run on any thread
+	std::mutex free_buffers_mutex;
 	egkr::vector<uint32_t> free_buffers;
 	egkr::vector<source> sources;
 	float3 listener_position{};
 	float3 listener_forward{1, 0, 0};
 	float3 listener_up{0, 0, 1};
+
+	container::mpsc_ring<source_command> commands{source_command_capacity};
+	// Takes what the ring cannot, so no command is ever lost. Once anything spills, later commands follow it here to stay in order
+	std::mutex overflow_mutex;
+	std::deque<source_command> overflow;
+	std::atomic<bool> has_overflow{};
+	std::mutex wake_mutex;
+	std::condition_variable_any wake;
+	bool has_commands{};
+	std::jthread mixer_thread;
+
+	std::atomic<uint64_t> wakeups{};
+	std::chrono::steady_clock::time_point last_statistics_time{};
+	uint64_t last_statistics_wakeups{};
     };
     struct plugin_data
     {
@@ -31,11 +77,6 @@ namespace egkr::audio
 	bool is_looping{};
     };
 
-    struct work_thread_params
-    {
-	source* audio_source{};
-    };
-
     struct source
     {
 	ALCuint id{};
@@ -43,139 +84,105 @@ namespace egkr::audio
 	float pitch{1.F};
 	float3 position{};
 	bool looping{};
+	// Only touched by the mixer thread
 	bool in_use{};
-	bool trigger_play{};
-	bool trigger_exit{false};
-	//std::mutex mutex;
+	bool paused{};
 	audio::file* current{};
-	std::jthread thread;
 
-	source()
-	{
-	    alGenSources((ALuint)1, &id);
-
-	    work_thread_params* params = new work_thread_params();
-	    params->audio_source = this;
-	    thread = std::jthread(&source::worker_thread, params);
-	}
+	source() { alGenSources((ALuint)1, &id); }
 
 	void destroy()
 	{
 	    alDeleteSources(1, &id);
 	    id = invalid_32_id;
-	    trigger_exit = true;
 	}
 
-	static uint32_t worker_thread(work_thread_params* params)
+	void play()
 	{
-	    source* s = params->audio_source;
+	    if (current)
+	    {
+		in_use = true;
+		paused = false;
+		alSourcePlay(id);
+	    }
+	}
 
-	    delete params;
-	    bool do_break{};
-	    while (!do_break)
+	void play_on_source(audio::file* file)
+	{
+	    if (file->audio_type == audio::type::sound_effect)
 	    {
+		alSourceQueueBuffers(id, 1, &file->data->buffer);
+	    }
+	    else
+	    {
+		for (uint32_t i{}; i < OAL_PLUGIN_MUSIC_BUFFER_COUNT; ++i)
 		{
-		    //std::lock_guard lock{ mutex };
-		    if (s->trigger_exit)
-		    {
-			do_break = true;
-		    }
-
-		    if (s->trigger_play)
+		    if (!stream_music_data(file->data->buffers[i], file))
 		    {
-			alSourcePlay(s->id);
-			s->trigger_play = false;
+			LOG_ERROR("Failed to stream data to buffer {} in music file. File load failed", i);
+			break;
 		    }
 		}
+		alSourceQueueBuffers(id, OAL_PLUGIN_MUSIC_BUFFER_COUNT, file->data->buffers.data());
+	    }
 
-		if (s->current && s->current->audio_type == type::music_stream)
-		{
-		    update_stream(s->current, s);
-		}
+	    current = file;
+	    in_use = true;
+	    paused = false;
+	    alSourcePlay(id);
+	}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(2));
-	    }
-	    return 0;
+	void stop()
+	{
+	    alSourceStop(id);
+	    alSourcei(id, AL_BUFFER, 0);
+	    alSourceRewind(id);
+	    in_use = false;
+	    paused = false;
+	    current = nullptr;
 	}
 
-	bool play()
+	void pause()
 	{
+	    ALint source_state{};
+	    alGetSourcei(id, AL_SOURCE_STATE, &source_state);
+	    if (source_state == AL_PLAYING)
 	    {
-		//std::lock_guard lock{ mutex };
-		if (current)
-		{
-		    trigger_play = true;
-		    in_use = true;
-		}
+		alSourcePause(id);
+		paused = true;
 	    }
-	    return true;
 	}
 
-	bool play_on_source(audio::file* file)
+	void resume()
 	{
+	    ALint source_state{};
+	    alGetSourcei(id, AL_SOURCE_STATE, &source_state);
+	    if (source_state == AL_PAUSED)
 	    {
-		//std::lock_guard lock{ mutex };
-		if (file->audio_type == audio::type::sound_effect)
-		{
-		    alSourceQueueBuffers(id, 1, &file->data->buffer);
-		    //check_error();
-		}
-		else
-		{
-		    for (uint32_t i{}; i < OAL_PLUGIN_MUSIC_BUFFER_COUNT; ++i)
-		    {
-			if (!stream_music_data(file->data->buffers[i], file))
-			{
-			    LOG_ERROR("Failed to stream data to buffer {} in music file. File load failed", i);
-			    break;
-			}
-		    }
-		    alSourceQueueBuffers(id, OAL_PLUGIN_MUSIC_BUFFER_COUNT, file->data->buffers.data());
-		    //check_error();
-		}
-
-		current = file;
-		in_use = true;
 		alSourcePlay(id);
+		paused = false;
 	    }
-	    return true;
 	}
-    };
 
+	[[nodiscard]] bool is_streaming() const { return in_use && current && current->audio_type == type::music_stream; }
+    };
 
     static plugin_internal_data* internal_data{};
 
     source create_source();
 
-    static egkr::vector<uint32_t> find_playing_sources()
-    {
-	egkr::vector<uint32_t> playing{};
-	ALint state{};
-	for (uint32_t i{}; i < internal_data->configuration.max_sources; ++i)
-	{
-	    alGetSourcei(internal_data->sources[i - 1].id, AL_SOURCE_STATE, &state);
-	    if (state == AL_PLAYING)
-	    {
-		playing.push_back(internal_data->sources[i - 1].id);
-	    }
-	}
-	return playing;
-    }
-
     static void clear_buffer(uint32_t* buffer, uint32_t amount)
     {
+	std::lock_guard lock{internal_data->free_buffers_mutex};
 	for (uint32_t a{}; a < amount; ++a)
 	{
-	    for (uint32_t i{}; i < internal_data->buffers.size(); ++i)
+	    if (std::ranges::find(internal_data->buffers, buffer[a]) == internal_data->buffers.end())
 	    {
-		if (buffer[a] == internal_data->buffers[i])
-		{
-		    internal_data->free_buffers.push_back(i);
-		    return;
-		}
+		LOG_WARN("Could not clear buffer");
+		continue;
 	    }
+	    internal_data->free_buffers.push_back(buffer[a]);
 	}
-	LOG_WARN("Could not clear buffer");
     }
 
     bool oal::check_error()
@@ -192,44 +199,12 @@ namespace egkr::audio
 
     uint32_t oal::find_free_buffer()
     {
+	// Sources only ever borrow a loaded file's buffers, so nothing can be reclaimed from them here. Sources belong to
+	// the mixer thread anyway, a buffer only comes back when its file is unloaded
+	std::lock_guard lock{internal_data->free_buffers_mutex};
 	if (internal_data->free_buffers.empty())
 	{
-	    LOG_INFO("No free buffers, attempting to free an existing one");
-	    if (!check_error())
-	    {
-		return false;
-	    }
-
-	    const auto playing_sources = find_playing_sources();
-
-	    for (uint32_t i{}; i < playing_sources.size(); ++i)
-	    {
-		alSourcePause(internal_data->sources[i - 1].id);
-	    }
-
-	    ALint to_be_freed{};
-	    ALuint buffers_freed{};
-	    for (uint32_t i{}; i < internal_data->buffers.size(); ++i)
-	    {
-		alGetSourcei(internal_data->sources[i - 1].id, AL_BUFFERS_PROCESSED, &to_be_freed);
-
-		if (to_be_freed > 0)
-		{
-		    alSourceUnqueueBuffers(internal_data->sources[i - 1].id, to_be_freed, &buffers_freed);
-		    clear_buffer(&buffers_freed, (uint32_t)to_be_freed);
-		    alSourcePlay(internal_data->sources[i - 1].id);
-		}
-	    }
-
-	    for (uint32_t i{}; i < playing_sources.size(); ++i)
-	    {
-		alSourcePlay(internal_data->sources[i - 1].id);
-	    }
-	}
-
-	if (internal_data->free_buffers.empty())
-	{
-	    LOG_ERROR("Could not find or clear a buffer");
+	    LOG_ERROR("No free audio buffers, unload a file or raise max_buffers");
 	    return invalid_32_id;
 	}
 
@@ -283,11 +258,8 @@ namespace egkr::audio
 	ALint source_state{};
 	alGetSourcei(source->id, AL_SOURCE_STATE, &source_state);
 
-	if (source_state != AL_PLAYING)
-	{
-	    LOG_TRACE("Need tp play audio file");
-	    alSourcePlay(source->id);
-	}
+	// A source that ran out of queued buffers stops on its own, restart it once refilled below
+	const bool underrun = source_state == AL_STOPPED && !source->paused;
 
 	ALint processed_buffer_count{};
 	alGetSourcei(source->id, AL_BUFFERS_PROCESSED, &processed_buffer_count);
@@ -315,6 +287,128 @@ namespace egkr::audio
 	    alSourceQueueBuffers(source->id, 1, &buffer_id);
 	}
 
+	if (underrun)
+	{
+	    LOG_TRACE("Audio stream underran, restarting source {}", source->id);
+	    alSourcePlay(source->id);
+	}
+
+	return true;
+    }
+
+    static void run_command(const source_command& command)
+    {
+	auto& source = internal_data->sources[command.source_index];
+	switch (command.command_type)
+	{
+	case source_command::type::play:
+	    source.play();
+	    break;
+	case source_command::type::play_file:
+	    source.play_on_source(command.file);
+	    break;
+	case source_command::type::stop:
+	    source.stop();
+	    break;
+	case source_command::type::pause:
+	    source.pause();
+	    break;
+	case source_command::type::resume:
+	    source.resume();
+	    break;
+	case source_command::type::detach:
+	    for (auto& playing : internal_data->sources)
+	    {
+		if (playing.current == command.file)
+		{
+		    playing.stop();
+		}
+	    }
+	    command.detached->count_down();
+	    break;
+	}
+    }
+
+    static std::chrono::milliseconds refill_interval()
+    {
+	std::chrono::milliseconds interval{max_refill_interval};
+	for (const auto& source : internal_data->sources)
+	{
+	    if (source.is_streaming() && source.current->sample_rate != 0 && source.current->channels != 0)
+	    {
+		const auto samples_per_second = (uint64_t)source.current->sample_rate * (uint64_t)source.current->channels;
+		const std::chrono::milliseconds buffer_length((int64_t)((uint64_t)internal_data->configuration.chunk_size * 1000 / samples_per_second));
+		interval = std::min(interval, buffer_length / 4);
+	    }
+	}
+	return std::max(interval, min_refill_interval);
+    }
+
+    // The one audio thread. Sleeps until a command is queued, or while anything streams until its buffers may
+    // need refilling, then runs the queued commands and refills every streaming source in one pass
+    static void mixer_thread(const std::stop_token& stop_token)
+    {
+	while (!stop_token.stop_requested())
+	{
+	    source_command command{};
+	    while (internal_data->commands.try_pop(command))
+	    {
+		run_command(command);
+	    }
+	    // Anything that spilled was posted after what the ring held
+	    if (internal_data->has_overflow.load(std::memory_order_acquire))
+	    {
+		std::deque<source_command> spilled;
+		{
+		    std::lock_guard lock{internal_data->overflow_mutex};
+		    spilled.swap(internal_data->overflow);
+		    internal_data->has_overflow.store(false, std::memory_order_release);
+		}
+		std::ranges::for_each(spilled, run_command);
+	    }
+
+	    bool is_streaming{};
+	    for (auto& source : internal_data->sources)
+	    {
+		if (source.is_streaming())
+		{
+		    if (!update_stream(source.current, &source))
+		    {
+			source.in_use = false;
+		    }
+		    is_streaming = is_streaming || source.is_streaming();
+		}
+	    }
+
+	    std::unique_lock lock{internal_data->wake_mutex};
+	    auto has_commands = [] { return internal_data->has_commands; };
+	    if (is_streaming)
+	    {
+		internal_data->wake.wait_for(lock, stop_token, refill_interval(), has_commands);
+	    }
+	    else
+	    {
+		internal_data->wake.wait(lock, stop_token, has_commands);
+	    }
+	    internal_data->has_commands = false;
+	    internal_data->wakeups.fetch_add(1, std::memory_order_relaxed);
+	}
+    }
+
+    static bool post_command(const source_command& command)
+    {
+	if (internal_data->has_overflow.load(std::memory_order_acquire) || !internal_data->commands.try_push(command))
+	{
+	    std::lock_guard lock{internal_data->overflow_mutex};
+	    internal_data->overflow.push_back(command);
+	    internal_data->has_overflow.store(true, std::memory_order_release);
+	}
+
+	{
+	    std::lock_guard lock{internal_data->wake_mutex};
+	    internal_data->has_commands = true;
+	}
+	internal_data->wake.notify_one();
 	return true;
     }
 
@@ -370,6 +464,8 @@ namespace egkr::audio
 	    internal_data->free_buffers.push_back(buffer);
 	}
 
+	internal_data->last_statistics_time = std::chrono::steady_clock::now();
+	internal_data->mixer_thread = std::jthread(mixer_thread);
 	return true;
     }
 
@@ -377,6 +473,12 @@ namespace egkr::audio
     {
 	if (internal_data)
 	{
+	    if (internal_data->mixer_thread.joinable())
+	    {
+		internal_data->mixer_thread.request_stop();
+		internal_data->mixer_thread.join();
+	    }
+
 	    for (uint32_t i{}; i < internal_data->configuration.max_sources; ++i)
 	    {
 		internal_data->sources[i].destroy();
@@ -400,6 +502,18 @@ namespace egkr::audio
 
     bool oal::update() { return true; }
 
+    plugin::statistics oal::get_statistics()
+    {
+	const auto now = std::chrono::steady_clock::now();
+	const auto wakeups = internal_data->wakeups.load(std::memory_order_relaxed);
+	const std::chrono::duration<float> elapsed = now - internal_data->last_statistics_time;
+	const float wakeups_per_second = elapsed.count() > 0.F ? (float)(wakeups - internal_data->last_statistics_wakeups) / elapsed.count() : 0.F;
+
+	internal_data->last_statistics_time = now;
+	internal_data->last_statistics_wakeups = wakeups;
+	return {.thread_count = internal_data->mixer_thread.joinable() ? 1U : 0U, .wakeups_per_second = wakeups_per_second};
+    }
+
     float3 oal::get_listener_position() const { return internal_data->listener_position; }
 
     bool oal::set_listener_position(const float3& position)
@@ -454,11 +568,8 @@ namespace egkr::audio
 	return true;
     }
 
-    audio::file* oal::load_chunk(const std::string& name)
+    audio::file* oal::load_chunk(const resource::shared_ptr& resource)
     {
-	audio_resource_loader_params params{.type = audio::type::sound_effect, .chunk_size = (uint64_t)internal_data->configuration.chunk_size};
-	auto resource = resource_system::load(name, resource::type::audio, &params);
-
 	audio::file* file = (audio::file*)resource->data;
 	file->audio_resource = resource;
 	file->data = new plugin_data();
@@ -490,6 +601,7 @@ namespace egkr::audio
 
 	if (file && file->data)
 	{
+	    clear_buffer(&file->data->buffer, 1);
 	    delete file->data;
 	}
 	resource_system::unload(resource);
@@ -512,6 +624,8 @@ namespace egkr::audio
 	    if (file->data->buffers[i] == invalid_32_id)
 	    {
 		LOG_ERROR("Unable to open music file due to no buffers being available");
+		clear_buffer(file->data->buffers.data(), i);
+		delete file->data;
 		resource_system::unload(resource);
 		return nullptr;
 	    }
@@ -530,46 +644,41 @@ namespace egkr::audio
 
     void oal::unload_audio(audio::file* file)
     {
-	clear_buffer(&file->data->buffer, 0);
+	// The mixer may be streaming file right now, so wait until no source refers to it before freeing anything
+	if (internal_data->mixer_thread.joinable())
+	{
+	    std::latch detached{1};
+	    post_command({.command_type = source_command::type::detach, .file = file, .detached = &detached});
+	    detached.wait();
+	}
+
+	if (file->data)
+	{
+	    if (file->audio_type == audio::type::sound_effect)
+	    {
+		clear_buffer(&file->data->buffer, 1);
+	    }
+	    else
+	    {
+		clear_buffer(file->data->buffers.data(), OAL_PLUGIN_MUSIC_BUFFER_COUNT);
+	    }
+	    delete file->data;
+	    file->data = nullptr;
+	}
 
 	resource_system::unload(file->audio_resource);
     }
 
-    bool oal::play_source(uint8_t source_index) { return internal_data->sources[source_index].play(); }
-
-    bool oal::play_on_source(audio::file* file, uint8_t source_index) { return internal_data->sources[source_index].play_on_source(file); }
+    bool oal::play_source(uint8_t source_index) { return post_command({.command_type = source_command::type::play, .source_index = source_index}); }
 
-
-    void oal::stop_source(uint8_t source_index)
+    bool oal::play_on_source(audio::file* file, uint8_t source_index)
     {
-	auto& source = internal_data->sources[source_index];
-	alSourceStop(source.id);
-
-	alSourcei(source.id, AL_BUFFER, 0);
-	check_error();
-	alSourceRewind(source.id);
-	source.in_use = false;
+	return post_command({.command_type = source_command::type::play_file, .source_index = source_index, .file = file});
     }
 
-    void oal::pause_source(uint8_t source_index)
-    {
-	auto& source = internal_data->sources[source_index];
-	ALint source_state{};
-	alGetSourcei(source.id, AL_SOURCE_STATE, &source_state);
-	if (source_state == AL_PLAYING)
-	{
-	    alSourcePause(source.id);
-	}
-    }
+    void oal::stop_source(uint8_t source_index) { post_command({.command_type = source_command::type::stop, .source_index = source_index}); }
 
-    void oal::resume_source(uint8_t source_index)
-    {
-	auto& source = internal_data->sources[source_index];
-	ALint source_state{};
-	alGetSourcei(source.id, AL_SOURCE_STATE, &source_state);
-	if (source_state == AL_PAUSED)
-	{
-	    alSourcePlay(source.id);
-	}
-    }
+    void oal::pause_source(uint8_t source_index) { post_command({.command_type = source_command::type::pause, .source_index = source_index}); }
+
+    void oal::resume_source(uint8_t source_index) { post_command({.command_type = source_command::type::resume, .source_index = source_index}); }
 } // namespace egkr::audio
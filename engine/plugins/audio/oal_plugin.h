@@ -13,6 +13,7 @@ namespace egkr::audio
 		bool shutdown() override;
 
 		bool update() override;
+		statistics get_statistics() override;
 
 		float3 get_listener_position() const override;
 		bool set_listener_position(const float3& position) override;
@@ -32,7 +33,7 @@ namespace egkr::audio
 		const float3& get_source_position(uint32_t source_id) const override;
 		bool set_source_position(uint32_t source_id, const float3& position) override;
 
-		audio::file* load_chunk(const std::string& name) override;
+		audio::file* load_chunk(const resource::shared_ptr& resource) override;
 		audio::file* load_stream(const std::string& name) override;
 
 		void unload_audio(audio::file* file) override;
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <resources/audio.h>
+#include <systems/console_system.h>
+#include "audio_plugin.h"
+
+namespace egkr::audio
+{
+	struct software_state;
+
+	// Mixes every source on the CPU into 16-bit stereo at the configured frequency, needing no audio device.
+	// Mixing happens in update, for the wall time since the previous one
+	class software : public audio::plugin
+	{
+	public:
+		// The mix is written to wav_path, or discarded when it is empty
+		explicit software(std::string wav_path = {});
+		~software() override;
+
+		bool init(const configuration& configuration) override;
+		bool shutdown() override;
+
+		bool update() override;
+		statistics get_statistics() override;
+
+		float3 get_listener_position() const override;
+		bool set_listener_position(const float3& position) override;
+
+		std::pair<const float3&, const float3&> get_orientation() const override;
+		bool set_orientation(const float3& forward, const float3& up) override;
+
+		float get_source_gain(uint32_t source_id) const override;
+		bool set_source_gain(uint32_t source_id, float gain) override;
+
+		float get_source_pitch(uint32_t source_id) const override;
+		bool set_source_pitch(uint32_t source_id, float pitch) override;
+
+		bool get_looping(uint32_t source_id) const override;
+		bool set_looping(uint32_t source_id, bool loop) override;
+
+		const float3& get_source_position(uint32_t source_id) const override;
+		bool set_source_position(uint32_t source_id, const float3& position) override;
+
+		audio::file* load_chunk(const resource::shared_ptr& resource) override;
+		audio::file* load_stream(const std::string& name) override;
+
+		void unload_audio(audio::file* file) override;
+		bool play_source(uint8_t source_index) override;
+		bool play_on_source(audio::file* file, uint8_t source_index) override;
+
+		void stop_source(uint8_t source_index) override;
+		void pause_source(uint8_t source_index) override;
+		void resume_source(uint8_t source_index) override;
+
+		// Plays interleaved samples owned by the caller, which must outlive the playback
+		bool play_samples(uint32_t source_index, std::span<const int16_t> samples, int32_t channels, uint32_t sample_rate);
+		// Mixes frame_count frames and hands them to the output
+		void mix(uint32_t frame_count);
+
+		static void benchmark_command(const console::context& context);
+
+	private:
+		std::string wav_path_;
+		std::unique_ptr<software_state> state_;
+	};
+}
@@ -3,11 +3,11 @@
 
 namespace egkr
 {
-	void command_buffer::begin_render_pass(const vk::RenderPassBeginInfo& renderpass_info) const
+	void command_buffer::begin_render_pass(const vk::RenderPassBeginInfo& renderpass_info, vk::SubpassContents contents) const
 	{
 		ZoneScoped;
 
-		command_buffer_.beginRenderPass(renderpass_info, vk::SubpassContents::eInline);
+		command_buffer_.beginRenderPass(renderpass_info, contents);
 	}
 	void command_buffer::end_render_pass() const
 	{
@@ -45,7 +45,7 @@ namespace egkr
 		state_ = command_buffer_state::not_allocated;
 	}
 
-	void command_buffer::begin(bool is_single_use, bool is_renderpass_continue, bool is_simultaneous_use) const
+	void command_buffer::begin(bool is_single_use, bool is_renderpass_continue, bool is_simultaneous_use, const vk::CommandBufferInheritanceInfo* inheritance) const
 	{
 		ZoneScoped;
 
@@ -68,7 +68,8 @@ namespace egkr
 
 		vk::CommandBufferBeginInfo begin_info{};
 		begin_info
-			.setFlags(usage);
+			.setFlags(usage)
+			.setPInheritanceInfo(inheritance);
 
 		command_buffer_.begin(begin_info);
 	}
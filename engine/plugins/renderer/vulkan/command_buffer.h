@@ -22,7 +22,7 @@ namespace egkr
 		void allocate(const vulkan_context* context, vk::CommandPool pool, bool is_primary);
 		void free(const vulkan_context* context, vk::CommandPool pool);
 
-		void begin(bool is_single_use, bool is_renderpass_continue, bool is_simultaneous_use) const;
+		void begin(bool is_single_use, bool is_renderpass_continue, bool is_simultaneous_use, const vk::CommandBufferInheritanceInfo* inheritance = nullptr) const;
 		void end() const;
 
 		void update_submitted();
@@ -31,7 +31,7 @@ namespace egkr
 		void begin_single_use(const vulkan_context* context, vk::CommandPool pool);
 		void end_single_use(const vulkan_context* context, vk::CommandPool pool, vk::Queue queue);
 
-		void begin_render_pass(const vk::RenderPassBeginInfo& renderpass_info) const;
+		void begin_render_pass(const vk::RenderPassBeginInfo& renderpass_info, vk::SubpassContents contents = vk::SubpassContents::eInline) const;
 		void end_render_pass() const;
 
 		auto& get_handle() const { return command_buffer_; }
@@ -177,7 +177,7 @@ namespace egkr
 			.setBasePipelineHandle(VK_NULL_HANDLE)
 			.setBasePipelineIndex(-1);
 
-		auto result = context_->device.logical_device.createGraphicsPipeline(VK_NULL_HANDLE, pipeline_create_info, context_->allocator);
+		auto result = context_->device.logical_device.createGraphicsPipeline(context_->device.pipeline_cache, pipeline_create_info, context_->allocator);
 		pipeline_ = result.value;
 	}
 
@@ -9,6 +9,7 @@
 #include "vulkan_shader.h"
 #include "vulkan_render_target.h"
 #include "resources/shader.h"
+#include "platform/filesystem.h"
 #include <memory>
 
 #define GLFW_INCLUDE_VULKAN
@@ -16,6 +17,31 @@
 
 namespace egkr
 {
+    constexpr static uint32_t PIPELINE_CACHE_MAGIC{0x45504346};
+
+    // Prefixed to the driver blob so a cache from another device or driver version is discarded rather than handed to the driver
+    struct pipeline_cache_header
+    {
+	uint32_t magic{PIPELINE_CACHE_MAGIC};
+	uint32_t vendor_id{};
+	uint32_t device_id{};
+	uint32_t driver_version{};
+	std::array<uint8_t, VK_UUID_SIZE> pipeline_cache_uuid{};
+	uint64_t data_size{};
+    };
+
+    // What this thread records into while it owns a parallel recording slot. Dynamic state set before the pass begins is held until its secondary exists
+    struct recording_slot_state
+    {
+	uint32_t slot{invalid_32_id};
+	const command_buffer* secondary{};
+	std::optional<vk::Viewport> viewport;
+	std::optional<vk::Rect2D> scissor;
+	vk::FrontFace front_face{vk::FrontFace::eCounterClockwise};
+    };
+
+    static thread_local recording_slot_state recording_slot_{};
+
     static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
         VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT /*messageType*/, const VkDebugUtilsMessengerCallbackDataEXT* callbackData, void* /*userData*/)
     {
@@ -313,6 +339,119 @@ namespace egkr
 	return true;
     }
 
+    const command_buffer& vulkan_context::get_command_buffer() const
+    {
+	if (recording_slot_.secondary)
+	{
+	    return *recording_slot_.secondary;
+	}
+	return graphics_command_buffers[image_index];
+    }
+
+    bool vulkan_context::is_recording_slot() const { return recording_slot_.slot != invalid_32_id; }
+
+    void vulkan_context::begin_secondary(const vk::RenderPassBeginInfo& begin_info) const
+    {
+	ZoneScoped;
+
+	vulkan_recording_pool* recording_pool{};
+	{
+	    std::lock_guard lock{recording_pools_mutex};
+	    auto& pool = recording_pools[std::this_thread::get_id()];
+	    if (!pool)
+	    {
+		pool = std::make_unique<vulkan_recording_pool>();
+	    }
+	    recording_pool = pool.get();
+	}
+
+	while (recording_pool->pools.size() <= image_index)
+	{
+	    vk::CommandPoolCreateInfo pool_create_info{};
+	    pool_create_info.setQueueFamilyIndex(device.graphics_queue_index).setFlags(vk::CommandPoolCreateFlagBits::eTransient);
+
+	    recording_pool->pools.push_back(device.logical_device.createCommandPool(pool_create_info, allocator));
+	    recording_pool->secondaries.emplace_back();
+	    recording_pool->used.push_back(0);
+	}
+
+	auto& secondaries = recording_pool->secondaries[image_index];
+	auto& used = recording_pool->used[image_index];
+	if (used == secondaries.size())
+	{
+	    secondaries.emplace_back().allocate(this, recording_pool->pools[image_index], false);
+	}
+	const auto& secondary = secondaries[used++];
+
+	vk::CommandBufferInheritanceInfo inheritance{};
+	inheritance.setRenderPass(begin_info.renderPass).setSubpass(0).setFramebuffer(begin_info.framebuffer);
+	secondary.begin(true, true, false, &inheritance);
+	recording_slot_.secondary = &secondary;
+
+	secondary.get_handle().setFrontFace(recording_slot_.front_face);
+	if (recording_slot_.viewport)
+	{
+	    secondary.get_handle().setViewport(0, *recording_slot_.viewport);
+	}
+	if (recording_slot_.scissor)
+	{
+	    secondary.get_handle().setScissor(0, *recording_slot_.scissor);
+	}
+
+	recorded_slots[recording_slot_.slot].push_back({
+	    .renderpass = begin_info.renderPass,
+	    .framebuffer = begin_info.framebuffer,
+	    .render_area = begin_info.renderArea,
+	    .clear_values = egkr::vector<vk::ClearValue>(begin_info.pClearValues, begin_info.pClearValues + begin_info.clearValueCount),
+	    .secondary = secondary.get_handle(),
+	});
+    }
+
+    void vulkan_context::end_secondary() const
+    {
+	recording_slot_.secondary->end();
+	recording_slot_.secondary = nullptr;
+    }
+
+    void vulkan_context::set_viewport(const vk::Viewport& viewport) const
+    {
+	if (is_recording_slot())
+	{
+	    recording_slot_.viewport = viewport;
+	    if (!recording_slot_.secondary)
+	    {
+		return;
+	    }
+	}
+	get_command_buffer().get_handle().setViewport(0, viewport);
+    }
+
+    void vulkan_context::set_scissor(const vk::Rect2D& scissor) const
+    {
+	if (is_recording_slot())
+	{
+	    recording_slot_.scissor = scissor;
+	    if (!recording_slot_.secondary)
+	    {
+		return;
+	    }
+	}
+	get_command_buffer().get_handle().setScissor(0, scissor);
+    }
+
+    void vulkan_context::set_front_face(vk::FrontFace front_face) const
+    {
+	if (is_recording_slot())
+	{
+	    recording_slot_.front_face = front_face;
+	    if (!recording_slot_.secondary)
+	    {
+		return;
+	    }
+	}
+	get_command_buffer().get_handle().setFrontFace(front_face);
+    }
+
     void renderer_vulkan::create_command_buffers()
     {
 	ZoneScoped;
@@ -366,6 +505,8 @@ namespace egkr
 
 	context_.surface = create_surface();
 	context_.device.create(&context_);
+	create_pipeline_cache();
+	context_.multithreading_enabled = std::thread::hardware_concurrency() > 1;
 	context_.swpchain = swapchain::create(&context_, {renderer_configuration.backend_flags});
 	out_window_attachment_count = context_.swpchain->get_image_count();
 
@@ -412,8 +553,22 @@ namespace egkr
 	    }
 	    context_.graphics_command_buffers.clear();
 
+	    for (auto& [thread_id, recording_pool] : context_.recording_pools)
+	    {
+		for (auto& pool : recording_pool->pools)
+		{
+		    context_.device.logical_device.destroyCommandPool(pool, context_.allocator);
+		}
+	    }
+	    context_.recording_pools.clear();
+	    context_.recorded_slots.clear();
+
 	    context_.device.logical_device.destroyCommandPool(context_.device.graphics_command_pool);
 
+	    save_pipeline_cache();
+	    context_.device.logical_device.destroyPipelineCache(context_.device.pipeline_cache, context_.allocator);
+	    context_.device.pipeline_cache = VK_NULL_HANDLE;
+
 	    context_.swpchain->destroy();
 	    context_.swpchain.reset();
 
@@ -494,6 +649,13 @@ namespace egkr
 	    return false;
 	}
 
+	// Anything keyed on the image index (its command buffers, per-image regions of persistently mapped buffers)
+	// may still be read by the last submission that used this image, wait for it before recording over them
+	if (context_.images_in_flight[context_.image_index] != VK_NULL_HANDLE)
+	{
+	    context_.images_in_flight[context_.image_index]->wait(std::numeric_limits<uint64_t>::max());
+	}
+
 	auto& command_buffer = context_.graphics_command_buffers[context_.image_index];
 	command_buffer.reset();
 	command_buffer.begin(false, false, false);
@@ -507,10 +669,6 @@ namespace egkr
 	auto& command_buffer = context_.graphics_command_buffers[context_.image_index];
 	command_buffer.end();
 
-	if (context_.images_in_flight[context_.image_index] != VK_NULL_HANDLE)
-	{
-	    context_.images_in_flight[context_.image_index]->wait(std::numeric_limits<uint64_t>::max());
-	}
 	context_.images_in_flight[context_.image_index] = context_.in_flight_fences[context_.current_frame];
 
 	context_.in_flight_fences[context_.current_frame]->reset();
@@ -816,6 +974,74 @@ namespace egkr
 	return true;
     }
 
+    bool renderer_vulkan::create_pipeline_cache()
+    {
+	ZoneScoped;
+
+	const auto& properties = context_.device.properties;
+	egkr::vector<uint8_t> initial_data{};
+
+	if (filesystem::does_path_exist(pipeline_cache_filename_))
+	{
+	    auto handle = filesystem::open(pipeline_cache_filename_, file_mode::read, true);
+	    auto contents = filesystem::read_all(handle);
+
+	    pipeline_cache_header header{};
+	    if (contents.size() >= sizeof(pipeline_cache_header))
+	    {
+		memcpy(&header, contents.data(), sizeof(pipeline_cache_header));
+	    }
+
+	    const bool matches_device = header.magic == PIPELINE_CACHE_MAGIC && header.vendor_id == properties.vendorID && header.device_id == properties.deviceID
+	                             && header.driver_version == properties.driverVersion && std::ranges::equal(header.pipeline_cache_uuid, properties.pipelineCacheUUID)
+	                             && header.data_size == contents.size() - sizeof(pipeline_cache_header);
+
+	    if (matches_device)
+	    {
+		initial_data.assign(contents.begin() + sizeof(pipeline_cache_header), contents.end());
+		LOG_INFO("Loaded pipeline cache: {} bytes", initial_data.size());
+	    }
+	    else
+	    {
+		LOG_INFO("Pipeline cache was created by a different device or driver, discarding");
+	    }
+	}
+
+	vk::PipelineCacheCreateInfo create_info{};
+	create_info.setInitialDataSize(initial_data.size()).setPInitialData(initial_data.data());
+
+	context_.device.pipeline_cache = context_.device.logical_device.createPipelineCache(create_info, context_.allocator);
+	return (bool)context_.device.pipeline_cache;
+    }
+
+    bool renderer_vulkan::save_pipeline_cache()
+    {
+	ZoneScoped;
+
+	if (!context_.device.pipeline_cache)
+	{
+	    return false;
+	}
+
+	const auto data = context_.device.logical_device.getPipelineCacheData(context_.device.pipeline_cache);
+	const auto& properties = context_.device.properties;
+
+	pipeline_cache_header header{.vendor_id = properties.vendorID, .device_id = properties.deviceID, .driver_version = properties.driverVersion, .data_size = data.size()};
+	std::ranges::copy(properties.pipelineCacheUUID, header.pipeline_cache_uuid.begin());
+
+	auto handle = filesystem::open(pipeline_cache_filename_, file_mode::write, true);
+	if (!handle.is_valid)
+	{
+	    LOG_WARN("Failed to write pipeline cache");
+	    return false;
+	}
+
+	filesystem::write(handle, header);
+	filesystem::write(handle, data);
+	LOG_INFO("Saved pipeline cache: {} bytes", data.size());
+	return true;
+    }
+
     bool renderer_vulkan::is_multithreaded() const { return context_.multithreading_enabled; }
 
     texture::shared_ptr renderer_vulkan::create_texture() const { return std::make_shared<vulkan_texture>(); }
@@ -885,8 +1111,7 @@ namespace egkr
 	vk::Viewport viewport{};
 	viewport.setX(rect.x).setY(rect.y).setWidth(rect.z).setHeight(rect.w).setMinDepth(0.F).setMaxDepth(1.F);
 
-	auto& command_buffer = context_.graphics_command_buffers[context_.image_index];
-	command_buffer.get_handle().setViewport(0, viewport);
+	context_.set_viewport(viewport);
     }
 
     void renderer_vulkan::set_scissor(const float4& rect) const
@@ -894,16 +1119,82 @@ namespace egkr
 	vk::Rect2D scissor{};
 	scissor.setOffset({(int32_t)rect.x, (int32_t)rect.y}).setExtent({(uint32_t)rect.z, (uint32_t)rect.w});
 
-	auto& command_buffer = context_.graphics_command_buffers[context_.image_index];
-	command_buffer.get_handle().setScissor(0, scissor);
+	context_.set_scissor(scissor);
     }
 
     void renderer_vulkan::reset_scissor() const { set_scissor(context_.scissor_rect); }
 
-    void renderer_vulkan::set_winding(winding winding) const
+    void renderer_vulkan::set_winding(winding winding) const { context_.set_front_face(winding == winding::counter_clockwise ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise); }
+
+    void renderer_vulkan::begin_parallel_recording(uint32_t slot_count)
     {
-	auto& command_buffer = context_.graphics_command_buffers[context_.image_index];
-	command_buffer.get_handle().setFrontFace(winding == winding::counter_clockwise ? vk::FrontFace::eCounterClockwise : vk::FrontFace::eClockwise);
+	ZoneScoped;
+
+	// begin() has already waited on this image's previous submission, so its pools can be reset
+	{
+	    std::lock_guard lock{context_.recording_pools_mutex};
+	    for (auto& [thread_id, recording_pool] : context_.recording_pools)
+	    {
+		if (context_.image_index < recording_pool->pools.size())
+		{
+		    context_.device.logical_device.resetCommandPool(recording_pool->pools[context_.image_index]);
+		    recording_pool->used[context_.image_index] = 0;
+		}
+	    }
+	}
+
+	for (auto& slot : context_.recorded_slots)
+	{
+	    slot.clear();
+	}
+	context_.recorded_slots.resize(slot_count);
+    }
+
+    void renderer_vulkan::begin_recording_slot(uint32_t slot) const { recording_slot_ = {.slot = slot}; }
+
+    void renderer_vulkan::end_recording_slot() const
+    {
+	if (recording_slot_.secondary)
+	{
+	    LOG_ERROR("Recording slot {} ended inside a renderpass", recording_slot_.slot);
+	    context_.end_secondary();
+	}
+	recording_slot_ = {};
+    }
+
+    void renderer_vulkan::end_parallel_recording()
+    {
+	ZoneScoped;
+
+	const auto& primary = context_.graphics_command_buffers[context_.image_index];
+	const vulkan_recorded_pass* open_pass{};
+	for (const auto& slot : context_.recorded_slots)
+	{
+	    for (const auto& pass : slot)
+	    {
+		// Consecutive slots drawing into the same target share one renderpass instance, the first slot's area and clear values win
+		if (open_pass && (open_pass->renderpass != pass.renderpass || open_pass->framebuffer != pass.framebuffer))
+		{
+		    primary.end_render_pass();
+		    open_pass = nullptr;
+		}
+
+		if (!open_pass)
+		{
+		    vk::RenderPassBeginInfo begin_info{};
+		    begin_info.setRenderPass(pass.renderpass).setFramebuffer(pass.framebuffer).setRenderArea(pass.render_area).setClearValues(pass.clear_values);
+		    primary.begin_render_pass(begin_info, vk::SubpassContents::eSecondaryCommandBuffers);
+		    open_pass = &pass;
+		}
+
+		primary.get_handle().executeCommands(pass.secondary);
+	    }
+	}
+
+	if (open_pass)
+	{
+	    primary.end_render_pass();
+	}
     }
 
     uint32_t renderer_vulkan::get_window_attachment_count() const { return context_.swpchain->get_image_count(); }
@@ -43,6 +43,11 @@ namespace egkr
 	void reset_scissor() const override;
 	void set_winding(winding winding) const override;
 
+	void begin_parallel_recording(uint32_t slot_count) override;
+	void begin_recording_slot(uint32_t slot) const override;
+	void end_recording_slot() const override;
+	void end_parallel_recording() override;
+
 	[[nodiscard]] uint32_t get_window_attachment_count() const override;
 	[[nodiscard]] texture::shared_ptr get_window_attachment(uint8_t index) const override;
 	[[nodiscard]] texture::shared_ptr get_depth_attachment(uint8_t index) const override;
@@ -67,6 +72,9 @@ namespace egkr
 	bool create_logical_device();
 	void create_command_buffers();
 
+	bool create_pipeline_cache();
+	bool save_pipeline_cache();
+
 	bool recreate_swapchain();
 
 	bool is_multithreaded() const override;
@@ -86,5 +94,8 @@ namespace egkr
 	};
 
 	static const inline std::vector<const char*> device_extensions_{"VK_KHR_swapchain"};
+
+	// Written next to the executable, keyed on the device so a driver update invalidates it
+	constexpr static std::string_view pipeline_cache_filename_{"pipeline_cache.bin"};
     };
 }
@@ -85,6 +85,18 @@ namespace egkr
 	}
     }
 
+    void vulkan_geometry::draw_range(uint64_t vertex_offset, uint32_t first_index, uint32_t index_count)
+    {
+	if (!vertex_buffer_ || !index_buffer_)
+	{
+	    LOG_WARN("Tried to render a range of geometry without valid vertex and index buffers");
+	    return;
+	}
+
+	vertex_buffer_->draw(vertex_offset * vertex_size_, 0, true);
+	index_buffer_->draw((uint64_t)first_index * sizeof(uint32_t), index_count, false);
+    }
+
     void vulkan_geometry::update_vertices(uint32_t offset, uint32_t vertex_count, void* vertices)
     {
 	if (vertex_count > vertex_count_)
@@ -16,6 +16,7 @@ namespace egkr
 		bool populate(const properties& properties) override;
 		bool upload() override;
 		void draw() override;
+		void draw_range(uint64_t vertex_offset, uint32_t first_index, uint32_t index_count) override;
 		void update_vertices(uint32_t offset, uint32_t vertex_count, void* vertices) override;
 		void free() override;
 	private:
@@ -22,6 +22,11 @@ namespace egkr
 			memory_property_flags_ = vk::MemoryPropertyFlagBits::eDeviceLocal;
 			buffer_name = "_vertex_";
 			break;
+		case dynamic_vertex:
+			usage_ = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
+			memory_property_flags_ = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+			buffer_name = "_dynamic_vertex_";
+			break;
 		case index:
 			usage_ = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
 			memory_property_flags_ = vk::MemoryPropertyFlagBits::eDeviceLocal;
@@ -43,8 +48,10 @@ namespace egkr
 			buffer_name = "_read_";
 			break;
 		case storage:
-			LOG_ERROR("Storage buffers not supported yet");
-			return;
+			usage_ = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
+			memory_property_flags_ = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+			buffer_name = "_storage_";
+			break;
 		default:
 			LOG_ERROR("Unknown buffer type specified");
 			return;
@@ -85,6 +92,12 @@ namespace egkr
 
 	void vulkan_buffer::destroy()
 	{
+		if (mapped_memory_)
+		{
+			context_->device.logical_device.unmapMemory(memory_);
+			mapped_memory_ = nullptr;
+		}
+
 		if (memory_)
 		{
 			context_->device.logical_device.freeMemory(memory_, context_->allocator);
@@ -103,6 +116,10 @@ namespace egkr
 	void vulkan_buffer::bind(uint64_t offset)
 	{
 		context_->device.logical_device.bindBufferMemory(handle_, memory_, offset);
+		if (type_ == egkr::renderbuffer::type::dynamic_vertex || type_ == egkr::renderbuffer::type::storage)
+		{
+			mapped_memory_ = context_->device.logical_device.mapMemory(memory_, 0, VK_WHOLE_SIZE);
+		}
 	}
 
 	void vulkan_buffer::unbind()
@@ -111,11 +128,19 @@ namespace egkr
 
 	void* vulkan_buffer::map_memory(uint64_t offset, uint64_t size)
 	{
+		if (mapped_memory_)
+		{
+			return (uint8_t*)mapped_memory_ + offset;
+		}
 		return context_->device.logical_device.mapMemory(memory_, offset, size);
 	}
 
 	void vulkan_buffer::unmap()
 	{
+		if (mapped_memory_)
+		{
+			return;
+		}
 		context_->device.logical_device.unmapMemory(memory_);
 	}
 
@@ -177,15 +202,22 @@ namespace egkr
 		vk::DeviceMemory new_memory = context_->device.logical_device.allocateMemory(allocate_info, context_->allocator);
 
 		context_->device.logical_device.bindBufferMemory(new_buffer, new_memory, 0);
-		copy_range(0, new_buffer, 0, total_size_);
+		copy_range(0, new_buffer, 0, std::min(total_size_, new_size));
 
 		context_->device.logical_device.waitIdle();
 
+		const bool persistently_mapped = is_persistently_mapped();
 		destroy();
 
 		memory_requirements_ = memory_requirements;
 		memory_ = new_memory;
 		handle_ = new_buffer;
+		total_size_ = new_size;
+
+		if (persistently_mapped)
+		{
+			mapped_memory_ = context_->device.logical_device.mapMemory(memory_, 0, VK_WHOLE_SIZE);
+		}
 	}
 
 	void vulkan_buffer::load_range(uint64_t offset, uint64_t size, const void* data)
@@ -216,9 +248,9 @@ namespace egkr
 
 	void vulkan_buffer::draw(uint64_t offset, uint32_t element_count, bool bind_only)
 	{
-		auto& command_buffer = context_->graphics_command_buffers[context_->image_index];
+		auto& command_buffer = context_->get_command_buffer();
 
-		if (type_ == egkr::renderbuffer::type::vertex)
+		if (type_ == egkr::renderbuffer::type::vertex || type_ == egkr::renderbuffer::type::dynamic_vertex)
 		{
 			command_buffer.get_handle().bindVertexBuffers(0, handle_, offset);
 			if (!bind_only)
@@ -257,7 +289,7 @@ namespace egkr
 	
 	bool vulkan_buffer::is_host_coherent() const
 	{
-		return (memory_property_flags_ & vk::MemoryPropertyFlagBits::eHostCoherent) == vk::MemoryPropertyFlagBits::eHostVisible;
+		return (memory_property_flags_ & vk::MemoryPropertyFlagBits::eHostCoherent) == vk::MemoryPropertyFlagBits::eHostCoherent;
 	}
 	void vulkan_buffer::copy_range(uint64_t source_offset, vk::Buffer destination, uint64_t dest_offset, uint64_t size)
 	{
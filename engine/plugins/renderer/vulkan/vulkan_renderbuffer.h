@@ -43,6 +43,7 @@ namespace egkr
 		bool is_device_local() const;
 		bool is_host_visible() const;
 		bool is_host_coherent() const;
+		bool is_persistently_mapped() const { return mapped_memory_ != nullptr; }
 
 	protected:
 		void copy_range(uint64_t source_offset, vk::Buffer destination, uint64_t dest_offset, uint64_t size);
@@ -56,5 +57,8 @@ namespace egkr
 		uint32_t memory_index_{invalid_32_id};
 		vk::MemoryRequirements memory_requirements_{};
 		vk::MemoryPropertyFlags memory_property_flags_{};
+
+		// Only set for dynamic vertex buffers, mapped once on bind and unmapped on destroy
+		void* mapped_memory_{};
 	};
 }
@@ -210,8 +210,6 @@ namespace egkr::renderpass
 	{
 		auto render_target = render_targets_[index];
 		auto* vulkan_render_target = (render_target::vulkan_render_target*)render_target.get();
-		const auto& command_buffer = context_->graphics_command_buffers[context_->image_index];
-
 		auto* viewport = engine::get()->get_renderer()->get_active_viewport();
 
 		vk::Rect2D render_area{};
@@ -255,9 +253,15 @@ namespace egkr::renderpass
 
 		begin_info.setClearValues(clear_colours);
 
-		command_buffer.get_handle().setFrontFace(vk::FrontFace::eCounterClockwise);
+		context_->set_front_face(vk::FrontFace::eCounterClockwise);
+
+		if (context_->is_recording_slot())
+		{
+			context_->begin_secondary(begin_info);
+			return true;
+		}
 
-		command_buffer.begin_render_pass(begin_info);
+		context_->get_command_buffer().begin_render_pass(begin_info);
 		return true;
 	}
 
@@ -265,8 +269,13 @@ namespace egkr::renderpass
 	{
 		ZoneScoped;
 
-		auto& command_buffer = context_->graphics_command_buffers[context_->image_index];
-		command_buffer.end_render_pass();
+		if (context_->is_recording_slot())
+		{
+			context_->end_secondary();
+			return true;
+		}
+
+		context_->get_command_buffer().end_render_pass();
 		return true;
 	}
 
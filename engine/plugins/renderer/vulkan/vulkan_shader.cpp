@@ -3,6 +3,7 @@
 
 #include "systems/resource_system.h"
 #include "systems/texture_system.h"
+#include "systems/job_system.h"
 
 namespace egkr
 {
@@ -74,7 +75,7 @@ namespace egkr
 
 	bool vulkan_shader::use()
 	{
-		const auto& command_buffer = context_->graphics_command_buffers[context_->image_index];
+		const auto& command_buffer = context_->get_command_buffer();
 		pipelines_[bound_pipeline_index_]->bind(command_buffer, vk::PipelineBindPoint::eGraphics);
 		command_buffer.get_handle().setPrimitiveTopology(current_topology_);
 		return true;
@@ -117,6 +118,12 @@ namespace egkr
 
 		configuration.pool_sizes.push_back(vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, 1024));
 		configuration.pool_sizes.push_back(vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, 4096));
+		const auto storage_buffer_count = (uint32_t)properties_.storage_buffers.size();
+		if (storage_buffer_count)
+		{
+			// Only the per-frame global sets hold storage buffers
+			configuration.pool_sizes.push_back(vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, storage_buffer_count * (uint32_t)global_descriptor_sets.size()));
+		}
 
 
 		for (const auto& shader_uniform : uniforms_)
@@ -155,7 +162,7 @@ namespace egkr
 			}
 		}
 
-		if (properties_.global_uniform_count || properties_.global_uniform_sampler_count)
+		if (properties_.global_uniform_count || properties_.global_uniform_sampler_count || storage_buffer_count)
 		{
 			vulkan_descriptor_set_configuration global_descriptor_set_configuration{};
 
@@ -179,6 +186,22 @@ namespace egkr
 				configuration.descriptor_sets[DESCRIPTOR_SET_INDEX_GLOBAL].sampler_binding_index = binding_index;
 				global_descriptor_set_configuration.bindings.push_back(ubo);
 			}
+
+			if (storage_buffer_count)
+			{
+				// One binding per buffer so each can be swapped independently
+				auto binding_index = (uint8_t)global_descriptor_set_configuration.bindings.size();
+				global_descriptor_set_configuration.storage_binding_index = binding_index;
+				for (auto i{ 0U }; i < storage_buffer_count; ++i)
+				{
+					vk::DescriptorSetLayoutBinding storage{};
+					storage.setBinding(binding_index + i)
+						.setDescriptorCount(1)
+						.setDescriptorType(vk::DescriptorType::eStorageBuffer)
+						.setStageFlags(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
+					global_descriptor_set_configuration.bindings.push_back(storage);
+				}
+			}
 			configuration.descriptor_sets[DESCRIPTOR_SET_INDEX_GLOBAL] = global_descriptor_set_configuration;
 		}
 
@@ -211,10 +234,14 @@ namespace egkr
 			configuration.descriptor_sets[DESCRIPTOR_SET_INDEX_INSTANCE] = instance_descriptor_set_configuration;
 		}
 
-		for (auto i{ 0U }; i < stage_flags.size(); ++i)
+		// Reading the SPIR-V and creating the module is independent per stage
+		vulkan_stages.resize(configuration.stages.size());
+		egkr::vector<std::function<void()>> stage_tasks{};
+		for (auto i{ 0U }; i < configuration.stages.size(); ++i)
 		{
-			vulkan_stages.push_back(create_module(configuration.stages[i]));
+			stage_tasks.emplace_back([this, i]() { vulkan_stages[i] = create_module(configuration.stages[i]); });
 		}
+		job_system::execute_and_wait(stage_tasks, job::type::general);
 
 		const auto& attributes = get_attributes();
 
@@ -271,31 +298,32 @@ namespace egkr
 		pipeline_properties.shader_flags = properties_.shader_flags;
 		bool pipeline_bound{};
 
-		if (topology_types_ & primitive_topology_type::point_list)
+		// Each topology class gets its own pipeline, build them as jobs against the shared pipeline cache
+		egkr::vector<std::function<void()>> pipeline_tasks{};
+		const auto create_pipeline = [&](topology_class pipeline_class, primitive_topology_type topology, vk::PrimitiveTopology default_topology)
 		{
-			pipeline_properties.topology_types = primitive_topology_type::point_list;
-			pipelines_[(int)topology_class::point] = pipeline::create(context_, pipeline_properties);
-			bound_pipeline_index_ = (int)topology_class::point;
-			current_topology_ = vk::PrimitiveTopology::ePointList;
+			auto class_properties = pipeline_properties;
+			class_properties.topology_types = topology;
+			pipeline_tasks.emplace_back([this, pipeline_class, class_properties]() { pipelines_[(size_t)pipeline_class] = pipeline::create(context_, class_properties); });
+			bound_pipeline_index_ = (uint16_t)pipeline_class;
+			current_topology_ = default_topology;
 			pipeline_bound = true;
+		};
+
+		if (topology_types_ & primitive_topology_type::point_list)
+		{
+			create_pipeline(topology_class::point, primitive_topology_type::point_list, vk::PrimitiveTopology::ePointList);
 		}
 		if (topology_types_ & primitive_topology_type::line_list || topology_types_ & primitive_topology_type::line_strip)
 		{
-			pipeline_properties.topology_types = primitive_topology_type::line_list | primitive_topology_type::line_strip;
-			pipelines_[(int)topology_class::line] = pipeline::create(context_, pipeline_properties);
-			bound_pipeline_index_ = (int)topology_class::line;
-			current_topology_ = vk::PrimitiveTopology::eLineList;
-			pipeline_bound = true;
+			create_pipeline(topology_class::line, primitive_topology_type::line_list | primitive_topology_type::line_strip, vk::PrimitiveTopology::eLineList);
 		}
 		if (topology_types_ & primitive_topology_type::triangle_list || topology_types_ & primitive_topology_type::triangle_strip || topology_types_ & primitive_topology_type::triangle_fan)
 		{
-			pipeline_properties.topology_types = primitive_topology_type::triangle_fan | primitive_topology_type::triangle_strip | primitive_topology_type::triangle_list;
-			pipelines_[(int)topology_class::triangle] = pipeline::create(context_, pipeline_properties);
-			bound_pipeline_index_ = (int)topology_class::triangle;
-			current_topology_ = vk::PrimitiveTopology::eTriangleList;
-			pipeline_bound = true;
+			create_pipeline(topology_class::triangle, primitive_topology_type::triangle_fan | primitive_topology_type::triangle_strip | primitive_topology_type::triangle_list, vk::PrimitiveTopology::eTriangleList);
 		}
 
+		job_system::execute_and_wait(pipeline_tasks, job::type::general);
 
 		if (!pipeline_bound)
 		{
@@ -337,7 +365,7 @@ namespace egkr
 		}
 
 		const auto image_index = context_->image_index;
-		const auto& command_buffer = context_->graphics_command_buffers[image_index].get_handle();
+		const auto& command_buffer = context_->get_command_buffer().get_handle();
 
 		auto& object_state = instance_states[get_bound_instance_id()];
 		auto& object_descriptor_set = object_state.descriptor_set_state.descriptor_sets[image_index];
@@ -480,9 +508,31 @@ namespace egkr
 
 			egkr::vector<vk::WriteDescriptorSet> writes{ ubo_write };
 
+			// Infos are sized up front so the writes can point into them
+			egkr::vector<vk::DescriptorBufferInfo> storage_infos(storage_buffers_.size());
+			const auto storage_binding_index = configuration.descriptor_sets[DESCRIPTOR_SET_INDEX_GLOBAL].storage_binding_index;
+			for (auto i{ 0U }; i < storage_buffers_.size(); ++i)
+			{
+				if (!storage_buffers_[i])
+				{
+					continue;
+				}
+
+				storage_infos[i].setBuffer(*(vk::Buffer*)(storage_buffers_[i]->get_buffer())).setOffset(0).setRange(VK_WHOLE_SIZE);
+
+				vk::WriteDescriptorSet storage_write{};
+				storage_write.setDstSet(global_descriptor)
+					.setDstBinding(storage_binding_index + i)
+					.setDstArrayElement(0)
+					.setDescriptorType(vk::DescriptorType::eStorageBuffer)
+					.setDescriptorCount(1)
+					.setBufferInfo(storage_infos[i]);
+				writes.push_back(storage_write);
+			}
+
 			context_->device.logical_device.updateDescriptorSets(writes, nullptr);
 		}
-		const auto& command_buffer = context_->graphics_command_buffers[image_index].get_handle();
+		const auto& command_buffer = context_->get_command_buffer().get_handle();
 		command_buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelines_[bound_pipeline_index_]->get_layout(), 0, 1, &global_descriptor, 0, nullptr);
 
 		return true;
@@ -527,7 +577,7 @@ namespace egkr
 			if (shader_uniform.uniform_scope == scope::local)
 			{
 				// Is local, using push constants. Do this immediately.
-				const auto& command_buffer = context_->graphics_command_buffers[context_->image_index].get_handle();
+				const auto& command_buffer = context_->get_command_buffer().get_handle();
 				command_buffer.pushConstants(
 					pipelines_[bound_pipeline_index_]->get_layout(), vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, (uint32_t)shader_uniform.offset, shader_uniform.size, value);
 			}
@@ -23,6 +23,7 @@ namespace egkr
 		egkr::vector<vk::DescriptorSetLayoutBinding> bindings;
 		uint32_t binding_count{};
 		uint8_t sampler_binding_index{};
+		uint8_t storage_binding_index{};
 	};
 
 	struct vulkan_stage_configuration
@@ -335,6 +335,34 @@ namespace egkr
 	return true;
     }
 
+    bool vulkan_texture::write_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* texture_data)
+    {
+	ZoneScoped;
+
+	auto image_format = channel_count_to_format(properties_.channel_count, vk::Format::eR8G8B8A8Unorm);
+	const uint64_t size = (uint64_t)width * height * properties_.channel_count;
+
+	auto staging_buffer = renderbuffer::renderbuffer::create(renderbuffer::type::staging, size);
+	staging_buffer->bind(0);
+
+	staging_buffer->load_range(0, size, texture_data);
+
+	command_buffer single_use{};
+	single_use.begin_single_use(context_, context_->device.graphics_command_pool);
+
+	// Coming from shader read rather than undefined so the rest of the image is preserved
+	transition_layout(single_use, image_format, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferDstOptimal);
+	copy_region_from_buffer(single_use, *(vk::Buffer*)staging_buffer->get_buffer(), x, y, width, height);
+
+	if (mip <= 1 || !generate_mipmaps(single_use, image_format, properties_.mip_levels))
+	{
+	    transition_layout(single_use, image_format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+	}
+
+	single_use.end_single_use(context_, context_->device.graphics_command_pool, context_->device.graphics_queue);
+	return true;
+    }
+
     void vulkan_texture::read_data(uint64_t offset, uint64_t size, void* out_memory)
     {
 	auto format = channel_count_to_format(properties_.channel_count, vk::Format::eR8G8B8A8Unorm);
@@ -375,7 +403,10 @@ namespace egkr
     {
 	ZoneScoped;
 
+	// destroy() forgets the context, which the new image still needs
+	const auto* context = context_;
 	destroy();
+	context_ = context;
 
 	const vulkan_texture::properties texture_properties{
 	    .image_format = channel_count_to_format(properties_.channel_count, vk::Format::eR8G8B8A8Unorm),
@@ -386,7 +417,7 @@ namespace egkr
 	};
 	width_ = width;
 	height_ = height;
-	mip = (uint32_t)std::floorf(std::log2f(std::max(width, height)) + 1);
+	mip = texture_properties.mip_levels;
 
 	populate_internal(texture_properties);
 
@@ -454,6 +485,13 @@ namespace egkr
 	    source_stage = vk::PipelineStageFlagBits::eTopOfPipe;
 	    destination_stage = vk::PipelineStageFlagBits::eTransfer;
 	}
+	else if (old_layout == vk::ImageLayout::eShaderReadOnlyOptimal && new_layout == vk::ImageLayout::eTransferDstOptimal)
+	{
+	    barrier.setSrcAccessMask(vk::AccessFlagBits::eShaderRead).setDstAccessMask(vk::AccessFlagBits::eTransferWrite);
+
+	    source_stage = vk::PipelineStageFlagBits::eFragmentShader;
+	    destination_stage = vk::PipelineStageFlagBits::eTransfer;
+	}
 	else if (old_layout == vk::ImageLayout::eTransferDstOptimal && new_layout == vk::ImageLayout::eShaderReadOnlyOptimal)
 	{
 	    barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite).setDstAccessMask(vk::AccessFlagBits::eShaderRead);
@@ -498,6 +536,24 @@ namespace egkr
 	command_buffer.get_handle().copyBufferToImage(buffer, image_, vk::ImageLayout::eTransferDstOptimal, image_copy);
     }
 
+    void vulkan_texture::copy_region_from_buffer(command_buffer command_buffer, vk::Buffer buffer, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+	ZoneScoped;
+
+	vk::ImageSubresourceLayers subresource{};
+	subresource.setAspectMask(vk::ImageAspectFlagBits::eColor).setMipLevel(0).setBaseArrayLayer(0).setLayerCount(1);
+
+	vk::BufferImageCopy image_copy{};
+	image_copy.setBufferOffset(0)
+	    .setBufferRowLength(0)
+	    .setBufferImageHeight(0)
+	    .setImageSubresource(subresource)
+	    .setImageOffset({(int32_t)x, (int32_t)y, 0})
+	    .setImageExtent({width, height, 1});
+
+	command_buffer.get_handle().copyBufferToImage(buffer, image_, vk::ImageLayout::eTransferDstOptimal, image_copy);
+    }
+
     void vulkan_texture::copy_to_buffer(command_buffer command_buffer, vk::Buffer buffer)
     {
 	ZoneScoped;
@@ -45,6 +45,7 @@ namespace egkr
 	bool generate_mipmaps(const command_buffer& command_buffer, vk::Format image_format, uint32_t mip_levels);
 
 	bool write_data(uint64_t offset, uint64_t size, const uint8_t* data) override;
+	bool write_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) override;
 	void read_data(uint64_t offset, uint64_t size, void* out_memory) override;
 	void read_pixel(uint32_t x, uint32_t y, uint4* out_rgba) override;
 	bool resize(uint32_t width, uint32_t height) override;
@@ -56,6 +57,7 @@ namespace egkr
 
 	void transition_layout(command_buffer command_buffer, vk::Format format, vk::ImageLayout old_layout, vk::ImageLayout new_layout);
 	void copy_from_buffer(command_buffer command_buffer, vk::Buffer buffer);
+	void copy_region_from_buffer(command_buffer command_buffer, vk::Buffer buffer, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 	void copy_to_buffer(command_buffer command_buffer, vk::Buffer buffer);
 	void copy_pixel_to_buffer(command_buffer command_buffer, vk::Buffer buffer, uint32_t x, uint32_t y);
 
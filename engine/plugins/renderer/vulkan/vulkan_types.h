@@ -2,6 +2,9 @@
 
 #include "pch.h"
 #include <vulkan/vulkan.hpp>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include "swapchain.h"
 #include "vulkan_renderpass.h"
@@ -63,6 +66,7 @@ namespace egkr
 		vk::PhysicalDeviceMemoryProperties memory{};
 
 		vk::CommandPool graphics_command_pool{};
+		vk::PipelineCache pipeline_cache{};
 
 		swapchain_support_details swapchain_supprt{};
 
@@ -74,6 +78,24 @@ namespace egkr
 	};
 
 
+	// Command pools owned by a single recording thread, one per swapchain image so a pool is only reset once its image is out of flight
+	struct vulkan_recording_pool
+	{
+		egkr::vector<vk::CommandPool> pools;
+		egkr::vector<egkr::vector<command_buffer>> secondaries;
+		egkr::vector<uint32_t> used;
+	};
+
+	// A render pass instance recorded into a secondary buffer, replayed into the primary in slot order
+	struct vulkan_recorded_pass
+	{
+		vk::RenderPass renderpass{};
+		vk::Framebuffer framebuffer{};
+		vk::Rect2D render_area{};
+		egkr::vector<vk::ClearValue> clear_values;
+		vk::CommandBuffer secondary{};
+	};
+
 	struct vulkan_context
 	{
 		vk::Instance instance;
@@ -110,6 +132,19 @@ namespace egkr
 #endif
 
 		float4 scissor_rect{};
+
+		mutable std::mutex recording_pools_mutex;
+		mutable std::unordered_map<std::thread::id, std::unique_ptr<vulkan_recording_pool>> recording_pools;
+		mutable egkr::vector<egkr::vector<vulkan_recorded_pass>> recorded_slots;
+
+		// The secondary this thread is recording a slot into, otherwise the frame's primary
+		const command_buffer& get_command_buffer() const;
+		bool is_recording_slot() const;
+		void begin_secondary(const vk::RenderPassBeginInfo& begin_info) const;
+		void end_secondary() const;
+		void set_viewport(const vk::Viewport& viewport) const;
+		void set_scissor(const vk::Rect2D& scissor) const;
+		void set_front_face(vk::FrontFace front_face) const;
 	};
 
 	struct queue_family_indices
@@ -39,6 +39,7 @@ namespace egkr::pass
 	    renderpass_configuration.target.attachments.push_back(colour_attachment_configration);
 	    renderpass_configuration.target.attachments.push_back(depth_attachment_configration);
 
+	    apply_attachment_usage(renderpass_configuration);
 	    renderpass = renderpass::renderpass::create(renderpass_configuration);
 	}
 
@@ -7,6 +7,8 @@
 #include "engine/engine.h"
 #include "systems/light_system.h"
 
+#include <unordered_map>
+
 namespace egkr::pass
 {
     scene* scene::create()
@@ -39,39 +41,39 @@ namespace egkr::pass
 	    renderpass_configuration.target.attachments.push_back(colour_attachment_configration);
 	    renderpass_configuration.target.attachments.push_back(depth_attachment_configration);
 
+	    apply_attachment_usage(renderpass_configuration);
 	    renderpass = egkr::renderpass::renderpass::create(renderpass_configuration);
 	}
 
 	{
-	    const std::string shader_name = "Shader.Material";
-	    auto resource = resource_system::load(shader_name, resource::type::shader, nullptr);
-	    auto* shader = (shader::properties*)resource->data;
-	    shader_system::create_shader(*shader, renderpass.get());
-	    resource_system::unload(resource);
+	    // None of this pass's shaders depend on each other, so their modules and pipelines are built together
+	    constexpr std::array shader_names{"Shader.Material", "Shader.Colour3DShader", "Shader.Terrain", "Shader.PBR"};
+	    egkr::vector<resource::shared_ptr> resources{};
+	    egkr::vector<const shader::properties*> properties{};
+	    for (const auto* shader_name : shader_names)
+	    {
+		auto& resource = resources.emplace_back(resource_system::load(shader_name, resource::type::shader, nullptr));
+		properties.push_back((const shader::properties*)resource->data);
+	    }
+
+	    auto shaders = shader_system::create_shaders(properties, renderpass.get());
+	    for (auto& resource : resources)
+	    {
+		resource_system::unload(resource);
+	    }
 
-	    material_shader = shader_system::get_shader(shader_name);
+	    material_shader = shaders[0];
+	    debug_colour_shader = shaders[1];
+	    terrain_shader = shaders[2];
+	    pbr_shader = shaders[3];
 	}
 
 	{
-	    std::string colour_3d_shader_name = "Shader.Colour3DShader";
-	    auto shader = resource_system::load(colour_3d_shader_name, egkr::resource::type::shader, nullptr);
-	    auto* properties = (shader::properties*)shader->data;
-	    shader_system::create_shader(*properties, renderpass.get());
-	    resource_system::unload(shader);
-
-	    debug_colour_shader = shader_system::get_shader(colour_3d_shader_name);
 	    debug_shader_locations.projection = debug_colour_shader->get_uniform_index("projection");
 	    debug_shader_locations.view = debug_colour_shader->get_uniform_index("view");
 	    debug_shader_locations.model = debug_colour_shader->get_uniform_index("model");
 	}
 	{
-	    std::string terrain_shader_name = "Shader.Terrain";
-	    auto shader = resource_system::load(terrain_shader_name, egkr::resource::type::shader, nullptr);
-	    auto* properties = (shader::properties*)shader->data;
-	    shader_system::create_shader(*properties, renderpass.get());
-	    resource_system::unload(shader);
-
-	    terrain_shader = shader_system::get_shader(terrain_shader_name);
 	    terrain_shader->acquire_instance_resources({});
 
 	    terrain_shader_locations.projection = terrain_shader->get_uniform_index("projection");
@@ -85,20 +87,13 @@ namespace egkr::pass
 	    terrain_shader_locations.view_position = terrain_shader->get_uniform_index("view_position");
 	    terrain_shader_locations.model = terrain_shader->get_uniform_index("model");
 	    terrain_shader_locations.mode = terrain_shader->get_uniform_index("mode");
-	    terrain_shader_locations.point_light = terrain_shader->get_uniform_index("point_lights");
 	    terrain_shader_locations.directional_light = terrain_shader->get_uniform_index("dir_light");
-	    terrain_shader_locations.num_point_lights = terrain_shader->get_uniform_index("num_point_lights");
+	    terrain_shader_locations.lights = terrain_shader->get_storage_index("lights");
+	    terrain_shader_locations.light_grid = terrain_shader->get_storage_index("light_grid");
+	    terrain_shader_locations.light_indices = terrain_shader->get_storage_index("light_indices");
 	}
 
 	{
-	    const std::string shader_name = "Shader.PBR";
-	    auto resource = resource_system::load(shader_name, resource::type::shader, nullptr);
-	    auto* shader = (shader::properties*)resource->data;
-	    shader_system::create_shader(*shader, renderpass.get());
-	    resource_system::unload(resource);
-
-	    pbr_shader = shader_system::get_shader(shader_name);
-
 	    pbr_shader_locations.projection = pbr_shader->get_uniform_index("projection");
 	    pbr_shader_locations.view = pbr_shader->get_uniform_index("view");
 	    pbr_shader_locations.albedo_texture = pbr_shader->get_uniform_index("albedo_texture");
@@ -109,9 +104,10 @@ namespace egkr::pass
 	    pbr_shader_locations.view_position = pbr_shader->get_uniform_index("view_position");
 	    pbr_shader_locations.model = pbr_shader->get_uniform_index("model");
 	    pbr_shader_locations.ibl_texture = pbr_shader->get_uniform_index("cube_texture");
-	    pbr_shader_locations.point_lights = pbr_shader->get_uniform_index("point_lights");
 	    pbr_shader_locations.directional_light = pbr_shader->get_uniform_index("dir_light");
-	    pbr_shader_locations.num_point_lights = pbr_shader->get_uniform_index("num_point_lights");
+	    pbr_shader_locations.lights = pbr_shader->get_storage_index("lights");
+	    pbr_shader_locations.light_grid = pbr_shader->get_storage_index("light_grid");
+	    pbr_shader_locations.light_indices = pbr_shader->get_storage_index("light_indices");
 	    pbr_shader_locations.ambient_colour = pbr_shader->get_uniform_index("ambient_colour");
 	    pbr_shader_locations.properties = pbr_shader->get_uniform_index("properties");
 	    pbr_shader_locations.mode = pbr_shader->get_uniform_index("mode");
@@ -123,131 +119,214 @@ namespace egkr::pass
     }
 
     bool scene::execute(const frame_data& frame_data) const
+    {
+	if (!prepare(frame_data))
+	{
+	    return false;
+	}
+
+	engine::get()->get_renderer()->set_active_viewport(viewport);
+	renderpass->begin(frame_data.render_target_index);
+
+	for (uint32_t chunk_index{0u}; chunk_index < get_chunk_count(); ++chunk_index)
+	{
+	    draw_chunk(frame_data, chunk_index);
+	}
+
+	renderpass->end();
+	return true;
+    }
+
+    bool scene::execute_chunk(const frame_data& frame_data, uint32_t chunk_index) const
     {
 	engine::get()->get_renderer()->set_active_viewport(viewport);
 	renderpass->begin(frame_data.render_target_index);
+	draw_chunk(frame_data, chunk_index);
+	renderpass->end();
+	return true;
+    }
 
+    bool scene::prepare(const frame_data& frame_data) const
+    {
+	light_system::update_clusters(frame_data, view, projection, viewport->near_clip, viewport->far_clip);
+	const auto& light_buffers = light_system::get_cluster_buffers(frame_data);
+
+	// Globals are written once here, the chunks only bind them
 	if (!data.terrain.empty())
 	{
-	    const float shininess{32};
-	    const float4 diffuse_colour{0.5, 0.5, 0.5, 1.0};
 	    shader_system::use(terrain_shader->get_id());
 	    shader_system::set_uniform(terrain_shader_locations.projection, &projection);
 	    shader_system::set_uniform(terrain_shader_locations.view, &view);
 	    shader_system::set_uniform(terrain_shader_locations.ambient_colour, &data.ambient_colour);
 	    shader_system::set_uniform(terrain_shader_locations.view_position, &view_position);
 	    shader_system::set_uniform(terrain_shader_locations.mode, &data.render_mode);
+	    shader_system::set_storage_buffer(terrain_shader_locations.lights, light_buffers.lights.get());
+	    shader_system::set_storage_buffer(terrain_shader_locations.light_grid, light_buffers.grid.get());
+	    shader_system::set_storage_buffer(terrain_shader_locations.light_indices, light_buffers.indices.get());
 
 	    shader_system::apply_global(true);
+	}
+
+	shader_system::use(material_shader->get_id());
+	material_system::apply_global(material_shader->get_id(), frame_data, projection, view, data.ambient_colour, view_position, data.render_mode);
+
+	shader_system::use(pbr_shader->get_id());
+	shader_system::set_uniform(pbr_shader_locations.projection, &projection);
+	shader_system::set_uniform(pbr_shader_locations.view, &view);
+	shader_system::set_uniform(pbr_shader_locations.ambient_colour, &data.ambient_colour);
+	shader_system::set_uniform(pbr_shader_locations.view_position, &view_position);
+	shader_system::set_uniform(pbr_shader_locations.mode, &data.render_mode);
+	shader_system::set_storage_buffer(pbr_shader_locations.lights, light_buffers.lights.get());
+	shader_system::set_storage_buffer(pbr_shader_locations.light_grid, light_buffers.grid.get());
+	shader_system::set_storage_buffer(pbr_shader_locations.light_indices, light_buffers.indices.get());
+	pbr_shader->apply_globals(true);
+
+	if (!data.debug_geometries.empty())
+	{
+	    shader_system::use(debug_colour_shader->get_id());
+	    shader_system::set_uniform(debug_shader_locations.projection, &projection);
+	    shader_system::set_uniform(debug_shader_locations.view, &view);
+	    shader_system::apply_global(true);
+	}
+
+	// A material never spans two chunks so its instance state is only touched by the thread recording that chunk
+	const auto chunk_count = std::clamp((uint32_t)data.geometries.size() / draws_per_chunk, 1U, max_chunks);
+	for (auto& chunk : draw_chunks)
+	{
+	    chunk.clear();
+	}
+	draw_chunks.resize(chunk_count);
+
+	std::unordered_map<const material*, uint32_t> chunk_by_material;
+	for (const egkr::render_data& render_data : data.geometries)
+	{
+	    auto [chunk, inserted] = chunk_by_material.try_emplace(render_data.render_geometry->get_material().get(), 0);
+	    if (inserted)
+	    {
+		const auto smallest = std::ranges::min_element(draw_chunks, {}, [](const auto& draws) { return draws.size(); });
+		chunk->second = (uint32_t)std::distance(draw_chunks.begin(), smallest);
+	    }
+	    draw_chunks[chunk->second].push_back(&render_data);
+	}
+
+	return true;
+    }
+
+    void scene::draw_chunk(const frame_data& frame_data, uint32_t chunk_index) const
+    {
+	if (chunk_index == 0 && !data.terrain.empty())
+	{
+	    const float shininess{32};
+	    const float4 diffuse_colour{0.5, 0.5, 0.5, 1.0};
+	    shader_system::use(terrain_shader->get_id());
+	    shader_system::apply_global(false);
 
 	    shader_system::bind_instance(0);
 	    shader_system::set_uniform(terrain_shader_locations.diffuse_colour, &diffuse_colour);
 	    shader_system::set_uniform(terrain_shader_locations.directional_light, light_system::get_directional_light());
-	    shader_system::set_uniform(terrain_shader_locations.point_light, light_system::get_point_lights().data());
-	    auto num_point_lights = light_system::point_light_count();
-	    shader_system::set_uniform(terrain_shader_locations.num_point_lights, &num_point_lights);
 	    shader_system::set_uniform(terrain_shader_locations.shininess, &shininess);
 	    shader_system::apply_instance(true);
 
+	    // Chunks of one terrain arrive together, the model only changes between terrains
+	    const transformable* current_transform{};
 	    for (const auto& terrain : data.terrain)
 	    {
-		if (const auto& world = terrain.transform.lock())
+		const auto& world = terrain.transform.lock();
+		if (world && world.get() != current_transform)
 		{
 		    const auto& model = world->get_world();
 		    shader_system::set_uniform(terrain_shader_locations.model, &model);
+		    current_transform = world.get();
 		}
-	    }
 
-	    if (data.terrain.front().is_winding_reversed)
-	    {
-		engine::get()->get_renderer()->set_winding(winding::clockwise);
-	    }
+		if (terrain.is_winding_reversed)
+		{
+		    engine::get()->get_renderer()->set_winding(winding::clockwise);
+		}
 
-	    data.terrain.front().render_geometry->draw();
+		if (terrain.index_count != 0)
+		{
+		    terrain.render_geometry->draw_range(terrain.vertex_offset, terrain.first_index, terrain.index_count);
+		}
+		else
+		{
+		    terrain.render_geometry->draw();
+		}
 
-	    if (data.terrain.front().is_winding_reversed)
-	    {
-		engine::get()->get_renderer()->set_winding(winding::counter_clockwise);
+		if (terrain.is_winding_reversed)
+		{
+		    engine::get()->get_renderer()->set_winding(winding::counter_clockwise);
+		}
 	    }
 	}
 
-	shader_system::use(material_shader->get_id());
-	material_system::apply_global(material_shader->get_id(), frame_data, projection, view, data.ambient_colour, view_position, data.render_mode);
-
-	shader_system::use(pbr_shader->get_id());
-	shader_system::set_uniform(pbr_shader_locations.projection, &projection);
-	shader_system::set_uniform(pbr_shader_locations.view, &view);
-	shader_system::set_uniform(pbr_shader_locations.ambient_colour, &data.ambient_colour);
-	shader_system::set_uniform(pbr_shader_locations.view_position, &view_position);
-	shader_system::set_uniform(pbr_shader_locations.mode, &data.render_mode);
-	pbr_shader->apply_globals(true);
-
-	material::type current_type = material::type::pbr;
-
-	for (const egkr::render_data& render_data : data.geometries)
+	const auto& chunk = draw_chunks[chunk_index];
+	if (!chunk.empty())
 	{
-	    auto mat = render_data.render_geometry->get_material();
-	    bool needs_update = (mat->get_render_frame() != frame_data.frame_number || mat->get_draw_index() != frame_data.draw_index);
+	    material::type current_type = material::type::pbr;
+	    shader_system::use(pbr_shader->get_id());
+	    shader_system::apply_global(false);
 
-	    if (current_type != mat->get_material_type())
+	    for (const egkr::render_data* render_data : chunk)
 	    {
-		current_type = mat->get_material_type();
-		shader_system::use(current_type == material::type::pbr ? pbr_shader->get_id() : material_shader->get_id());
-	    }
+		auto mat = render_data->render_geometry->get_material();
+		bool needs_update = (mat->get_render_frame() != frame_data.frame_number || mat->get_draw_index() != frame_data.draw_index);
 
-	    switch (current_type)
-	    {
-	    case material::type::phong:
-		material_system::apply_instance(mat, needs_update);
-		break;
-	    case material::type::pbr:
-	    {
-		mat->get_ibl_map()->map_texture = data.irradiance_texture;
-		shader_system::bind_instance(mat->get_internal_id());
-		shader_system::set_uniform(pbr_shader_locations.albedo_texture, &mat->get_albedo_map());
-		shader_system::set_uniform(pbr_shader_locations.normal_texture, &mat->get_normal_map());
-		shader_system::set_uniform(pbr_shader_locations.metallic_texture, &mat->get_metallic_map());
-		shader_system::set_uniform(pbr_shader_locations.roughness_texture, &mat->get_roughness_map());
-		shader_system::set_uniform(pbr_shader_locations.ao_texture, &mat->get_ao_map());
-		shader_system::set_uniform(pbr_shader_locations.ibl_texture, &mat->get_ibl_map());
-		shader_system::set_uniform(pbr_shader_locations.directional_light, light_system::get_directional_light());
-		shader_system::set_uniform(pbr_shader_locations.point_lights, light_system::get_point_lights().data());
-		auto num_point_lights = light_system::point_light_count();
-
-		shader_system::set_uniform(pbr_shader_locations.num_point_lights, &num_point_lights);
-
-		shader_system::apply_instance(needs_update);
-		break;
-	    }
-	    default:
-		LOG_ERROR("Unrecognised material type, skipping");
-		continue;
-	    }
-	    mat->set_render_frame(frame_data.frame_number);
-	    mat->set_draw_index(frame_data.draw_index);
+		if (current_type != mat->get_material_type())
+		{
+		    current_type = mat->get_material_type();
+		    shader_system::use(current_type == material::type::pbr ? pbr_shader->get_id() : material_shader->get_id());
+		    shader_system::apply_global(false);
+		}
 
-	    if (auto transform = render_data.transform.lock())
-	    {
-		material_system::apply_local(mat, transform->get_world());
-	    }
+		switch (current_type)
+		{
+		case material::type::phong:
+		    material_system::apply_instance(mat, needs_update);
+		    break;
+		case material::type::pbr:
+		{
+		    mat->get_ibl_map()->map_texture = data.irradiance_texture;
+		    shader_system::bind_instance(mat->get_internal_id());
+		    shader_system::set_uniform(pbr_shader_locations.albedo_texture, &mat->get_albedo_map());
+		    shader_system::set_uniform(pbr_shader_locations.normal_texture, &mat->get_normal_map());
+		    shader_system::set_uniform(pbr_shader_locations.metallic_texture, &mat->get_metallic_map());
+		    shader_system::set_uniform(pbr_shader_locations.roughness_texture, &mat->get_roughness_map());
+		    shader_system::set_uniform(pbr_shader_locations.ao_texture, &mat->get_ao_map());
+		    shader_system::set_uniform(pbr_shader_locations.ibl_texture, &mat->get_ibl_map());
+		    shader_system::set_uniform(pbr_shader_locations.directional_light, light_system::get_directional_light());
+
+		    shader_system::apply_instance(needs_update);
+		    break;
+		}
+		default:
+		    LOG_ERROR("Unrecognised material type, skipping");
+		    continue;
+		}
+		mat->set_render_frame(frame_data.frame_number);
+		mat->set_draw_index(frame_data.draw_index);
 
-	    if (render_data.is_winding_reversed)
-	    {
-		engine::get()->get_renderer()->set_winding(winding::clockwise);
-	    }
-	    render_data.render_geometry->draw();
-	    if (render_data.is_winding_reversed)
-	    {
-		engine::get()->get_renderer()->set_winding(winding::counter_clockwise);
+		if (auto transform = render_data->transform.lock())
+		{
+		    material_system::apply_local(mat, transform->get_world());
+		}
+
+		if (render_data->is_winding_reversed)
+		{
+		    engine::get()->get_renderer()->set_winding(winding::clockwise);
+		}
+		render_data->render_geometry->draw();
+		if (render_data->is_winding_reversed)
+		{
+		    engine::get()->get_renderer()->set_winding(winding::counter_clockwise);
+		}
 	    }
 	}
 
-	if (!data.debug_geometries.empty())
+	if (chunk_index + 1 == get_chunk_count() && !data.debug_geometries.empty())
 	{
 	    shader_system::use(debug_colour_shader->get_id());
-	    shader_system::set_uniform(debug_shader_locations.projection, &projection);
-	    shader_system::set_uniform(debug_shader_locations.view, &view);
-	    shader_system::apply_global(true);
+	    shader_system::apply_global(false);
 	    for (const render_data& debug_data : data.debug_geometries)
 	    {
 		if (auto transform = debug_data.transform.lock())
@@ -261,9 +340,6 @@ namespace egkr::pass
 	    debug_colour_shader->set_frame_number(frame_data.frame_number);
 	    debug_colour_shader->set_draw_index(frame_data.draw_index);
 	}
-
-	renderpass->end();
-	return true;
     }
 
     bool scene::destroy()
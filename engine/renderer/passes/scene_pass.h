@@ -41,8 +41,9 @@ namespace egkr::pass
 	    uint32_t model{};
 	    uint32_t mode{};
 	    uint32_t directional_light{};
-	    uint32_t point_light{};
-	    uint32_t num_point_lights{};
+	    uint32_t lights{};
+	    uint32_t light_grid{};
+	    uint32_t light_indices{};
 	} terrain_shader_locations;
 
 	struct pbr_shader_locations
@@ -59,8 +60,9 @@ namespace egkr::pass
 	    uint32_t ibl_texture{};
 	    uint32_t model{};
 	    uint32_t directional_light{};
-	    uint32_t point_lights{};
-	    uint32_t num_point_lights{};
+	    uint32_t lights{};
+	    uint32_t light_grid{};
+	    uint32_t light_indices{};
 	    uint32_t properties{};
 	    uint32_t mode{};
 	} pbr_shader_locations;
@@ -74,8 +76,18 @@ namespace egkr::pass
 	bool init() override;
 	bool execute(const frame_data& frame_data) const override;
 	bool destroy() override;
+
+	[[nodiscard]] bool prepare(const frame_data& frame_data) const override;
+	[[nodiscard]] uint32_t get_chunk_count() const override { return (uint32_t)draw_chunks.size(); }
+	[[nodiscard]] bool execute_chunk(const frame_data& frame_data, uint32_t chunk_index) const override;
 	~scene() override = default;
     private:
+	void draw_chunk(const frame_data& frame_data, uint32_t chunk_index) const;
 	static bool on_event(event::code code, void* /*sender*/, void* listener, const event::context& context);
+
+	constexpr static uint32_t draws_per_chunk{64};
+	constexpr static uint32_t max_chunks{8};
+	// Geometry draws split by material, rebuilt by prepare each frame
+	mutable egkr::vector<egkr::vector<const egkr::render_data*>> draw_chunks;
     };
 }
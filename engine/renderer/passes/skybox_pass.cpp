@@ -27,6 +27,7 @@ namespace egkr::pass
 
 		skybox_renderpass_configuration.target.attachments.push_back(skybox_attachment_configration);
 
+		apply_attachment_usage(skybox_renderpass_configuration);
 		renderpass = egkr::renderpass::renderpass::create(skybox_renderpass_configuration);
 
 		const std::string shader_name = "Shader.Skybox";
@@ -33,6 +33,7 @@ namespace egkr::pass
 
 	    renderpass_configuration.target.attachments.push_back(attachment_configration);
 
+	    apply_attachment_usage(renderpass_configuration);
 	    renderpass = renderpass::renderpass::create(renderpass_configuration);
 	}
 
@@ -48,10 +49,47 @@ namespace egkr::pass
 	shader_locations.diffuse_colour_location = shader->get_uniform_index("diffuse_colour");
 	shader_locations.model_location = shader->get_uniform_index("model");
 
+	text_batcher = ui_batcher::create();
+
 	return true;
     }
 
     bool ui::execute(const frame_data& frame_data) const
+    {
+	if (!prepare(frame_data))
+	{
+	    return false;
+	}
+
+	record(frame_data);
+	return true;
+    }
+
+    bool ui::execute_chunk(const frame_data& frame_data, uint32_t /*chunk_index*/) const
+    {
+	record(frame_data);
+	return true;
+    }
+
+    bool ui::prepare(const frame_data& frame_data) const
+    {
+	ZoneScoped;
+
+	// A repack uploads the atlas and the batch is written to mapped memory, neither can happen from a recording thread
+	text_batcher->begin();
+	for (const auto& txt : data.texts)
+	{
+	    if (auto text = txt.lock())
+	    {
+		text->refresh_atlas();
+		text_batcher->add(text);
+	    }
+	}
+	text_batcher->end(frame_data);
+	return true;
+    }
+
+    void ui::record(const frame_data& frame_data) const
     {
 	engine::get()->get_renderer()->set_active_viewport(viewport);
 
@@ -76,39 +114,41 @@ namespace egkr::pass
 	    render_data.render_geometry->draw();
 	}
 
-	for (const auto& txt : data.texts)
+	if (!text_batcher->get_batches().empty())
 	{
-	    if (auto text = txt.lock())
-	    {
-		shader_system::bind_instance(text->get_id());
+	    const auto& renderer = engine::get()->get_renderer();
+	    const float4x4 model{1.F};
+	    constexpr static const float4 white_colour{1, 1, 1, 1};
 
-		auto atlas = text->get_data()->atlas;
-		if (atlas->map_texture->get_generation() == invalid_32_id)
-		{
-		    continue;
-		}
+	    text_batcher->bind(frame_data);
+	    for (const auto& batch : text_batcher->get_batches())
+	    {
+		const bool clipped = batch.clip_rect.z > 0.F && batch.clip_rect.w > 0.F;
+		renderer->set_scissor(clipped ? batch.clip_rect : viewport->viewport_rect);
 
-		shader_system::set_uniform(shader_locations.diffuse_map_location, &text->get_data()->atlas);
-		constexpr static const float4 white_colour{1, 1, 1, 1};
+		const auto& owner = batch.owner;
+		shader_system::bind_instance(owner->get_id());
+		shader_system::set_uniform(shader_locations.diffuse_map_location, &owner->get_data()->atlas);
 		shader_system::set_uniform(shader_locations.diffuse_colour_location, &white_colour);
 
-		bool needs_update = (text->get_render_frame() != frame_data.frame_number) || (text->get_draw_index() != frame_data.draw_index);
+		bool needs_update = (owner->get_render_frame() != frame_data.frame_number) || (owner->get_draw_index() != frame_data.draw_index);
 		shader_system::apply_instance(needs_update);
-		text->set_render_frame(frame_data.render_target_index);
-		text->set_draw_index(frame_data.draw_index);
+		owner->set_render_frame(frame_data.frame_number);
+		owner->set_draw_index(frame_data.draw_index);
 
-		float4x4 model = text->get_world();
+		// Batched vertices are already in ui space
 		shader_system::set_uniform(shader_locations.model_location, &model);
-		text->draw();
+		text_batcher->draw(batch);
 	    }
+	    renderer->set_scissor(viewport->viewport_rect);
 	}
 
 	renderpass->end();
-	return true;
     }
 
     bool ui::destroy()
     {
+	text_batcher.reset();
 	renderpass->free();
 	renderpass.reset();
 	return true;
@@ -3,6 +3,7 @@
 #include "resources/geometry.h"
 #include "resources/shader.h"
 #include "renderer/render_graph.h"
+#include "renderer/ui_batcher.h"
 #include "resources/ui_text.h"
 #include "resources/mesh.h"
 
@@ -26,13 +27,22 @@ namespace egkr::pass
 	} shader_locations;
 
 	shader::shared_ptr shader;
+	// Every text is drawn through this, one draw per atlas and clip rect
+	ui_batcher::unique_ptr text_batcher;
 
 	static ui* create();
 
 	bool init() override;
 	bool execute(const frame_data& frame_data) const override;
+	[[nodiscard]] bool prepare(const frame_data& frame_data) const override;
+	[[nodiscard]] bool execute_chunk(const frame_data& frame_data, uint32_t chunk_index) const override;
 	bool destroy() override;
 
+	[[nodiscard]] const ui_batcher::statistics& get_text_statistics() const { return text_batcher->get_statistics(); }
+
 	~ui() override = default;
+
+    private:
+	void record(const frame_data& frame_data) const;
     };
 }
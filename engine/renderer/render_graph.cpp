@@ -1,6 +1,11 @@
 #include "render_graph.h"
 #include <algorithm>
+#include <unordered_map>
 #include "engine/engine.h"
+#include "systems/job_system.h"
+#include "systems/shader_system.h"
+
+#include <atomic>
 
 namespace egkr
 {
@@ -51,6 +56,27 @@ namespace egkr
 	return true;
     }
 
+    void rendergraph::pass::apply_attachment_usage(renderpass::configuration& configuration) const
+    {
+	if (!usage.compiled)
+	{
+	    return;
+	}
+
+	for (auto& attachment : configuration.target.attachments)
+	{
+	    const bool is_colour = attachment.type == render_target::attachment_type::colour;
+	    const bool is_cleared = configuration.pass_clear_flags & (is_colour ? renderpass::clear_flags::colour : renderpass::clear_flags::depth);
+	    // Contents only need loading if an earlier pass wrote them and this pass doesn't clear them anyway
+	    const bool load = (is_colour ? usage.load_colour : usage.load_depth) && !is_cleared;
+	    const bool store = is_colour ? usage.store_colour : usage.store_depth;
+
+	    attachment.load_op = load ? render_target::load_operation::load : render_target::load_operation::dont_care;
+	    attachment.store_op = store ? render_target::store_operation::store : render_target::store_operation::dont_care;
+	    attachment.present_after = is_colour && usage.present_colour;
+	}
+    }
+
     bool rendergraph::pass::on_event(event::code code, void*, void* listener, const event::context& /*context*/)
     {
 	auto* view = static_cast<pass*>(listener);
@@ -224,40 +250,69 @@ namespace egkr
 	    return false;
 	}
 
-	for (auto& renderpass : passes)
+	if (!compile())
+	{
+	    LOG_ERROR("Failed to compile rendergraph {}", name);
+	    return false;
+	}
+
+	for (auto renderpass : passes)
+	{
+	    if (!renderpass->init())
+	    {
+		LOG_ERROR("Failed to initialise pass {}", renderpass->get_name());
+		return false;
+	    }
+
+	    if (!renderpass->regenerate_render_targets())
+	    {
+		LOG_ERROR("Failed to regenerate render targets for pass {}", renderpass->get_name());
+		return false;
+	    }
+	}
+	return true;
+    }
+
+    rendergraph::pass* rendergraph::get_source_owner(const source* src) const
+    {
+	for (auto* renderpass : passes)
+	{
+	    for (const auto& pass_source : renderpass->get_sources())
+	    {
+		if (&pass_source == src)
+		{
+		    return renderpass;
+		}
+	    }
+	}
+	return nullptr;
+    }
+
+    bool rendergraph::compile()
+    {
+	ZoneScoped;
+
+	const auto is_consumed = [this](const source* src)
+	{
+	    return std::ranges::any_of(passes, [src](const pass* renderpass) { return std::ranges::any_of(renderpass->get_sinks(), [src](const sink& snk) { return snk.bound_source == src; }); });
+	};
+
+	// The backbuffer is whichever colour output no other pass reads
+	const pass* present_pass{};
+	backbuffer_global_sink.bound_source = nullptr;
+	for (auto* renderpass : passes)
 	{
 	    for (auto& src : renderpass->get_sources())
 	    {
-		if (src.source_type == source::type::render_target_colour && src.source_origin == source::origin::other)
+		if (src.source_type == source::type::render_target_colour && src.source_origin == source::origin::other && !is_consumed(&src))
 		{
-		    for (const auto& other_pass : passes)
+		    if (present_pass)
 		    {
-			bool found = false;
-			for (const auto& other_sink : other_pass->get_sinks())
-			{
-			    if (other_sink.bound_source == &src)
-			    {
-				found = true;
-				break;
-			    }
-			}
-
-			if (!found)
-			{
-			    backbuffer_global_sink.bound_source = &src;
-			    renderpass->set_present_after(true);
-			    break;
-			}
+			LOG_WARN("Passes {} and {} both have unconsumed colour outputs, presenting {}", present_pass->get_name(), renderpass->get_name(), renderpass->get_name());
 		    }
+		    backbuffer_global_sink.bound_source = &src;
+		    present_pass = renderpass;
 		}
-		if (backbuffer_global_sink.bound_source != nullptr)
-		{
-		    break;
-		}
-	    }
-	    if (backbuffer_global_sink.bound_source != nullptr)
-	    {
-		break;
 	    }
 	}
 
@@ -267,27 +322,113 @@ namespace egkr
 	    return false;
 	}
 
-	for (auto renderpass : passes)
+	// Walk back from the present pass so dependencies come first, anything never reached doesn't contribute to the frame
+	enum class visit_state : uint8_t
 	{
-	    if (!renderpass->init())
+	    unvisited,
+	    visiting,
+	    done
+	};
+	std::unordered_map<const pass*, visit_state> visited;
+	execution_order.clear();
+
+	std::function<bool(pass*)> visit = [&](pass* renderpass)
+	{
+	    auto& state = visited[renderpass];
+	    if (state == visit_state::done)
 	    {
-		LOG_ERROR("Failed to initialise pass {}", renderpass->get_name());
+		return true;
+	    }
+	    if (state == visit_state::visiting)
+	    {
+		LOG_ERROR("Cycle in rendergraph {} at pass {}", name, renderpass->get_name());
 		return false;
 	    }
 
-	    if (!renderpass->regenerate_render_targets())
+	    state = visit_state::visiting;
+	    for (const auto& snk : renderpass->get_sinks())
 	    {
-		LOG_ERROR("Failed to regenerate render targets for pass {}", renderpass->get_name());
-		return false;
+		if (auto* producer = get_source_owner(snk.bound_source); producer && !visit(producer))
+		{
+		    return false;
+		}
+	    }
+	    visited[renderpass] = visit_state::done;
+	    execution_order.push_back(renderpass);
+	    return true;
+	};
+
+	if (!visit(const_cast<pass*>(present_pass)))
+	{
+	    return false;
+	}
+
+	for (const auto* renderpass : passes)
+	{
+	    if (!visited.contains(renderpass))
+	    {
+		LOG_INFO("Culling pass {}, its output never reaches the backbuffer", renderpass->get_name());
+	    }
+	}
+
+	// Loads are only needed where a live pass produced the contents, stores only where a live pass reads them
+	for (auto* renderpass : execution_order)
+	{
+	    pass::attachment_usage usage{.compiled = true};
+	    for (const auto& snk : renderpass->get_sinks())
+	    {
+		if (get_source_owner(snk.bound_source) == nullptr)
+		{
+		    continue;
+		}
+
+		if (snk.bound_source->source_type == source::type::render_target_colour)
+		{
+		    usage.load_colour = true;
+		}
+		else
+		{
+		    usage.load_depth = true;
+		}
+	    }
+
+	    for (const auto& src : renderpass->get_sources())
+	    {
+		const bool is_read = std::ranges::any_of(execution_order,
+		    [&src](const pass* other) { return std::ranges::any_of(other->get_sinks(), [&src](const sink& snk) { return snk.bound_source == &src; }); });
+		const bool is_presented = &src == backbuffer_global_sink.bound_source;
+
+		if (src.source_type == source::type::render_target_colour)
+		{
+		    usage.store_colour |= is_read || is_presented;
+		    usage.present_colour |= is_presented;
+		}
+		else
+		{
+		    usage.store_depth |= is_read;
+		}
 	    }
+
+	    renderpass->set_attachment_usage(usage);
 	}
+
 	return true;
     }
 
     bool egkr::rendergraph::execute(const frame_data& frame_data)
     {
-	for (const auto& renderpass : passes)
+	if (engine::get()->get_renderer()->get_backend()->is_multithreaded())
+	{
+	    return execute_parallel(frame_data);
+	}
+
+	for (const auto& renderpass : execution_order)
 	{
+	    if (!renderpass->do_execute)
+	    {
+		continue;
+	    }
+
 	    if (!renderpass->execute(frame_data))
 	    {
 		LOG_ERROR("Failed to execute pass {}", renderpass->get_name());
@@ -296,4 +437,56 @@ namespace egkr
 	}
 	return false;
     }
+
+    bool rendergraph::execute_parallel(const frame_data& frame_data)
+    {
+	ZoneScoped;
+
+	recording_slots.clear();
+	for (const auto& renderpass : execution_order)
+	{
+	    if (!renderpass->do_execute)
+	    {
+		continue;
+	    }
+
+	    if (!renderpass->prepare(frame_data))
+	    {
+		LOG_ERROR("Failed to prepare pass {}", renderpass->get_name());
+		return false;
+	    }
+
+	    for (uint32_t chunk_index{0u}; chunk_index < renderpass->get_chunk_count(); ++chunk_index)
+	    {
+		recording_slots.push_back({renderpass, chunk_index});
+	    }
+	}
+
+	const auto& backend = engine::get()->get_renderer()->get_backend();
+	backend->begin_parallel_recording((uint32_t)recording_slots.size());
+
+	std::atomic<bool> succeeded{true};
+	recording_tasks.clear();
+	for (uint32_t slot_index{0u}; slot_index < recording_slots.size(); ++slot_index)
+	{
+	    recording_tasks.emplace_back(
+	        [this, slot_index, &frame_data, &backend, &succeeded]()
+	        {
+		    const auto& slot = recording_slots[slot_index];
+		    backend->begin_recording_slot(slot_index);
+		    // Each slot records into a fresh secondary, nothing is bound yet
+		    shader_system::reset_current_shader();
+		    if (!slot.slot_pass->execute_chunk(frame_data, slot.chunk_index))
+		    {
+		        LOG_ERROR("Failed to execute pass {}", slot.slot_pass->get_name());
+		        succeeded = false;
+		    }
+		    backend->end_recording_slot();
+	        });
+	}
+
+	job_system::execute_and_wait(recording_tasks, job::type::general);
+	backend->end_parallel_recording();
+	return succeeded;
+    }
 }
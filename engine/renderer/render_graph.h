@@ -48,9 +48,24 @@ namespace egkr
 	    [[nodiscard]] virtual bool execute(const frame_data& frame_data) const = 0;
 	    virtual bool destroy() = 0;
 
+	    // Multithreaded recording: prepare runs once on the graph's thread, then each chunk may be recorded on a different thread
+	    [[nodiscard]] virtual bool prepare(const frame_data& /*frame_data*/) const { return true; }
+	    [[nodiscard]] virtual uint32_t get_chunk_count() const { return 1; }
+	    [[nodiscard]] virtual bool execute_chunk(const frame_data& frame_data, uint32_t /*chunk_index*/) const { return execute(frame_data); }
+
 	    bool regenerate_render_targets();
 
-	    void set_present_after(bool present) { present_after = present; }
+	    // Filled in when the graph compiles, says which attachments the pass has to load, keep or present
+	    struct attachment_usage
+	    {
+		bool compiled{};
+		bool load_colour{};
+		bool store_colour{};
+		bool present_colour{};
+		bool load_depth{};
+		bool store_depth{};
+	    };
+	    void set_attachment_usage(const attachment_usage& attachment_usage) { usage = attachment_usage; }
 
 	    [[nodiscard]] const std::string& get_name() const { return name; }
 	    [[nodiscard]] const auto& get_sources() const { return sources; }
@@ -62,13 +77,16 @@ namespace egkr
 	    float4x4 view;
 	    float4x4 projection;
 	    float3 view_position;
-	    bool do_execute;
+	    bool do_execute{true};
 	protected:
+	    // Overrides the attachment load/store/present ops with what the compiled graph needs, a no-op before the graph is compiled
+	    void apply_attachment_usage(renderpass::configuration& configuration) const;
+
 	    std::string name;
 	    std::vector<source> sources;
 	    std::vector<sink> sinks;
 	    renderpass::renderpass::shared_ptr renderpass;
-	    bool present_after{false};
+	    attachment_usage usage{};
 	private:
 	    static bool on_event(event::code code, void* /*sender*/, void* listener, const event::context& context);
 	};
@@ -89,9 +107,23 @@ namespace egkr
 	bool finalise();
 	bool execute(const frame_data& frame_data);
     private:
+	bool compile();
+	bool execute_parallel(const frame_data& frame_data);
+	[[nodiscard]] pass* get_source_owner(const source* src) const;
+
+	struct recording_slot
+	{
+	    const pass* slot_pass;
+	    uint32_t chunk_index;
+	};
+
 	std::string name;
 	std::vector<source> global_sources;
 	std::vector<pass*> passes;
 	sink backbuffer_global_sink{};
+	// Passes that contribute to the backbuffer, dependencies first. Filled by compile
+	std::vector<pass*> execution_order;
+	std::vector<recording_slot> recording_slots;
+	std::vector<std::function<void()>> recording_tasks;
     };
 }
@@ -10,10 +10,13 @@ namespace egkr
 		{
 			unknown,
 			vertex,
+			// Host visible vertex buffer that stays mapped for its lifetime, for geometry rewritten from the CPU every few frames
+			dynamic_vertex,
 			index,
 			uniform,
 			staging,
 			read,
+			// Host visible and persistently mapped, for shader-read data rewritten from the CPU every frame
 			storage
 		};
 
@@ -2,6 +2,8 @@
 
 namespace egkr
 {
+    static thread_local egkr::viewport* active_viewport_{};
+
     renderer_frontend::unique_ptr renderer_frontend::create(renderer_backend::unique_ptr renderer_plugin) { return std::make_unique<renderer_frontend>(std::move(renderer_plugin)); }
 
     renderer_frontend::renderer_frontend(renderer_backend::unique_ptr renderer_plugin): backend_(std::move(renderer_plugin)) { }
@@ -60,6 +62,8 @@ namespace egkr
 
     void renderer_frontend::reset_scissor() const { backend_->reset_scissor(); }
 
+    viewport* renderer_frontend::get_active_viewport() const { return active_viewport_; }
+
     void renderer_frontend::set_active_viewport(viewport* viewport)
     {
 	active_viewport_ = viewport;
@@ -37,7 +37,8 @@ namespace egkr
 	void set_scissor(const float4& rect) const;
 	void reset_scissor() const;
 
-	[[nodiscard]] viewport* get_active_viewport() const { return active_viewport_; }
+	// Per thread, so passes recording in parallel each see the viewport they set
+	[[nodiscard]] viewport* get_active_viewport() const;
 
 	void set_active_viewport(viewport* viewport);
 
@@ -55,6 +56,5 @@ namespace egkr
 
 	uint32_t framebuffer_width_{};
 	uint32_t framebuffer_height_{};
-	egkr::viewport* active_viewport_;
     };
 }
@@ -88,6 +88,12 @@ namespace egkr
 	virtual void reset_scissor() const = 0;
 	virtual void set_winding(winding winding) const = 0;
 
+	// Parallel recording: each slot is recorded on whichever thread calls begin_recording_slot, then end_parallel_recording replays the slots into the frame in order
+	virtual void begin_parallel_recording(uint32_t slot_count) = 0;
+	virtual void begin_recording_slot(uint32_t slot) const = 0;
+	virtual void end_recording_slot() const = 0;
+	virtual void end_parallel_recording() = 0;
+
 	[[nodiscard]] virtual uint32_t get_window_attachment_count() const = 0;
 	[[nodiscard]] virtual texture::shared_ptr get_window_attachment(uint8_t index) const = 0;
 	[[nodiscard]] virtual texture::shared_ptr get_depth_attachment(uint8_t index) const = 0;
@@ -0,0 +1,164 @@
+#include "ui_batcher.h"
+
+#include "engine/engine.h"
+#include <resources/font.h>
+
+namespace egkr
+{
+    constexpr static const uint32_t verts_per_quad{4};
+    constexpr static const uint32_t indices_per_quad{6};
+    constexpr static const uint64_t quad_size = sizeof(vertex_2d) * verts_per_quad;
+    constexpr static const uint32_t min_quad_capacity{1024};
+
+    ui_batcher::unique_ptr ui_batcher::create() { return std::make_unique<ui_batcher>(); }
+
+    ui_batcher::ui_batcher()
+    {
+	region_count_ = std::max(engine::get()->get_renderer()->get_backend()->get_window_attachment_count(), 1u);
+	reserve(min_quad_capacity);
+    }
+
+    ui_batcher::~ui_batcher()
+    {
+	vertex_buffer_.reset();
+	index_buffer_.reset();
+    }
+
+    void ui_batcher::begin()
+    {
+	batches_.clear();
+	entries_.clear();
+	vertices_.clear();
+	statistics_ = {};
+    }
+
+    void ui_batcher::add(const text::ui_text::shared_ptr& text)
+    {
+	const auto& atlas = text->get_data()->atlas;
+	if (!atlas || !atlas->map_texture || atlas->map_texture->get_generation() == invalid_32_id || text->get_vertices().empty())
+	{
+	    return;
+	}
+
+	// Linear, a frame only ever has a handful of atlases and clip rects
+	uint32_t batch_index{};
+	for (; batch_index < batches_.size(); ++batch_index)
+	{
+	    const auto& existing = batches_[batch_index];
+	    if (existing.owner->get_data()->atlas == atlas && existing.clip_rect == text->get_clip_rect())
+	    {
+		break;
+	    }
+	}
+
+	if (batch_index == batches_.size())
+	{
+	    batches_.push_back({.owner = text, .clip_rect = text->get_clip_rect()});
+	}
+
+	entries_.push_back({.batch = batch_index, .text = text.get()});
+	++statistics_.text_count;
+    }
+
+    void ui_batcher::end(const frame_data& frame_data)
+    {
+	ZoneScoped;
+
+	std::ranges::stable_sort(entries_, {}, &entry::batch);
+
+	for (const auto& [batch_index, text] : entries_)
+	{
+	    auto& batch = batches_[batch_index];
+	    if (batch.quad_count == 0)
+	    {
+		batch.first_quad = (uint32_t)(vertices_.size() / verts_per_quad);
+	    }
+
+	    const float4x4 world = text->get_world();
+	    const auto vertices = text->get_vertices();
+	    for (size_t quad{}; quad < vertices.size(); quad += verts_per_quad)
+	    {
+		// Newlines, tabs and spaces leave empty quads behind, they cost a draw slot for nothing
+		if (vertices[quad].position == vertices[quad + 2].position)
+		{
+		    continue;
+		}
+
+		for (uint32_t v{}; v < verts_per_quad; ++v)
+		{
+		    const auto& vertex = vertices[quad + v];
+		    const float4 position = world * float4{vertex.position.x, vertex.position.y, 0.F, 1.F};
+		    vertices_.push_back({.position = {position.x, position.y}, .tex = vertex.tex});
+		}
+		++batch.quad_count;
+	    }
+	}
+
+	std::erase_if(batches_, [](const batch& batch) { return batch.quad_count == 0; });
+
+	const auto quad_count = (uint32_t)(vertices_.size() / verts_per_quad);
+	statistics_.quad_count = quad_count;
+	statistics_.draw_count = (uint32_t)batches_.size();
+	if (quad_count == 0)
+	{
+	    return;
+	}
+
+	if (quad_count > quad_capacity_)
+	{
+	    reserve(quad_count);
+	}
+
+	// begin() waited on this image's last submission, so its region is free to write
+	const auto region = frame_data.render_target_index % region_count_;
+	const uint64_t size = quad_count * quad_size;
+	auto* mapped = vertex_buffer_->map_memory(region * quad_capacity_ * quad_size, size);
+	memcpy(mapped, vertices_.data(), size);
+	vertex_buffer_->unmap();
+    }
+
+    void ui_batcher::bind(const frame_data& frame_data) const
+    {
+	const auto region = frame_data.render_target_index % region_count_;
+	vertex_buffer_->draw(region * quad_capacity_ * quad_size, 0, true);
+    }
+
+    void ui_batcher::draw(const batch& batch) const
+    {
+	// The quad indices are absolute, so offsetting into the index buffer selects the batch's vertices
+	index_buffer_->draw((uint64_t)batch.first_quad * indices_per_quad * sizeof(uint32_t), batch.quad_count * indices_per_quad, false);
+    }
+
+    void ui_batcher::reserve(uint32_t quad_count)
+    {
+	// Grow geometrically so a busy frame doesn't reallocate on every new label
+	quad_capacity_ = std::max(quad_count, quad_capacity_ * 2);
+
+	const uint64_t vertex_buffer_size = region_count_ * quad_capacity_ * quad_size;
+	if (vertex_buffer_)
+	{
+	    vertex_buffer_->resize(vertex_buffer_size);
+	}
+	else
+	{
+	    vertex_buffer_ = renderbuffer::renderbuffer::create(renderbuffer::type::dynamic_vertex, vertex_buffer_size);
+	    vertex_buffer_->bind(0);
+	}
+
+	egkr::vector<uint32_t> index_data((size_t)quad_capacity_ * indices_per_quad);
+	for (uint32_t quad{}; quad < quad_capacity_; ++quad)
+	{
+	    index_data[(quad * indices_per_quad) + 0] = (quad * verts_per_quad) + 2;
+	    index_data[(quad * indices_per_quad) + 1] = (quad * verts_per_quad) + 1;
+	    index_data[(quad * indices_per_quad) + 2] = (quad * verts_per_quad) + 0;
+	    index_data[(quad * indices_per_quad) + 3] = (quad * verts_per_quad) + 3;
+	    index_data[(quad * indices_per_quad) + 4] = (quad * verts_per_quad) + 2;
+	    index_data[(quad * indices_per_quad) + 5] = (quad * verts_per_quad) + 0;
+	}
+
+	const uint64_t index_buffer_size = sizeof(uint32_t) * index_data.size();
+	index_buffer_ = renderbuffer::renderbuffer::create(renderbuffer::type::index, index_buffer_size);
+	index_buffer_->bind(0);
+	index_buffer_->load_range(0, index_buffer_size, index_data.data());
+    }
+}
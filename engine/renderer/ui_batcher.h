@@ -0,0 +1,69 @@
+#pragma once
+#include "pch.h"
+
+#include <renderer/renderbuffer.h>
+#include <renderer/vertex_types.h>
+#include <resources/ui_text.h>
+
+namespace egkr
+{
+    // Collects the quads of every ui text into one vertex stream per frame, grouped into one draw per atlas and clip rect.
+    // Batches are ordered by the first text that used them, so texts only overlap correctly within a batch
+    class ui_batcher
+    {
+    public:
+	struct batch
+	{
+	    // The batch draws with this text's shader instance, which binds the shared atlas
+	    text::ui_text::shared_ptr owner;
+	    float4 clip_rect{};
+	    uint32_t first_quad{};
+	    uint32_t quad_count{};
+	};
+
+	struct statistics
+	{
+	    uint32_t text_count{};
+	    uint32_t quad_count{};
+	    uint32_t draw_count{};
+	};
+
+	using unique_ptr = std::unique_ptr<ui_batcher>;
+	static unique_ptr create();
+
+	ui_batcher();
+	~ui_batcher();
+
+	void begin();
+	void add(const text::ui_text::shared_ptr& text);
+	// Builds the batches and writes the frame's quads into the stream region owned by its render target
+	void end(const frame_data& frame_data);
+
+	void bind(const frame_data& frame_data) const;
+	void draw(const batch& batch) const;
+
+	[[nodiscard]] const auto& get_batches() const { return batches_; }
+	[[nodiscard]] const auto& get_statistics() const { return statistics_; }
+
+    private:
+	void reserve(uint32_t quad_count);
+
+    private:
+	struct entry
+	{
+	    uint32_t batch{};
+	    text::ui_text* text{};
+	};
+
+	egkr::vector<batch> batches_;
+	egkr::vector<entry> entries_;
+	egkr::vector<vertex_2d> vertices_;
+	statistics statistics_{};
+
+	renderbuffer::renderbuffer::shared_ptr vertex_buffer_;
+	renderbuffer::renderbuffer::shared_ptr index_buffer_;
+	uint32_t quad_capacity_{};
+	// One region of the stream per swapchain image, so a region is never written while the gpu reads it
+	uint32_t region_count_{1};
+    };
+}
@@ -0,0 +1,91 @@
+#include "font.h"
+
+namespace egkr::font
+{
+	constexpr static int32_t max_direct_codepoint{0x10000};
+
+	static uint64_t kerning_key(int32_t codepoint_0, int32_t codepoint_1)
+	{
+		return ((uint64_t)(uint32_t)codepoint_0 << 32) | (uint32_t)codepoint_1;
+	}
+
+	void data::build_lookup()
+	{
+		ZoneScoped;
+
+		int32_t max_codepoint{-1};
+		for (const auto& g : glyphs)
+		{
+			if (g.codepoint < max_direct_codepoint)
+			{
+				max_codepoint = std::max(max_codepoint, g.codepoint);
+			}
+		}
+
+		glyph_table.assign((size_t)(max_codepoint + 1), invalid_32_id);
+		glyph_map.clear();
+		for (uint32_t i{}; i < glyphs.size(); ++i)
+		{
+			const auto codepoint = glyphs[i].codepoint;
+			if (codepoint >= 0 && codepoint < (int32_t)glyph_table.size())
+			{
+				glyph_table[(size_t)codepoint] = i;
+			}
+			else
+			{
+				glyph_map[codepoint] = i;
+			}
+		}
+
+		kerning_map.clear();
+		kerning_map.reserve(kernings.size());
+		for (const auto& k : kernings)
+		{
+			// First entry wins, as the old linear scan did
+			kerning_map.try_emplace(kerning_key(k.codepoint_0, k.codepoint_1), k.amount);
+		}
+
+		++generation;
+	}
+
+	void data::add_glyph(const glyph& new_glyph)
+	{
+		const auto index = (uint32_t)glyphs.size();
+		glyphs.push_back(new_glyph);
+
+		const auto codepoint = new_glyph.codepoint;
+		if (codepoint >= 0 && codepoint < max_direct_codepoint)
+		{
+			if (codepoint >= (int32_t)glyph_table.size())
+			{
+				glyph_table.resize((size_t)codepoint + 1, invalid_32_id);
+			}
+			glyph_table[(size_t)codepoint] = index;
+		}
+		else
+		{
+			glyph_map[codepoint] = index;
+		}
+	}
+
+	const glyph* data::find_glyph(int32_t codepoint) const
+	{
+		uint32_t index{invalid_32_id};
+		if (codepoint >= 0 && codepoint < (int32_t)glyph_table.size())
+		{
+			index = glyph_table[(size_t)codepoint];
+		}
+		else if (auto it = glyph_map.find(codepoint); it != glyph_map.end())
+		{
+			index = it->second;
+		}
+
+		return index == invalid_32_id ? nullptr : &glyphs[index];
+	}
+
+	int16_t data::find_kerning(int32_t codepoint_0, int32_t codepoint_1) const
+	{
+		auto it = kerning_map.find(kerning_key(codepoint_0, codepoint_1));
+		return it == kerning_map.end() ? int16_t{0} : it->second;
+	}
+}
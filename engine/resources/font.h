@@ -3,6 +3,8 @@
 #include "pch.h"
 #include <resources/texture.h>
 
+#include <unordered_map>
+
 namespace egkr::font
 {
 	struct glyph
@@ -46,6 +48,22 @@ namespace egkr::font
 		float tab_advance{};
 		uint32_t internal_data_size{};
 		void* internal{};
+
+		// Lookups over glyphs and kernings, rebuilt by build_lookup whenever either changes.
+		// BMP codepoints index glyph_table directly, anything else (and the -1 fallback glyph) goes through glyph_map
+		egkr::vector<uint32_t> glyph_table;
+		std::unordered_map<int32_t, uint32_t> glyph_map;
+		std::unordered_map<uint64_t, int16_t> kerning_map;
+		// Bumped on every rebuild so cached layouts know the glyphs have moved
+		uint32_t generation{};
+		// System fonts only: which packing of the shared atlas these glyphs were copied from
+		uint32_t atlas_generation{invalid_32_id};
+
+		void build_lookup();
+		// Adds a glyph without invalidating the ones already placed, so generation is left alone
+		void add_glyph(const glyph& new_glyph);
+		[[nodiscard]] const glyph* find_glyph(int32_t codepoint) const;
+		[[nodiscard]] int16_t find_kerning(int32_t codepoint_0, int32_t codepoint_1) const;
 	};
 
 	struct bitmap_font_page
@@ -69,7 +87,9 @@ namespace egkr::font
 	{
 		egkr::vector<system_font_face> fonts;
 		uint64_t binary_size{};
-		void* font_binary{};
+		// Points into binary_resource, the mapped font file, so it stays valid while this resource is loaded
+		const void* font_binary{};
+		resource::shared_ptr binary_resource;
 	};
 
 }
@@ -42,6 +42,8 @@ namespace egkr
 	virtual bool populate(const properties& properties) = 0;
 	virtual bool upload() = 0;
 	virtual void draw() = 0;
+	// Draws index_count indices from first_index, with the vertex buffer bound from vertex_offset
+	virtual void draw_range(uint64_t vertex_offset, uint32_t first_index, uint32_t index_count) = 0;
 	virtual void update_vertices(uint32_t offset, uint32_t vertex_count, void* vertices) = 0;
 	virtual void free() = 0;
 	void destroy();
@@ -72,6 +74,10 @@ namespace egkr
 	std::weak_ptr<transformable> transform;
 	uint64_t unique_id{};
 	bool is_winding_reversed;
+	// A non zero index count draws only this range of the geometry
+	uint64_t vertex_offset{};
+	uint32_t first_index{};
+	uint32_t index_count{};
     };
 
     struct geometry_distance
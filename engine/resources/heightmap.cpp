@@ -0,0 +1,76 @@
+#include "heightmap.h"
+
+namespace egkr
+{
+    constexpr static float sample_scale{1.F / std::numeric_limits<uint16_t>::max()};
+
+    heightmap::shared_ptr heightmap::create(uint32_t width, uint32_t height, egkr::vector<uint16_t> samples)
+    {
+	if (samples.size() != (size_t)width * height)
+	{
+	    LOG_ERROR("Heightmap sample count {} doesn't match its size {}x{}", samples.size(), width, height);
+	    return nullptr;
+	}
+	return std::make_shared<heightmap>(width, height, std::move(samples), mapped_file{});
+    }
+
+    heightmap::shared_ptr heightmap::open_raw(const std::string& path, uint32_t width, uint32_t height)
+    {
+	// Mapped once, bands are read straight out of the mapping without seeking
+	auto file = mapped_file::open(path, mapped_file::access_hint::sequential);
+	if (!file.is_valid())
+	{
+	    LOG_ERROR("Could not open raw heightmap {}", path);
+	    return nullptr;
+	}
+
+	const uint64_t expected_size = (uint64_t)width * height * sizeof(uint16_t);
+	if (file.size() != expected_size)
+	{
+	    LOG_ERROR("Raw heightmap {} is {} bytes, {}x{} 16-bit samples need {}", path, file.size(), width, height, expected_size);
+	    return nullptr;
+	}
+	return std::make_shared<heightmap>(width, height, egkr::vector<uint16_t>{}, std::move(file));
+    }
+
+    heightmap::heightmap(uint32_t width, uint32_t height, egkr::vector<uint16_t> samples, mapped_file file)
+        : width_{width}, height_{height}, samples_{std::move(samples)}, file_{std::move(file)}
+    {
+    }
+
+    void heightmap::read_rows(int64_t first_row, uint32_t row_count, egkr::vector<float>& out) const
+    {
+	out.resize((size_t)row_count * width_);
+	if (width_ == 0 || height_ == 0)
+	{
+	    std::ranges::fill(out, 0.F);
+	    return;
+	}
+
+	// Only the rows inside the heightmap are read, the rest are copied from its edge afterwards
+	const auto first_inside = (uint32_t)std::clamp<int64_t>(first_row, 0, height_ - 1);
+	const auto last_inside = (uint32_t)std::clamp<int64_t>(first_row + row_count - 1, 0, height_ - 1);
+
+	const uint16_t* samples{};
+	if (samples_.empty())
+	{
+	    // open_raw checked the size, so the whole band lies inside the mapping
+	    samples = (const uint16_t*)file_.data().subspan((size_t)first_inside * width_ * sizeof(uint16_t)).data();
+	}
+	else
+	{
+	    samples = samples_.data() + ((size_t)first_inside * width_);
+	}
+
+	for (uint32_t row{}; row < row_count; ++row)
+	{
+	    const auto source_row = (uint32_t)std::clamp<int64_t>(first_row + row, first_inside, last_inside) - first_inside;
+	    const uint16_t* source = samples + ((size_t)source_row * width_);
+	    float* destination = out.data() + ((size_t)row * width_);
+	    for (uint32_t x{}; x < width_; ++x)
+	    {
+		destination[x] = (float)source[x] * sample_scale;
+	    }
+	}
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pch.h"
+#include "platform/mapped_file.h"
+
+namespace egkr
+{
+    // Height samples normalised to [0, 1]. Decoded images stay resident as 16-bit samples, raw 16-bit files are mapped
+    // and read a band of full-width rows at a time, so only the pages of the band being built are touched. The terrain
+    // built from it still keeps every chunk's vertices resident
+    class heightmap
+    {
+    public:
+	using shared_ptr = std::shared_ptr<heightmap>;
+	static shared_ptr create(uint32_t width, uint32_t height, egkr::vector<uint16_t> samples);
+	// Little endian, row major, no header. The file must hold exactly width * height samples
+	static shared_ptr open_raw(const std::string& path, uint32_t width, uint32_t height);
+
+	heightmap(uint32_t width, uint32_t height, egkr::vector<uint16_t> samples, mapped_file file);
+
+	[[nodiscard]] uint32_t get_width() const { return width_; }
+	[[nodiscard]] uint32_t get_height() const { return height_; }
+
+	// Fills out with row_count rows from first_row. Rows outside the heightmap repeat its first or last row
+	void read_rows(int64_t first_row, uint32_t row_count, egkr::vector<float>& out) const;
+
+    private:
+	uint32_t width_{};
+	uint32_t height_{};
+	egkr::vector<uint16_t> samples_;
+	// Streamed from here when no samples are resident
+	mapped_file file_;
+    };
+}
@@ -2,6 +2,7 @@
 #include <pch.h>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 
 namespace egkr::job
 {
@@ -48,6 +49,7 @@ namespace egkr::job
 		std::jthread thread;
 		information info{};
 		std::mutex mutex;
+		std::condition_variable wake;
 		type mask{};
 	};
 
@@ -60,6 +62,9 @@ namespace egkr::job
 	};
 
 	constexpr static uint32_t MAX_JOB_RESULTS = 512u;
+	constexpr static uint32_t MAX_JOB_THREADS = 32u;
+	// Every thread that is not a job worker shares index 0, worker i is i + 1
+	constexpr static uint32_t MAX_THREAD_INDICES = MAX_JOB_THREADS + 1;
 
 	class job
 	{
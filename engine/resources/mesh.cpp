@@ -3,28 +3,57 @@
 #include "systems/geometry_system.h"
 #include "systems/resource_system.h"
 
-#include "systems/job_system.h"
-
 #include "identifier.h"
 
 namespace egkr
 {
-	struct mesh_load_parameters
+	mesh::shared_ptr mesh::create(const configuration& configuration)
 	{
-		const char* resource_name;
-		mesh::shared_ptr loaded_mesh;
-		resource::resource::shared_ptr mesh_resource;
-	};
+		return std::make_shared<mesh>(configuration);
+	}
+
+	//mesh::shared_ptr mesh::create(const geometry::geometry::shared_ptr& geometry, const transform& model)
+	//{
+	//	auto mesh = create();
+	//	mesh->add_geometry(geometry);
+	//	mesh->set_model(model);
+
+	//	return mesh;
+	//}
+
+	mesh::mesh(const configuration& mesh_configuration)
+		: resource(0, 0, ""), configuration_{mesh_configuration}, unique_id_(identifier::acquire_unique_id(this))
+	{
+	}
+
+	mesh::~mesh()
+	{
+		unload();
+	}
 
-	static void load_job_success(void* params)
+	void mesh::load()
 	{
-		auto* mesh_params = (mesh_load_parameters*)params;
+		if (!configuration_.name.empty())
+		{
+			load_from_resource(configuration_.name);
+		}
+		else
+		{
+			for (const auto& config : configuration_.geometry_configurations)
+			{
+				auto geo = geometry_system::acquire(config);
+				add_geometry(geo);
+			}
+		}
+	}
 
-		auto* geo_configs = (egkr::vector<geometry::properties>*)mesh_params->mesh_resource->data;
+	void mesh::load(const resource::shared_ptr& mesh_resource)
+	{
+		auto* geo_configs = (egkr::vector<geometry::properties>*)mesh_resource->data;
 
 		for (const auto& geo : *geo_configs)
 		{
-			mesh_params->loaded_mesh->add_geometry(geometry_system::acquire(geo));
+			add_geometry(geometry_system::acquire(geo));
 			auto local_extents = geo.extents;
 			vertex_3d* vertices = (vertex_3d*)geo.vertices;
 
@@ -57,7 +86,7 @@ namespace egkr
 				}
 			}
 
-			auto& global_extents = mesh_params->loaded_mesh->extents();
+			auto& global_extents = extents();
 
 				if (local_extents.min.x < global_extents.min.x)
 				{
@@ -85,68 +114,7 @@ namespace egkr
 				}
 		}
 
-		mesh_params->loaded_mesh->increment_generation();
-		LOG_TRACE("Successfully loaded mesh '{}'", mesh_params->resource_name);
-
-		resource_system::unload(mesh_params->mesh_resource);
-	}
-
-	static void load_job_fail(void* params)
-	{
-		auto* mesh_params = (mesh_load_parameters*)params;
-		LOG_ERROR("Failed to load mesh '{}'", mesh_params->resource_name);
-
-		resource_system::unload(mesh_params->mesh_resource);
-	}
-
-	static bool load_job_start(void* params, void* result_data)
-	{
-		auto* load_params = (mesh_load_parameters*)params;
-		auto mesh = resource_system::load(load_params->resource_name, resource::type::mesh, nullptr);
-		load_params->mesh_resource = mesh;
-		memcpy(result_data, load_params, sizeof(mesh_load_parameters));
-
-		return mesh != nullptr;
-	}
-
-	mesh::shared_ptr mesh::create(const configuration& configuration)
-	{
-		return std::make_shared<mesh>(configuration);
-	}
-
-	//mesh::shared_ptr mesh::create(const geometry::geometry::shared_ptr& geometry, const transform& model)
-	//{
-	//	auto mesh = create();
-	//	mesh->add_geometry(geometry);
-	//	mesh->set_model(model);
-
-	//	return mesh;
-	//}
-
-	mesh::mesh(const configuration& mesh_configuration)
-		: resource(0, 0, ""), configuration_{mesh_configuration}, unique_id_(identifier::acquire_unique_id(this))
-	{
-	}
-
-	mesh::~mesh()
-	{
-		unload();
-	}
-
-	void mesh::load()
-	{
-		if (!configuration_.name.empty())
-		{
-			load_from_resource(configuration_.name);
-		}
-		else
-		{
-			for (const auto& config : configuration_.geometry_configurations)
-			{
-				auto geo = geometry_system::acquire(config);
-				add_geometry(geo);
-			}
-		}
+		increment_generation();
 	}
 
 	void mesh::add_geometry(const geometry::geometry::shared_ptr& geometry)
@@ -199,16 +167,26 @@ namespace egkr
 			geo_config.release();
 		}
 		configuration_.geometry_configurations.clear();
+		load_failed_ = false;
 
 		set_generation(invalid_32_id);
 	}
 
 	void mesh::load_from_resource(const std::string& name)
 	{
-		mesh_load_parameters parameters{ .resource_name = name.c_str(), .loaded_mesh = shared_from_this(), .mesh_resource = {}};
-
-		auto info = job_system::job_system::create_job(load_job_start, load_job_success, load_job_fail, &parameters, sizeof(mesh_load_parameters), sizeof(mesh_load_parameters));
-		job_system::job_system::submit(info);
+		resource_system::load_async(name, resource::type::mesh, nullptr,
+			[loaded_mesh = shared_from_this(), name](const resource::shared_ptr& mesh_resource)
+			{
+				if (!mesh_resource)
+				{
+					LOG_ERROR("Failed to load mesh '{}'", name);
+					loaded_mesh->load_failed_ = true;
+					return;
+				}
 
+				loaded_mesh->load(mesh_resource);
+				LOG_TRACE("Successfully loaded mesh '{}'", name);
+				resource_system::unload(mesh_resource);
+			});
 	}
 }
@@ -26,8 +26,15 @@ namespace egkr
 		~mesh();
 
 		void load();
+		// Builds the geometry from a mesh resource the caller already loaded, on the calling thread
+		void load(const resource::shared_ptr& mesh_resource);
 		void unload();
 
+		[[nodiscard]] const std::string& get_resource_name() const { return configuration_.name; }
+		[[nodiscard]] bool is_loaded() const { return !geometries_.empty(); }
+		// Set when the mesh resource could not be read, such a mesh never becomes loaded
+		[[nodiscard]] bool has_failed_to_load() const { return load_failed_; }
+
 		void add_geometry(const geometry::geometry::shared_ptr& geometry);
 		[[nodiscard]] const auto& get_geometries() const { return geometries_; }
 
@@ -45,5 +52,6 @@ namespace egkr
 		//TODO how to do this properly?
 		debug::debug_box3d::shared_ptr debug_data;
 		uint32_t unique_id_{};
+		bool load_failed_{};
 	};
 }
@@ -1,18 +1,24 @@
 #pragma once
 #include "pch.h"
+#include "platform/mapped_file.h"
 
 namespace egkr
 {
 
     struct binary_resource_properties
     {
-	egkr::vector<uint8_t> data;
+	// Views file when the loader mapped it, otherwise owned
+	std::span<const uint8_t> data;
+	mapped_file file;
+	egkr::vector<uint8_t> owned;
     };
 
     struct image_resource_parameters
     {
 	bool flip_y{};
 	uint32_t mip_levels{ 1 };
+	// Decodes to a single 16-bit channel, 8-bit sources are widened. Used for heightmaps, not uploadable as a texture
+	bool single_channel_16_bit{};
     };
 
     constexpr auto RESOURCE_MAGIC = 0xdeadbeef;
@@ -79,6 +85,7 @@ namespace egkr
 
 	void set_name(const std::string& name) { name_ = name; }
 	const auto& get_name() const { return name_; }
+	const auto& get_full_path() const { return full_path_; }
 
 	void* data{};
     private:
@@ -1,6 +1,7 @@
 #include "shader.h"
 
 #include "systems/texture_system.h"
+#include "systems/job_system.h"
 #include "engine/engine.h"
 
 namespace egkr
@@ -37,23 +38,48 @@ namespace egkr
 				add_uniform(shader_uniform);
 			}
 		}
+		storage_buffers_.resize(shader_properties.storage_buffers.size());
 		state_ = state::initialised;
 	}
 
 	shader::~shader() = default;
 
-	uint32_t shader::get_uniform_index(std::string_view uniform_name)
+	uint32_t shader::get_uniform_index(uniform_id id) const
 	{
-		if (uniform_id_by_name_.contains(uniform_name.data()))
+		const auto found = std::ranges::lower_bound(uniform_index_by_hash_, id.hash, {}, &std::pair<uint64_t, uint16_t>::first);
+		if (found != uniform_index_by_hash_.end() && found->first == id.hash)
 		{
-			return uniforms_[uniform_id_by_name_[uniform_name.data()]].index;
+			return found->second;
 		}
 
-		LOG_WARN("Attempted to retrieve an invalid uniform: {}, from shader: {}", uniform_name, get_name());
+		LOG_WARN("Attempted to retrieve an invalid uniform: {} ({:#x}), from shader: {}", id.name, id.hash, get_name());
 
 		return invalid_32_id;
 	}
 
+	uint32_t shader::get_storage_index(std::string_view storage_name) const
+	{
+		const auto& names = properties_.storage_buffers;
+		if (auto found = std::ranges::find(names, storage_name); found != names.end())
+		{
+			return (uint32_t)std::distance(names.begin(), found);
+		}
+
+		LOG_WARN("Attempted to retrieve an invalid storage buffer: {}, from shader: {}", storage_name, get_name());
+
+		return invalid_32_id;
+	}
+
+	void shader::set_storage_buffer(uint32_t index, renderbuffer::renderbuffer* buffer)
+	{
+		if (index >= storage_buffers_.size())
+		{
+			LOG_ERROR("Storage buffer index {} out of range for shader: {}", index, get_name());
+			return;
+		}
+		storage_buffers_[index] = buffer;
+	}
+
 	const shader::uniform& shader::get_uniform(uint32_t index)
 	{
 		return uniforms_[index];
@@ -61,12 +87,18 @@ namespace egkr
 
 	void shader::set_bound_scope(scope shader_scope)
 	{
-		bound_scope_ = shader_scope;
+		get_binding_state().bound_scope = shader_scope;
 	}
 
 	void shader::set_bound_instance_id(uint32_t instance_id)
 	{
-		bound_instance_id_ = instance_id;
+		get_binding_state().bound_instance_id = instance_id;
+	}
+
+	shader::binding_state& shader::get_binding_state() const
+	{
+		// Recording slots run on job workers or the main thread, which is the only other thread that binds shaders
+		return binding_states_[job_system::get_thread_index()];
 	}
 
 	bool shader::add_attribute(const attribute_configuration& configuration)
@@ -191,7 +223,10 @@ namespace egkr
 		
 		}
 		uniforms_.push_back(shader_uniform);
-		uniform_id_by_name_[uniform_name.data()] = shader_uniform.index;
+
+		const auto hash = uniform_id::hash_name(uniform_name);
+		const auto position = std::ranges::lower_bound(uniform_index_by_hash_, hash, {}, &std::pair<uint64_t, uint16_t>::first);
+		uniform_index_by_hash_.emplace(position, hash, shader_uniform.index);
 
 		if (!is_sampler)
 		{
@@ -208,9 +243,11 @@ namespace egkr
 
 	bool shader::is_uniform_name_valid(std::string_view uniform_name)
 	{
-		if (uniform_id_by_name_.contains(uniform_name.data()))
+		const auto hash = uniform_id::hash_name(uniform_name);
+		if (std::ranges::binary_search(uniform_index_by_hash_, hash, {}, &std::pair<uint64_t, uint16_t>::first))
 		{
-			LOG_INFO("Uniform already exists: {}", uniform_name.data());
+			// Either a repeat or two names sharing a hash, neither could be told apart at lookup
+			LOG_INFO("Uniform already exists or its name hash collides: {}", uniform_name.data());
 			return false;
 		}
 		return true;
@@ -2,12 +2,39 @@
 #include "pch.h"
 
 #include "renderer/renderpass.h"
+#include "renderer/renderbuffer.h"
 #include "texture.h"
+#include "resources/job.h"
 
 #include <unordered_map>
 
 namespace egkr
 {
+	// FNV-1a hash of a uniform's name. A literal name is hashed at compile time, runtime names go through from_name.
+	// The name is kept only for error messages, so an id from from_name must not outlive the string it was made from
+	struct uniform_id
+	{
+		uint64_t hash{};
+		std::string_view name;
+
+		consteval uniform_id(const char* uniform_name) : hash{ hash_name(uniform_name) }, name{ uniform_name } {}
+
+		constexpr static uniform_id from_name(std::string_view uniform_name) { return uniform_id{ hash_name(uniform_name), uniform_name }; }
+
+		constexpr static uint64_t hash_name(std::string_view name)
+		{
+			uint64_t result{ 0xcbf29ce484222325ULL };
+			for (const char character : name)
+			{
+				result = (result ^ (uint8_t)character) * 0x100000001b3ULL;
+			}
+			return result;
+		}
+
+	private:
+		constexpr uniform_id(uint64_t name_hash, std::string_view uniform_name) : hash{ name_hash }, name{ uniform_name } {}
+	};
+
 	class shader : public resource
 	{
 	public:
@@ -126,6 +153,8 @@ namespace egkr
 			std::string name;
 			egkr::vector<attribute_configuration> attributes;
 			egkr::vector<uniform_configuration> uniforms;
+			// Global storage buffers, bound after the global uniforms and samplers in declaration order
+			egkr::vector<std::string> storage_buffers;
 			egkr::vector<stages> shader_stages;
 			egkr::vector<std::string> stage_names;
 			egkr::vector<std::string> stage_filenames;
@@ -171,13 +200,14 @@ namespace egkr
 		explicit shader(const properties& properties);
 		virtual ~shader();
 
-		uint32_t get_uniform_index(std::string_view uniform_name);
+		// Binary search of the hashes sorted at creation, resolve once and keep the index for per-draw use
+		uint32_t get_uniform_index(uniform_id id) const;
 		const uniform& get_uniform(uint32_t index);
 
-		const auto& get_bound_scope() const { return bound_scope_; }
+		const auto& get_bound_scope() const { return get_binding_state().bound_scope; }
 		void set_bound_scope(scope scope);
 
-		const auto& get_bound_instance_id() const { return bound_instance_id_; }
+		const auto& get_bound_instance_id() const { return get_binding_state().bound_instance_id; }
 		void set_bound_instance_id(uint32_t instance_id);
 
 		auto has_instances() const { return properties_.instance_uniform_count > 0 || properties_.instance_uniform_sampler_count > 0; }
@@ -195,11 +225,16 @@ namespace egkr
 		void set_ubo_stride(uint64_t stride) { ubo_stride_ = stride; }
 
 		const auto& get_global_ubo_offset() const { return global_ubo_offset_; }
-		void set_bound_ubo_offset(uint64_t offset) { bound_ubo_offset_ = offset; }
-		const auto& get_bound_ubo_offset() const { return bound_ubo_offset_; }
+		void set_bound_ubo_offset(uint64_t offset) { get_binding_state().bound_ubo_offset = offset; }
+		const auto& get_bound_ubo_offset() const { return get_binding_state().bound_ubo_offset; }
 
 		void set_global_texture(uint32_t index, texture_map* map);
 
+		uint32_t get_storage_index(std::string_view storage_name) const;
+		// Takes effect on the next apply_globals that updates
+		void set_storage_buffer(uint32_t index, renderbuffer::renderbuffer* buffer);
+		[[nodiscard]] const auto& get_storage_buffers() const { return storage_buffers_; }
+
 		const auto& get_attribute_stride() const { return attribute_stride_; }
 
 		[[nodiscard]] uint64_t get_frame_number() const { return frame_number_; }
@@ -217,6 +252,16 @@ namespace egkr
 		virtual uint32_t acquire_instance_resources(const egkr::vector<texture_map::shared_ptr>& texture_maps) = 0;
 		virtual bool set_uniform(const uniform& uniform, const void* value) = 0;
 	private:
+		// Bound state is kept per job thread so passes recording in parallel with the same shader don't clobber each other
+		struct binding_state
+		{
+			scope bound_scope{};
+			uint32_t bound_instance_id{};
+			uint64_t bound_ubo_offset{};
+		};
+
+		binding_state& get_binding_state() const;
+
 		bool add_attribute(const attribute_configuration& configuration);
 		bool add_sampler(const uniform_configuration& configuration);
 		bool add_uniform(const uniform_configuration& configuration);
@@ -239,13 +284,13 @@ namespace egkr
 		uint64_t push_constant_size_{};
 		uint64_t push_constan_stride_{};
 		egkr::vector<std::shared_ptr<texture_map>> global_textures_;
+		egkr::vector<renderbuffer::renderbuffer*> storage_buffers_;
 
 		uint8_t instance_texture_count_{};
-		scope bound_scope_{};
-		uint32_t bound_instance_id_{};
-		uint64_t bound_ubo_offset_{};
+		mutable std::array<binding_state, job::MAX_THREAD_INDICES> binding_states_{};
 
-		std::unordered_map<std::string, uint32_t> uniform_id_by_name_;
+		// Uniform indices sorted by name hash
+		egkr::vector<std::pair<uint64_t, uint16_t>> uniform_index_by_hash_;
 		egkr::vector<uniform> uniforms_;
 
 		egkr::vector<attribute> attributes_;
@@ -1,54 +1,630 @@
 #include "terrain.h"
 #include <cstdlib>
 #include <memory>
+#include <random>
 #include "identifier.h"
 #include "pch.h"
 #include "resources/resource.h"
-#include "systems/geometry_utils.h"
+#include "systems/job_system.h"
 #include "systems/resource_system.h"
 
 namespace egkr
 {
+    constexpr static uint32_t stitch_left{1};
+    constexpr static uint32_t stitch_right{2};
+    constexpr static uint32_t stitch_bottom{4};
+    constexpr static uint32_t stitch_top{8};
+
     terrain::shared_ptr terrain::create(const terrain::configuration& configuration) { return std::make_shared<terrain>(configuration); }
 
     terrain::terrain(const terrain::configuration& configuration)
         : resource(0, 0, configuration.name), unique_id{identifier::acquire_unique_id(this)}, name{configuration.name}, tiles_x{configuration.tiles_x}, tiles_y{configuration.tiles_y},
           scale_x{configuration.scale_x}, scale_y{configuration.scale_y}, scale_z{configuration.scale_z}
     {
-	vertices.resize(tiles_x * tiles_y);
-	indices.resize(6 * tiles_x * tiles_y);
+	ZoneScoped;
+
+	const auto& heights = configuration.heights;
+	if (heights)
+	{
+	    tiles_x = heights->get_width();
+	    tiles_y = heights->get_height();
+	}
+	tiles_x = std::max(tiles_x, 1u);
+	tiles_y = std::max(tiles_y, 1u);
+
+	chunks_x = std::max((tiles_x + chunk_size - 2) / chunk_size, 1u);
+	chunks_y = std::max((tiles_y + chunk_size - 2) / chunk_size, 1u);
+	chunks.resize((size_t)chunks_x * chunks_y);
+	vertices.resize(chunks.size() * chunk_vertex_count);
+
+	// One band of heightmap rows is resident at a time, its chunks are built in parallel
+	constexpr uint32_t band_rows{chunk_size + 3};
+	constexpr uint32_t max_tasks{8};
+	egkr::vector<float> band;
+	uint32_t cy{};
+	int64_t first_row{};
+	std::atomic<uint32_t> next_chunk{};
+
+	egkr::vector<std::function<void()>> tasks(std::min(chunks_x, max_tasks));
+	for (auto& task : tasks)
+	{
+	    task = [&]()
+	    {
+		for (uint32_t cx = next_chunk.fetch_add(1, std::memory_order_relaxed); cx < chunks_x; cx = next_chunk.fetch_add(1, std::memory_order_relaxed))
+		{
+		    build_chunk(cx, cy, band, first_row);
+		}
+	    };
+	}
+
+	for (; cy < chunks_y; ++cy)
+	{
+	    first_row = ((int64_t)cy * chunk_size) - 1;
+	    if (heights)
+	    {
+		heights->read_rows(first_row, band_rows, band);
+	    }
+	    else
+	    {
+		band.assign((size_t)band_rows * tiles_x, 0.F);
+	    }
+
+	    next_chunk.store(0, std::memory_order_relaxed);
+	    job_system::execute_and_wait(tasks, job::type::general);
+	}
+
+	extents = {.min = float3{std::numeric_limits<float>::max()}, .max = float3{std::numeric_limits<float>::lowest()}};
+	for (const auto& chunk : chunks)
+	{
+	    extents.min = glm::min(extents.min, chunk.center - chunk.half_extents);
+	    extents.max = glm::max(extents.max, chunk.center + chunk.half_extents);
+	}
+
+	build_lod_indices();
+    }
+
+    void terrain::build_chunk(uint32_t cx, uint32_t cy, const egkr::vector<float>& band, int64_t first_row)
+    {
+	constexpr uint32_t row = chunk_size + 1;
+
+	auto& chunk = chunks[(cy * chunks_x) + cx];
+	auto* chunk_vertices = &vertices[(size_t)((cy * chunks_x) + cx) * chunk_vertex_count];
+
+	auto sample = [&](uint32_t x, uint32_t y) { return band[((size_t)(y - first_row) * tiles_x) + x] * scale_z; };
+
+	// Chunks past the heightmap edge repeat its last row and column, those triangles collapse to nothing
+	float3 min{std::numeric_limits<float>::max()};
+	float3 max{std::numeric_limits<float>::lowest()};
+	for (uint32_t y{}; y < row; ++y)
+	{
+	    const uint32_t grid_y = std::min((cy * chunk_size) + y, tiles_y - 1);
+	    const uint32_t y0 = grid_y > 0 ? grid_y - 1 : 0;
+	    const uint32_t y1 = std::min(grid_y + 1, tiles_y - 1);
+	    for (uint32_t x{}; x < row; ++x)
+	    {
+		const uint32_t grid_x = std::min((cx * chunk_size) + x, tiles_x - 1);
+		const uint32_t x0 = grid_x > 0 ? grid_x - 1 : 0;
+		const uint32_t x1 = std::min(grid_x + 1, tiles_x - 1);
+
+		// Central differences weigh the four quads around the vertex evenly, the same as averaging their
+		// area weighted face normals on a regular grid
+		const float dzdx = x1 != x0 ? (sample(x1, grid_y) - sample(x0, grid_y)) / ((float)(x1 - x0) * scale_x) : 0.F;
+		const float dzdy = y1 != y0 ? (sample(grid_x, y1) - sample(grid_x, y0)) / ((float)(y1 - y0) * scale_y) : 0.F;
+
+		const float3 position{(float)grid_x * scale_x, (float)grid_y * scale_y, sample(grid_x, grid_y)};
+		chunk_vertices[(y * row) + x] = terrain::vertex{.position = position,
+		    .normal = glm::normalize(float3{-dzdx, -dzdy, 1.F}),
+		    .tex = {(float)grid_x, (float)grid_y},
+		    .colour{0.5, 0.5, 0.5, 1.0},
+		    .tangent{glm::normalize(float3{1.F, 0.F, dzdx}), -1.F}};
+		min = glm::min(min, position);
+		max = glm::max(max, position);
+	    }
+	}
+	chunk.center = (min + max) * 0.5F;
+	chunk.half_extents = (max - min) * 0.5F;
+
+	auto height = [chunk_vertices](uint32_t x, uint32_t y) { return chunk_vertices[(y * row) + x].position.z; };
+	for (uint32_t lod{1}; lod < lod_count; ++lod)
+	{
+	    const uint32_t step = 1U << lod;
+	    float error{};
+	    for (uint32_t y{}; y < row; ++y)
+	    {
+		for (uint32_t x{}; x < row; ++x)
+		{
+		    const uint32_t x0 = x / step * step;
+		    const uint32_t y0 = y / step * step;
+		    const uint32_t x1 = std::min(x0 + step, chunk_size);
+		    const uint32_t y1 = std::min(y0 + step, chunk_size);
+		    const float fx = (float)(x - x0) / (float)step;
+		    const float fy = (float)(y - y0) / (float)step;
+
+		    const float bottom = glm::mix(height(x0, y0), height(x1, y0), fx);
+		    const float top = glm::mix(height(x0, y1), height(x1, y1), fx);
+		    error = std::max(error, std::abs(height(x, y) - glm::mix(bottom, top, fy)));
+		}
+	    }
+	    chunk.lod_error[lod] = std::max(error, chunk.lod_error[lod - 1]);
+	}
+    }
+
+    void terrain::build_lod_indices()
+    {
+	constexpr uint32_t row = chunk_size + 1;
+
+	indices.clear();
+	for (uint32_t lod{}; lod < lod_count; ++lod)
+	{
+	    const uint32_t step = 1U << lod;
+	    const uint32_t coarse_step = step * 2;
+	    // Nothing is coarser than the last lod, it only needs the unstitched variant
+	    const uint32_t variant_count = lod + 1 < lod_count ? stitch_variant_count : 1;
+
+	    for (uint32_t mask{}; mask < stitch_variant_count; ++mask)
+	    {
+		if (mask >= variant_count)
+		{
+		    lod_ranges[lod][mask] = lod_ranges[lod][0];
+		    continue;
+		}
+
+		// Edge vertices between the coarser neighbour's are snapped onto the previous one, so the edge runs along
+		// exactly the neighbour's segments and the leftover triangles collapse
+		auto snap = [mask, coarse_step](uint32_t x, uint32_t y)
+		{
+		    if (((mask & stitch_left) && x == 0) || ((mask & stitch_right) && x == chunk_size))
+		    {
+			y = y / coarse_step * coarse_step;
+		    }
+		    if (((mask & stitch_bottom) && y == 0) || ((mask & stitch_top) && y == chunk_size))
+		    {
+			x = x / coarse_step * coarse_step;
+		    }
+		    return (y * row) + x;
+		};
+
+		auto emit = [this](uint32_t a, uint32_t b, uint32_t c)
+		{
+		    if (a != b && b != c && a != c)
+		    {
+			indices.insert(indices.end(), {a, b, c});
+		    }
+		};
+
+		const auto first_index = (uint32_t)indices.size();
+		for (uint32_t y{}; y < chunk_size; y += step)
+		{
+		    for (uint32_t x{}; x < chunk_size; x += step)
+		    {
+			const uint32_t v0 = snap(x, y);
+			const uint32_t v1 = snap(x + step, y);
+			const uint32_t v2 = snap(x, y + step);
+			const uint32_t v3 = snap(x + step, y + step);
+			emit(v0, v1, v2);
+			emit(v2, v1, v3);
+		    }
+		}
+		lod_ranges[lod][mask] = {.first_index = first_index, .index_count = (uint32_t)indices.size() - first_index};
+	    }
+	}
+    }
+
+    const egkr::vector<terrain::chunk_draw>& terrain::select_chunks(const frustum& frustum, const float3& view_position, float lod_scale, float max_pixel_error)
+    {
+	ZoneScoped;
+
+	const float4x4 world = get_world();
+	const glm::mat3 abs_basis{glm::abs(float3{world[0]}), glm::abs(float3{world[1]}), glm::abs(float3{world[2]})};
+	const float world_scale = std::max({glm::length(float3{world[0]}), glm::length(float3{world[1]}), glm::length(float3{world[2]})});
+
+	chunk_lods.resize(chunks.size());
+	chunk_visible.resize(chunks.size());
+	visible_chunks.clear();
+
+	for (size_t i{}; i < chunks.size(); ++i)
+	{
+	    const auto& chunk = chunks[i];
+	    const float3 center = world * float4{chunk.center, 1.F};
+	    const float3 half_extents = abs_basis * chunk.half_extents;
+	    chunk_visible[i] = frustum.intersects_aabb(center, half_extents) ? 1 : 0;
+
+	    const float3 outside = glm::max(glm::abs(view_position - center) - half_extents, float3{0.F});
+	    const float distance = std::max(glm::length(outside), 0.001F);
+
+	    uint8_t lod{};
+	    for (uint32_t candidate{lod_count - 1}; candidate > 0; --candidate)
+	    {
+		if (chunk.lod_error[candidate] * world_scale * lod_scale / distance <= max_pixel_error)
+		{
+		    lod = (uint8_t)candidate;
+		    break;
+		}
+	    }
+	    chunk_lods[i] = lod;
+	}
+
+	// Stitching only covers neighbours one lod apart, refine chunks until no neighbour is further away.
+	// Lods only ever decrease, so this settles within lod_count passes
+	auto lod_at = [this](int64_t x, int64_t y) -> uint32_t
+	{
+	    if (x < 0 || y < 0 || x >= (int64_t)chunks_x || y >= (int64_t)chunks_y)
+	    {
+		return lod_count;
+	    }
+	    return chunk_lods[(size_t)((y * chunks_x) + x)];
+	};
+
+	bool changed{true};
+	while (changed)
+	{
+	    changed = false;
+	    for (int64_t y{}; y < chunks_y; ++y)
+	    {
+		for (int64_t x{}; x < chunks_x; ++x)
+		{
+		    auto& lod = chunk_lods[(size_t)((y * chunks_x) + x)];
+		    const uint32_t limit = std::min({lod_at(x - 1, y), lod_at(x + 1, y), lod_at(x, y - 1), lod_at(x, y + 1)}) + 1;
+		    if (lod > limit)
+		    {
+			lod = (uint8_t)limit;
+			changed = true;
+		    }
+		}
+	    }
+	}
+
+	for (int64_t y{}; y < chunks_y; ++y)
+	{
+	    for (int64_t x{}; x < chunks_x; ++x)
+	    {
+		const auto index = (size_t)((y * chunks_x) + x);
+		if (!chunk_visible[index])
+		{
+		    continue;
+		}
+
+		const uint32_t lod = chunk_lods[index];
+		uint32_t mask{};
+		auto coarser = [lod, &lod_at](int64_t nx, int64_t ny) { return lod_at(nx, ny) != lod_count && lod_at(nx, ny) > lod; };
+		mask |= coarser(x - 1, y) ? stitch_left : 0U;
+		mask |= coarser(x + 1, y) ? stitch_right : 0U;
+		mask |= coarser(x, y - 1) ? stitch_bottom : 0U;
+		mask |= coarser(x, y + 1) ? stitch_top : 0U;
+
+		auto draw = lod_ranges[lod][mask];
+		draw.vertex_offset = (uint32_t)(index * chunk_vertex_count);
+		visible_chunks.push_back(draw);
+	    }
+	}
+
+	return visible_chunks;
+    }
+
+    // Moller-Trumbore, returns the ray parameter of the hit
+    static std::optional<float> intersect_triangle(const float3& origin, const float3& direction, const float3& v0, const float3& v1, const float3& v2)
+    {
+	constexpr float epsilon{1e-8F};
+	const float3 edge1 = v1 - v0;
+	const float3 edge2 = v2 - v0;
+	const float3 p = glm::cross(direction, edge2);
+	const float determinant = glm::dot(edge1, p);
+	if (std::abs(determinant) < epsilon)
+	{
+	    return {};
+	}
+
+	const float inverse = 1.F / determinant;
+	const float3 s = origin - v0;
+	const float u = glm::dot(s, p) * inverse;
+	if (u < 0.F || u > 1.F)
+	{
+	    return {};
+	}
+
+	const float3 q = glm::cross(s, edge1);
+	const float v = glm::dot(direction, q) * inverse;
+	if (v < 0.F || u + v > 1.F)
+	{
+	    return {};
+	}
+
+	const float t = glm::dot(edge2, q) * inverse;
+	return t >= 0.F ? std::optional{t} : std::nullopt;
+    }
+
+    static bool spans_height(float origin_z, float direction_z, float t_enter, float t_exit, float min_z, float max_z)
+    {
+	const float z0 = origin_z + (direction_z * t_enter);
+	const float z1 = origin_z + (direction_z * t_exit);
+	return std::min(z0, z1) <= max_z && std::max(z0, z1) >= min_z;
+    }
+
+    // 2D DDA over the cells of cell_size in [begin, end) crossed by origin + t * direction for t in [t_min, t_max], nearest first.
+    // visit(x, y, t_enter, t_exit) returns true to stop the walk
+    template <typename visitor>
+    static bool walk_cells(const float3& origin, const float3& direction, float t_min, float t_max, uint32_t begin_x, uint32_t begin_y, uint32_t end_x, uint32_t end_y, float cell_size,
+        visitor&& visit)
+    {
+	constexpr float infinity{std::numeric_limits<float>::infinity()};
+	const float3 start = origin + (direction * t_min);
+	auto x = std::clamp((int64_t)std::floor(start.x / cell_size), (int64_t)begin_x, (int64_t)end_x - 1);
+	auto y = std::clamp((int64_t)std::floor(start.y / cell_size), (int64_t)begin_y, (int64_t)end_y - 1);
 
-	for (uint32_t y{}; y < tiles_y; y++)
+	const int64_t step_x = direction.x > 0.F ? 1 : -1;
+	const int64_t step_y = direction.y > 0.F ? 1 : -1;
+	const float delta_x = direction.x != 0.F ? cell_size / std::abs(direction.x) : infinity;
+	const float delta_y = direction.y != 0.F ? cell_size / std::abs(direction.y) : infinity;
+	float next_x = direction.x != 0.F ? (((float)(x + (step_x > 0 ? 1 : 0)) * cell_size) - origin.x) / direction.x : infinity;
+	float next_y = direction.y != 0.F ? (((float)(y + (step_y > 0 ? 1 : 0)) * cell_size) - origin.y) / direction.y : infinity;
+
+	float t = t_min;
+	while (x >= begin_x && x < end_x && y >= begin_y && y < end_y)
 	{
-	    for (uint32_t x{}; x < tiles_x; x++)
+	    const float t_exit = std::min({next_x, next_y, t_max});
+	    if (visit((uint32_t)x, (uint32_t)y, t, t_exit))
 	    {
-		const uint32_t v0 = y * tiles_x + x;
+		return true;
+	    }
 
-		vertices[v0]
-		    = terrain::vertex{.position = {x * scale_x, y * scale_y, configuration.height_data[v0] * scale_z}, .normal = {0, 0, 1}, .tex = {x, y}, .colour{0.5, 0.5, 0.5, 1.0}, .tangent{1, 0, 0, 0}};
+	    if (t_exit >= t_max)
+	    {
+		break;
 	    }
+
+	    t = t_exit;
+	    if (next_x < next_y)
+	    {
+		x += step_x;
+		next_x += delta_x;
+	    }
+	    else
+	    {
+		y += step_y;
+		next_y += delta_y;
+	    }
+	}
+	return false;
+    }
+
+    const terrain::vertex& terrain::vertex_at(uint32_t x, uint32_t y) const
+    {
+	// Shared edges are duplicated between chunks, the last chunk in each direction owns the far edge
+	const uint32_t cx = std::min(x / chunk_size, chunks_x - 1);
+	const uint32_t cy = std::min(y / chunk_size, chunks_y - 1);
+	const size_t chunk_offset = (size_t)((cy * chunks_x) + cx) * chunk_vertex_count;
+	return vertices[chunk_offset + ((y - (cy * chunk_size)) * (chunk_size + 1)) + (x - (cx * chunk_size))];
+    }
+
+    void terrain::sample_surface(float x, float y, std::array<const vertex*, 3>& corners, float3& weights) const
+    {
+	const float grid_x = std::clamp(x / scale_x, 0.F, (float)(tiles_x - 1));
+	const float grid_y = std::clamp(y / scale_y, 0.F, (float)(tiles_y - 1));
+	const uint32_t x0 = std::min((uint32_t)grid_x, std::max(tiles_x, 2u) - 2);
+	const uint32_t y0 = std::min((uint32_t)grid_y, std::max(tiles_y, 2u) - 2);
+	const uint32_t x1 = std::min(x0 + 1, tiles_x - 1);
+	const uint32_t y1 = std::min(y0 + 1, tiles_y - 1);
+	const float fx = grid_x - (float)x0;
+	const float fy = grid_y - (float)y0;
+
+	// Same split as the mesh, the diagonal runs from x1, y0 to x0, y1
+	if (fx + fy <= 1.F)
+	{
+	    corners = {&vertex_at(x0, y0), &vertex_at(x1, y0), &vertex_at(x0, y1)};
+	    weights = {1.F - fx - fy, fx, fy};
 	}
-	uint32_t i{};
-	for (uint32_t y{}; y < tiles_y - 1; y++)
+	else
+	{
+	    corners = {&vertex_at(x1, y1), &vertex_at(x1, y0), &vertex_at(x0, y1)};
+	    weights = {fx + fy - 1.F, 1.F - fy, 1.F - fx};
+	}
+    }
+
+    float terrain::height_at(float x, float y) const
+    {
+	if (vertices.empty())
 	{
-	    for (uint32_t x{}; x < tiles_x - 1; x++, i += 6)
+	    return 0.F;
+	}
+
+	std::array<const vertex*, 3> corners{};
+	float3 weights{};
+	sample_surface(x, y, corners, weights);
+	return (corners[0]->position.z * weights.x) + (corners[1]->position.z * weights.y) + (corners[2]->position.z * weights.z);
+    }
+
+    float3 terrain::normal_at(float x, float y) const
+    {
+	if (vertices.empty())
+	{
+	    return {0, 0, 1};
+	}
+
+	std::array<const vertex*, 3> corners{};
+	float3 weights{};
+	sample_surface(x, y, corners, weights);
+	return glm::normalize((corners[0]->normal * weights.x) + (corners[1]->normal * weights.y) + (corners[2]->normal * weights.z));
+    }
+
+    std::optional<float> terrain::intersect_cell(const float3& origin, const float3& direction, uint32_t x, uint32_t y) const
+    {
+	const float3& v0 = vertex_at(x, y).position;
+	const float3& v1 = vertex_at(x + 1, y).position;
+	const float3& v2 = vertex_at(x, y + 1).position;
+	const float3& v3 = vertex_at(x + 1, y + 1).position;
+
+	const auto first = intersect_triangle(origin, direction, v0, v1, v2);
+	const auto second = intersect_triangle(origin, direction, v2, v1, v3);
+	if (first && second)
+	{
+	    return std::min(*first, *second);
+	}
+	return first ? first : second;
+    }
+
+    std::optional<ray::hit> terrain::raycast(const ray& ray)
+    {
+	if (tiles_x < 2 || tiles_y < 2)
+	{
+	    return {};
+	}
+
+	// Both spaces are affine to world space, so the ray parameter is the same in all three
+	const float4x4 inverse = glm::inverse(get_world());
+	const float3 origin = inverse * float4{ray.origin, 1.F};
+	const float3 direction = inverse * float4{ray.direction, 0.F};
+	const float3 scale{scale_x, scale_y, 1.F};
+	const float3 grid_origin = origin / scale;
+	const float3 grid_direction = direction / scale;
+
+	const float3 grid_min{0.F, 0.F, extents.min.z};
+	const float3 grid_max{(float)(tiles_x - 1), (float)(tiles_y - 1), extents.max.z};
+	float t_min{};
+	float t_max{std::numeric_limits<float>::max()};
+	for (int32_t axis{}; axis < 3; ++axis)
+	{
+	    if (grid_direction[axis] == 0.F)
 	    {
-		const uint32_t v0 = y * tiles_x + x;
-		const uint32_t v1 = v0 + 1;
-		const uint32_t v2 = v0 + tiles_x;
-		const uint32_t v3 = v2 + 1;
-		indices[i] = v0;
-		indices[i + 1] = v1;
-		indices[i + 2] = v2;
+		if (grid_origin[axis] < grid_min[axis] || grid_origin[axis] > grid_max[axis])
+		{
+		    return {};
+		}
+		continue;
+	    }
 
-		indices[i + 3] = v2;
-		indices[i + 4] = v1;
-		indices[i + 5] = v3;
+	    float t0 = (grid_min[axis] - grid_origin[axis]) / grid_direction[axis];
+	    float t1 = (grid_max[axis] - grid_origin[axis]) / grid_direction[axis];
+	    if (t0 > t1)
+	    {
+		std::swap(t0, t1);
 	    }
+	    t_min = std::max(t_min, t0);
+	    t_max = std::min(t_max, t1);
+	}
+
+	if (t_min > t_max)
+	{
+	    return {};
 	}
 
-	generate_normals(vertices, indices);
-	generate_tangents(vertices, indices);
+	std::optional<float> nearest{};
+	walk_cells(grid_origin, grid_direction, t_min, t_max, 0, 0, chunks_x, chunks_y, (float)chunk_size,
+	    [&](uint32_t cx, uint32_t cy, float chunk_enter, float chunk_exit)
+	    {
+		const auto& chunk = chunks[(cy * chunks_x) + cx];
+		if (!spans_height(origin.z, direction.z, chunk_enter, chunk_exit, chunk.center.z - chunk.half_extents.z, chunk.center.z + chunk.half_extents.z))
+		{
+		    return false;
+		}
+
+		const uint32_t end_x = std::min((cx + 1) * chunk_size, tiles_x - 1);
+		const uint32_t end_y = std::min((cy + 1) * chunk_size, tiles_y - 1);
+		return walk_cells(grid_origin, grid_direction, chunk_enter, chunk_exit, cx * chunk_size, cy * chunk_size, end_x, end_y, 1.F,
+		    [&](uint32_t x, uint32_t y, float cell_enter, float cell_exit)
+		    {
+			const float h0 = vertex_at(x, y).position.z;
+			const float h1 = vertex_at(x + 1, y).position.z;
+			const float h2 = vertex_at(x, y + 1).position.z;
+			const float h3 = vertex_at(x + 1, y + 1).position.z;
+			if (!spans_height(origin.z, direction.z, cell_enter, cell_exit, std::min({h0, h1, h2, h3}), std::max({h0, h1, h2, h3})))
+			{
+			    return false;
+			}
+
+			nearest = intersect_cell(origin, direction, x, y);
+			return nearest.has_value();
+		    });
+	    });
+
+	if (!nearest)
+	{
+	    return {};
+	}
+
+	return ray::hit{
+	    .type = ray::hit_type::surface,
+	    .unique_id = unique_id,
+	    .position = ray.origin + (ray.direction * *nearest),
+	    .distance = *nearest * glm::length(ray.direction),
+	};
+    }
+
+    // Rays per second on the sample heightmaps, against testing every triangle of the terrain
+    void terrain::raycast_benchmark_command(const console::context& /*context*/)
+    {
+	constexpr std::array heightmaps{"terrain_heightmap_512", "terrain_heightmap3"};
+	constexpr uint32_t ray_count{100000};
+	constexpr uint32_t brute_force_ray_count{16};
+	using clock = std::chrono::high_resolution_clock;
+
+	for (const auto* heightmap_name : heightmaps)
+	{
+	    image_resource_parameters params{.flip_y = false, .single_channel_16_bit = true};
+	    auto image = resource_system::load(heightmap_name, resource::type::image, &params);
+	    if (!image || !image->data)
+	    {
+		LOG_ERROR("Could not load heightmap image: {}", heightmap_name);
+		continue;
+	    }
+
+	    auto* image_properties = (texture::properties*)image->data;
+	    const auto* samples = (uint16_t*)image_properties->data;
+	    const size_t sample_count = (size_t)image_properties->width * image_properties->height;
+	    auto heights = heightmap::create(image_properties->width, image_properties->height, egkr::vector<uint16_t>(samples, samples + sample_count));
+	    resource_system::unload(image);
+
+	    auto benchmark_terrain = terrain::create({.name = heightmap_name, .scale_z = 100.F, .heights = heights});
+
+	    // Fixed seed, every run casts the same rays down onto the terrain at an angle
+	    std::mt19937 random{1234};
+	    std::uniform_real_distribution<float> unit{0.F, 1.F};
+	    egkr::vector<ray> rays(ray_count);
+	    for (auto& ray : rays)
+	    {
+		ray.origin = {unit(random) * benchmark_terrain->extents.max.x, unit(random) * benchmark_terrain->extents.max.y, benchmark_terrain->extents.max.z + 50.F};
+		ray.direction = glm::normalize(float3{(unit(random) * 2.F) - 1.F, (unit(random) * 2.F) - 1.F, -0.5F});
+	    }
+
+	    uint32_t hit_count{};
+	    egkr::vector<std::optional<ray::hit>> hits(ray_count);
+	    auto start = clock::now();
+	    for (uint32_t i{}; i < ray_count; ++i)
+	    {
+		hits[i] = benchmark_terrain->raycast(rays[i]);
+		hit_count += hits[i] ? 1 : 0;
+	    }
+	    const auto walk_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+	    uint32_t mismatch_count{};
+	    start = clock::now();
+	    for (uint32_t i{}; i < brute_force_ray_count; ++i)
+	    {
+		std::optional<float> nearest{};
+		for (uint32_t y{}; y + 1 < benchmark_terrain->tiles_y; ++y)
+		{
+		    for (uint32_t x{}; x + 1 < benchmark_terrain->tiles_x; ++x)
+		    {
+			if (const auto t = benchmark_terrain->intersect_cell(rays[i].origin, rays[i].direction, x, y); t && (!nearest || *t < *nearest))
+			{
+			    nearest = t;
+			}
+		    }
+		}
+
+		if (nearest.has_value() != hits[i].has_value() || (nearest && std::abs(*nearest - hits[i]->distance) > 1e-3F * *nearest))
+		{
+		    ++mismatch_count;
+		}
+	    }
+	    const auto brute_force_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+	    LOG_INFO("Terrain raycast {} ({}x{}): {:.0f} rays/s, brute force {:.0f} rays/s, {} of {} rays hit", heightmap_name, benchmark_terrain->tiles_x, benchmark_terrain->tiles_y,
+	        ray_count / walk_seconds, brute_force_ray_count / brute_force_seconds, hit_count, ray_count);
+	    if (mismatch_count != 0)
+	    {
+		LOG_WARN("Terrain raycast disagreed with brute force on {} of {} rays", mismatch_count, brute_force_ray_count);
+	    }
+	}
     }
 
     terrain::~terrain() { unload(); }
@@ -69,7 +645,11 @@ namespace egkr
 
     void terrain::unload()
     {
-	geometry->destroy();
+	if (geometry)
+	{
+	    geometry->destroy();
+	    geometry.reset();
+	}
 
 	if (unique_id != invalid_32_id)
 	{
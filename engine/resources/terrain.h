@@ -2,7 +2,10 @@
 
 #include "pch.h"
 #include "resource.h"
+#include "resources/heightmap.h"
 #include "resources/geometry.h"
+#include "ray.h"
+#include "systems/console_system.h"
 #include "transform.h"
 
 namespace egkr
@@ -14,13 +17,16 @@ namespace egkr
 	{
 	    std::string name;
 	    std::string heightmap;
+	    // Streamed 16-bit raw heightmap, tiles_x and tiles_y give its size
+	    std::string heightmap_raw;
 	    uint32_t tiles_x{1};
 	    uint32_t tiles_y{1};
 	    float scale_x{1.f};
 	    float scale_y{1.f};
 	    float scale_z{1.f};
 
-	    std::vector<float> height_data;
+	    // Flat when null
+	    heightmap::shared_ptr heights;
 	};
 	using shared_ptr = std::shared_ptr<terrain>;
 	static shared_ptr create(const terrain::configuration& configuration);
@@ -38,9 +44,55 @@ namespace egkr
 	    // std::array<float, 8> texture_weights;
 	};
 
+	// Quads along a chunk edge, chunks are drawn with geomipmapping at 1 << lod quad spacing
+	constexpr static uint32_t chunk_size{64};
+	constexpr static uint32_t chunk_vertex_count{(chunk_size + 1) * (chunk_size + 1)};
+	constexpr static uint32_t lod_count{7};
+	// Edge bits set when the neighbour on that side is one lod coarser, those edges are stitched to its vertices
+	constexpr static uint32_t stitch_variant_count{16};
+
+	struct chunk_draw
+	{
+	    uint32_t vertex_offset{};
+	    uint32_t first_index{};
+	    uint32_t index_count{};
+	};
+
 	void load();
 	void unload();
 	[[nodiscard]] const auto& get_geometry() const { return geometry; }
+	[[nodiscard]] uint32_t get_unique_id() const { return unique_id; }
+
+	// Local space queries against the full resolution surface, positions off the terrain clamp to its edge
+	[[nodiscard]] float height_at(float x, float y) const;
+	[[nodiscard]] float3 normal_at(float x, float y) const;
+	// Walks the chunks then the cells under the ray, testing only cells whose height range the ray passes through
+	[[nodiscard]] std::optional<ray::hit> raycast(const ray& ray);
+
+	static void raycast_benchmark_command(const console::context& context);
+
+	// Culls the chunks against the frustum and picks each one's lod so its height error stays under
+	// max_pixel_error on screen. lod_scale is the viewport height over 2 * tan(fov / 2)
+	const egkr::vector<chunk_draw>& select_chunks(const frustum& frustum, const float3& view_position, float lod_scale, float max_pixel_error = 2.F);
+
+    private:
+	struct chunk
+	{
+	    // Local space
+	    float3 center{};
+	    float3 half_extents{};
+	    // Largest height difference between full resolution and each lod, never decreasing with lod
+	    std::array<float, lod_count> lod_error{};
+	};
+
+	// band holds heightmap rows from first_row, including the row either side of the chunk's
+	void build_chunk(uint32_t cx, uint32_t cy, const egkr::vector<float>& band, int64_t first_row);
+	void build_lod_indices();
+	[[nodiscard]] const vertex& vertex_at(uint32_t x, uint32_t y) const;
+	// The triangle under the local position and its barycentric weights
+	void sample_surface(float x, float y, std::array<const vertex*, 3>& corners, float3& weights) const;
+	// Local space ray, returns the ray parameter of the nearest hit on the cell's two triangles
+	[[nodiscard]] std::optional<float> intersect_cell(const float3& origin, const float3& direction, uint32_t x, uint32_t y) const;
     private:
 	uint32_t unique_id{invalid_32_id};
 	std::string name;
@@ -52,9 +104,19 @@ namespace egkr
 	extent3d extents{};
 	[[maybe_unused]] float3 origin{};
 
-	//vertices and indices
-	std::vector<vertex> vertices;
-	std::vector<uint32_t> indices;
+	uint32_t chunks_x{};
+	uint32_t chunks_y{};
+	egkr::vector<chunk> chunks;
+	// Chunk vertices back to back, every chunk uses the same local grid so the index variants are shared
+	egkr::vector<vertex> vertices;
+	egkr::vector<uint32_t> indices;
+	// Per lod and stitch variant, the range of indices to draw
+	std::array<std::array<chunk_draw, stitch_variant_count>, lod_count> lod_ranges{};
+
+	// Scratch for select_chunks, reused between frames
+	egkr::vector<uint8_t> chunk_lods;
+	egkr::vector<uint8_t> chunk_visible;
+	egkr::vector<chunk_draw> visible_chunks;
 
 	geometry::shared_ptr geometry;
     };
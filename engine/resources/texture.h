@@ -49,6 +49,8 @@ namespace egkr
 	virtual bool populate(const properties& properties, const uint8_t* data) = 0;
 	virtual bool populate_writeable() = 0;
 	virtual bool write_data(uint64_t offset, uint64_t size, const uint8_t* data) = 0;
+	// Writes tightly packed pixels into a sub-rectangle, leaving the rest of the image untouched
+	virtual bool write_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height, const uint8_t* data) = 0;
 	virtual void read_data(uint64_t offset, uint64_t size, void* out_memory) = 0;
 	virtual void read_pixel(uint32_t x, uint32_t y, uint4* out_rgba) = 0;
 	virtual bool resize(uint32_t width, uint32_t height) = 0;
@@ -6,37 +6,25 @@
 
 #include <identifier.h>
 
+#include <chrono>
+
 namespace egkr
 {
     namespace text
     {
 
+	constexpr static const uint32_t verts_per_quad{4};
+
 	ui_text::shared_ptr ui_text::create(text::type type, const std::string& font_name, uint16_t font_size, const std::string& text) { return std::make_shared<ui_text>(type, font_name, font_size, text); }
 
 	ui_text::ui_text(text::type type, const std::string& font_name, uint16_t font_size, const std::string& text): type_{type}, text_{text}
 	{
 	    acquire(font_name, font_size, type);
 
-	    constexpr static const uint64_t quad_size = sizeof(vertex_2d) * 4;
-
-	    uint32_t text_length = (uint32_t)text.size();
-	    if (text_length < 1)
-	    {
-		text_length = 1;
-	    }
-
 	    auto ui_shader = shader_system::get_shader("Shader.UI");
 
 	    instance_id_ = ui_shader->acquire_instance_resources({data_->atlas});
 
-	    vertex_buffer_ = renderbuffer::renderbuffer::create(renderbuffer::type::vertex, text_length * quad_size);
-	    vertex_buffer_->bind(0);
-
-	    constexpr static const uint32_t quad_index_size = 6 * sizeof(uint32_t);
-
-	    index_buffer_ = renderbuffer::renderbuffer::create(renderbuffer::type::index, text_length * quad_index_size);
-	    index_buffer_->bind(0);
-
 	    if (!font_system::verify_atlas(data_, text))
 	    {
 		LOG_ERROR("Failed to verify atlas");
@@ -50,8 +38,6 @@ namespace egkr
 	ui_text::~ui_text()
 	{
 	    identifier::release_id(unique_id_);
-	    vertex_buffer_.reset();
-	    index_buffer_.reset();
 	}
 
 	void ui_text::acquire(const std::string& name, uint16_t font_size, type type)
@@ -80,7 +66,6 @@ namespace egkr
 
 		//Size doesn't exist
 		auto variant = font_system::create_system_font_variant(font, font_size, name);
-		font_system::setup_font_data(variant);
 
 		font.size_variants.push_back(variant);
 
@@ -116,152 +101,173 @@ namespace egkr
 
 	void ui_text::regenerate_geometry()
 	{
-	    uint32_t char_length = (uint32_t)text_.size();
-	    char_length = std::max(char_length, 1u);
-
-	    constexpr static const uint64_t verts_per_quad{4};
-	    constexpr static const uint64_t indices_per_quad{6};
+	    ZoneScoped;
 
-	    const uint64_t vertex_buffer_size = sizeof(vertex_2d) * verts_per_quad * char_length;
-	    const uint64_t index_buffer_size = sizeof(uint32_t) * indices_per_quad * char_length;
-
-	    if (vertex_buffer_size > vertex_buffer_->get_size())
+	    // A rebuilt atlas moves every glyph, nothing cached is valid anymore
+	    if (layout_generation_ != data_->generation)
 	    {
-		vertex_buffer_->resize(vertex_buffer_size);
+		line_layouts_.clear();
+		layout_generation_ = data_->generation;
 	    }
 
-	    if (index_buffer_size > index_buffer_->get_size())
+	    // Lines keep their quads while both their text and their first quad are unchanged, everything from the first line
+	    // that differs onwards is rewritten. Appending to the last line only touches that line
+	    uint32_t dirty_from{invalid_32_id};
+	    uint32_t quad_count{};
+	    uint32_t line_index{};
+	    size_t line_start{};
+	    for (;;)
 	    {
-		index_buffer_->resize(index_buffer_size);
-	    }
+		auto line_end = text_.find('\n', line_start);
+		if (line_end == std::string::npos)
+		{
+		    line_end = text_.size();
+		}
 
-	    float x{};
-	    float y{};
+		const std::string_view line{text_.data() + line_start, line_end - line_start};
+		if (line_index == line_layouts_.size())
+		{
+		    line_layouts_.emplace_back();
+		}
+
+		auto& layout = line_layouts_[line_index];
+		if (layout.text != line)
+		{
+		    layout_line(line, layout);
+		    dirty_from = std::min(dirty_from, quad_count);
+		}
+		else if (layout.first_quad != quad_count)
+		{
+		    dirty_from = std::min(dirty_from, quad_count);
+		}
+		layout.first_quad = quad_count;
+		quad_count += (uint32_t)(layout.vertices.size() / verts_per_quad);
+
+		if (line_end == text_.size())
+		{
+		    break;
+		}
 
-	    egkr::vector<vertex_2d> vertex_buffer_data(vertex_buffer_size);
-	    egkr::vector<uint32_t> index_buffer_data(index_buffer_size, 0);
+		// The newline keeps its (empty) quad so quad indices still line up with the text
+		++quad_count;
+		++line_index;
+		line_start = line_end + 1;
+	    }
+	    line_layouts_.resize(line_index + 1);
+	    quad_count_ = quad_count;
+
+	    // Size to the new quad count before anything can return, get_vertices hands out quad_count_ quads. A bare newline
+	    // adds a quad without changing any line, so quads past the old end are always rewritten
+	    const auto previous_quad_count = (uint32_t)(vertices_.size() / verts_per_quad);
+	    vertices_.resize((size_t)quad_count_ * verts_per_quad);
+	    dirty_from = std::min(dirty_from, previous_quad_count);
+	    if (dirty_from >= quad_count_)
+	    {
+		return;
+	    }
 
-	    for (uint32_t c{}, uc{}; c < char_length; ++c)
+	    std::fill(vertices_.begin() + (ptrdiff_t)dirty_from * verts_per_quad, vertices_.end(), vertex_2d{});
+	    for (uint32_t l{}; l < line_layouts_.size(); ++l)
 	    {
-		int32_t codepoint = text_[c];
-		if (codepoint == '\n')
+		const auto& layout = line_layouts_[l];
+		const auto line_quads = (uint32_t)(layout.vertices.size() / verts_per_quad);
+		if (layout.first_quad + line_quads <= dirty_from)
 		{
-		    x = 0;
-		    y += (float)data_->line_height;
-		    ++uc;
 		    continue;
 		}
 
+		const float y = (float)l * (float)data_->line_height;
+		for (size_t v{}; v < layout.vertices.size(); ++v)
+		{
+		    const auto& vertex = layout.vertices[v];
+		    vertices_[(layout.first_quad * verts_per_quad) + v] = {.position = {vertex.position.x, vertex.position.y + y}, .tex = vertex.tex};
+		}
+	    }
+	}
+
+	void ui_text::layout_line(std::string_view line, line_layout& out_layout) const
+	{
+	    out_layout.text = line;
+	    out_layout.vertices.clear();
+
+	    float x{};
+	    const float y{};
+	    const auto line_length = (uint32_t)line.size();
+	    for (uint32_t c{}; c < line_length; ++c)
+	    {
+		// Every codepoint owns a quad, left empty when nothing is drawn for it
+		const auto quad = out_layout.vertices.size();
+		out_layout.vertices.resize(quad + 4);
+
+		int32_t codepoint = (uint8_t)line[c];
 		if (codepoint == '\t')
 		{
 		    x += data_->tab_advance;
-		    ++uc;
 		    continue;
 		}
 
-		uint8_t advance{};
-		if (!bytes_to_codepoint(text_, c, codepoint, advance))
+		uint8_t advance{1};
+		if (!bytes_to_codepoint(line, c, codepoint, advance))
 		{
-		    LOG_WARN("Coulddd not find codepoint for {}", c);
+		    LOG_WARN("Could not find codepoint for {}", c);
 		    codepoint = -1;
 		}
 
-		font::glyph* glyph{};
-		for (auto& g : data_->glyphs)
-		{
-		    if (g.codepoint == codepoint)
-		    {
-			glyph = &g;
-			break;
-		    }
-		}
-
+		const font::glyph* glyph = data_->find_glyph(codepoint);
 		if (!glyph)
 		{
-		    codepoint = -1;
-		    for (auto& g : data_->glyphs)
-		    {
-			if (g.codepoint == codepoint)
-			{
-			    glyph = &g;
-			    break;
-			}
-		    }
+		    glyph = data_->find_glyph(-1);
 		}
 
 		if (!glyph)
 		{
 		    LOG_ERROR("No valid glyph found");
-		    ++uc;
+		    c += advance - 1;
 		    continue;
 		}
-		else
-		{
-		    float minx = x + (float)glyph->x_offset;
-		    float miny = y + (float)glyph->y_offset;
-		    float maxx = minx + (float)glyph->width;
-		    float maxy = miny + (float)glyph->height;
 
-		    float tminx = (float)glyph->x / (float)data_->atlas_size_x;
-		    float tminy = (float)glyph->y / (float)data_->atlas_size_y;
-		    float tmaxx = (float)(glyph->x + glyph->width) / (float)data_->atlas_size_x;
-		    float tmaxy = (float)(glyph->y + glyph->height) / (float)data_->atlas_size_y;
+		float minx = x + (float)glyph->x_offset;
+		float miny = y + (float)glyph->y_offset;
+		float maxx = minx + (float)glyph->width;
+		float maxy = miny + (float)glyph->height;
 
-		    if (type_ == text::type::system)
-		    {
-			tminy = 1 - tminy;
-			tmaxy = 1 - tmaxy;
-		    }
+		float tminx = (float)glyph->x / (float)data_->atlas_size_x;
+		float tminy = (float)glyph->y / (float)data_->atlas_size_y;
+		float tmaxx = (float)(glyph->x + glyph->width) / (float)data_->atlas_size_x;
+		float tmaxy = (float)(glyph->y + glyph->height) / (float)data_->atlas_size_y;
 
-		    const vertex_2d p0{.position = {minx, miny}, .tex = {tminx, tminy}};
-		    const vertex_2d p1{.position = {maxx, miny}, .tex = {tmaxx, tminy}};
-		    const vertex_2d p2{.position = {maxx, maxy}, .tex = {tmaxx, tmaxy}};
-		    const vertex_2d p3{.position = {minx, maxy}, .tex = {tminx, tmaxy}};
+		if (type_ == text::type::system)
+		{
+		    tminy = 1 - tminy;
+		    tmaxy = 1 - tmaxy;
+		}
 
-		    vertex_buffer_data[(uc * 4) + 0] = p0;
-		    vertex_buffer_data[(uc * 4) + 1] = p1;
-		    vertex_buffer_data[(uc * 4) + 2] = p2;
-		    vertex_buffer_data[(uc * 4) + 3] = p3;
+		out_layout.vertices[quad + 0] = {.position = {minx, miny}, .tex = {tminx, tminy}};
+		out_layout.vertices[quad + 1] = {.position = {maxx, miny}, .tex = {tmaxx, tminy}};
+		out_layout.vertices[quad + 2] = {.position = {maxx, maxy}, .tex = {tmaxx, tmaxy}};
+		out_layout.vertices[quad + 3] = {.position = {minx, maxy}, .tex = {tminx, tmaxy}};
 
-		    int32_t kern{};
-		    uint32_t offset = c + advance;
-		    if (offset < char_length - 1)
+		int32_t kern{};
+		uint32_t offset = c + advance;
+		if (offset < line_length)
+		{
+		    int32_t next_codepoint{};
+		    uint8_t next_advance{};
+
+		    if (!bytes_to_codepoint(line, offset, next_codepoint, next_advance))
+		    {
+			LOG_WARN("Code not find codepoint");
+		    }
+		    else
 		    {
-			int32_t next_codepoint{};
-			uint8_t next_advance{};
-
-			if (!bytes_to_codepoint(text_, offset, next_codepoint, next_advance))
-			{
-			    LOG_WARN("Code not find codepoint");
-			    codepoint = -1;
-			}
-			else
-			{
-			    for (const auto& kerning : data_->kernings)
-			    {
-				if (kerning.codepoint_0 == codepoint && kerning.codepoint_1 == next_codepoint)
-				{
-				    kern = kerning.amount;
-				    break;
-				}
-			    }
-			}
+			kern = data_->find_kerning(codepoint, next_codepoint);
 		    }
-		    x += (float)glyph->x_advance + (float)kern;
 		}
-		index_buffer_data[(uc * 6) + 0] = (uc * 4) + 2;
-		index_buffer_data[(uc * 6) + 1] = (uc * 4) + 1;
-		index_buffer_data[(uc * 6) + 2] = (uc * 4) + 0;
-		index_buffer_data[(uc * 6) + 3] = (uc * 4) + 3;
-		index_buffer_data[(uc * 6) + 4] = (uc * 4) + 2;
-		index_buffer_data[(uc * 6) + 5] = (uc * 4) + 0;
+		x += (float)glyph->x_advance + (float)kern;
 
 		//already incremented by one
 		c += advance - 1;
-		++uc;
 	    }
-	    vertex_buffer_->load_range(0, vertex_buffer_size, vertex_buffer_data.data());
-	    index_buffer_->load_range(0, index_buffer_size, index_buffer_data.data());
 	}
 
 	void ui_text::set_text(const std::string& text)
@@ -281,13 +287,56 @@ namespace egkr
 	    regenerate_geometry();
 	}
 
-	void ui_text::draw() const
+	void ui_text::refresh_atlas()
+	{
+	    if (font_system::is_atlas_current(*data_))
+	    {
+		return;
+	    }
+
+	    if (!font_system::verify_atlas(data_, text_))
+	    {
+		LOG_ERROR("Failed to verify atlas");
+		return;
+	    }
+
+	    regenerate_geometry();
+	}
+
+	void ui_text::layout_benchmark_command(const console::context& /*context*/)
 	{
-	    constexpr static const uint32_t quad_vertex_count = 4;
-	    vertex_buffer_->draw(0, quad_vertex_count * (uint32_t)text_.size(), true);
+	    constexpr uint32_t line_count{1000};
+	    constexpr uint32_t line_length{80};
+	    constexpr uint32_t repeat_count{20};
+	    using clock = std::chrono::high_resolution_clock;
+
+	    // Printable ASCII only, which the bitmap font covers, so every codepoint hits a real glyph
+	    egkr::vector<std::string> lines(line_count);
+	    for (uint32_t l{}; l < line_count; ++l)
+	    {
+		lines[l].resize(line_length);
+		for (uint32_t c{}; c < line_length; ++c)
+		{
+		    lines[l][c] = (char)(' ' + ((l * 31 + c * 7) % 95));
+		}
+	    }
+
+	    auto benchmark_text = create(type::bitmap, "Arial 32", 32, "");
+	    line_layout layout{};
+	    uint64_t glyph_count{};
+
+	    const auto start = clock::now();
+	    for (uint32_t r{}; r < repeat_count; ++r)
+	    {
+		for (const auto& line : lines)
+		{
+		    benchmark_text->layout_line(line, layout);
+		    glyph_count += layout.vertices.size() / verts_per_quad;
+		}
+	    }
+	    const auto microseconds = std::chrono::duration<double, std::micro>(clock::now() - start).count();
 
-	    constexpr static const uint8_t quad_index_count = 6;
-	    index_buffer_->draw(0, quad_index_count * (uint32_t)text_.size(), false);
+	    LOG_INFO("Text layout: {} glyphs in {:.0f}us, {:.1f} glyphs/us", glyph_count, microseconds, (double)glyph_count / microseconds);
 	}
     }
 }
@@ -3,7 +3,10 @@
 #include <pch.h>
 
 #include <resources/transform.h>
-#include <renderer/renderbuffer.h>
+#include <renderer/vertex_types.h>
+#include <systems/console_system.h>
+
+#include <span>
 
 namespace egkr
 {
@@ -31,7 +34,8 @@ namespace egkr
 			~ui_text();
 
 			void set_text(const std::string& text);
-			void draw() const;
+			// Relays the text out if its font's atlas was repacked since it was last laid out, must run outside recording
+			void refresh_atlas();
 
 			void acquire(const std::string& name, uint16_t font_size, type type);
 
@@ -39,6 +43,11 @@ namespace egkr
 			[[nodiscard]] std::shared_ptr<font::data> get_data() const { return data_; }
 			[[nodiscard]] const auto& get_text() const { return text_; }
 			[[nodiscard]] bool has_text() const { return text_.size() != 0; }
+			// Four vertices per quad in the text's local space, empty quads included so indices follow the text
+			[[nodiscard]] std::span<const vertex_2d> get_vertices() const { return {vertices_.data(), (size_t)quad_count_ * 4}; }
+			// In window pixels, a zero sized rect leaves the text unclipped
+			[[nodiscard]] const auto& get_clip_rect() const { return clip_rect_; }
+			void set_clip_rect(const float4& clip_rect) { clip_rect_ = clip_rect; }
 			[[nodiscard]] uint64_t get_render_frame() const { return render_frame_number_; }
 			void set_render_frame(uint64_t frame) { render_frame_number_ = frame;}
 			[[nodiscard]] uint64_t get_draw_index() const { return draw_index_; }
@@ -46,19 +55,37 @@ namespace egkr
 
 			void pop_back();
 			void push_back(char c);
+
+			// Lays out many lines of generated text in the sandbox bitmap font and reports glyphs per microsecond
+			static void layout_benchmark_command(const console::context& context);
 		private:
+			// Quads for one line, positioned relative to the line's origin. Kept between regenerations so unchanged lines skip layout
+			struct line_layout
+			{
+				std::string text;
+				egkr::vector<vertex_2d> vertices;
+				uint32_t first_quad{invalid_32_id};
+			};
+
 			void regenerate_geometry();
+			void layout_line(std::string_view line, line_layout& out_layout) const;
 		private:
 			type type_;
 			std::shared_ptr<font::data> data_{};
-			renderbuffer::renderbuffer::shared_ptr vertex_buffer_{};
-			renderbuffer::renderbuffer::shared_ptr index_buffer_{};
+			float4 clip_rect_{};
 
 			std::string text_{};
 			uint32_t instance_id_{invalid_32_id};
 			uint64_t render_frame_number_{};
 			uint64_t draw_index_{};
 			uint32_t unique_id_{};
+
+			egkr::vector<line_layout> line_layouts_;
+			uint32_t layout_generation_{invalid_32_id};
+
+			// Every quad of the text, rewritten from the first line that changed. The ui batcher reads these each frame
+			egkr::vector<vertex_2d> vertices_;
+			uint32_t quad_count_{};
 		};
 	}
 }
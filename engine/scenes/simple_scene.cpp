@@ -2,8 +2,15 @@
 #include "identifier.h"
 #include "resources/terrain.h"
 #include <systems/light_system.h>
+#include <systems/job_system.h>
+#include <systems/material_system.h>
+#include <systems/resource_system.h>
+#include <systems/texture_system.h>
 #include <renderer/renderer_types.h>
 
+#include <atomic>
+#include <thread>
+
 namespace egkr::scene
 {
     simple_scene::unique_ptr simple_scene::create(const configuration& configuration) { return std::make_unique<simple_scene>(configuration); }
@@ -12,6 +19,8 @@ namespace egkr::scene
     //		: configuration_{ configuration }
     {
 	id_ = identifier::acquire_unique_id(this);
+	frustum_culling_ = evar_system::create_bool("scene_frustum_culling", true);
+	terrain_lod_bias_ = evar_system::create_float("terrain_lod_bias", 1.F, 0.1F, 16.F);
     }
 
     void simple_scene::init() { state_ = state::initialised; }
@@ -24,19 +33,45 @@ namespace egkr::scene
 	}
 
 	meshes_.clear();
+	for (const auto reference : point_lights_ | std::views::values)
+	{
+	    light_system::remove_point_light(reference);
+	}
 	point_lights_.clear();
 	frame_geometry_.reset();
 	state_ = state::uninitialised;
     }
 
-    void simple_scene::load()
+    void simple_scene::load() { load(dependency_graph{}); }
+
+    void simple_scene::load(const dependency_graph& dependencies)
     {
+	load_start_ = std::chrono::steady_clock::now();
+	awaiting_full_frame_ = true;
+
+	preload(dependencies);
+
 	if (skybox_)
 	{
 	    skybox_->load();
 	}
 
-	std::ranges::for_each(meshes_ | std::views::values, [](auto& mesh) { mesh->load(); });
+	for (auto& mesh : meshes_ | std::views::values)
+	{
+	    if (auto preloaded = preloaded_meshes_.find(mesh->get_resource_name()); preloaded != preloaded_meshes_.end())
+	    {
+		mesh->load(preloaded->second);
+	    }
+	    else
+	    {
+		mesh->load();
+	    }
+	}
+	for (const auto& mesh_resource : preloaded_meshes_ | std::views::values)
+	{
+	    resource_system::unload(mesh_resource);
+	}
+	preloaded_meshes_.clear();
 	std::ranges::for_each(terrains_ | std::views::values, [](auto& terrain) { terrain->load(); });
 
 	std::ranges::for_each(debug_boxes_ | std::views::values, [](auto& box) { box->load(); });
@@ -48,6 +83,102 @@ namespace egkr::scene
 
     void simple_scene::unload() { state_ = state::unloading; }
 
+    void simple_scene::preload(const dependency_graph& dependencies)
+    {
+	ZoneScoped;
+
+	const size_t texture_count = dependencies.textures.size();
+	const size_t material_count = dependencies.materials.size();
+	const size_t leaf_count = texture_count + material_count + dependencies.meshes.size();
+	if (leaf_count == 0)
+	{
+	    return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	// Textures, then materials, then meshes. None depends on another until uploaded, so all are read at once
+	egkr::vector<resource::shared_ptr> leaves(leaf_count);
+	std::atomic<size_t> next_leaf{};
+	const auto load_leaves = [&]()
+	{
+	    for (auto i = next_leaf++; i < leaf_count; i = next_leaf++)
+	    {
+		if (i < texture_count)
+		{
+		    image_resource_parameters params{.flip_y = true};
+		    leaves[i] = resource_system::load(dependencies.textures[i], resource::type::image, &params);
+		}
+		else if (i < texture_count + material_count)
+		{
+		    leaves[i] = resource_system::load(dependencies.materials[i - texture_count].name, resource::type::material, nullptr);
+		}
+		else
+		{
+		    leaves[i] = resource_system::load(dependencies.meshes[i - texture_count - material_count].resource_name, resource::type::mesh, nullptr);
+		}
+	    }
+	};
+
+	// Each task pulls leaves until none are left, so one large mesh doesn't leave the other workers idle
+	const egkr::vector<std::function<void()>> tasks(std::max(1U, std::thread::hardware_concurrency()), load_leaves);
+	job_system::execute_and_wait(tasks, job::type::general);
+
+	// Fan in on the main thread, which owns uploads. Textures go first so the materials find them registered
+	for (size_t i{}; i < texture_count; ++i)
+	{
+	    if (!leaves[i])
+	    {
+		LOG_WARN("Failed to preload texture {}", dependencies.textures[i]);
+		continue;
+	    }
+	    (void)texture_system::acquire_loaded(dependencies.textures[i], leaves[i]);
+	    resource_system::unload(leaves[i]);
+	}
+
+	for (size_t i{}; i < material_count; ++i)
+	{
+	    const auto& material_resource = leaves[texture_count + i];
+	    if (!material_resource)
+	    {
+		LOG_WARN("Failed to preload material {}", dependencies.materials[i].name);
+		continue;
+	    }
+	    material_system::acquire(*(material::properties*)material_resource->data);
+	    resource_system::unload(material_resource);
+	}
+
+	for (size_t i{}; i < dependencies.meshes.size(); ++i)
+	{
+	    if (const auto& mesh_resource = leaves[texture_count + material_count + i])
+	    {
+		preloaded_meshes_.emplace(dependencies.meshes[i].resource_name, mesh_resource);
+	    }
+	}
+
+	LOG_INFO("Preloaded {} textures, {} materials and {} meshes in {:.1f}ms", texture_count, material_count, dependencies.meshes.size(),
+	    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    void simple_scene::report_first_full_frame()
+    {
+	if (!awaiting_full_frame_ || texture_system::pending_load_count() != 0)
+	{
+	    return;
+	}
+
+	// A mesh that failed to load is as resident as it will ever get
+	if (std::ranges::any_of(meshes_ | std::views::values, [](const auto& mesh) { return !mesh->is_loaded() && !mesh->has_failed_to_load(); }))
+	{
+	    return;
+	}
+
+	awaiting_full_frame_ = false;
+	const auto failed_count = std::ranges::count_if(meshes_ | std::views::values, [](const auto& mesh) { return mesh->has_failed_to_load(); });
+	LOG_INFO("Time to first full frame: {:.1f}ms, {} meshes failed to load", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start_).count(),
+	    failed_count);
+    }
+
     void simple_scene::update(const frame_data& /*delta_time*/, const camera::shared_ptr& camera, viewport* viewport)
     {
 	if (state_ == state::unloading)
@@ -58,6 +189,9 @@ namespace egkr::scene
 
 	if (state_ >= state::loaded)
 	{
+	    // Everything drawn this frame is resident, so it is the scene's first full frame
+	    report_first_full_frame();
+
 	    auto frustum = egkr::frustum(camera->get_position(), camera->get_forward(), camera->get_right(), camera->get_up(), viewport->viewport_rect.z / viewport->viewport_rect.w, viewport->fov,
 	        camera->get_near_clip(), camera->get_far_clip());
 
@@ -77,7 +211,7 @@ namespace egkr::scene
 
 		    const egkr::float3 half_extents{glm::abs(t - center)};
 
-		    if (frustum.intersects_aabb(center, half_extents))
+		    if (!frustum_culling_.get() || frustum.intersects_aabb(center, half_extents))
 		    {
 			egkr::render_data data{.render_geometry = geo, .transform = mesh, .is_winding_reversed = mesh->get_determinant() < 0.f};
 			if ((geo->get_material()->get_diffuse_map()->map_texture->get_flags() & texture::texture::flags::has_transparency) == texture::texture::flags::has_transparency)
@@ -97,11 +231,23 @@ namespace egkr::scene
 		frame_geometry_.world_geometries.push_back(mesh);
 	    }
 
-	    //TODO: Frustum culling
+	    const float lod_scale = viewport->viewport_rect.w / (2.F * std::tan(viewport->fov * 0.5F)) / terrain_lod_bias_.get();
 	    for (const auto& terrain : terrains_ | std::views::values)
 	    {
-		egkr::render_data terrain_data{.render_geometry = terrain->get_geometry(), .transform = terrain, .is_winding_reversed = terrain->get_determinant() < 0.f};
-		frame_geometry_.terrain_geometries.push_back(terrain_data);
+		if (!terrain->get_geometry())
+		{
+		    continue;
+		}
+
+		for (const auto& chunk : terrain->select_chunks(frustum, camera->get_position(), lod_scale))
+		{
+		    frame_geometry_.terrain_geometries.push_back({.render_geometry = terrain->get_geometry(),
+		        .transform = terrain,
+		        .is_winding_reversed = terrain->get_determinant() < 0.f,
+		        .vertex_offset = chunk.vertex_offset,
+		        .first_index = chunk.first_index,
+		        .index_count = chunk.index_count});
+		}
 	    }
 
 	    for (auto& mesh : meshes_ | std::views::values)
@@ -167,18 +313,26 @@ namespace egkr::scene
 
     void simple_scene::add_point_light(const std::string& name, light::point_light& light)
     {
-	light_system::add_point_light(light);
+	if (point_lights_.contains(name))
+	{
+	    LOG_WARN("Point light, {}, already added to scene, replacing", name);
+	    remove_point_light(name);
+	}
 
-	point_lights_.emplace(name, light);
+	const auto reference = light_system::add_point_light(light);
+	if (reference == invalid_32_id)
+	{
+	    return;
+	}
+	point_lights_.emplace(name, reference);
     }
 
     void simple_scene::remove_point_light(const std::string& name)
     {
-	//LOG_WARN("Cannot currently remove a point light");
-	//light_system::remove_point_light(light);
-	if (point_lights_.contains(name))
+	if (auto found = point_lights_.find(name); found != point_lights_.end())
 	{
-	    point_lights_.erase(name);
+	    light_system::remove_point_light(found->second);
+	    point_lights_.erase(found);
 	    return;
 	}
 
@@ -366,6 +520,10 @@ namespace egkr::scene
 	}
 	debug_frusta_.clear();
 
+	for (const auto reference : point_lights_ | std::views::values)
+	{
+	    light_system::remove_point_light(reference);
+	}
 	point_lights_.clear();
 	remove_directional_light();
 
@@ -391,13 +549,29 @@ namespace egkr::scene
 	    }
 	}
 
+	for (const auto& terrain : terrains_ | std::views::values)
+	{
+	    if (auto hit = terrain->raycast(ray))
+	    {
+		result.hits.push_back(*hit);
+	    }
+	}
+
 	//TODO: raycast other scene objects?
 
+	// Nearest first, so a mesh in front of the terrain is picked over it
+	std::ranges::sort(result.hits, std::less{}, &ray::hit::distance);
 	return result;
     }
 
     std::shared_ptr<transformable> simple_scene::get_transform(uint32_t unique_id) const
     {
+	// A stale id from an old pick can't match anything, skip the search
+	if (!identifier::is_valid(unique_id))
+	{
+	    return nullptr;
+	}
+
 	for (const auto& mesh : meshes_ | std::views::values)
 	{
 	    if (mesh->unique_id() == unique_id)
@@ -12,6 +12,7 @@
 #include "debug/debug_box3d.h"
 #include "debug/debug_grid.h"
 #include "debug/debug_frustum.h"
+#include "systems/evar_system.h"
 
 #include <queue>
 
@@ -71,6 +72,29 @@ namespace egkr
 	    float quadratic;
 	};
 
+	struct material_dependency
+	{
+	    std::string name;
+	    // Indices into dependency_graph::textures
+	    egkr::vector<uint32_t> textures;
+	};
+
+	struct mesh_dependency
+	{
+	    std::string resource_name;
+	    // Indices into dependency_graph::materials
+	    egkr::vector<uint32_t> materials;
+	};
+
+	// Resolved when a scene is baked so every leaf can be loaded at once, rather than discovering materials
+	// only after their mesh has loaded and textures only after their material
+	struct dependency_graph
+	{
+	    egkr::vector<std::string> textures;
+	    egkr::vector<material_dependency> materials;
+	    egkr::vector<mesh_dependency> meshes;
+	};
+
 	struct configuration
 	{
 	    std::string name;
@@ -81,6 +105,7 @@ namespace egkr
 	    std::vector<terrain_scene_configuration> terrains;
 	    std::vector<point_light_scene_configuration> point_lights;
 	    int32_t version{};
+	    dependency_graph dependencies;
 	};
 
 	class simple_scene : public transformable
@@ -94,6 +119,8 @@ namespace egkr
 	    void init();
 	    void destroy();
 	    void load();
+	    // Loads every dependency up front across the job workers, then uploads them before the meshes are built
+	    void load(const dependency_graph& dependencies);
 	    void unload();
 
 	    void update(const frame_data& delta_time, const camera::shared_ptr& camera, viewport* viewport);
@@ -132,17 +159,24 @@ namespace egkr
 	    const frame_geometry_data& get_frame_data() const { return frame_geometry_; }
 	private:
 	    void actual_unload();
+	    void preload(const dependency_graph& dependencies);
+	    void report_first_full_frame();
 	private:
 	    //configuration configuration_{};
 	    uint32_t id_{};
 	    state state_{state::uninitialised};
 	    //bool is_enabled_{};
 
+	    evar_handle<bool> frustum_culling_;
+	    // Above 1 trades terrain detail for fewer triangles
+	    evar_handle<float> terrain_lod_bias_;
+
 	    std::string skybox_name_;
 	    skybox::shared_ptr skybox_;
 	    std::string directional_light_name_;
 	    std::shared_ptr<light::directional_light> directional_light_;
-	    std::unordered_map<std::string, light::point_light> point_lights_;
+	    // References into the light system, which owns the lights
+	    std::unordered_map<std::string, uint32_t> point_lights_;
 
 	    std::unordered_map<std::string, mesh::shared_ptr> meshes_;
 	    std::unordered_map<std::string, terrain::shared_ptr> terrains_;
@@ -153,6 +187,11 @@ namespace egkr
 
 	    frame_geometry_data frame_geometry_{};
 	    float4 ambient_colour_{0.25, 0.25, 0.25, 1};
+
+	    // Mesh resources read by preload, consumed when the meshes load
+	    std::unordered_map<std::string, resource::shared_ptr> preloaded_meshes_;
+	    std::chrono::steady_clock::time_point load_start_{};
+	    bool awaiting_full_frame_{};
 	};
     }
 }
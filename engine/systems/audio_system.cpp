@@ -5,6 +5,9 @@
 
 #include <plugins/audio/audio_plugin.h>
 #include <plugins/audio/oal_plugin.h>
+#include <plugins/audio/software_plugin.h>
+#include <systems/job_system.h>
+#include <systems/resource_system.h>
 
 namespace egkr::audio
 {
@@ -39,7 +42,14 @@ namespace egkr::audio
 			.chunk_size = configuration_.chunk_size
 		};
 
-		plugin_ = new audio::oal();
+		if (configuration_.audio_backend == backend::software)
+		{
+			plugin_ = new audio::software(configuration_.wav_path);
+		}
+		else
+		{
+			plugin_ = new audio::oal();
+		}
 		plugin_->init(plugin_configuration);
 	}
 
@@ -77,9 +87,41 @@ namespace egkr::audio
 		return true;
 	}
 
+	static resource::shared_ptr decode_chunk(const std::string& name)
+	{
+		audio_resource_loader_params params{ .type = audio::type::sound_effect, .chunk_size = state->configuration_.chunk_size };
+		return resource_system::load(name, resource::type::audio, &params);
+	}
+
 	file* audio_system::load_chunk(const std::string& name)
 	{
-		return state->plugin_->load_chunk(name);
+		auto resource = decode_chunk(name);
+		if (!resource)
+		{
+			LOG_ERROR("Failed to load audio file {}", name);
+			return nullptr;
+		}
+		return state->plugin_->load_chunk(resource);
+	}
+
+	void audio_system::load_chunk_async(const std::string& name, std::function<void(file*)> on_loaded)
+	{
+		// The worker's decoded resource goes straight to the main thread, which only hands the samples to the plugin
+		auto decoded = std::make_shared<resource::shared_ptr>();
+		auto job = job_system::create_job(
+			[name, decoded](void*, void*)
+			{
+				*decoded = decode_chunk(name);
+				return (bool)*decoded;
+			},
+			[decoded, on_loaded](void*) { on_loaded(state->plugin_->load_chunk(std::exchange(*decoded, nullptr))); },
+			[name, on_loaded](void*)
+			{
+				LOG_ERROR("Failed to decode audio {}", name);
+				on_loaded(nullptr);
+			},
+			job::type::resource_load, nullptr, 0, 0);
+		job_system::submit(job);
 	}
 
 	file* audio_system::load_stream(const std::string& name)
@@ -241,4 +283,16 @@ namespace egkr::audio
 			plugin_->resume_source(channel_id);
 		}
 	}
+
+	void audio_system::statistics_command(const console::context& /*context*/)
+	{
+		if (!state || !state->plugin_)
+		{
+			LOG_WARN("Audio system isn't running");
+			return;
+		}
+
+		const auto statistics = state->plugin_->get_statistics();
+		LOG_INFO("Audio threads: {}, wakeups per second: {:.1f}", statistics.thread_count, statistics.wakeups_per_second);
+	}
 }
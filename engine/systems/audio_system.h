@@ -3,6 +3,7 @@
 #include <pch.h>
 
 #include <systems/system.h>
+#include <systems/console_system.h>
 #include <resources/audio.h>
 
 constexpr static const uint32_t MAX_AUDIO_CHANNELS = 16u;
@@ -12,8 +13,18 @@ namespace egkr::audio
 {
 	class plugin;
 
+	enum class backend
+	{
+		openal,
+		// CPU mixer, needs no audio device
+		software
+	};
+
 	struct system_configuration
 	{
+		backend audio_backend{ backend::openal };
+		// Software backend only, the mix is written here as a WAV file or discarded when empty
+		std::string wav_path;
 		uint32_t frequency{};
 		uint32_t channel_count{};
 		uint32_t chunk_size{};
@@ -41,7 +52,10 @@ namespace egkr::audio
 
 			static bool set_listener_orientation(const float3& position, const float3& forward, const float3& up);
 
+			// Decodes on the calling thread, sound effects loaded during play should use load_chunk_async
 			static file* load_chunk(const std::string& name);
+			// Decodes on a resource_load worker, on_loaded is called on the main thread with the file, or nullptr on failure
+			static void load_chunk_async(const std::string& name, std::function<void(file*)> on_loaded);
 			static file* load_stream(const std::string& name);
 
 			static void close(file* file);
@@ -59,6 +73,8 @@ namespace egkr::audio
 			void pause(uint8_t channel_id);
 			void resume(uint8_t channel_id);
 
+			static void statistics_command(const console::context& context);
+
 		private:
 			system_configuration configuration_{};
 			plugin* plugin_{};
@@ -1,5 +1,13 @@
 #include "console_system.h"
 #include "evar_system.h"
+#include "input_recorder.h"
+#include "identifier.h"
+#include "audio_system.h"
+#include "plugins/audio/software_plugin.h"
+#include "resources/terrain.h"
+#include "resources/ui_text.h"
+#include "loaders/mesh_loader.h"
+#include "loaders/scene_loader.h"
 
 namespace egkr
 {
@@ -16,6 +24,22 @@ namespace egkr
 	{
 		register_command("evar_create_int", 2, evar_system::create_int_command);
 		register_command("evar_print_int", 1, evar_system::print_int_command);
+		register_command("evar_set", 2, evar_system::set_command);
+		register_command("evar_print", 1, evar_system::print_command);
+		register_command("evar_list", 0, evar_system::list_command);
+		register_command("evar_save", 0, evar_system::save_command);
+		register_command("log_benchmark", 0, [](const context& /*context*/) { log::benchmark(); });
+		register_command("identifier_benchmark", 0, identifier::benchmark_command);
+		register_command("parse_benchmark", 0, scene_loader::parse_benchmark_command);
+		register_command("scene_bake", 1, scene_loader::bake_command);
+		register_command("file_read_benchmark", 1, mesh_loader::file_read_benchmark_command);
+		register_command("terrain_raycast_benchmark", 0, terrain::raycast_benchmark_command);
+		register_command("text_layout_benchmark", 0, text::ui_text::layout_benchmark_command);
+		register_command("audio_stats", 0, audio::audio_system::statistics_command);
+		register_command("audio_mix_benchmark", 0, audio::software::benchmark_command);
+		register_command("input_record", 1, input_recorder::record_command);
+		register_command("input_replay", 1, input_recorder::replay_command);
+		register_command("input_stop", 0, input_recorder::stop_command);
 		return true;
 	}
 
@@ -1,60 +1,246 @@
 #include "evar_system.h"
 #include "event.h"
+#include "platform/filesystem.h"
+#include "loaders/parser.h"
 
 namespace egkr
 {
 	static evar_system::unique_ptr state;
 
-	evar_system* evar_system::create()
+	template<class... Ts>
+	struct overloaded : Ts... { using Ts::operator()...; };
+
+	evar_system* evar_system::create(const configuration& configuration)
 	{
-		state = std::make_unique<evar_system>();
+		state = std::make_unique<evar_system>(configuration);
 		return state.get();
 	}
 
+	evar_system::evar_system(configuration configuration)
+		: configuration_{ std::move(configuration) }
+	{}
+
 	bool evar_system::init()
 	{
+		if (!configuration_.config_path.empty() && filesystem::does_path_exist(configuration_.config_path))
+		{
+			load(configuration_.config_path);
+		}
 		return true;
 	}
 
 	bool evar_system::shutdown()
 	{
+		// Entries stay alive, systems shut down after this one may still read their handles
 		return true;
 	}
 
-	bool evar_system::create_int(const std::string& name, int32_t value)
+	template<class T>
+	evar_handle<T> evar_system::create(const std::string& name, T value, T min, T max)
 	{
-		if (state->registered_ints_.contains(name))
+		if (auto* existing = find_entry(name))
 		{
-			LOG_WARN("Evar {} is already registered as an int", name);
-			return false;
+			if (!std::holds_alternative<T>(existing->value))
+			{
+				LOG_ERROR("Evar {} is already registered with a different type", name);
+				return {};
+			}
+			return evar_handle<T>{ existing };
 		}
 
-		state->registered_ints_.emplace(name, value);
-		return true;
+		auto& entry = state->evars_.emplace_back(evar{ .name = name, .value = std::move(value), .min = std::move(min), .max = std::move(max) });
+		state->evars_by_name_.emplace(name, &entry);
+
+		if (auto pending = state->pending_values_.find(name); pending != state->pending_values_.end())
+		{
+			const auto text = std::move(pending->second);
+			state->pending_values_.erase(pending);
+			set_from_string(name, text);
+		}
+		return evar_handle<T>{ &entry };
+	}
+
+	evar_handle<int32_t> evar_system::create_int(const std::string& name, int32_t value, int32_t min, int32_t max)
+	{
+		return create<int32_t>(name, value, min, max);
+	}
+
+	evar_handle<float> evar_system::create_float(const std::string& name, float value, float min, float max)
+	{
+		return create<float>(name, value, min, max);
+	}
+
+	evar_handle<bool> evar_system::create_bool(const std::string& name, bool value)
+	{
+		return create<bool>(name, value, false, true);
+	}
+
+	evar_handle<std::string> evar_system::create_string(const std::string& name, const std::string& value)
+	{
+		return create<std::string>(name, value, {}, {});
+	}
+
+	evar_handle<float4> evar_system::create_vector(const std::string& name, const float4& value, const float4& min, const float4& max)
+	{
+		return create<float4>(name, value, min, max);
+	}
+
+	evar* evar_system::find_entry(const std::string& name)
+	{
+		auto found = state->evars_by_name_.find(name);
+		return found != state->evars_by_name_.end() ? found->second : nullptr;
 	}
 
 	int32_t evar_system::get_int(const std::string& name)
 	{
-		if (state->registered_ints_.contains(name))
+		if (auto* entry = find_entry(name); entry && std::holds_alternative<int32_t>(entry->value))
 		{
-			return state->registered_ints_[name];
+			return std::get<int32_t>(entry->value);
 		}
-		LOG_ERROR("Evar {} is not registered", name);
+		LOG_ERROR("Evar {} is not registered as an int", name);
 		return 0;
 	}
 
 	void evar_system::set_int(const std::string& name, int32_t value)
 	{
-		if (state->registered_ints_.contains(name))
+		if (auto* entry = find_entry(name); entry && std::holds_alternative<int32_t>(entry->value))
 		{
-			state->registered_ints_[name] = value;
-			event::context context{};
-			context.set(0, value);
-			event::fire_event(event::code::evar_changed, nullptr, context);
+			set(*entry, value);
 			return;
 		}
-		LOG_ERROR("Evar {} is not registered", name);
+		LOG_ERROR("Evar {} is not registered as an int", name);
+	}
 
+	void evar_system::set(evar& entry, evar_value value)
+	{
+		if (value.index() != entry.value.index())
+		{
+			LOG_ERROR("Evar {} set with the wrong type", entry.name);
+			return;
+		}
+
+		std::visit(overloaded{
+			[&entry](int32_t& v) { v = std::clamp(v, std::get<int32_t>(entry.min), std::get<int32_t>(entry.max)); },
+			[&entry](float& v) { v = std::clamp(v, std::get<float>(entry.min), std::get<float>(entry.max)); },
+			[&entry](float4& v) { v = glm::clamp(v, std::get<float4>(entry.min), std::get<float4>(entry.max)); },
+			[](auto&) {} },
+			value);
+
+		if (value == entry.value)
+		{
+			return;
+		}
+		entry.value = std::move(value);
+
+		for (const auto& callback : entry.change_callbacks)
+		{
+			callback(entry);
+		}
+
+		event::context context{};
+		if (const auto* int_value = std::get_if<int32_t>(&entry.value))
+		{
+			context.set(0, *int_value);
+		}
+		event::fire_event(event::code::evar_changed, &entry, context);
+	}
+
+	bool evar_system::set_from_string(const std::string& name, const std::string& text)
+	{
+		auto* entry = find_entry(name);
+		if (!entry)
+		{
+			LOG_ERROR("Evar {} is not registered", name);
+			return false;
+		}
+
+		try
+		{
+			evar_value parsed = std::visit(overloaded{
+				[&text](int32_t) -> evar_value { return std::stoi(text); },
+				[&text](float) -> evar_value { return std::stof(text); },
+				[&text](bool) -> evar_value { return text == "1" || text == "true" || text == "on"; },
+				[&text](const std::string&) -> evar_value { return text; },
+				[&text](const float4& current) -> evar_value
+				{
+					// Missing trailing components keep their current value
+					float4 vector{ current };
+					std::string_view remaining{ text };
+					for (glm::length_t i{}; i < 4 && !remaining.empty(); ++i)
+					{
+						const auto comma = remaining.find(',');
+						vector[i] = std::stof(std::string{ remaining.substr(0, comma) });
+						remaining = comma == std::string_view::npos ? std::string_view{} : remaining.substr(comma + 1);
+					}
+					return vector;
+				} },
+				entry->value);
+
+			set(*entry, std::move(parsed));
+			return true;
+		}
+		catch (const std::exception&)
+		{
+			LOG_ERROR("Could not parse {} as a value for evar {}", text, name);
+			return false;
+		}
+	}
+
+	std::string evar_system::to_string(const evar_value& value)
+	{
+		return std::visit(overloaded{
+			[](int32_t v) { return std::to_string(v); },
+			[](float v) { return std::format("{}", v); },
+			[](bool v) { return std::string{ v ? "true" : "false" }; },
+			[](const std::string& v) { return v; },
+			[](const float4& v) { return std::format("{},{},{},{}", v.x, v.y, v.z, v.w); } },
+			value);
+	}
+
+	bool evar_system::save(std::string_view path)
+	{
+		auto handle = filesystem::open(path, file_mode::write, false);
+		if (!handle.is_valid)
+		{
+			LOG_ERROR("Failed to open evar config for writing: {}", path);
+			return false;
+		}
+
+		for (const auto& entry : state->evars_)
+		{
+			const auto line = std::format("{} = {}", entry.name, to_string(entry.value));
+			egkr::vector<uint8_t> bytes{ line.begin(), line.end() };
+			bytes.push_back('\0');
+			filesystem::write_line(handle, bytes);
+		}
+		return true;
+	}
+
+	bool evar_system::load(std::string_view path)
+	{
+		auto handle = filesystem::open(path, file_mode::read, false);
+		if (!handle.is_valid)
+		{
+			LOG_ERROR("Failed to open evar config: {}", path);
+			return false;
+		}
+
+		const auto text = filesystem::read_all(handle);
+		parser::tokenizer tokenizer{ text };
+		while (const auto token = tokenizer.next())
+		{
+			const std::string name{ token->key };
+			const std::string value{ token->value };
+			if (find_entry(name))
+			{
+				set_from_string(name, value);
+			}
+			else
+			{
+				state->pending_values_[name] = value;
+			}
+		}
+		return true;
 	}
 
 	void evar_system::create_int_command(const console::context& context)
@@ -79,4 +265,49 @@ namespace egkr
 		auto value = get_int(context.arguments[0].value);
 		console::write_line(nullptr, log_level::info, std::to_string(value));
 	}
+
+	void evar_system::set_command(const console::context& context)
+	{
+		if (context.arguments.size() != 2)
+		{
+			LOG_ERROR("Invalid number of arguments for set command. Got {}, expected 2", context.arguments.size());
+			return;
+		}
+
+		set_from_string(context.arguments[0].value, context.arguments[1].value);
+	}
+
+	void evar_system::print_command(const console::context& context)
+	{
+		if (context.arguments.size() != 1)
+		{
+			LOG_ERROR("Invalid number of arguments for print command. Got {}, expected 1", context.arguments.size());
+			return;
+		}
+
+		if (const auto* entry = find_entry(context.arguments[0].value))
+		{
+			console::write_line(nullptr, log_level::info, to_string(entry->value));
+			return;
+		}
+		LOG_ERROR("Evar {} is not registered", context.arguments[0].value);
+	}
+
+	void evar_system::list_command(const console::context& /*context*/)
+	{
+		for (const auto& entry : state->evars_)
+		{
+			console::write_line(nullptr, log_level::info, std::format("{} = {}", entry.name, to_string(entry.value)));
+		}
+	}
+
+	void evar_system::save_command(const console::context& /*context*/)
+	{
+		if (state->configuration_.config_path.empty())
+		{
+			LOG_WARN("No evar config path configured, nothing saved");
+			return;
+		}
+		save(state->configuration_.config_path);
+	}
 }
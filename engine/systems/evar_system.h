@@ -4,29 +4,131 @@
 #include "system.h"
 #include "console_system.h"
 
+#include <deque>
+
 namespace egkr
 {
+	using evar_value = std::variant<int32_t, float, bool, std::string, float4>;
+
+	struct evar
+	{
+		std::string name;
+		evar_value value;
+		// Unused by bool and string evars, vectors are clamped per component
+		evar_value min;
+		evar_value max;
+		egkr::vector<std::function<void(const evar&)>> change_callbacks;
+	};
+
+	// Reads the registered value in place, without a name lookup. Evars are never freed so a handle stays valid
+	// for the life of the program. Values are changed from the main thread, between the frames that read them
+	template<class T>
+	class evar_handle
+	{
+	public:
+		evar_handle() = default;
+		explicit evar_handle(evar* entry) : entry_{ entry } {}
+
+		[[nodiscard]] const T& get() const
+		{
+			static const T unregistered{};
+			return entry_ ? std::get<T>(entry_->value) : unregistered;
+		}
+		void set(const T& value) const;
+		void on_change(std::function<void(const T&)> callback) const;
+
+		[[nodiscard]] bool is_valid() const { return entry_ != nullptr; }
+
+	private:
+		evar* entry_{};
+	};
+
 	class evar_system : public system
 	{
 	public:
+		struct configuration
+		{
+			// Loaded on init and written only by evar_save, so running the engine never rewrites a tracked asset
+			std::string config_path;
+		};
+
 		using unique_ptr = std::unique_ptr<evar_system>;
-		static evar_system* create();
+		static evar_system* create(const configuration& configuration);
 
-		evar_system() = default;
+		explicit evar_system(configuration configuration);
 
 		bool init() override;
 		bool shutdown() override;
 
-		static bool create_int(const std::string& name, int32_t value);
+		// Creating an evar that already exists with the same type returns the existing one and keeps its value
+		static evar_handle<int32_t> create_int(const std::string& name, int32_t value, int32_t min = std::numeric_limits<int32_t>::lowest(), int32_t max = std::numeric_limits<int32_t>::max());
+		static evar_handle<float> create_float(const std::string& name, float value, float min = std::numeric_limits<float>::lowest(), float max = std::numeric_limits<float>::max());
+		static evar_handle<bool> create_bool(const std::string& name, bool value);
+		static evar_handle<std::string> create_string(const std::string& name, const std::string& value);
+		static evar_handle<float4> create_vector(const std::string& name, const float4& value, const float4& min = float4{ std::numeric_limits<float>::lowest() }, const float4& max = float4{ std::numeric_limits<float>::max() });
+
+		template<class T>
+		static evar_handle<T> find(const std::string& name);
+
 		static int32_t get_int(const std::string& name);
 		static void set_int(const std::string& name, int32_t value);
 
+		// Clamps to the evar's range and notifies its listeners if the value changed
+		static void set(evar& entry, evar_value value);
+		// Parses text as the evar's type, the form used by the console and the config file
+		static bool set_from_string(const std::string& name, const std::string& text);
+		static std::string to_string(const evar_value& value);
+
+		static bool save(std::string_view path);
+		static bool load(std::string_view path);
+
 		static void create_int_command(const console::context& context);
 		static void print_int_command(const console::context& context);
+		static void set_command(const console::context& context);
+		static void print_command(const console::context& context);
+		static void list_command(const console::context& context);
+		static void save_command(const console::context& context);
 
 	private:
+		template<class T>
+		static evar_handle<T> create(const std::string& name, T value, T min, T max);
+		static evar* find_entry(const std::string& name);
 
-		std::unordered_map<std::string, int32_t> registered_ints_{};
-
+		configuration configuration_{};
+		// A deque so adding evars never moves the ones handles point at
+		std::deque<evar> evars_{};
+		std::unordered_map<std::string, evar*> evars_by_name_{};
+		// Values loaded before their evar was created, applied on creation
+		std::unordered_map<std::string, std::string> pending_values_{};
 	};
+
+	template<class T>
+	inline void evar_handle<T>::set(const T& value) const
+	{
+		if (entry_)
+		{
+			evar_system::set(*entry_, value);
+		}
+	}
+
+	template<class T>
+	inline void evar_handle<T>::on_change(std::function<void(const T&)> callback) const
+	{
+		if (entry_)
+		{
+			entry_->change_callbacks.push_back([callback = std::move(callback)](const evar& changed) { callback(std::get<T>(changed.value)); });
+		}
+	}
+
+	template<class T>
+	inline evar_handle<T> evar_system::find(const std::string& name)
+	{
+		auto* entry = find_entry(name);
+		if (!entry || !std::holds_alternative<T>(entry->value))
+		{
+			LOG_ERROR("Evar {} is not registered with the requested type", name);
+			return {};
+		}
+		return evar_handle<T>{ entry };
+	}
 }
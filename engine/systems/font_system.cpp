@@ -1,9 +1,12 @@
 #include "font_system.h"
 
 #include <glm/detail/qualifier.hpp>
+#include <filesystem>
 #include <ranges>
 #include <systems/resource_system.h>
 #include <systems/texture_system.h>
+#include <platform/filesystem.h>
+#include <platform/mapped_file.h>
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb_truetype.h>
@@ -56,20 +59,47 @@ namespace egkr
 		{
 			for(auto& variant: font.size_variants)
 			{
+				save_system_font_variant_cache(font, variant);
 				delete (system_font_variant_data*)variant.internal;
 			}
-			free(font.font_binary);
 		}
 		registered_system_fonts_.clear();
 		registered_system_fonts_by_name_.clear();
 
+		for (const auto& system_font_resource : system_font_resources_)
+		{
+			resource_system::unload(system_font_resource);
+		}
+		system_font_resources_.clear();
+
 		return true;
 	}
 
+	// Stamped into atlas caches instead of a hash of the binary, which would read every byte of a large face on every start.
+	// 0 when there is no file to stat, which never matches a cache written from a real one
+	static int64_t get_font_binary_write_time(const font::system_font_resource_data& data)
+	{
+		if (!data.binary_resource)
+		{
+			return 0;
+		}
+
+		std::error_code error{};
+		const auto write_time = std::filesystem::last_write_time(data.binary_resource->get_full_path(), error);
+		return error ? 0 : (int64_t)write_time.time_since_epoch().count();
+	}
+
 	bool font_system::load_system_font(const system_font_configuration& configuration)
 	{
 		auto system_font_resource = resource_system::load(configuration.resource_name, resource::type::system_font, nullptr);
+		if (!system_font_resource)
+		{
+			LOG_ERROR("Failed to load system font {}", configuration.resource_name);
+			return false;
+		}
+		font_system_->system_font_resources_.push_back(system_font_resource);
 		auto* data = (font::system_font_resource_data*)system_font_resource->data;
+		const auto binary_write_time = get_font_binary_write_time(*data);
 
 		for (const auto& face : data->fonts)
 		{
@@ -84,6 +114,7 @@ namespace egkr
 			{
 				.id = (uint16_t)index,
 				.binary_size = data->binary_size,
+				.binary_write_time = binary_write_time,
 				.face = face.name,
 				.font_binary = data->font_binary,
 				.offset = stbtt_GetFontOffsetForIndex((unsigned char*)data->font_binary, (int32_t)index)
@@ -216,9 +247,106 @@ namespace egkr
 				data.tab_advance = 4.F * (float)data.size;
 			}
 		}
+
+		data.build_lookup();
 		return true;
 	}
 
+	constexpr static uint32_t FONT_ATLAS_CACHE_MAGIC{0x45474643};
+	constexpr static uint32_t font_atlas_cache_version{3};
+
+	// Followed by the glyphs, kernings, packer skyline and single channel atlas pixels, in that order
+	struct font_atlas_cache_header
+	{
+		uint32_t magic{FONT_ATLAS_CACHE_MAGIC};
+		uint32_t version{font_atlas_cache_version};
+		uint64_t font_size{};
+		int64_t font_write_time{};
+		uint32_t size{};
+		uint32_t atlas_width{};
+		uint32_t atlas_height{};
+		uint32_t glyph_count{};
+		uint32_t kerning_count{};
+		uint32_t skyline_count{};
+	};
+
+	static std::string get_variant_cache_path(const system_font_lookup& lookup, uint32_t size)
+	{
+		auto face = lookup.face;
+		std::ranges::replace(face, ' ', '_');
+		return std::format("font_atlas_{}_i{}_sz{}.bin", face, lookup.index, size);
+	}
+
+	constexpr static uint32_t initial_atlas_size{1024};
+	constexpr static uint32_t max_atlas_size{4096};
+	constexpr static uint32_t glyph_padding{1};
+
+	// ASCII is packed up front and never evicted
+	static bool is_pinned_codepoint(int32_t codepoint) { return codepoint < 128; }
+
+	static bool rasterise_glyph(const system_font_lookup& lookup, system_font_variant_data& internal, int32_t codepoint, font::glyph& out_glyph)
+	{
+		// -1 is the fallback glyph, index 0 is the font's own missing glyph
+		const int32_t glyph_index = codepoint < 0 ? 0 : stbtt_FindGlyphIndex(&lookup.info, codepoint);
+
+		int32_t advance{};
+		int32_t left_side_bearing{};
+		stbtt_GetGlyphHMetrics(&lookup.info, glyph_index, &advance, &left_side_bearing);
+
+		int32_t x0{};
+		int32_t y0{};
+		int32_t x1{};
+		int32_t y1{};
+		stbtt_GetGlyphBitmapBox(&lookup.info, glyph_index, internal.scale, internal.scale, &x0, &y0, &x1, &y1);
+
+		const auto width = (uint32_t)(x1 - x0);
+		const auto height = (uint32_t)(y1 - y0);
+		auto slot = internal.packer.insert(width + glyph_padding, height + glyph_padding);
+		if (!slot)
+		{
+			return false;
+		}
+
+		if (width > 0 && height > 0)
+		{
+			const auto atlas_width = internal.packer.get_width();
+			auto* destination = internal.pixels.data() + ((size_t)slot->y * atlas_width) + slot->x;
+			stbtt_MakeGlyphBitmap(&lookup.info, destination, (int32_t)width, (int32_t)height, (int32_t)atlas_width, internal.scale, internal.scale, glyph_index);
+		}
+
+		out_glyph = {
+			.codepoint = codepoint,
+			.x = (uint16_t)slot->x,
+			.y = (uint16_t)slot->y,
+			.width = (uint16_t)width,
+			.height = (uint16_t)height,
+			.x_offset = (int16_t)x0,
+			.y_offset = (int16_t)y0,
+			.x_advance = (int16_t)((float)advance * internal.scale),
+			.page_id = 0,
+		};
+		return true;
+	}
+
+	static egkr::vector<uint8_t> expand_atlas_region(const system_font_variant_data& internal, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+	{
+		const auto atlas_width = internal.packer.get_width();
+		egkr::vector<uint8_t> rgba_pixels((size_t)width * height * 4);
+		for (uint32_t row{}; row < height; ++row)
+		{
+			const auto* source = internal.pixels.data() + ((size_t)(y + row) * atlas_width) + x;
+			auto* destination = rgba_pixels.data() + ((size_t)row * width * 4);
+			for (uint32_t column{}; column < width; ++column)
+			{
+				destination[(column * 4) + 0] = source[column];
+				destination[(column * 4) + 1] = source[column];
+				destination[(column * 4) + 2] = source[column];
+				destination[(column * 4) + 3] = source[column];
+			}
+		}
+		return rgba_pixels;
+	}
+
 	font::data font_system::create_system_font_variant(const system_font_lookup& lookup, uint16_t size, const std::string& font_name)
 	{
 		font::data variant
@@ -226,19 +354,20 @@ namespace egkr
 			.font_type = font::type::system,
 			.face = font_name,
 			.size = size,
-			.atlas_size_x = 1024,
-			.atlas_size_y = 1024,
+			.atlas_size_x = initial_atlas_size,
+			.atlas_size_y = initial_atlas_size,
 			.internal_data_size = sizeof(system_font_variant_data),
 		};
 		variant.internal = new system_font_variant_data();
 
 		setup_font_data(variant);
 		system_font_variant_data* internal = (system_font_variant_data*)variant.internal;
-		internal->codepoint.reserve(96);
-		internal->codepoint.push_back(-1);
+		internal->packer.reset(variant.atlas_size_x, variant.atlas_size_y);
+		internal->last_used.reserve(96);
+		internal->last_used[-1] = 0;
 		for (int32_t i{}; i < 95; ++i)
 		{
-			internal->codepoint.push_back(i + 32);
+			internal->last_used[i + 32] = 0;
 		}
 		auto font_texture_name = std::format("__system_text_atlas_{}_i{}_sz{}__", font_name, lookup.index, size);
 		variant.atlas->map_texture = texture_system::acquire_writable(font_texture_name, variant.atlas_size_x, variant.atlas_size_y, 4, true);
@@ -250,6 +379,34 @@ namespace egkr
 		stbtt_GetFontVMetrics(&lookup.info, &ascent, &descent, &line_gap);
 		variant.line_height = (int32_t)((float)(ascent - descent + line_gap) * internal->scale);
 
+		if (load_system_font_variant_cache(lookup, variant))
+		{
+			return variant;
+		}
+
+		// The kerning table doesn't depend on which glyphs are packed, read it once
+		internal->kernings.resize((size_t)stbtt_GetKerningTableLength(&lookup.info));
+		if (!internal->kernings.empty())
+		{
+			std::vector<stbtt_kerningentry> kerning_table(internal->kernings.size());
+			int32_t entry_count = stbtt_GetKerningTable(&lookup.info, kerning_table.data(), (int32_t)internal->kernings.size());
+
+			if (entry_count != (int32_t)internal->kernings.size())
+			{
+				LOG_ERROR("Kerning entry count mismatch");
+				internal->kernings.clear();
+			}
+			else
+			{
+				for (const auto [table, kern] : std::views::zip(kerning_table, internal->kernings))
+				{
+					kern.codepoint_0 = table.glyph1;
+					kern.codepoint_1 = table.glyph2;
+					kern.amount = (int16_t)table.advance;
+				}
+			}
+		}
+
 		if (!rebuild_system_font_variant_atlas(lookup, variant))
 		{
 			LOG_ERROR("Failed to rebuild atlas for {}", font_name);
@@ -259,144 +416,341 @@ namespace egkr
 
 	bool font_system::rebuild_system_font_variant_atlas(const system_font_lookup& lookup, font::data& variant)
 	{
+		ZoneScoped;
+
+		auto* internal = (system_font_variant_data*)variant.internal;
+
+		// Pinned glyphs first, then most recently used, so eviction only has to drop from the back
+		egkr::vector<std::pair<int32_t, uint64_t>> resident(internal->last_used.begin(), internal->last_used.end());
+		std::ranges::sort(resident,
+		    [](const auto& a, const auto& b)
+		    {
+			    if (is_pinned_codepoint(a.first) != is_pinned_codepoint(b.first))
+			    {
+				    return is_pinned_codepoint(a.first);
+			    }
+			    if (a.second != b.second)
+			    {
+				    return a.second > b.second;
+			    }
+			    return a.first < b.first;
+		    });
+		const auto pinned_count = (size_t)std::ranges::count_if(resident, [](const auto& entry) { return is_pinned_codepoint(entry.first); });
+
+		uint32_t width = internal->packer.get_width();
+		uint32_t height = internal->packer.get_height();
+		for (;;)
+		{
+			internal->packer.reset(width, height);
+			internal->pixels.assign((size_t)width * height, 0);
+			internal->glyphs.clear();
+			internal->glyphs.reserve(resident.size());
+
+			size_t packed{};
+			for (; packed < resident.size(); ++packed)
+			{
+				font::glyph glyph{};
+				if (!rasterise_glyph(lookup, *internal, resident[packed].first, glyph))
+				{
+					break;
+				}
+				internal->glyphs.push_back(glyph);
+			}
+
+			if (packed == resident.size())
+			{
+				break;
+			}
+
+			if (std::max(width, height) < max_atlas_size)
+			{
+				if (width <= height)
+				{
+					width *= 2;
+				}
+				else
+				{
+					height *= 2;
+				}
+				continue;
+			}
+
+			// Full at the largest size, drop the least recently used half of what isn't pinned
+			const size_t keep = pinned_count + ((resident.size() - pinned_count) / 2);
+			if (keep == resident.size())
+			{
+				LOG_ERROR("Font atlas for {} cannot hold its pinned glyphs", variant.face);
+				return false;
+			}
+
+			for (size_t i{keep}; i < resident.size(); ++i)
+			{
+				internal->last_used.erase(resident[i].first);
+			}
+			resident.resize(keep);
+		}
+
+		auto& texture = variant.atlas->map_texture;
+		if (texture->get_width() != width || texture->get_height() != height)
+		{
+			texture_system::resize(texture, width, height, true);
+		}
+
+		const auto rgba_pixels = expand_atlas_region(*internal, 0, 0, width, height);
+		texture->write_data(0, rgba_pixels.size(), rgba_pixels.data());
+
+		++internal->atlas_generation;
+		internal->cache_dirty = true;
+		sync_system_font_variant(variant);
+		return true;
+	}
+
+	bool font_system::pack_system_font_glyphs(const system_font_lookup& lookup, font::data& variant, const egkr::vector<int32_t>& codepoints)
+	{
+		ZoneScoped;
+
 		auto* internal = (system_font_variant_data*)variant.internal;
 
-		uint32_t pack_image_size = variant.atlas_size_x * variant.atlas_size_y * sizeof(uint8_t);
-		std::vector<uint8_t> pixels(pack_image_size);
+		uint32_t min_x{std::numeric_limits<uint32_t>::max()};
+		uint32_t min_y{std::numeric_limits<uint32_t>::max()};
+		uint32_t max_x{};
+		uint32_t max_y{};
+		for (const auto codepoint : codepoints)
+		{
+			font::glyph glyph{};
+			if (!rasterise_glyph(lookup, *internal, codepoint, glyph))
+			{
+				// Out of space: grow or evict and repack everything resident, including the rest of these
+				for (const auto pending : codepoints)
+				{
+					internal->last_used[pending] = internal->use_clock;
+				}
+				return rebuild_system_font_variant_atlas(lookup, variant);
+			}
+
+			internal->last_used[codepoint] = internal->use_clock;
+			internal->glyphs.push_back(glyph);
+
+			min_x = std::min(min_x, (uint32_t)glyph.x);
+			min_y = std::min(min_y, (uint32_t)glyph.y);
+			max_x = std::max(max_x, (uint32_t)glyph.x + glyph.width);
+			max_y = std::max(max_y, (uint32_t)glyph.y + glyph.height);
+		}
 
-		auto codepoint_count = (uint32_t)internal->codepoint.size();
-		std::vector<stbtt_packedchar> packed_chars(codepoint_count);
+		internal->cache_dirty = true;
 
-		stbtt_pack_context context{};
-		if (!stbtt_PackBegin(&context, pixels.data(), (int32_t)variant.atlas_size_x, (int32_t)variant.atlas_size_y, 0, 1, nullptr))
+		// Only the rectangle covering the new glyphs goes to the gpu
+		if (max_x > min_x && max_y > min_y)
+		{
+			const auto rgba_pixels = expand_atlas_region(*internal, min_x, min_y, max_x - min_x, max_y - min_y);
+			variant.atlas->map_texture->write_region(min_x, min_y, max_x - min_x, max_y - min_y, rgba_pixels.data());
+		}
+		return true;
+	}
+
+	void font_system::sync_system_font_variant(font::data& variant)
+	{
+		const auto* internal = (const system_font_variant_data*)variant.internal;
+		if (variant.atlas_generation != internal->atlas_generation)
+		{
+			variant.atlas_size_x = internal->packer.get_width();
+			variant.atlas_size_y = internal->packer.get_height();
+			variant.glyphs = internal->glyphs;
+			variant.kernings = internal->kernings;
+			variant.atlas_generation = internal->atlas_generation;
+			variant.build_lookup();
+			return;
+		}
+
+		// Same packing, the shared glyph list has only been appended to since this copy last synced
+		for (size_t i{variant.glyphs.size()}; i < internal->glyphs.size(); ++i)
+		{
+			variant.add_glyph(internal->glyphs[i]);
+		}
+	}
+
+	bool font_system::load_system_font_variant_cache(const system_font_lookup& lookup, font::data& variant)
+	{
+		ZoneScoped;
+
+		const auto path = get_variant_cache_path(lookup, variant.size);
+		if (!filesystem::does_path_exist(path))
 		{
-			LOG_ERROR("stbtt_PackBegin failed");
 			return false;
 		}
 
-		stbtt_pack_range range
+		const auto file = mapped_file::open(path);
+		const auto contents = file.bytes();
+
+		font_atlas_cache_header header{};
+		if (contents.size() >= sizeof(font_atlas_cache_header))
 		{
-			.font_size = (float)variant.size,
-			.first_unicode_codepoint_in_range = 0,
-			.array_of_unicode_codepoints = internal->codepoint.data(),
-			.num_chars = (int32_t)codepoint_count,
-			.chardata_for_range = packed_chars.data(),
-		};
+			memcpy(&header, contents.data(), sizeof(font_atlas_cache_header));
+		}
 
-		if (!stbtt_PackFontRanges(&context, (unsigned char*)lookup.font_binary, lookup.index, &range, 1))
+		const uint64_t expected_size = sizeof(font_atlas_cache_header) + (header.glyph_count * sizeof(font::glyph)) + (header.kerning_count * sizeof(font::kerning))
+		                             + (header.skyline_count * sizeof(container::skyline_packer::node)) + ((uint64_t)header.atlas_width * header.atlas_height);
+
+		const bool matches_font = header.magic == FONT_ATLAS_CACHE_MAGIC && header.version == font_atlas_cache_version && header.font_size == lookup.binary_size
+		                       && header.font_write_time == lookup.binary_write_time && lookup.binary_write_time != 0 && header.size == variant.size && header.atlas_width <= max_atlas_size && header.atlas_height <= max_atlas_size && expected_size == contents.size();
+		if (!matches_font)
 		{
-			LOG_ERROR("stbtt_PackFontRanges failed");
+			LOG_INFO("Font atlas cache {} is stale, rebuilding", path);
 			return false;
 		}
 
-		stbtt_PackEnd(&context);
+		const auto* cursor = contents.data() + sizeof(font_atlas_cache_header);
+		const auto read_array = [&cursor]<class T>(egkr::vector<T>& out, size_t count)
+		{
+			out.resize(count);
+			memcpy(out.data(), cursor, count * sizeof(T));
+			cursor += count * sizeof(T);
+		};
+
+		auto* internal = (system_font_variant_data*)variant.internal;
+		egkr::vector<container::skyline_packer::node> skyline;
+		read_array(internal->glyphs, header.glyph_count);
+		read_array(internal->kernings, header.kerning_count);
+		read_array(skyline, header.skyline_count);
+		read_array(internal->pixels, (size_t)header.atlas_width * header.atlas_height);
 
-		std::vector<uint8_t> rgba_pixels(pack_image_size * 4);
-		for (uint32_t i{}; i < pack_image_size; ++i)
+		if (!internal->packer.restore(header.atlas_width, header.atlas_height, std::move(skyline)))
 		{
-			rgba_pixels[i * 4 + 0] = pixels[i];
-			rgba_pixels[i * 4 + 1] = pixels[i];
-			rgba_pixels[i * 4 + 2] = pixels[i];
-			rgba_pixels[i * 4 + 3] = pixels[i];
+			LOG_WARN("Font atlas cache {} has an invalid packing, rebuilding", path);
+			internal->packer.reset(initial_atlas_size, initial_atlas_size);
+			return false;
 		}
 
-		variant.atlas->map_texture->write_data(0, rgba_pixels.size(), rgba_pixels.data());
+		internal->last_used.clear();
+		for (const auto& glyph : internal->glyphs)
+		{
+			internal->last_used[glyph.codepoint] = 0;
+		}
 
-		if (!variant.glyphs.empty())
+		auto& texture = variant.atlas->map_texture;
+		if (texture->get_width() != header.atlas_width || texture->get_height() != header.atlas_height)
 		{
-			variant.glyphs.clear();
+			texture_system::resize(texture, header.atlas_width, header.atlas_height, true);
 		}
-		variant.glyphs.reserve(codepoint_count);
 
-		for(const auto[i, pc] : packed_chars | std::views::enumerate)
+		const auto rgba_pixels = expand_atlas_region(*internal, 0, 0, header.atlas_width, header.atlas_height);
+		texture->write_data(0, rgba_pixels.size(), rgba_pixels.data());
+
+		++internal->atlas_generation;
+		internal->cache_dirty = false;
+		sync_system_font_variant(variant);
+
+		LOG_INFO("Loaded font atlas cache {}: {} glyphs", path, header.glyph_count);
+		return true;
+	}
+
+	bool font_system::save_system_font_variant_cache(const system_font_lookup& lookup, const font::data& variant)
+	{
+		ZoneScoped;
+
+		const auto* internal = (const system_font_variant_data*)variant.internal;
+		if (!internal || !internal->cache_dirty)
 		{
-			const font::glyph glyph
-			{
-				.codepoint = internal->codepoint[(unsigned long)i],
-				.x = pc.x0,
-				.y = pc.y0,
-				.width = (uint16_t)(pc.x1 - pc.x0),
-				.height = (uint16_t)(pc.y1 - pc.y0),
-				.x_offset = (int16_t)pc.xoff,
-				.y_offset = (int16_t)pc.yoff,
-				.x_advance = (int16_t)pc.xadvance,
-				.page_id = 0,
-			};
-			variant.glyphs.push_back(glyph);
+			return true;
+		}
 
-			if (!variant.kernings.empty())
-			{
-				variant.kernings.clear();
-			}
+		const auto& skyline = internal->packer.get_skyline();
+		const font_atlas_cache_header header{
+			.font_size = lookup.binary_size,
+			.font_write_time = lookup.binary_write_time,
+			.size = variant.size,
+			.atlas_width = internal->packer.get_width(),
+			.atlas_height = internal->packer.get_height(),
+			.glyph_count = (uint32_t)internal->glyphs.size(),
+			.kerning_count = (uint32_t)internal->kernings.size(),
+			.skyline_count = (uint32_t)skyline.size(),
+		};
 
-			variant.kernings.resize((size_t)stbtt_GetKerningTableLength(&lookup.info));
-			if (!variant.kernings.empty())
-			{
-				std::vector<stbtt_kerningentry> kerning_table(variant.kernings.size());
-				int32_t entry_count = stbtt_GetKerningTable(&lookup.info, kerning_table.data(), (int32_t)variant.kernings.size());
+		// Written aside and renamed over the cache once complete, an interrupted write never leaves a truncated cache
+		const auto path = get_variant_cache_path(lookup, variant.size);
+		const auto temporary_path = path + ".tmp";
+		auto handle = filesystem::open(temporary_path, file_mode::write, true);
+		if (!handle.is_valid)
+		{
+			LOG_WARN("Failed to write font atlas cache {}", path);
+			return false;
+		}
 
-				if (entry_count != (int32_t)variant.kernings.size())
-				{
-					LOG_ERROR("Kerning entry count mismatch");
-					return {};
-				}
+		filesystem::write(handle, header);
+		filesystem::write(handle, internal->glyphs);
+		filesystem::write(handle, internal->kernings);
+		filesystem::write(handle, skyline);
+		filesystem::write(handle, internal->pixels);
 
-				for(const auto [table, kern] : std::views::zip(kerning_table, variant.kernings))
-				{
-					kern.codepoint_0 = table.glyph1;
-					kern.codepoint_1 = table.glyph2;
-					kern.amount = (int16_t)table.advance;
-				}
-			}
+		const bool written = fflush(handle.handle) == 0 && ferror(handle.handle) == 0;
+		filesystem::close(handle);
+
+		std::error_code error{};
+		if (written)
+		{
+			std::filesystem::rename(temporary_path, path, error);
+		}
+		if (!written || error)
+		{
+			LOG_WARN("Failed to write font atlas cache {}", path);
+			std::filesystem::remove(temporary_path, error);
+			return false;
 		}
 		return true;
 	}
 
+	bool font_system::is_atlas_current(const font::data& data)
+	{
+		if (data.font_type != font::type::system)
+		{
+			return true;
+		}
+
+		const auto* internal = (const system_font_variant_data*)data.internal;
+		return data.atlas_generation == internal->atlas_generation;
+	}
+
 	bool font_system::verify_system_font_size_variant(const system_font_lookup& lookup, font::data& variant, const std::string& text)
 	{
-		system_font_variant_data* internal = (system_font_variant_data*)variant.internal;
-		uint32_t added_codepoints{};
-		for (uint32_t i{}; i < text.size(); ++i)
+		ZoneScoped;
+
+		auto* internal = (system_font_variant_data*)variant.internal;
+		++internal->use_clock;
+
+		egkr::vector<int32_t> missing;
+		for (uint32_t i{}; i < text.size();)
 		{
 			int32_t codepoint{};
 			uint8_t advance{};
 			if (!bytes_to_codepoint(text, i, codepoint, advance))
 			{
-				LOG_ERROR("failed to get codepoint");
 				++i;
 				continue;
 			}
-			else
-			{
-				i += advance;
-				if (codepoint < 128)
-				{
-					continue;
-				}
+			i += advance;
 
-				uint32_t codepoint_count = (uint32_t)internal->codepoint.size();
-				bool found{};
-				for (uint32_t j{ 95 }; j < codepoint_count; ++j)
-				{
-					if (internal->codepoint[j] == codepoint)
-					{
-						found = true;
-						break;
-					}
-
-					if (!found)
-					{
-						internal->codepoint.push_back(codepoint);
-						++added_codepoints;
-					}
-				}
+			// Control characters are laid out without a glyph
+			if (codepoint < 32 && codepoint >= 0)
+			{
+				continue;
 			}
 
-			if (added_codepoints > 0)
+			if (auto it = internal->last_used.find(codepoint); it != internal->last_used.end())
 			{
-				return rebuild_system_font_variant_atlas(lookup, variant);
+				it->second = internal->use_clock;
+			}
+			else if (std::ranges::find(missing, codepoint) == missing.end())
+			{
+				missing.push_back(codepoint);
 			}
 		}
+
+		if (!missing.empty() && !pack_system_font_glyphs(lookup, variant, missing))
+		{
+			return false;
+		}
+
+		sync_system_font_variant(variant);
 		return true;
 	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <resources/font.h>
+#include <containers/skyline_packer.h>
 
 #include <systems/system.h>
 
@@ -9,46 +10,38 @@
 
 namespace egkr
 {
-	inline bool bytes_to_codepoint(const std::string& bytes, uint32_t offset, int32_t& out_codepoint, uint8_t& out_advance)
+	inline bool bytes_to_codepoint(std::string_view bytes, uint32_t offset, int32_t& out_codepoint, uint8_t& out_advance)
 	{
-		auto codepoint = bytes[offset];
-		if (codepoint >= 0 && codepoint < 0x7F)
+		const auto lead = (uint8_t)bytes[offset];
+		const auto continuation = [&bytes, offset](uint32_t i) { return (int32_t)((uint8_t)bytes[offset + i] & 0b00111111); };
+
+		if (lead < 0x80)
 		{
 			out_advance = 1;
-			out_codepoint = codepoint;
+			out_codepoint = lead;
 			return true;
 		}
-		else if ((codepoint & 0xE8) == 0xC0)
+		else if ((lead & 0xE0) == 0xC0 && offset + 1 < bytes.size())
 		{
-			codepoint = (char)(((bytes[offset + 0] & 0b00011111) << 6) +
-				(bytes[offset + 1] & 0b00111111));
-
+			out_codepoint = ((lead & 0b00011111) << 6) + continuation(1);
 			out_advance = 2;
-			out_codepoint = codepoint;
 			return true;
 		}
-		else if ((codepoint & 0xF0) == 0xE0)
+		else if ((lead & 0xF0) == 0xE0 && offset + 2 < bytes.size())
 		{
-			codepoint = (char)(((bytes[offset + 0] & 0b00001111) << 12) +
-				((bytes[offset + 1] & 0b00111111) << 6) +
-				(bytes[offset + 2] & 0b00111111));
+			out_codepoint = ((lead & 0b00001111) << 12) + (continuation(1) << 6) + continuation(2);
 			out_advance = 3;
-			out_codepoint = codepoint;
 			return true;
 		}
-		else if ((codepoint & 0xF8) == 0xF0)
+		else if ((lead & 0xF8) == 0xF0 && offset + 3 < bytes.size())
 		{
-			codepoint = (char)(((bytes[offset + 0] & 0b00000111) << 18) +
-				((bytes[offset + 1] & 0b00111111) << 12) +
-				((bytes[offset + 2] & 0b00111111) << 6) +
-				(bytes[offset + 3] & 0b00111111));
+			out_codepoint = ((lead & 0b00000111) << 18) + (continuation(1) << 12) + (continuation(2) << 6) + continuation(3);
 			out_advance = 4;
-			out_codepoint = codepoint;
 			return true;
 		}
 		else
 		{
-			LOG_ERROR("Not supporting 5 or 6 byte codepoints");
+			LOG_ERROR("Invalid or truncated UTF-8 sequence");
 			return false;
 		}
 
@@ -75,10 +68,22 @@ namespace egkr
 		font::bitmap_font_resource_data* resource_data;
 	};
 
+	// Shared by every copy of a size variant. Glyphs are rasterised into free atlas space the first time text uses them and
+	// only move when the atlas grows or evicts, which bumps atlas_generation
 	struct system_font_variant_data
 	{
-		egkr::vector<int32_t> codepoint;
 		float scale{};
+		container::skyline_packer packer{};
+		// Single channel copy of the atlas, expanded to rgba on upload
+		egkr::vector<uint8_t> pixels;
+		egkr::vector<font::glyph> glyphs;
+		egkr::vector<font::kerning> kernings;
+		// Use stamp per resident codepoint, the oldest are evicted first when the atlas is full at its largest size
+		std::unordered_map<int32_t, uint64_t> last_used;
+		uint64_t use_clock{};
+		uint32_t atlas_generation{};
+		// Set when the atlas changed since it was loaded from or saved to the on-disk cache
+		bool cache_dirty{};
 	};
 
 	struct bitmap_font_lookup
@@ -92,8 +97,10 @@ namespace egkr
 		uint16_t id{};
 		egkr::vector<font::data> size_variants;
 		uint64_t binary_size{};
+		// With binary_size, keys the on-disk atlas cache, so replacing the font file invalidates it
+		int64_t binary_write_time{};
 		std::string face;
-		void* font_binary{};
+		const void* font_binary{};
 		int32_t offset{};
 		int32_t index{};
 		stbtt_fontinfo info{};
@@ -129,14 +136,22 @@ namespace egkr
 		static bool verify_atlas(const std::shared_ptr<font::data>& data, const std::string& text);
 		static bool setup_font_data(font::data& data);
 		static font::data create_system_font_variant(const system_font_lookup& lookup, uint16_t size, const std::string& font_name);
+		// False when the font's atlas was repacked since this copy of its data was last verified
+		static bool is_atlas_current(const font::data& data);
 
 	private:
 		static bool rebuild_system_font_variant_atlas(const system_font_lookup& lookup, font::data& variant);
+		static bool pack_system_font_glyphs(const system_font_lookup& lookup, font::data& variant, const egkr::vector<int32_t>& codepoints);
+		static void sync_system_font_variant(font::data& variant);
+		static bool load_system_font_variant_cache(const system_font_lookup& lookup, font::data& variant);
+		static bool save_system_font_variant_cache(const system_font_lookup& lookup, const font::data& variant);
 		static bool verify_system_font_size_variant(const system_font_lookup& lookup, font::data& variant, const std::string& text);
 	private:
 		configuration configuration_{};
 		egkr::vector<bitmap_font_lookup> registered_bitmap_fonts_;
 		egkr::vector<system_font_lookup> registered_system_fonts_;
+		// Their mapped binaries back the registered system font faces, so they are unloaded last
+		egkr::vector<resource::shared_ptr> system_font_resources_;
 		std::unordered_map<std::string, bitmap_font_reference> registered_bitmap_fonts_by_name_;
 		std::unordered_map<std::string, system_font_reference> registered_system_fonts_by_name_;
 	};
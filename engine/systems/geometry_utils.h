@@ -71,8 +71,14 @@ template <typename vertex> [[maybe_unused]] static void generate_tangents(egkr::
     }
 }
 
+// Smooth normals, each vertex averages the faces around it weighted by their area
 template <typename vertex> [[maybe_unused]] static void generate_normals(egkr::vector<vertex>& vertices, const egkr::vector<uint32_t>& indices)
 {
+    for (auto& vertex : vertices)
+    {
+	vertex.normal = {};
+    }
+
     for (auto i{0U}; i < indices.size(); i += 3)
     {
 	auto& vertex1 = vertices[indices[i + 0]];
@@ -82,11 +88,18 @@ template <typename vertex> [[maybe_unused]] static void generate_normals(egkr::v
 	auto edge1 = vertex2.position - vertex1.position;
 	auto edge2 = vertex3.position - vertex1.position;
 
-	auto normal = glm::normalize(glm::cross(edge1, edge2));
+	// Unnormalised, its length is twice the face area
+	auto normal = glm::cross(edge1, edge2);
 
-	vertex1.normal = normal;
-	vertex2.normal = normal;
-	vertex3.normal = normal;
+	vertex1.normal += normal;
+	vertex2.normal += normal;
+	vertex3.normal += normal;
+    }
+
+    for (auto& vertex : vertices)
+    {
+	const auto length = glm::length(vertex.normal);
+	vertex.normal = length > 0.f ? vertex.normal / length : egkr::float3{0, 0, 1};
     }
 }
 
@@ -1,5 +1,6 @@
 #include "input.h"
 #include "event.h"
+#include "input_recorder.h"
 
 namespace egkr
 {
@@ -83,7 +84,7 @@ namespace egkr
 
     void input::process_key(key key, bool pressed)
     {
-	if (key == key::unknown)
+	if (key == key::unknown || !input_recorder::capture({.type = input_recorder::input_type::key, .pressed = pressed, .code = std::to_underlying(key)}))
 	{
 	    return;
 	}
@@ -125,7 +126,7 @@ namespace egkr
 	    event::context context{};
 	    context.set(0, std::to_underlying(key));
 
-	    event::fire_event(code, nullptr, context);
+	    event::post(code, nullptr, context);
 	}
     }
 
@@ -141,6 +142,11 @@ namespace egkr
 
     void input::process_button(mouse_button button, bool pressed)
     {
+	if (!input_recorder::capture({.type = input_recorder::input_type::button, .pressed = pressed, .code = std::to_underlying(button)}))
+	{
+	    return;
+	}
+
 	auto& button_state = state->current_mouse.buttons[(size_t)button];
 
 	event::context context{};
@@ -153,13 +159,13 @@ namespace egkr
 	    button_state = pressed;
 
 	    auto code = pressed ? event::code::mouse_down : event::code::mouse_up;
-	    event::fire_event(code, nullptr, context);
+	    event::post(code, nullptr, context);
 	}
 
 	if (!pressed && state->current_mouse.dragging[std::to_underlying(button)])
 	{
 	    state->current_mouse.dragging[std::to_underlying(button)] = false;
-	    event::fire_event(event::code::mouse_drag_end, nullptr, context);
+	    event::post(event::code::mouse_drag_end, nullptr, context);
 	}
     }
 
@@ -169,12 +175,17 @@ namespace egkr
 
     void input::process_mouse_move(int32_t xpos, int32_t ypos)
     {
+	if (!input_recorder::capture({.type = input_recorder::input_type::mouse_move, .x = xpos, .y = ypos}))
+	{
+	    return;
+	}
+
 	state->current_mouse.x = xpos;
 	state->current_mouse.y = ypos;
 	event::context context{};
 	context.set(0, state->current_mouse.x);
 	context.set(1, state->current_mouse.y);
-	event::fire_event(event::code::mouse_move, nullptr, context);
+	event::post(event::code::mouse_move, nullptr, context);
 
 	for (uint32_t i{0u}; i < std::to_underlying(mouse_button::button_count); ++i)
 	{
@@ -186,22 +197,29 @@ namespace egkr
 	    if (state->current_mouse.buttons[i] && !state->previous_mouse.dragging[i])
 	    {
 		state->current_mouse.dragging[i] = true;
-		event::fire_event(event::code::mouse_drag_begin, nullptr, drag_context);
+		event::post(event::code::mouse_drag_begin, nullptr, drag_context);
 	    }
 	    else if (state->current_mouse.buttons[i])
 	    {
-		event::fire_event(event::code::mouse_drag, nullptr, drag_context);
+		event::post(event::code::mouse_drag, nullptr, drag_context);
 	    }
 	}
     }
 
     void input::process_mouse_wheel(double xoffset, double yoffset)
     {
+	const input_recorder::input_record record{
+	    .type = input_recorder::input_type::mouse_wheel, .x = std::bit_cast<int32_t>((float)xoffset), .y = std::bit_cast<int32_t>((float)yoffset)};
+	if (!input_recorder::capture(record))
+	{
+	    return;
+	}
+
 	event::context context{};
 	context.set(0, xoffset);
 	context.set(1, yoffset);
 
-	event::fire_event(event::code::mouse_wheel, nullptr, context);
+	event::post(event::code::mouse_wheel, nullptr, context);
     }
 
     void input::push_keymap(const keymap& keymap) { state->keymaps.push_back(keymap); }
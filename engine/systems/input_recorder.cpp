@@ -0,0 +1,310 @@
+#include "input_recorder.h"
+
+#include "systems/input.h"
+#include "platform/filesystem.h"
+#include "engine/engine.h"
+
+namespace egkr
+{
+	constexpr static uint32_t recording_magic{ 0x52494745 };
+	constexpr static uint32_t recording_version{ 1 };
+
+	constexpr static key replay_console_key{ key::grave };
+	constexpr static key replay_stop_key{ key::esc };
+
+	struct recording_header
+	{
+		uint32_t magic{ recording_magic };
+		uint32_t version{ recording_version };
+		double start_time{};
+	};
+
+	struct recorded_frame
+	{
+		float delta_time{};
+		uint32_t input_count{};
+	};
+
+	static_assert(sizeof(input_recorder::input_record) == 12);
+
+	enum class recorder_mode
+	{
+		idle,
+		recording,
+		replaying
+	};
+
+	struct input_recorder_state
+	{
+		recorder_mode mode{ recorder_mode::idle };
+		std::string path;
+
+		// Kept in memory and written on stop, so recording adds no disk writes to the frames being measured
+		egkr::vector<uint8_t> recording{};
+		egkr::vector<input_recorder::input_record> frame_inputs{};
+
+		// The whole recording is read up front so a replay never waits on the disk
+		egkr::vector<uint8_t> replay_data{};
+		size_t replay_offset{};
+		double replay_time{};
+		// Set while a replayed frame is fed through input, so those events aren't ignored
+		bool is_feeding{};
+
+		uint64_t frame_count{};
+		std::chrono::steady_clock::time_point wall_start{};
+	};
+
+	static input_recorder_state state{};
+
+	template<class T>
+	static void append(egkr::vector<uint8_t>& buffer, const T& value)
+	{
+		const auto* bytes = (const uint8_t*)&value;
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	bool input_recorder::start_recording(std::string_view path)
+	{
+		if (state.mode != recorder_mode::idle)
+		{
+			LOG_ERROR("Input recorder busy, stop the current recording or replay first");
+			return false;
+		}
+
+		const recording_header header{ .start_time = engine::get_frame_data().total_time };
+		state.recording.clear();
+		append(state.recording, header);
+
+		state.mode = recorder_mode::recording;
+		state.path = path;
+		state.frame_inputs.clear();
+		state.frame_count = 0;
+		LOG_INFO("Recording input to {}", path);
+		return true;
+	}
+
+	void input_recorder::stop_recording()
+	{
+		if (state.mode != recorder_mode::recording)
+		{
+			return;
+		}
+
+		state.mode = recorder_mode::idle;
+
+		auto file = filesystem::open(state.path, file_mode::write, true);
+		if (!file.is_valid)
+		{
+			LOG_ERROR("Failed to open input recording {}", state.path);
+			return;
+		}
+
+		filesystem::write(file, state.recording);
+		filesystem::close(file);
+		state.recording.clear();
+		LOG_INFO("Recorded {} frames of input to {}", state.frame_count, state.path);
+	}
+
+	bool input_recorder::start_replay(std::string_view path)
+	{
+		if (state.mode != recorder_mode::idle)
+		{
+			LOG_ERROR("Input recorder busy, stop the current recording or replay first");
+			return false;
+		}
+
+		auto file = filesystem::open(path, file_mode::read, true);
+		if (!file.is_valid)
+		{
+			LOG_ERROR("Failed to open input recording {}", path);
+			return false;
+		}
+
+		state.replay_data = filesystem::read_all(file);
+		filesystem::close(file);
+
+		recording_header header{};
+		if (state.replay_data.size() < sizeof(header))
+		{
+			LOG_ERROR("Input recording {} is truncated", path);
+			return false;
+		}
+
+		memcpy(&header, state.replay_data.data(), sizeof(header));
+		if (header.magic != recording_magic || header.version != recording_version)
+		{
+			LOG_ERROR("{} is not an input recording this build can read", path);
+			return false;
+		}
+
+		state.mode = recorder_mode::replaying;
+		state.path = path;
+		state.replay_offset = sizeof(header);
+		state.replay_time = header.start_time;
+		state.frame_count = 0;
+		state.wall_start = std::chrono::steady_clock::now();
+		LOG_INFO("Replaying input from {}", path);
+		return true;
+	}
+
+	void input_recorder::stop_replay()
+	{
+		if (state.mode != recorder_mode::replaying)
+		{
+			return;
+		}
+
+		// Release anything the recording left held, otherwise the camera keeps moving after the replay
+		state.is_feeding = true;
+		for (uint32_t i{}; i < std::to_underlying(key::key_count); ++i)
+		{
+			if (input::is_key_down((key)i))
+			{
+				input::process_key((key)i, false);
+			}
+		}
+		for (uint16_t i{}; i < std::to_underlying(mouse_button::button_count); ++i)
+		{
+			if (input::is_button_down((mouse_button)i))
+			{
+				input::process_button((mouse_button)i, false);
+			}
+		}
+		state.is_feeding = false;
+
+		const std::chrono::duration<double, std::milli> wall_time = std::chrono::steady_clock::now() - state.wall_start;
+		const auto average = state.frame_count ? wall_time.count() / (double)state.frame_count : 0.0;
+		LOG_INFO("Replayed {} frames from {} in {:.2f}ms, {:.3f}ms per frame", state.frame_count, state.path, wall_time.count(), average);
+
+		state.mode = recorder_mode::idle;
+		state.replay_data.clear();
+		state.replay_data.shrink_to_fit();
+	}
+
+	bool input_recorder::is_recording() { return state.mode == recorder_mode::recording; }
+
+	bool input_recorder::is_replaying() { return state.mode == recorder_mode::replaying; }
+
+	// The only live input a replay lets through. The console key still toggles the console, and pressing the stop
+	// key ends the replay, so a long replay can always be left
+	static bool capture_during_replay(const input_recorder::input_record& record)
+	{
+		if (record.type != input_recorder::input_type::key)
+		{
+			return false;
+		}
+
+		const auto live_key = (key)record.code;
+		if (live_key == replay_stop_key)
+		{
+			// Consumed, so escape ends the replay instead of also reaching its usual binding
+			if (record.pressed)
+			{
+				LOG_INFO("Replay stopped from the keyboard");
+				input_recorder::stop_replay();
+			}
+			return false;
+		}
+		return live_key == replay_console_key;
+	}
+
+	bool input_recorder::capture(const input_record& record)
+	{
+		switch (state.mode)
+		{
+		case recorder_mode::recording:
+			state.frame_inputs.push_back(record);
+			return true;
+		case recorder_mode::replaying:
+			return state.is_feeding || capture_during_replay(record);
+		default:
+			return true;
+		}
+	}
+
+	void input_recorder::begin_frame(frame_data& frame_data)
+	{
+		if (state.mode == recorder_mode::recording)
+		{
+			const recorded_frame frame{ .delta_time = frame_data.delta_time, .input_count = (uint32_t)state.frame_inputs.size() };
+			append(state.recording, frame);
+			for (const auto& input : state.frame_inputs)
+			{
+				append(state.recording, input);
+			}
+			state.frame_inputs.clear();
+			++state.frame_count;
+			return;
+		}
+
+		if (state.mode != recorder_mode::replaying)
+		{
+			return;
+		}
+
+		recorded_frame frame{};
+		if (state.replay_offset + sizeof(frame) > state.replay_data.size())
+		{
+			stop_replay();
+			return;
+		}
+
+		memcpy(&frame, state.replay_data.data() + state.replay_offset, sizeof(frame));
+		state.replay_offset += sizeof(frame);
+
+		const size_t inputs_size = frame.input_count * sizeof(input_record);
+		if (state.replay_offset + inputs_size > state.replay_data.size())
+		{
+			LOG_WARN("Input recording {} ends mid frame", state.path);
+			stop_replay();
+			return;
+		}
+
+		state.is_feeding = true;
+		for (uint32_t i{}; i < frame.input_count; ++i)
+		{
+			input_record record{};
+			memcpy(&record, state.replay_data.data() + state.replay_offset, sizeof(record));
+			state.replay_offset += sizeof(record);
+
+			switch (record.type)
+			{
+			case input_type::key:
+				input::process_key((key)record.code, record.pressed != 0);
+				break;
+			case input_type::button:
+				input::process_button((mouse_button)record.code, record.pressed != 0);
+				break;
+			case input_type::mouse_move:
+				input::process_mouse_move(record.x, record.y);
+				break;
+			case input_type::mouse_wheel:
+				input::process_mouse_wheel(std::bit_cast<float>(record.x), std::bit_cast<float>(record.y));
+				break;
+			}
+		}
+		state.is_feeding = false;
+
+		// The recorded step replaces the wall clock, so every run simulates exactly the same frames
+		frame_data.delta_time = frame.delta_time;
+		state.replay_time += frame.delta_time;
+		frame_data.total_time = state.replay_time;
+		++state.frame_count;
+	}
+
+	void input_recorder::record_command(const console::context& context)
+	{
+		start_recording(context.arguments[0].value);
+	}
+
+	void input_recorder::replay_command(const console::context& context)
+	{
+		start_replay(context.arguments[0].value);
+	}
+
+	void input_recorder::stop_command(const console::context& /*context*/)
+	{
+		stop_recording();
+		stop_replay();
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "pch.h"
+#include "systems/console_system.h"
+
+namespace egkr
+{
+	// Records the platform input and delta time of every frame to a binary file, and replays such a file through
+	// the input entry points. A replay owns the input: live platform events are ignored until it finishes, except the
+	// console key and escape, which stops the replay
+	class input_recorder
+	{
+	public:
+		enum class input_type : uint8_t
+		{
+			key,
+			button,
+			mouse_move,
+			mouse_wheel
+		};
+
+		struct input_record
+		{
+			input_type type{};
+			uint8_t pressed{};
+			uint16_t code{};
+			// Mouse position, or the bit pattern of the wheel offsets as floats
+			int32_t x{};
+			int32_t y{};
+		};
+
+		static bool start_recording(std::string_view path);
+		static void stop_recording();
+		static bool start_replay(std::string_view path);
+		static void stop_replay();
+
+		[[nodiscard]] static bool is_recording();
+		[[nodiscard]] static bool is_replaying();
+
+		// Called by input for every event it is given. Returns false when the event should be ignored
+		static bool capture(const input_record& record);
+		// Called once a frame after the platform pump. Writes the frame out, or feeds the next recorded frame and its delta time
+		static void begin_frame(frame_data& frame_data);
+
+		static void record_command(const console::context& context);
+		static void replay_command(const console::context& context);
+		static void stop_command(const console::context& context);
+	};
+}
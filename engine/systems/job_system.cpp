@@ -1,14 +1,12 @@
 #include "job_system.h"
 
-#include <utility>
-
-#include <utility>
-
+#include <latch>
 #include <utility>
 
 namespace egkr
 {
     static job_system::unique_ptr state_{};
+    static thread_local uint32_t thread_index_{};
 
     job_system* job_system::create(const configuration& configuration)
     {
@@ -34,12 +32,19 @@ namespace egkr
 
     bool job_system::init()
     {
+	// Started early by system_manager::init_jobs, the regular init pass finds it already running
+	if (running_)
+	{
+	    return true;
+	}
+
 	if (thread_count_ > max_thread_count_)
 	{
 	    LOG_ERROR("Exceeded the max thread count");
 	    return false;
 	}
 	running_ = true;
+	parallel_workers_ = evar_system::create_int("job_parallel_workers", thread_count_, 0, thread_count_);
 
 	for (uint8_t i{0U}; i < thread_count_; ++i)
 	{
@@ -121,6 +126,7 @@ namespace egkr
 		    {
 			LOG_TRACE("Job immediately started");
 			state_->threads_[i].info = info;
+			thread.wake.notify_one();
 			found = true;
 		    }
 		    if (found)
@@ -142,10 +148,60 @@ namespace egkr
 	LOG_TRACE("Job queued");
     }
 
+    void job_system::execute_and_wait(std::span<const std::function<void()>> tasks, job::type type)
+    {
+	std::latch remaining{(std::ptrdiff_t)tasks.size()};
+	uint32_t next_thread{};
+	uint32_t handed_out{};
+	const auto max_handed_out = state_ ? (uint32_t)state_->parallel_workers_.get() : 0U;
+
+	for (const auto& task : tasks)
+	{
+	    bool assigned{};
+	    if (state_ && state_->running_ && handed_out < max_handed_out)
+	    {
+		for (; next_thread < state_->thread_count_ && !assigned; ++next_thread)
+		{
+		    auto& thread = state_->threads_[next_thread];
+		    if ((uint32_t)(thread.mask & type) == 0)
+		    {
+			continue;
+		    }
+
+		    std::lock_guard lock{thread.mutex};
+		    if (!thread.info.entry_point)
+		    {
+			thread.info = {.entry_point =
+			                   [&task, &remaining](void*, void*)
+			                   {
+			                       task();
+			                       remaining.count_down();
+			                       return true;
+			                   },
+			    .job_type = type,
+			    .job_priority = job::priority::high};
+			thread.wake.notify_one();
+			assigned = true;
+			++handed_out;
+		    }
+		}
+	    }
+
+	    if (!assigned)
+	    {
+		task();
+		remaining.count_down();
+	    }
+	}
+
+	remaining.wait();
+    }
+
     uint32_t job_system::run(void* params)
     {
-	uint32_t index = *(uint32_t*)params;
+	const uint32_t index = *(uint8_t*)params;
 	auto& thread = state_->threads_[index];
+	thread_index_ = index + 1;
 
 	for (;;)
 	{
@@ -189,7 +245,8 @@ namespace egkr
 	    }
 	    if (state_->running_)
 	    {
-		std::this_thread::sleep_for(10ms);
+		std::unique_lock lock{thread.mutex};
+		thread.wake.wait_for(lock, 10ms, [&thread]() { return (bool)thread.info.entry_point; });
 	    }
 	    else
 	    {
@@ -200,6 +257,8 @@ namespace egkr
 	return 1;
     }
 
+    uint32_t job_system::get_thread_index() { return thread_index_; }
+
     void job_system::process_queue(container::ring_queue<job::information>* queue, std::mutex* mutex)
     {
 	uint64_t thread_count = state_->thread_count_;
@@ -232,6 +291,7 @@ namespace egkr
 			    queue->dequeue(info);
 			}
 			thread.info = info;
+			thread.wake.notify_one();
 			LOG_TRACE("Assigning job to thread");
 			thread_found = true;
 		    }
@@ -6,6 +6,7 @@
 #include <resources/job.h>
 
 #include <systems/system.h>
+#include <systems/evar_system.h>
 
 namespace egkr
 {
@@ -30,7 +31,11 @@ namespace egkr
 		bool shutdown() override;
 
 		static void submit(job::information info);
+		// Hands each task straight to an idle worker of the given type, runs any left over on the calling thread and returns once all have finished
+		static void execute_and_wait(std::span<const std::function<void()>> tasks, job::type type);
 		static uint32_t run(void* params);
+		// Dense index of the calling thread, below job::MAX_THREAD_INDICES. Lets per thread state live in a fixed array
+		[[nodiscard]] static uint32_t get_thread_index();
 		static void process_queue(container::ring_queue<job::information>* queue, std::mutex* mutex);
 
 		static job::information create_job(job::start_job entry_point, job::complete_job on_success, job::complete_job on_fail, void* params, uint32_t params_size, uint32_t result_size);
@@ -45,7 +50,9 @@ namespace egkr
 		egkr::vector<job::type> type_masks_;
 
 		uint8_t thread_count_{};
-		std::array<job::thread, 32> threads_{};
+		std::array<job::thread, job::MAX_JOB_THREADS> threads_{};
+		// How many workers execute_and_wait may hand tasks to, the rest run on the caller
+		evar_handle<int32_t> parallel_workers_;
 
 		container::ring_queue<job::information>::unique_ptr low_priority_queue_;
 		container::ring_queue<job::information>::unique_ptr normal_priority_queue_;
@@ -1,10 +1,45 @@
 #include <systems/light_system.h>
+#include <systems/job_system.h>
 
 namespace egkr
 {
 
 	static light_system::unique_ptr light_system_{};
 
+	constexpr static uint32_t reference_index_bits{ 24 };
+	constexpr static uint32_t reference_index_mask{ (1u << reference_index_bits) - 1 };
+	constexpr static uint32_t reference_generation_mask{ 0xFF };
+	// Lights whose attenuated intensity drops under 1/256 of their colour no longer contribute
+	constexpr static float light_cutoff{ 256.F };
+	constexpr static uint32_t max_cluster_tasks{ 8 };
+	constexpr static uint32_t min_lights_per_task{ 256 };
+
+	static light_system::light_reference make_reference(uint32_t slot_index, uint32_t generation)
+	{
+		return ((generation & reference_generation_mask) << reference_index_bits) | slot_index;
+	}
+
+	static float compute_radius(const light::point_light& light)
+	{
+		const float intensity = std::max({ light.colour.r, light.colour.g, light.colour.b });
+		const float c = light.constant - (light_cutoff * intensity);
+		if (c >= 0.F)
+		{
+			return 0.F;
+		}
+
+		if (light.quadratic > 0.F)
+		{
+			return (-light.linear + std::sqrt((light.linear * light.linear) - (4.F * light.quadratic * c))) / (2.F * light.quadratic);
+		}
+		if (light.linear > 0.F)
+		{
+			return -c / light.linear;
+		}
+		// No falloff, reaches everything in view
+		return std::numeric_limits<float>::max();
+	}
+
 	light_system* light_system::create()
 	{
 		light_system_ = std::make_unique<light_system>();
@@ -12,7 +47,7 @@ namespace egkr
 	}
 
 	light_system::light_system()
-		: max_point_light_count_{ 10 }
+		: max_point_light_count_{ 4096 }
 	{}
 
 	light_system::~light_system()
@@ -22,6 +57,9 @@ namespace egkr
 
 	bool light_system::init()
 	{
+		point_lights_.reserve(max_point_light_count_);
+		point_light_radii_.reserve(max_point_light_count_);
+		dense_to_slot_.reserve(max_point_light_count_);
 		return true;
 	}
 
@@ -30,7 +68,12 @@ namespace egkr
 		if(light_system_)
 		{
 		point_lights_.clear();
+		point_light_radii_.clear();
+		dense_to_slot_.clear();
+		slots_.clear();
+		free_slots_.clear();
 		directional_light_.reset();
+		cluster_buffers_ = {};
 
 		light_system_ = nullptr;
 		}
@@ -62,21 +105,101 @@ namespace egkr
 
 	light_system::light_reference light_system::add_point_light(const light::point_light& light)
 	{
-		uint32_t reference = (uint32_t)light_system_->point_lights_.size();
-		if (reference + 1 == light_system_->max_point_light_count_)
+		auto& state = *light_system_;
+		if (state.point_lights_.size() >= state.max_point_light_count_)
 		{
 			LOG_ERROR("Max point light count exceeded. Light not added");
+			return invalid_32_id;
+		}
+
+		uint32_t slot_index{};
+		if (!state.free_slots_.empty())
+		{
+			slot_index = state.free_slots_.back();
+			state.free_slots_.pop_back();
+		}
+		else
+		{
+			slot_index = (uint32_t)state.slots_.size();
+			state.slots_.emplace_back();
+		}
+
+		auto& slot = state.slots_[slot_index];
+		slot.dense_index = (uint32_t)state.point_lights_.size();
+		state.point_lights_.push_back(light);
+		state.point_light_radii_.push_back(compute_radius(light));
+		state.dense_to_slot_.push_back(slot_index);
+
+		return make_reference(slot_index, slot.generation);
+	}
+
+	bool light_system::remove_point_light(light_reference light)
+	{
+		auto& state = *light_system_;
+		const uint32_t slot_index = light & reference_index_mask;
+		if (light == invalid_32_id || slot_index >= state.slots_.size())
+		{
+			LOG_WARN("Tried to remove a point light that was never added");
 			return false;
 		}
 
-		light_system_->point_lights_.push_back(light);
-		return reference;
+		auto& slot = state.slots_[slot_index];
+		if (slot.dense_index == invalid_32_id || (slot.generation & reference_generation_mask) != (light >> reference_index_bits))
+		{
+			LOG_WARN("Tried to remove a point light that was already removed");
+			return false;
+		}
+
+		// Swap the last light into the hole to keep the array the shaders read dense
+		const uint32_t removed = slot.dense_index;
+		const uint32_t last = (uint32_t)state.point_lights_.size() - 1;
+		if (removed != last)
+		{
+			state.point_lights_[removed] = state.point_lights_[last];
+			state.point_light_radii_[removed] = state.point_light_radii_[last];
+			state.dense_to_slot_[removed] = state.dense_to_slot_[last];
+			state.slots_[state.dense_to_slot_[removed]].dense_index = removed;
+		}
+		state.point_lights_.pop_back();
+		state.point_light_radii_.pop_back();
+		state.dense_to_slot_.pop_back();
+
+		slot.dense_index = invalid_32_id;
+		++slot.generation;
+		state.free_slots_.push_back(slot_index);
+		return true;
 	}
 
-	bool light_system::remove_point_light(light_reference /*light*/)
+	bool light_system::update_point_light(light_reference reference, const light::point_light& light)
 	{
-		LOG_WARN("Cannot remove point lights just yet. Come back later.");
-		return false;
+		auto* existing = get_point_light(reference);
+		if (!existing)
+		{
+			LOG_WARN("Tried to update a point light that isn't registered");
+			return false;
+		}
+
+		*existing = light;
+		const auto dense_index = (uint32_t)std::distance(light_system_->point_lights_.data(), existing);
+		light_system_->point_light_radii_[dense_index] = compute_radius(light);
+		return true;
+	}
+
+	light::point_light* light_system::get_point_light(light_reference reference)
+	{
+		auto& state = *light_system_;
+		const uint32_t slot_index = reference & reference_index_mask;
+		if (reference == invalid_32_id || slot_index >= state.slots_.size())
+		{
+			return nullptr;
+		}
+
+		const auto& slot = state.slots_[slot_index];
+		if (slot.dense_index == invalid_32_id || (slot.generation & reference_generation_mask) != (reference >> reference_index_bits))
+		{
+			return nullptr;
+		}
+		return &state.point_lights_[slot.dense_index];
 	}
 
 	int32_t light_system::point_light_count()
@@ -92,4 +215,196 @@ namespace egkr
 	{
 		return light_system_->point_lights_;
 	}
+
+	void light_system::update_clusters(const frame_data& frame_data, const float4x4& view, const float4x4& projection, float near_clip, float far_clip)
+	{
+		ZoneScoped;
+
+		auto& state = *light_system_;
+		// Every pass in a frame shares the one camera's clusters
+		if (state.clustered_frame_ == frame_data.frame_number)
+		{
+			return;
+		}
+		state.clustered_frame_ = frame_data.frame_number;
+
+		if (!state.cluster_buffers_[0].lights)
+		{
+			state.create_cluster_buffers();
+		}
+
+		// Slices grow exponentially with depth, so a zero near plane would put them all at the camera
+		const float near_depth = std::max(near_clip, 0.01F);
+		const float log_depth_ratio = std::log(far_clip / near_depth);
+		const float4 depth{ near_depth, far_clip, (float)cluster_z_count / log_depth_ratio, (float)cluster_z_count * std::log(near_depth) / log_depth_ratio };
+
+		const auto light_count = (uint32_t)state.point_lights_.size();
+		state.bounds_.resize(light_count);
+
+		egkr::vector<std::function<void()>> tasks{};
+		const uint32_t bounds_task_count = std::clamp((light_count + min_lights_per_task - 1) / min_lights_per_task, 1U, max_cluster_tasks);
+		const uint32_t lights_per_task = (light_count + bounds_task_count - 1) / bounds_task_count;
+		for (uint32_t task{}; task < bounds_task_count; ++task)
+		{
+			tasks.emplace_back(
+				[&state, &view, &projection, &depth, task, lights_per_task, light_count]()
+				{
+					const uint32_t last = std::min(light_count, (task + 1) * lights_per_task);
+					for (uint32_t i = task * lights_per_task; i < last; ++i)
+					{
+						const float radius = std::min(state.point_light_radii_[i], depth.y);
+						state.bounds_[i] = state.compute_bounds(state.point_lights_[i], radius, view, projection, depth);
+					}
+				});
+		}
+		job_system::execute_and_wait(tasks, job::type::general);
+
+		auto& buffers = state.cluster_buffers_[frame_data.frame_number % state.cluster_buffers_.size()];
+		buffers.lights->load_range(0, light_count * sizeof(light::point_light), state.point_lights_.data());
+
+		auto* grid = (uint8_t*)buffers.grid->map_memory(0, buffers.grid->get_size());
+		const cluster_header header{ .dimensions = { cluster_x_count, cluster_y_count, cluster_z_count, light_count }, .depth = depth };
+		memcpy(grid, &header, sizeof(header));
+
+		// Each cluster owns a fixed run of the index buffer, so slices are filled in parallel straight into the mapped memory
+		auto* cells = (cluster_cell*)(grid + sizeof(cluster_header));
+		auto* indices = (uint32_t*)buffers.indices->map_memory(0, buffers.indices->get_size());
+
+		tasks.clear();
+		constexpr uint32_t slices_per_task = (cluster_z_count + max_cluster_tasks - 1) / max_cluster_tasks;
+		for (uint32_t first_slice{}; first_slice < cluster_z_count; first_slice += slices_per_task)
+		{
+			const uint32_t last_slice = std::min(cluster_z_count, first_slice + slices_per_task) - 1;
+			tasks.emplace_back([&state, first_slice, last_slice, cells, indices]() { state.assign_slices(first_slice, last_slice, cells, indices); });
+		}
+		job_system::execute_and_wait(tasks, job::type::general);
+
+		buffers.grid->unmap();
+		buffers.indices->unmap();
+	}
+
+	const light_system::cluster_buffers& light_system::get_cluster_buffers(const frame_data& frame_data)
+	{
+		auto& state = *light_system_;
+		if (!state.cluster_buffers_[0].lights)
+		{
+			state.create_cluster_buffers();
+		}
+		return state.cluster_buffers_[frame_data.frame_number % state.cluster_buffers_.size()];
+	}
+
+	void light_system::create_cluster_buffers()
+	{
+		const uint64_t lights_size = max_point_light_count_ * sizeof(light::point_light);
+		const uint64_t grid_size = sizeof(cluster_header) + (cluster_count * sizeof(cluster_cell));
+		const uint64_t indices_size = (uint64_t)cluster_count * max_lights_per_cluster * sizeof(uint32_t);
+
+		for (auto& buffers : cluster_buffers_)
+		{
+			buffers.lights = renderbuffer::renderbuffer::create(renderbuffer::type::storage, lights_size);
+			buffers.lights->bind(0);
+			buffers.grid = renderbuffer::renderbuffer::create(renderbuffer::type::storage, grid_size);
+			buffers.grid->bind(0);
+			buffers.indices = renderbuffer::renderbuffer::create(renderbuffer::type::storage, indices_size);
+			buffers.indices->bind(0);
+
+			// Shaders may read before the first update, so start with no clusters rather than garbage
+			const cluster_header header{ .dimensions = { cluster_x_count, cluster_y_count, cluster_z_count, 0 }, .depth = { 0.1F, 1.F, 0.F, 0.F } };
+			egkr::vector<uint8_t> empty_grid(grid_size);
+			memcpy(empty_grid.data(), &header, sizeof(header));
+			buffers.grid->load_range(0, grid_size, empty_grid.data());
+		}
+	}
+
+	light_system::light_bounds light_system::compute_bounds(const light::point_light& light, float radius, const float4x4& view, const float4x4& projection, const float4& depth) const
+	{
+		const auto centre = float3(view * float4(float3(light.position), 1.F));
+		// View space looks down -z
+		const float light_depth = -centre.z;
+		if (radius <= 0.F || light_depth + radius < depth.x || light_depth - radius > depth.y)
+		{
+			return {};
+		}
+
+		auto slice = [&depth](float slice_depth)
+		{
+			const float index = std::floor((std::log(std::max(slice_depth, depth.x)) * depth.z) - depth.w);
+			return (uint32_t)std::clamp(index, 0.F, (float)(cluster_z_count - 1));
+		};
+
+		light_bounds bounds{ .min = { 0, 0, slice(light_depth - radius) }, .max = { cluster_x_count - 1, cluster_y_count - 1, slice(light_depth + radius) }, .visible = true };
+
+		// A sphere reaching behind the near plane can cover any tile, so only tighter bounds are worth finding in front of it
+		if (light_depth - radius <= depth.x)
+		{
+			return bounds;
+		}
+
+		// The projected corners of the sphere's box contain the projected sphere
+		float2 ndc_min{ std::numeric_limits<float>::max() };
+		float2 ndc_max{ std::numeric_limits<float>::lowest() };
+		for (uint32_t corner{}; corner < 8; ++corner)
+		{
+			const float3 offset{ (corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius };
+			const float4 clip = projection * float4(centre + offset, 1.F);
+			const float2 ndc = float2(clip) / clip.w;
+			ndc_min = glm::min(ndc_min, ndc);
+			ndc_max = glm::max(ndc_max, ndc);
+		}
+
+		if (ndc_max.x < -1.F || ndc_max.y < -1.F || ndc_min.x > 1.F || ndc_min.y > 1.F)
+		{
+			return {};
+		}
+
+		const float2 grid_size{ cluster_x_count, cluster_y_count };
+		const float2 tile_min = glm::clamp(glm::floor(((ndc_min * 0.5F) + 0.5F) * grid_size), float2(0.F), grid_size - 1.F);
+		const float2 tile_max = glm::clamp(glm::floor(((ndc_max * 0.5F) + 0.5F) * grid_size), float2(0.F), grid_size - 1.F);
+		bounds.min.x = (uint32_t)tile_min.x;
+		bounds.min.y = (uint32_t)tile_min.y;
+		bounds.max.x = (uint32_t)tile_max.x;
+		bounds.max.y = (uint32_t)tile_max.y;
+		return bounds;
+	}
+
+	void light_system::assign_slices(uint32_t first_slice, uint32_t last_slice, cluster_cell* cells, uint32_t* indices) const
+	{
+		ZoneScoped;
+
+		constexpr uint32_t slice_cluster_count = cluster_x_count * cluster_y_count;
+		std::array<cluster_cell, slice_cluster_count> slice_cells{};
+
+		for (uint32_t z = first_slice; z <= last_slice; ++z)
+		{
+			const uint32_t slice_offset = z * slice_cluster_count;
+			for (uint32_t cell{}; cell < slice_cluster_count; ++cell)
+			{
+				slice_cells[cell] = { .offset = (slice_offset + cell) * max_lights_per_cluster, .count = 0 };
+			}
+
+			for (uint32_t light_index{}; light_index < (uint32_t)bounds_.size(); ++light_index)
+			{
+				const auto& bounds = bounds_[light_index];
+				if (!bounds.visible || z < bounds.min.z || z > bounds.max.z)
+				{
+					continue;
+				}
+
+				for (uint32_t y = bounds.min.y; y <= bounds.max.y; ++y)
+				{
+					for (uint32_t x = bounds.min.x; x <= bounds.max.x; ++x)
+					{
+						// A full cluster drops its furthest-submitted lights rather than spilling into its neighbour
+						auto& cell = slice_cells[x + (y * cluster_x_count)];
+						if (cell.count < max_lights_per_cluster)
+						{
+							indices[cell.offset + cell.count++] = light_index;
+						}
+					}
+				}
+			}
+
+			memcpy(cells + slice_offset, slice_cells.data(), sizeof(slice_cells));
+		}
+	}
 }
@@ -3,15 +3,46 @@
 
 #include <resources/light.h>
 #include <systems/system.h>
+#include <renderer/renderbuffer.h>
 
 namespace egkr
 {
 		class light_system : public system
 		{
 		public:
+			// Low 24 bits index a slot, high 8 bits hold its generation so a removed light's reference stops resolving
 			using light_reference = uint32_t;
 			using unique_ptr = std::unique_ptr<light_system>;
-			
+
+			// The view frustum is split into a grid of clusters, exponentially in depth, each listing the lights touching it
+			constexpr static uint32_t cluster_x_count{ 16 };
+			constexpr static uint32_t cluster_y_count{ 9 };
+			constexpr static uint32_t cluster_z_count{ 24 };
+			constexpr static uint32_t cluster_count{ cluster_x_count * cluster_y_count * cluster_z_count };
+			constexpr static uint32_t max_lights_per_cluster{ 128 };
+
+			// Matches the light_grid storage buffer header in the shaders
+			struct cluster_header
+			{
+				uint4 dimensions{};
+				// near, far, slice scale, slice bias
+				float4 depth{};
+			};
+
+			struct cluster_cell
+			{
+				uint32_t offset{};
+				uint32_t count{};
+			};
+
+			// The storage buffers read by the lit shaders for one frame in flight
+			struct cluster_buffers
+			{
+				renderbuffer::renderbuffer::shared_ptr lights;
+				renderbuffer::renderbuffer::shared_ptr grid;
+				renderbuffer::renderbuffer::shared_ptr indices;
+			};
+
 			static light_system* create();
 
 			light_system();
@@ -22,16 +53,51 @@ namespace egkr
 
 			static bool add_directional_light(const std::shared_ptr<light::directional_light>& light);
 			static bool remove_directional_light();
+			// Returns invalid_32_id when the light couldn't be added
 			static light_reference add_point_light(const light::point_light& light);
 			static bool remove_point_light(light_reference light);
+			static bool update_point_light(light_reference reference, const light::point_light& light);
+			static light::point_light* get_point_light(light_reference reference);
 
 			static int32_t point_light_count();
 			static light::directional_light* get_directional_light();
+			// Densely packed, the order changes as lights are removed
 			static const std::vector<light::point_light>& get_point_lights();
 
+			// Assigns the point lights to the clusters of the given view and packs them into this frame's storage buffers
+			static void update_clusters(const frame_data& frame_data, const float4x4& view, const float4x4& projection, float near_clip, float far_clip);
+			static const cluster_buffers& get_cluster_buffers(const frame_data& frame_data);
+
 		private:
+			struct light_slot
+			{
+				uint32_t dense_index{ invalid_32_id };
+				uint32_t generation{};
+			};
+
+			// Cluster ranges a light covers, inclusive
+			struct light_bounds
+			{
+				uint3 min{};
+				uint3 max{};
+				bool visible{};
+			};
+
+			void create_cluster_buffers();
+			light_bounds compute_bounds(const light::point_light& light, float radius, const float4x4& view, const float4x4& projection, const float4& depth) const;
+			void assign_slices(uint32_t first_slice, uint32_t last_slice, cluster_cell* cells, uint32_t* indices) const;
+
 			uint32_t max_point_light_count_{};
 			std::vector<light::point_light> point_lights_{};
+			// Cutoff distance of each dense light, where its attenuated intensity falls below visibility
+			std::vector<float> point_light_radii_{};
+			std::vector<uint32_t> dense_to_slot_{};
+			std::vector<light_slot> slots_{};
+			std::vector<uint32_t> free_slots_{};
 			std::shared_ptr<light::directional_light> directional_light_{};
+
+			std::vector<light_bounds> bounds_{};
+			std::array<cluster_buffers, 3> cluster_buffers_{};
+			uint64_t clustered_frame_{ invalid_64u_id };
 		};
 }
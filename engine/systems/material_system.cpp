@@ -127,9 +127,10 @@ namespace egkr
 	    locations.view_position = shader->get_uniform_index("view_position");
 	    locations.model = shader->get_uniform_index("model");
 	    locations.mode = shader->get_uniform_index("mode");
-	    locations.point_light = shader->get_uniform_index("point_lights");
 	    locations.directional_light = shader->get_uniform_index("dir_light");
-	    locations.num_point_lights = shader->get_uniform_index("num_point_lights");
+	    locations.lights = shader->get_storage_index("lights");
+	    locations.light_grid = shader->get_storage_index("light_grid");
+	    locations.light_indices = shader->get_storage_index("light_indices");
 	    material_system_->material_locations_ = locations;
 	}
 	else if (material_system_->ui_shader_id_ == invalid_32_id && properties.shader_name == "Shader.UI")
@@ -179,6 +180,11 @@ namespace egkr
 	    shader_system::set_uniform(material_system_->material_locations_.ambient_colour, &ambient_colour);
 	    shader_system::set_uniform(material_system_->material_locations_.view_position, &view_position);
 	    shader_system::set_uniform(material_system_->material_locations_.mode, &mode);
+
+	    const auto& light_buffers = light_system::get_cluster_buffers(frame_data);
+	    shader_system::set_storage_buffer(material_system_->material_locations_.lights, light_buffers.lights.get());
+	    shader_system::set_storage_buffer(material_system_->material_locations_.light_grid, light_buffers.grid.get());
+	    shader_system::set_storage_buffer(material_system_->material_locations_.light_indices, light_buffers.indices.get());
 	}
 	else
 	{
@@ -203,9 +209,6 @@ namespace egkr
 		shader_system::set_uniform(material_system_->material_locations_.normal_texture, &material->get_normal_map());
 		shader_system::set_uniform(material_system_->material_locations_.shininess, &material->get_shininess());
 		shader_system::set_uniform(material_system_->material_locations_.directional_light, light_system::get_directional_light());
-		shader_system::set_uniform(material_system_->material_locations_.point_light, light_system::get_point_lights().data());
-		auto num_point_lights = light_system::point_light_count();
-		shader_system::set_uniform(material_system_->material_locations_.num_point_lights, &num_point_lights);
 	    }
 	    else if (material->get_shader_id() == material_system_->ui_shader_id_)
 	    {
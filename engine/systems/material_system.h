@@ -22,8 +22,9 @@ namespace egkr
 	uint32_t model{};
 	uint32_t mode{};
 	uint32_t directional_light{};
-	uint32_t point_light{};
-	uint32_t num_point_lights{};
+	uint32_t lights{};
+	uint32_t light_grid{};
+	uint32_t light_indices{};
     };
 
     struct ui_shader_uniform_location
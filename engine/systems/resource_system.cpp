@@ -11,6 +11,8 @@
 #include "loaders/scene_loader.h"
 #include "loaders/terrain_loader.h"
 #include "plugins/audio/audio_loader.h"
+#include "platform/async_file.h"
+#include "systems/job_system.h"
 
 namespace egkr
 {
@@ -134,6 +136,58 @@ namespace egkr
 	return nullptr;
     }
 
+    void resource_system::load_async(const std::string& name, resource::type type, void* params, std::function<void(const resource::shared_ptr&)> on_loaded)
+    {
+	auto found = resource_system_->registered_loaders_.find(type);
+	if (found == resource_system_->registered_loaders_.end())
+	{
+	    LOG_ERROR("Attempted to load resource without corresponding loader registered");
+	    on_loaded(nullptr);
+	    return;
+	}
+
+	auto* loader = found->second.get();
+	auto loaded = std::make_shared<resource::shared_ptr>();
+	const auto finish = [loaded, on_loaded = std::move(on_loaded)]() { on_loaded(*loaded); };
+
+	// Only formats the paths, the reading thread looks for them on disk
+	if (auto candidates = loader->candidate_paths(name, params); !candidates.empty())
+	{
+	    const std::array files{std::move(candidates)};
+	    async_file::submit(
+	        files,
+	        [loader, name, params, loaded](std::span<read_result> results)
+	        {
+		    auto& file = results.front();
+		    // Nothing was there to read, the loader may still build the resource another way, such as importing an obj
+		    *loaded = file.success ? loader->load_from_buffer(name, file.path, std::move(file.data), params) : loader->load(name, params);
+		    return *loaded != nullptr;
+	        },
+	        finish, finish);
+	    return;
+	}
+
+	// The loader reads for itself, so it blocks a worker as before
+	auto info = job_system::create_job(
+	    [loader, name, params, loaded](void*, void*)
+	    {
+		*loaded = loader->load(name, params);
+		return *loaded != nullptr;
+	    },
+	    [finish](void*) { finish(); }, [finish](void*) { finish(); }, nullptr, 0, 0);
+	job_system::submit(info);
+    }
+
+    std::optional<std::string> resource_system::resolve_path(const std::string& name, resource::type type, void* params)
+    {
+	auto found = resource_system_->registered_loaders_.find(type);
+	if (found == resource_system_->registered_loaders_.end())
+	{
+	    return {};
+	}
+	return found->second->resolve_path(name, params);
+    }
+
     bool resource_system::unload(const resource::shared_ptr& resource)
     {
 	if (resource_system_->registered_loaders_.contains(resource->get_type()))
@@ -27,7 +27,12 @@ namespace egkr
 	void register_loader(resource_loader::unique_ptr loader);
 
 	static resource::shared_ptr load(const std::string& name, resource::type type, void* params);
+	// Reads the file asynchronously and builds the resource on a worker once the bytes are in, so no worker waits on
+	// disk. on_loaded runs on the main thread, with nullptr on failure. params must stay valid until then
+	static void load_async(const std::string& name, resource::type type, void* params, std::function<void(const resource::shared_ptr&)> on_loaded);
 	static bool unload(const resource::shared_ptr& resource);
+	// The file the type's loader would read for name, if it reads one. Blocks on the disk, unlike load_async
+	static std::optional<std::string> resolve_path(const std::string& name, resource::type type, void* params);
     private:
 	uint32_t max_loader_count_{};
 	std::string base_path_;
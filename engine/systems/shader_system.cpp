@@ -1,8 +1,11 @@
 #include "shader_system.h"
+#include "job_system.h"
 
 namespace egkr
 {
 	static shader_system::unique_ptr shader_system_{};
+	// Per thread, each recording thread binds into its own command buffer
+	static thread_local uint32_t current_shader_id_{ invalid_32_id };
 
 	shader_system* shader_system::create(const configuration& configuration)
 	{
@@ -52,6 +55,31 @@ namespace egkr
 		return  shader;
 	}
 
+	egkr::vector<shader::shader::shared_ptr> shader_system::create_shaders(std::span<const shader::properties* const> properties, renderpass::renderpass* pass)
+	{
+		ZoneScoped;
+
+		egkr::vector<shader::shader::shared_ptr> shaders(properties.size());
+		egkr::vector<std::function<void()>> tasks{};
+		tasks.reserve(properties.size());
+		for (auto i{ 0U }; i < properties.size(); ++i)
+		{
+			tasks.emplace_back([&shaders, &properties, pass, i]() { shaders[i] = shader::shader::create(*properties[i], pass); });
+		}
+		job_system::execute_and_wait(tasks, job::type::general);
+
+		// Ids and the name lookup are only touched here, so registration stays on this thread
+		for (auto i{ 0U }; i < shaders.size(); ++i)
+		{
+			uint32_t id = new_shader_id();
+			shaders[i]->set_id(id);
+
+			shader_system_->shaders_.push_back(shaders[i]);
+			shader_system_->shader_id_by_name_[properties[i]->name] = id;
+		}
+		return shaders;
+	}
+
 	uint32_t shader_system::get_shader_id(const std::string& shader_name)
 	{
 		if (shader_system_->shader_id_by_name_.contains(shader_name))
@@ -98,10 +126,10 @@ namespace egkr
 
 	bool shader_system::use(uint32_t shader_id)
 	{
-		if (shader_system_->current_shader_id_ != shader_id)
+		if (current_shader_id_ != shader_id)
 		{
 			auto shader = get_shader(shader_id);
-			shader_system_->current_shader_id_ = shader_id;
+			current_shader_id_ = shader_id;
 
 			shader->use();
 			shader->bind_globals();
@@ -111,20 +139,20 @@ namespace egkr
 
 	void shader_system::apply_global(bool needs_update)
 	{
-		auto shader = shader_system_->get_shader(shader_system_->current_shader_id_);
+		auto shader = shader_system_->get_shader(current_shader_id_);
 		shader->apply_globals(needs_update);
 	}
 
 	void shader_system::apply_instance(bool needs_update)
 	{
-		auto shader = shader_system_->get_shader(shader_system_->current_shader_id_);
+		auto shader = shader_system_->get_shader(current_shader_id_);
 		shader->apply_instances(needs_update);
 	}
 
-	void shader_system::set_uniform(std::string_view uniform_name, const void* data)
+	void shader_system::set_uniform(uniform_id id, const void* data)
 	{
-		auto shader = get_shader(shader_system_->current_shader_id_);
-		auto uniform_index = shader->get_uniform_index(uniform_name);
+		auto shader = get_shader(current_shader_id_);
+		auto uniform_index = shader->get_uniform_index(id);
 		set_uniform(uniform_index, data);
 	}
 
@@ -132,7 +160,7 @@ namespace egkr
 	{
 		if (data)
 		{
-			auto shader = get_shader(shader_system_->current_shader_id_);
+			auto shader = get_shader(current_shader_id_);
 			auto uniform = shader->get_uniform(instance_id);
 
 			if (uniform.uniform_scope != shader->get_bound_scope())
@@ -152,9 +180,9 @@ namespace egkr
 		}
 	}
 
-	void shader_system::set_sampler(std::string_view sampler_name, const texture* texture)
+	void shader_system::set_sampler(uniform_id id, const texture* texture)
 	{
-		set_uniform(sampler_name, texture);
+		set_uniform(id, texture);
 	}
 
 	void shader_system::set_sampler(uint32_t sampler_id, const texture* texture)
@@ -162,12 +190,23 @@ namespace egkr
 		set_uniform(sampler_id, texture);
 	}
 
+	void shader_system::set_storage_buffer(uint32_t storage_id, renderbuffer::renderbuffer* buffer)
+	{
+		auto shader = get_shader(current_shader_id_);
+		shader->set_storage_buffer(storage_id, buffer);
+	}
+
 	void shader_system::bind_instance(uint32_t instance_id)
 	{
-		auto shader = shader_system_->get_shader(shader_system_->current_shader_id_);
+		auto shader = shader_system_->get_shader(current_shader_id_);
 		shader->set_bound_instance_id(instance_id);
 
 	}
+	void shader_system::reset_current_shader()
+	{
+		current_shader_id_ = invalid_32_id;
+	}
+
 	uint32_t shader_system::new_shader_id()
 	{
 		return (uint32_t)shader_system_->shaders_.size();
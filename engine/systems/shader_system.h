@@ -4,6 +4,7 @@
 #include "resources/shader.h"
 #include <systems/system.h>
 
+#include <span>
 #include <unordered_map>
 
 namespace egkr
@@ -27,6 +28,8 @@ namespace egkr
 		bool shutdown() override;
 
 		static shader::shared_ptr create_shader(const shader::properties& properties, renderpass::renderpass* pass);
+		// Builds independent shaders for one pass as parallel jobs, then registers them in order on the calling thread
+		static egkr::vector<shader::shared_ptr> create_shaders(std::span<const shader::properties* const> properties, renderpass::renderpass* pass);
 		[[nodiscard]] static uint32_t get_shader_id(const std::string& shader_name);
 		[[nodiscard]] static shader::shared_ptr get_shader(const std::string& shader_name);
 		[[nodiscard]] static shader::shared_ptr get_shader(uint32_t shader_id);
@@ -37,12 +40,15 @@ namespace egkr
 		static void apply_global(bool needs_update);
 		static void apply_instance(bool needs_update);
 
-		static void set_uniform(std::string_view uniform_name, const void* data);
+		static void set_uniform(uniform_id id, const void* data);
 		static void set_uniform(uint32_t instance_id, const void* data);
-		static void set_sampler(std::string_view sampler_name, const texture* texture);
+		static void set_sampler(uniform_id id, const texture* texture);
 		static void set_sampler(uint32_t sampler_id, const texture* texture);
+		static void set_storage_buffer(uint32_t storage_id, renderbuffer::renderbuffer* buffer);
 
 		static void bind_instance(uint32_t instance_id);
+		// Forgets this thread's current shader so the next use() binds it again, needed when starting a fresh command buffer
+		static void reset_current_shader();
 
 	private:
 		static uint32_t new_shader_id();
@@ -51,6 +57,5 @@ namespace egkr
 
 		std::unordered_map<std::string, uint32_t> shader_id_by_name_;
 		egkr::vector<shader::shader::shared_ptr> shaders_;
-		uint32_t current_shader_id_{ invalid_32_id };
 	};
 }
@@ -13,6 +13,7 @@
 #include <systems/console_system.h>
 #include <systems/evar_system.h>
 #include <systems/audio_system.h>
+#include <platform/async_file.h>
 
 #include <application/application.h>
 #include "engine/engine.h"
@@ -56,6 +57,16 @@ namespace egkr
 	return true;
     }
 
+    bool system_manager::init_jobs()
+    {
+	if (!system_manager_state)
+	{
+	    LOG_ERROR("System manager not created. Failed to start the job system");
+	    return false;
+	}
+	return system_manager_state->registered_systems_[system_type::job]->init();
+    }
+
     bool system_manager::update(const frame_data& frame_data)
     {
 	for (auto& [type, system] : system_manager_state->registered_systems_)
@@ -131,6 +142,11 @@ namespace egkr
 	    const job_system::configuration configuration{.thread_count = thread_count, .type_masks = types};
 	    registered_systems_.emplace(system_type::job, job_system::create(configuration));
 	}
+	{
+	    // Hands finished reads to the job system, so it comes after it
+	    const async_file::configuration configuration{.queue_depth = 256, .fallback_thread_count = 2};
+	    registered_systems_.emplace(system_type::async_file, async_file::create(configuration));
+	}
 	{
 	    const shader_system::configuration configuration{
 	        .max_shader_count = 1024,
@@ -156,12 +172,14 @@ namespace egkr
 	    registered_systems_.emplace(system_type::console, console::create());
 	}
 	{
-	    registered_systems_.emplace(system_type::evar, evar_system::create());
+	    const evar_system::configuration configuration{.config_path = "../../../../assets/evars.cfg"};
+	    registered_systems_.emplace(system_type::evar, evar_system::create(configuration));
 	}
 	{
-	    // audio::system_configuration audio_configuration{.audio_channel_count = 8};
+	    // Mixed in software to no device, so audio runs everywhere including headless runs
+	    audio::system_configuration audio_configuration{.audio_backend = audio::backend::software, .audio_channel_count = 8};
 
-	    // registered_systems_.emplace(system_type::audio, audio::audio_system::create(audio_configuration));
+	    registered_systems_.emplace(system_type::audio, audio::audio_system::create(audio_configuration));
 	}
     }
 
@@ -179,13 +197,14 @@ namespace egkr
 	{
 	    return;
 	}
-	// system_manager_state->registered_systems_[system_type::audio]->shutdown();
+	system_manager_state->registered_systems_[system_type::audio]->shutdown();
 	system_manager_state->registered_systems_[system_type::evar]->shutdown();
 	system_manager_state->registered_systems_[system_type::console]->shutdown();
 	system_manager_state->registered_systems_[system_type::font]->shutdown();
 	system_manager_state->registered_systems_[system_type::light]->shutdown();
 	system_manager_state->registered_systems_[system_type::camera]->shutdown();
 	system_manager_state->registered_systems_[system_type::shader]->shutdown();
+	system_manager_state->registered_systems_[system_type::async_file]->shutdown();
 	system_manager_state->registered_systems_[system_type::job]->shutdown();
 	system_manager_state->registered_systems_[system_type::geometry]->shutdown();
 	system_manager_state->registered_systems_[system_type::material]->shutdown();
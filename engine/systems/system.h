@@ -15,6 +15,7 @@ namespace egkr
 		shader,
 		renderer_system,
 		job,
+		async_file,
 		texture,
 		font,
 		camera,
@@ -48,6 +49,8 @@ namespace egkr
 		explicit system_manager(application* application);
 
 		static bool init();
+		// Starts the job workers ahead of init, so work done while the application boots can already run in parallel
+		static bool init_jobs();
 		static bool update(const frame_data& frame_data);
 		static void update_input(const frame_data& frame_data);
 
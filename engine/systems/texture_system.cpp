@@ -2,7 +2,6 @@
 
 #include "renderer/render_target.h"
 #include "systems/resource_system.h"
-#include "systems/job_system.h"
 
 #include "renderer/renderer_frontend.h"
 
@@ -366,6 +365,34 @@ namespace egkr
 	return new_texture;
     }
 
+    texture::shared_ptr texture_system::acquire_loaded(const std::string& texture_name, const resource::shared_ptr& image)
+    {
+	if (auto found = texture_system_->registered_textures_by_name_.find(texture_name); found != texture_system_->registered_textures_by_name_.end())
+	{
+	    return texture_system_->registered_textures_[found->second];
+	}
+
+	uint32_t texture_id = (uint32_t)texture_system_->registered_textures_.size();
+	if (texture_id >= texture_system_->max_texture_count_)
+	{
+	    LOG_FATAL("Exceeded max texture count");
+	    return nullptr;
+	}
+
+	auto properties = *(texture::properties*)image->data;
+	properties.name = texture_name;
+	properties.id = texture_id;
+
+	auto new_texture = texture::texture::create(properties, (const uint8_t*)properties.data);
+	new_texture->increment_generation();
+
+	texture_system_->registered_textures_.push_back(new_texture);
+	texture_system_->registered_textures_by_name_[texture_name] = texture_id;
+	return new_texture;
+    }
+
+    uint32_t texture_system::pending_load_count() { return texture_system_->pending_load_count_; }
+
     texture::shared_ptr texture_system::acquire_cube(const std::string& texture_name)
     {
 	if (strcmp(texture_name.data(), default_texture_name.data()) == 0)
@@ -481,15 +508,28 @@ namespace egkr
 
     texture::shared_ptr texture_system::load_texture(const std::string& filename, uint32_t /*id*/)
     {
+	// Read only by the image loader, so one instance serves every load in flight
+	static image_resource_parameters image_params{.flip_y = true};
+
 	auto tex = texture::texture::create();
-	load_parameters params{.out_texture = tex.get()};
+	++texture_system_->pending_load_count_;
 
-	params.name = (char*)malloc(filename.size() + 1);
-	memcpy(params.name, filename.data(), filename.size());
-	params.name[filename.size()] = '\0';
-	job::information info = job_system::job_system::create_job(job_start, load_job_success, load_job_fail, &params, sizeof(load_parameters), sizeof(load_parameters));
+	resource_system::load_async(filename, resource::type::image, &image_params,
+	    [out_texture = tex.get(), filename](const resource::shared_ptr& image)
+	    {
+		--texture_system_->pending_load_count_;
+		if (!image)
+		{
+		    LOG_ERROR("Failed to load texture {}", filename);
+		    return;
+		}
 
-	job_system::job_system::submit(info);
+		auto* properties = (texture::properties*)image->data;
+		out_texture->free();
+		texture::texture::create(*properties, (const uint8_t*)properties->data, out_texture);
+		out_texture->increment_generation();
+		resource_system::unload(image);
+	    });
 	return tex;
     }
 
@@ -537,45 +577,4 @@ namespace egkr
 	free(pixels);
 	return temp_texture;
     }
-
-    void texture_system::load_job_success(void* params)
-    {
-	load_parameters* load_params = (load_parameters*)params;
-	auto& resource = load_params->loaded_resource;
-
-	auto properties = (texture::properties*)resource->data;
-
-	load_params->out_texture->free();
-	texture::texture::create(*properties, (const uint8_t*)properties->data, load_params->out_texture);
-
-	load_params->out_texture->increment_generation();
-	free(load_params->name);
-	load_params->name = nullptr;
-	resource_system::unload(load_params->loaded_resource);
-	resource.reset();
-    }
-
-    bool texture_system::job_start(void* params, void* result_data)
-    {
-	auto* load_params = (load_parameters*)params;
-	image_resource_parameters image_params{.flip_y = true};
-	load_params->loaded_resource = resource_system::load(load_params->name, resource::type::image, &image_params);
-
-	if (!load_params->loaded_resource)
-	{
-	    return false;
-	}
-
-	memcpy(result_data, load_params, sizeof(load_parameters));
-
-	return true;
-    }
-
-    void texture_system::load_job_fail(void* params)
-    {
-	auto* load_params = (load_parameters*)params;
-	LOG_ERROR("Failed to load texture");
-
-	resource_system::unload(load_params->loaded_resource);
-    }
 }
@@ -23,16 +23,6 @@ namespace egkr
 	uint32_t max_texture_count{};
     };
 
-    struct load_parameters
-    {
-	char* name{};
-	texture* out_texture{};
-	texture* temp;
-	uint32_t current_generation{invalid_32_id};
-
-	resource::shared_ptr loaded_resource;
-    };
-
     class texture_system : public system
     {
     public:
@@ -53,6 +43,10 @@ namespace egkr
 	[[nodiscard]] static texture::shared_ptr acquire(const std::string& texture_name);
 	[[nodiscard]] static texture::shared_ptr acquire_cube(const std::string& texture_name);
 	[[nodiscard]] static texture::shared_ptr acquire_writable(const std::string& name, uint32_t width, uint32_t height, uint8_t channel_count, bool has_transparency);
+	// Registers and uploads an image already decoded by the caller, returning the existing texture if the name is taken
+	[[nodiscard]] static texture::shared_ptr acquire_loaded(const std::string& texture_name, const resource::shared_ptr& image);
+	// Textures acquired but still decoding on a job
+	[[nodiscard]] static uint32_t pending_load_count();
 	void release(std::string_view texture_name);
 
 	static texture::shared_ptr get_default_texture();
@@ -67,11 +61,6 @@ namespace egkr
     private:
 	static texture::shared_ptr load_texture(const std::string& filepath, uint32_t id);
 	static texture::shared_ptr load_cube_texture(const std::string& name, const egkr::vector<std::string>& texture_names, uint32_t id);
-
-	static void load_job_success(void* params);
-	static void load_job_fail(void* params);
-
-	static bool job_start(void* params, void* result_data);
     private:
 	texture::shared_ptr default_texture_;
 	texture::shared_ptr default_diffuse_texture_;
@@ -87,5 +76,6 @@ namespace egkr
 	std::unordered_map<std::string, texture_handle> registered_textures_by_name_;
 
 	uint32_t max_texture_count_{};
+	uint32_t pending_load_count_{};
     };
 }
@@ -9,6 +9,7 @@
 #include <systems/light_system.h>
 #include <systems/camera_system.h>
 #include <systems/audio_system.h>
+#include <identifier.h>
 #include <systems/material_system.h>
 
 #include <systems/resource_system.h>
@@ -83,14 +84,18 @@ bool sandbox_application::init()
     cam->set_aspect((float)width_ / (float)height_);
 
     //TODO add to scene
-    // test_audio = egkr::audio::audio_system::load_chunk("Test.ogg");
-    // test_loop_audio = egkr::audio::audio_system::load_chunk("Fire_loop.ogg");
+    // egkr::audio::audio_system::load_chunk_async("Test.ogg", [this](egkr::audio::file* file) { test_audio = file; });
+    // egkr::audio::audio_system::load_chunk_async("Fire_loop.ogg",
+    //     [this](egkr::audio::file* file)
+    //     {
+    //         test_loop_audio = file;
+    //         test_emitter.audio_file = test_loop_audio;
+    //         test_emitter.looping = true;
+    //         test_emitter.falloff = 1.F;
+    //         egkr::audio::audio_system::play_emitter(6, &test_emitter);
+    //     });
     // test_music = egkr::audio::audio_system::load_stream("Woodland Fantasy.ogg");
 
-    // test_emitter.audio_file = test_loop_audio;
-    // test_emitter.looping = true;
-    // test_emitter.falloff = 1.F;
-
     // egkr::audio::audio_system::set_master_volume(1.F);
     // egkr::audio::audio_system::set_channel_volume(0, 1.F);
     // egkr::audio::audio_system::set_channel_volume(1, 0.75F);
@@ -101,7 +106,6 @@ bool sandbox_application::init()
     // egkr::audio::audio_system::set_channel_volume(6, 1.F);
     // egkr::audio::audio_system::set_channel_volume(7, 1.0F);
 
-    //egkr::audio::audio_system::play_emitter(6, &test_emitter);
     //egkr::audio::audio_system::play_channel(7, test_music, true);
 
     egkr::debug_console::create();
@@ -163,11 +167,17 @@ void sandbox_application::prepare_frame(const egkr::frame_data& /*frame_data*/)
     }
 
     const auto& pos = camera_->get_position();
-    std::string text = std::format("Camera pos: {:.3} {:.3} {:.3}\n Mouse pos: {} {}", (double)pos.x, (double)pos.y, (double)pos.z, mouse_pos_.x, mouse_pos_.y);
+    const auto& ui_stats = ui_pass->get_text_statistics();
+    std::string text = std::format("Camera pos: {:.3} {:.3} {:.3}\n Mouse pos: {} {}\n UI: {} texts, {} quads, {} draws", (double)pos.x, (double)pos.y, (double)pos.z, mouse_pos_.x,
+        mouse_pos_.y, ui_stats.text_count, ui_stats.quad_count, ui_stats.draw_count);
 
     more_test_text_->set_text(text);
 
-    egkr::vector<egkr::text::ui_text::weak_ptr> texts{test_text_, more_test_text_};
+    // Reuses the pass's storage rather than building a new list every frame
+    auto& texts = ui_pass->data.texts;
+    texts.clear();
+    texts.push_back(test_text_);
+    texts.push_back(more_test_text_);
     if (egkr::debug_console::is_visible())
     {
 	texts.push_back(egkr::debug_console::get_text());
@@ -176,8 +186,8 @@ void sandbox_application::prepare_frame(const egkr::frame_data& /*frame_data*/)
     ui_pass->data.mesh_data = ui_meshes_;
     egkr::render_data data{.render_geometry = ui_mesh_->get_geometries()[0], .transform = ui_mesh_, .is_winding_reversed = ui_mesh_->get_determinant() < 0.f};
 
+    ui_pass->data.ui_geometries.clear();
     ui_pass->data.ui_geometries.push_back(data);
-    ui_pass->data.texts = texts;
     ui_pass->viewport = &ui_view;
     ui_pass->projection = ui_view.projection;
     ui_pass->do_execute = true;
@@ -325,7 +335,10 @@ bool sandbox_application::on_event(egkr::event::code code, void* /*sender*/, voi
     auto* game = (sandbox_application*)listener;
     if (code == egkr::event::code::hover_id_changed)
     {
-	context.get(0, game->hovered_object_id_);
+	uint32_t hovered_id{invalid_32_id};
+	context.get(0, hovered_id);
+	// Picks arrive a frame or more late, the object may already be gone
+	game->hovered_object_id_ = egkr::identifier::is_valid(hovered_id) ? hovered_id : invalid_32_id;
     }
     return false;
 }
@@ -537,7 +550,7 @@ void sandbox_application::load_scene()
 	}
     }
     //TODO: temp
-    main_scene_->load();
+    main_scene_->load(scene_configuration.dependencies);
     egkr::resource_system::unload(scene);
 }
 